@@ -96,6 +96,15 @@ extern "C" {
 
 #include <cassert>
 
+#ifdef WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <unistd.h>
+#endif
+
 typedef boost::shared_ptr<AUD_IFactory> AUD_Sound;
 typedef boost::shared_ptr<AUD_IDevice> AUD_Device;
 typedef boost::shared_ptr<AUD_IHandle> AUD_Handle;
@@ -1222,16 +1231,62 @@ void AUD_Handle_free(AUD_Handle *handle)
 	delete handle;
 }
 
+/* Mixdown renders chunks of this length in parallel, each after a pre-roll
+ * long enough for resampler history and volume ramps to settle. */
+#define AUD_MIXDOWN_CHUNK_SECONDS 10
+#define AUD_MIXDOWN_PREROLL_SECONDS 1
+
+/// Creates the high quality readers of a sequencer for the mixdown.
+class AUD_QualitySequencerFactory : public AUD_IFactory
+{
+private:
+	boost::shared_ptr<AUD_IFactory> m_sequencer;
+
+public:
+	AUD_QualitySequencerFactory(boost::shared_ptr<AUD_IFactory> sequencer) :
+		m_sequencer(sequencer) {}
+
+	virtual boost::shared_ptr<AUD_IReader> createReader()
+	{
+		return dynamic_cast<AUD_SequencerFactory *>(m_sequencer.get())->createQualityReader();
+	}
+};
+
+static int AUD_getProcessorCount()
+{
+#ifdef WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? count : 1;
+#endif
+}
+
 const char *AUD_mixdown(AUD_Sound *sound, unsigned int start, unsigned int length, unsigned int buffersize, const char *filename, AUD_DeviceSpecs specs, AUD_Container format, AUD_Codec codec, unsigned int bitrate)
 {
 	try {
 		AUD_SequencerFactory *f = dynamic_cast<AUD_SequencerFactory *>(sound->get());
 
 		f->setSpecs(specs.specs);
-		boost::shared_ptr<AUD_IReader> reader = f->createQualityReader();
-		reader->seek(start);
 		boost::shared_ptr<AUD_IWriter> writer = AUD_FileWriter::createWriter(filename, specs, format, codec, bitrate);
-		AUD_FileWriter::writeReader(reader, writer, length, buffersize);
+
+		int threads = AUD_getProcessorCount();
+		unsigned int chunksize = AUD_MIXDOWN_CHUNK_SECONDS * specs.rate;
+
+		// chunks start with fresh resamplers, which would differ from reading through
+		if(threads > 1 && length > chunksize && !f->isResampled())
+		{
+			boost::shared_ptr<AUD_IFactory> quality(new AUD_QualitySequencerFactory(*sound));
+			AUD_FileWriter::writeFactoryParallel(quality, writer, start, length, buffersize, chunksize, AUD_MIXDOWN_PREROLL_SECONDS * specs.rate, threads);
+		}
+		else
+		{
+			boost::shared_ptr<AUD_IReader> reader = f->createQualityReader();
+			reader->seek(start);
+			AUD_FileWriter::writeReader(reader, writer, length, buffersize);
+		}
 
 		return NULL;
 	}
@@ -761,6 +761,7 @@ extern void *AUD_getSet(void *set);
  * \param codec The codec used for encoding the audio data.
  * \param bitrate The bitrate for encoding.
  * \return An error message or NULL in case of success.
+ * \note Long mixdowns are rendered in chunks by several threads.
  */
 extern const char *AUD_mixdown(AUD_Sound *sound, unsigned int start, unsigned int length,
                                unsigned int buffersize, const char *filename,
@@ -28,6 +28,10 @@
 
 #include <cmath>
 
+#ifdef __SSE2__
+#  include <xmmintrin.h>
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -204,8 +208,32 @@ void AUD_ChannelMapperReader::read(int& length, bool& eos, sample_t* buffer)
 	m_reader->read(length, eos, in);
 
 	sample_t sum;
+	int i = 0;
+
+	// mono sources are the common case for 3D sound, panning them is a plain scale
+	if(m_source_channels == AUD_CHANNELS_MONO && m_target_channels == AUD_CHANNELS_STEREO)
+	{
+#ifdef __SSE2__
+		const __m128 map = _mm_set_ps(m_mapping[1], m_mapping[0], m_mapping[1], m_mapping[0]);
+
+		for(; i + 4 <= length; i += 4)
+		{
+			const __m128 v = _mm_loadu_ps(in + i);
+			_mm_storeu_ps(buffer + i * 2, _mm_mul_ps(_mm_unpacklo_ps(v, v), map));
+			_mm_storeu_ps(buffer + i * 2 + 4, _mm_mul_ps(_mm_unpackhi_ps(v, v), map));
+		}
+#endif
+
+		for(; i < length; i++)
+		{
+			buffer[i * 2] = m_mapping[0] * in[i];
+			buffer[i * 2 + 1] = m_mapping[1] * in[i];
+		}
+
+		return;
+	}
 
-	for(int i = 0; i < length; i++)
+	for(; i < length; i++)
 	{
 		for(int j = 0; j < m_target_channels; j++)
 		{
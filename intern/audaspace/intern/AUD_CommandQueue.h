@@ -0,0 +1,112 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This file is part of AudaSpace.
+ *
+ * Audaspace is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * AudaSpace is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Audaspace; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file audaspace/intern/AUD_CommandQueue.h
+ *  \ingroup audaspaceintern
+ */
+
+
+#ifndef __AUD_COMMANDQUEUE_H__
+#define __AUD_COMMANDQUEUE_H__
+
+#include "atomic_ops.h"
+
+/**
+ * This class is a fixed size ring buffer of commands for exactly one
+ * producing and one consuming thread. Neither side ever blocks, pushing
+ * fails if the queue is full and popping fails if it is empty.
+ * \param T The command type, it has to be default constructible and copyable.
+ * \param SIZE The capacity, has to be a power of two.
+ */
+template <class T, unsigned int SIZE>
+class AUD_CommandQueue
+{
+private:
+	/// The ring buffer.
+	T* m_commands;
+
+	/// Number of pushed commands, only written by the producer.
+	uint32_t m_write;
+
+	/// Number of popped commands, only written by the consumer.
+	uint32_t m_read;
+
+	// hide copy constructor and operator=
+	AUD_CommandQueue(const AUD_CommandQueue&);
+	AUD_CommandQueue& operator=(const AUD_CommandQueue&);
+
+public:
+	/**
+	 * Creates an empty queue.
+	 */
+	AUD_CommandQueue() :
+		m_write(0), m_read(0)
+	{
+		m_commands = new T[SIZE];
+	}
+
+	~AUD_CommandQueue()
+	{
+		delete[] m_commands;
+	}
+
+	/**
+	 * Appends a command, may only be called by the producing thread.
+	 * \param command The command to append.
+	 * \return Whether there was space left for the command.
+	 */
+	bool push(const T& command)
+	{
+		// the counters wrap around, their difference stays correct
+		if(m_write - atomic_fetch_and_add_uint32(&m_read, 0) >= SIZE)
+			return false;
+
+		m_commands[m_write & (SIZE - 1)] = command;
+
+		// full barrier, the command is visible before the counter
+		atomic_add_and_fetch_uint32(&m_write, 1);
+
+		return true;
+	}
+
+	/**
+	 * Removes the oldest command, may only be called by the consuming thread.
+	 * \param command The command is copied here.
+	 * \return Whether there was a command in the queue.
+	 */
+	bool pop(T& command)
+	{
+		if(atomic_fetch_and_add_uint32(&m_write, 0) == m_read)
+			return false;
+
+		T& slot = m_commands[m_read & (SIZE - 1)];
+		command = slot;
+		// don't keep references alive until the slot is reused
+		slot = T();
+
+		atomic_add_and_fetch_uint32(&m_read, 1);
+
+		return true;
+	}
+};
+
+#endif //__AUD_COMMANDQUEUE_H__
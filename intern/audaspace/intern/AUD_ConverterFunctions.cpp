@@ -30,6 +30,10 @@
 #include "AUD_ConverterFunctions.h"
 #include "AUD_Buffer.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #define AUD_U8_0		0x80
 #define AUD_S16_MAX		((int16_t)0x7FFF)
 #define AUD_S16_MIN		((int16_t)0x8000)
@@ -40,6 +44,31 @@
 #define AUD_FLT_MAX		1.0f
 #define AUD_FLT_MIN		-1.0f
 
+#ifdef __SSE2__
+/* Clamps like the scalar conversions: everything at or beyond the float
+ * limits maps to the integer limits, the rest is truncated. */
+static inline __m128i AUD_float_to_int_sse2(__m128 s, float scale, int32_t min, int32_t max)
+{
+	const __m128 lo = _mm_cmple_ps(s, _mm_set1_ps(AUD_FLT_MIN));
+	const __m128 hi = _mm_cmpge_ps(s, _mm_set1_ps(AUD_FLT_MAX));
+	const __m128i in = _mm_castps_si128(_mm_or_ps(lo, hi));
+
+	__m128i t = _mm_cvttps_epi32(_mm_mul_ps(s, _mm_set1_ps(scale)));
+	t = _mm_andnot_si128(in, t);
+	t = _mm_or_si128(t, _mm_and_si128(_mm_castps_si128(lo), _mm_set1_epi32(min)));
+	return _mm_or_si128(t, _mm_and_si128(_mm_castps_si128(hi), _mm_set1_epi32(max)));
+}
+#endif
+
+static inline int32_t AUD_float_to_s32(float s)
+{
+	if(s <= AUD_FLT_MIN)
+		return AUD_S32_MIN;
+	else if(s >= AUD_FLT_MAX)
+		return AUD_S32_MAX;
+	return (int32_t)(s * AUD_S32_MAX);
+}
+
 void AUD_convert_u8_s16(data_t* target, data_t* source, int length)
 {
 	int16_t* t = (int16_t*) target;
@@ -133,8 +162,25 @@ void AUD_convert_s16_float(data_t* target, data_t* source, int length)
 {
 	int16_t* s = (int16_t*) source;
 	float* t = (float*) target;
-	for(int i = length - 1; i >= 0; i--)
+	int i = length - 1;
+
+#ifdef __SSE2__
+	// backwards as the conversion may happen in place, the remainder first
+	for(; i >= 0 && (i + 1) & 3; i--)
+		t[i] = s[i] / AUD_S16_FLT;
+
+	const __m128 scale = _mm_set1_ps(AUD_S16_FLT);
+
+	for(i -= 3; i >= 0; i -= 4)
+	{
+		__m128i v = _mm_loadl_epi64((__m128i*)(s + i));
+		v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		_mm_storeu_ps(t + i, _mm_div_ps(_mm_cvtepi32_ps(v), scale));
+	}
+#else
+	for(; i >= 0; i--)
 		t[i] = s[i] / AUD_S16_FLT;
+#endif
 }
 
 void AUD_convert_s16_double(data_t* target, data_t* source, int length)
@@ -279,7 +325,16 @@ void AUD_convert_s32_float(data_t* target, data_t* source, int length)
 {
 	int32_t* s = (int32_t*) source;
 	float* t = (float*) target;
-	for(int i = 0; i < length; i++)
+	int i = 0;
+
+#ifdef __SSE2__
+	const __m128 scale = _mm_set1_ps(AUD_S32_FLT);
+
+	for(; i + 4 <= length; i += 4)
+		_mm_storeu_ps(t + i, _mm_div_ps(_mm_cvtepi32_ps(_mm_loadu_si128((__m128i*)(s + i))), scale));
+#endif
+
+	for(; i < length; i++)
 		t[i] = s[i] / AUD_S32_FLT;
 }
 
@@ -311,7 +366,18 @@ void AUD_convert_float_s16(data_t* target, data_t* source, int length)
 {
 	int16_t* t = (int16_t*) target;
 	float* s = (float*) source;
-	for(int i = 0; i < length; i++)
+	int i = 0;
+
+#ifdef __SSE2__
+	for(; i + 8 <= length; i += 8)
+	{
+		__m128i a = AUD_float_to_int_sse2(_mm_loadu_ps(s + i), AUD_S16_MAX, AUD_S16_MIN, AUD_S16_MAX);
+		__m128i b = AUD_float_to_int_sse2(_mm_loadu_ps(s + i + 4), AUD_S16_MAX, AUD_S16_MIN, AUD_S16_MAX);
+		_mm_storeu_si128((__m128i*)(t + i), _mm_packs_epi32(a, b));
+	}
+#endif
+
+	for(; i < length; i++)
 	{
 		if(s[i] <= AUD_FLT_MIN)
 			t[i] = AUD_S16_MIN;
@@ -326,15 +392,29 @@ void AUD_convert_float_s24_be(data_t* target, data_t* source, int length)
 {
 	int32_t t;
 	float* s = (float*) source;
-	for(int i = 0; i < length; i++)
+	int i = 0;
+
+#ifdef __SSE2__
+	int32_t block[4];
+
+	for(; i + 4 <= length; i += 4)
 	{
-		if(s[i] <= AUD_FLT_MIN)
-			t = AUD_S32_MIN;
-		else if(s[i] >= AUD_FLT_MAX)
-			t = AUD_S32_MAX;
-		else
-			t = (int32_t)(s[i]*AUD_S32_MAX);
-		target[i*3] = t >> 24 & 0xFF;
+		_mm_storeu_si128((__m128i*)block, AUD_float_to_int_sse2(_mm_loadu_ps(s + i), AUD_S32_MAX, AUD_S32_MIN, AUD_S32_MAX));
+
+		for(int j = 0; j < 4; j++)
+		{
+			t = block[j];
+			target[(i+j)*3+0] = t >> 24 & 0xFF;
+			target[(i+j)*3+1] = t >> 16 & 0xFF;
+			target[(i+j)*3+2] = t >> 8 & 0xFF;
+		}
+	}
+#endif
+
+	for(; i < length; i++)
+	{
+		t = AUD_float_to_s32(s[i]);
+		target[i*3+0] = t >> 24 & 0xFF;
 		target[i*3+1] = t >> 16 & 0xFF;
 		target[i*3+2] = t >> 8 & 0xFF;
 	}
@@ -344,17 +424,31 @@ void AUD_convert_float_s24_le(data_t* target, data_t* source, int length)
 {
 	int32_t t;
 	float* s = (float*) source;
-	for(int i = 0; i < length; i++)
+	int i = 0;
+
+#ifdef __SSE2__
+	int32_t block[4];
+
+	for(; i + 4 <= length; i += 4)
 	{
-		if(s[i] <= AUD_FLT_MIN)
-			t = AUD_S32_MIN;
-		else if(s[i] >= AUD_FLT_MAX)
-			t = AUD_S32_MAX;
-		else
-			t = (int32_t)(s[i]*AUD_S32_MAX);
+		_mm_storeu_si128((__m128i*)block, AUD_float_to_int_sse2(_mm_loadu_ps(s + i), AUD_S32_MAX, AUD_S32_MIN, AUD_S32_MAX));
+
+		for(int j = 0; j < 4; j++)
+		{
+			t = block[j];
+			target[(i+j)*3+2] = t >> 24 & 0xFF;
+			target[(i+j)*3+1] = t >> 16 & 0xFF;
+			target[(i+j)*3+0] = t >> 8 & 0xFF;
+		}
+	}
+#endif
+
+	for(; i < length; i++)
+	{
+		t = AUD_float_to_s32(s[i]);
 		target[i*3+2] = t >> 24 & 0xFF;
 		target[i*3+1] = t >> 16 & 0xFF;
-		target[i*3] = t >> 8 & 0xFF;
+		target[i*3+0] = t >> 8 & 0xFF;
 	}
 }
 
@@ -362,15 +456,15 @@ void AUD_convert_float_s32(data_t* target, data_t* source, int length)
 {
 	int32_t* t = (int32_t*) target;
 	float* s = (float*) source;
-	for(int i = 0; i < length; i++)
-	{
-		if(s[i] <= AUD_FLT_MIN)
-			t[i] = AUD_S32_MIN;
-		else if(s[i] >= AUD_FLT_MAX)
-			t[i] = AUD_S32_MAX;
-		else
-			t[i] = (int32_t)(s[i]*AUD_S32_MAX);
-	}
+	int i = 0;
+
+#ifdef __SSE2__
+	for(; i + 4 <= length; i += 4)
+		_mm_storeu_si128((__m128i*)(t + i), AUD_float_to_int_sse2(_mm_loadu_ps(s + i), AUD_S32_MAX, AUD_S32_MIN, AUD_S32_MAX));
+#endif
+
+	for(; i < length; i++)
+		t[i] = AUD_float_to_s32(s[i]);
 }
 
 void AUD_convert_float_double(data_t* target, data_t* source, int length)
@@ -41,6 +41,8 @@
 #include "AUD_FileWriter.h"
 #include "AUD_Buffer.h"
 
+#include <pthread.h>
+
 static const char* write_error = "AUD_FileWriter: File couldn't be written.";
 
 boost::shared_ptr<AUD_IWriter> AUD_FileWriter::createWriter(std::string filename,AUD_DeviceSpecs specs,
@@ -129,3 +131,178 @@ void AUD_FileWriter::writeReader(boost::shared_ptr<AUD_IReader> reader, std::vec
 		}
 	}
 }
+
+/// A chunk of the signal rendered by writeReaderParallel().
+struct AUD_WriterChunk
+{
+	boost::shared_ptr<AUD_IFactory> factory;
+	AUD_Buffer buffer;
+	int channels;
+	int buffersize;
+	/// Position of the first read, the pre-roll before the chunk.
+	int position;
+	int preroll;
+	int length;
+	pthread_t thread;
+	bool running;
+	bool failed;
+	AUD_Exception exception;
+};
+
+/// Index of a chunk in the two sets of chunks.
+#define AUD_CHUNK_SLOT(chunk, threads) ((chunk) / (threads) % 2 * (threads) + (chunk) % (threads))
+
+static void AUD_clampBuffer(sample_t* buffer, int length)
+{
+	for(int i = 0; i < length; i++)
+	{
+		if(buffer[i] > 1)
+			buffer[i] = 1;
+		else if(buffer[i] < -1)
+			buffer[i] = -1;
+	}
+}
+
+static void* AUD_renderChunk(void* data)
+{
+	AUD_WriterChunk* chunk = (AUD_WriterChunk*) data;
+	int samplesize = chunk->channels * sizeof(sample_t);
+
+	try
+	{
+		chunk->buffer.assureSize(AUD_MAX(chunk->length, chunk->buffersize) * samplesize);
+		sample_t* buf = chunk->buffer.getBuffer();
+
+		int len;
+		bool eos = false;
+
+		// a fresh reader, a reused one keeps state from its previous chunk
+		boost::shared_ptr<AUD_IReader> reader = chunk->factory->createReader();
+		reader->seek(chunk->position);
+
+		// same read lengths as the serial writer, so that the state matches
+		for(int pos = 0; pos < chunk->preroll; pos += chunk->buffersize)
+		{
+			len = AUD_MIN(chunk->buffersize, chunk->preroll - pos);
+			reader->read(len, eos, buf);
+		}
+
+		for(int pos = 0; pos < chunk->length; pos += len)
+		{
+			len = AUD_MIN(chunk->buffersize, chunk->length - pos);
+			reader->read(len, eos, buf + pos * chunk->channels);
+
+			if(eos)
+			{
+				pos += len;
+				chunk->length = pos;
+				break;
+			}
+		}
+
+		AUD_clampBuffer(buf, chunk->length * chunk->channels);
+	}
+	catch(AUD_Exception& e)
+	{
+		chunk->failed = true;
+		chunk->exception = e;
+	}
+
+	return NULL;
+}
+
+static void AUD_startChunk(AUD_WriterChunk* chunk)
+{
+	chunk->failed = false;
+	chunk->running = pthread_create(&chunk->thread, NULL, AUD_renderChunk, chunk) == 0;
+
+	// without a thread the chunk is rendered right away
+	if(!chunk->running)
+		AUD_renderChunk(chunk);
+}
+
+static void AUD_finishChunk(AUD_WriterChunk* chunk)
+{
+	if(chunk->running)
+		pthread_join(chunk->thread, NULL);
+	chunk->running = false;
+}
+
+void AUD_FileWriter::writeFactoryParallel(boost::shared_ptr<AUD_IFactory> factory, boost::shared_ptr<AUD_IWriter> writer, unsigned int start, unsigned int length, unsigned int buffersize, unsigned int chunksize, unsigned int preroll, int threads)
+{
+	threads = AUD_MAX(threads, 1);
+	int channels = writer->getSpecs().channels;
+
+	chunksize = AUD_MAX(chunksize, 1u);
+	chunksize = (chunksize + buffersize - 1) / buffersize * buffersize;
+	preroll = (preroll + buffersize - 1) / buffersize * buffersize;
+
+	int chunks = (length + chunksize - 1) / chunksize;
+
+	// two sets of chunks, one is written while the next one renders
+	AUD_WriterChunk* jobs = new AUD_WriterChunk[2 * threads];
+	int rendered = 0;
+	int written = 0;
+	bool eos = false;
+
+	for(int i = 0; i < 2 * threads; i++)
+		jobs[i].running = false;
+
+	try
+	{
+		while(written < chunks && !eos)
+		{
+			int end = rendered;
+
+			// the slots of the next set were last used two sets ago
+			for(int i = written; i < end; i++)
+				AUD_finishChunk(&jobs[AUD_CHUNK_SLOT(i, threads)]);
+
+			for(int t = 0; t < threads && rendered < chunks; t++, rendered++)
+			{
+				AUD_WriterChunk* chunk = &jobs[AUD_CHUNK_SLOT(rendered, threads)];
+				unsigned int offset = rendered * chunksize;
+
+				chunk->factory = factory;
+				chunk->channels = channels;
+				chunk->buffersize = buffersize;
+				chunk->preroll = AUD_MIN(preroll, offset);
+				chunk->position = start + offset - chunk->preroll;
+				chunk->length = AUD_MIN(chunksize, length - offset);
+
+				AUD_startChunk(chunk);
+			}
+
+			for(; written < end; written++)
+			{
+				AUD_WriterChunk* chunk = &jobs[AUD_CHUNK_SLOT(written, threads)];
+
+				if(chunk->failed)
+					throw chunk->exception;
+
+				sample_t* buf = chunk->buffer.getBuffer();
+
+				for(int pos = 0; pos < chunk->length; pos += buffersize)
+					writer->write(AUD_MIN(buffersize, chunk->length - pos), buf + pos * channels);
+
+				// the signal ended early, there's nothing left to write
+				if(chunk->length < (int)AUD_MIN(chunksize, length - written * chunksize))
+				{
+					eos = true;
+					break;
+				}
+			}
+		}
+	}
+	catch(AUD_Exception&)
+	{
+		for(int i = 0; i < 2 * threads; i++)
+			AUD_finishChunk(&jobs[i]);
+		delete[] jobs;
+		throw;
+	}
+
+	for(int i = 0; i < 2 * threads; i++)
+		AUD_finishChunk(&jobs[i]);
+	delete[] jobs;
+}
@@ -36,6 +36,7 @@
 
 #include "AUD_IWriter.h"
 #include "AUD_IReader.h"
+#include "AUD_IFactory.h"
 
 /**
  * This class is able to create IWriter classes as well as write reads to them.
@@ -77,6 +78,26 @@ public:
 	 * \param buffersize How many samples should be transferred at once.
 	 */
 	static void writeReader(boost::shared_ptr<AUD_IReader> reader, std::vector<boost::shared_ptr<AUD_IWriter> >& writers, unsigned int length, unsigned int buffersize);
+
+	/**
+	 * Writes a signal to a writer, rendering it in chunks in parallel.
+	 * Every chunk is rendered by a new reader of the factory, that first
+	 * reads and discards a pre-roll before the chunk so that its state
+	 * (resampler history, volume ramps, started sounds) matches a serial
+	 * read. Reads happen at the same positions relative to start as with
+	 * writeReader() on a reader seeked to start.
+	 * \param factory The factory of seekable readers of the signal.
+	 * \param writer The writer to write to.
+	 * \param start The position of the first sample to write.
+	 * \param length How many samples should be transferred, must not be 0.
+	 * \param buffersize How many samples should be transferred at once.
+	 * \param chunksize Length of a chunk in samples, rounded up to a multiple
+	 *        of buffersize.
+	 * \param preroll How many samples are read before a chunk, rounded up to
+	 *        a multiple of buffersize.
+	 * \param threads How many chunks are rendered at the same time.
+	 */
+	static void writeFactoryParallel(boost::shared_ptr<AUD_IFactory> factory, boost::shared_ptr<AUD_IWriter> writer, unsigned int start, unsigned int length, unsigned int buffersize, unsigned int chunksize, unsigned int preroll, int threads);
 };
 
 #endif //__AUD_FILEWRITER_H__
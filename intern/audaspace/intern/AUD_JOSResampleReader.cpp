@@ -33,6 +33,12 @@
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#include <map>
+#include <pthread.h>
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
 
 /* MSVC does not have lrint */
 #ifdef _MSC_VER
@@ -71,14 +77,157 @@ static inline int lrint(double d)
 #define fp_rest(x) (x & ((1 << SHIFT_BITS) - 1))
 #define fp_rest_to_double(x) fp_to_double(fp_rest(x))
 
+/// Limits of the filter banks: phase count and size in coefficients.
+#define AUD_POLYPHASE_MAX_PHASES 1024
+#define AUD_POLYPHASE_MAX_SIZE (1 << 20)
+
+/**
+ * The filter of a constant rational ratio sampled at every output phase.
+ * Phase k holds the coefficients of the input samples n - width + 1 to
+ * n + width for an output sample at position n + k / phases.
+ */
+struct AUD_JOSPolyphaseTable
+{
+	/// Output phases per input sample, the denominator of the ratio.
+	int phases;
+	/// Phase increment per output sample, the numerator of the ratio.
+	int step;
+	/// Half filter length in input samples, a multiple of 4.
+	int width;
+	AUD_Buffer coeff;
+};
+
+typedef std::map<std::pair<int, int>, boost::shared_ptr<AUD_JOSPolyphaseTable> > AUD_JOSPolyphaseCache;
+
+// the filter banks are shared by all readers, there are only few ratios
+static AUD_JOSPolyphaseCache polyphase_cache;
+static pthread_mutex_t polyphase_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int AUD_gcd(int a, int b)
+{
+	while(b)
+	{
+		int t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
 AUD_JOSResampleReader::AUD_JOSResampleReader(boost::shared_ptr<AUD_IReader> reader, AUD_Specs specs) :
 	AUD_ResampleReader(reader, specs.rate),
 	m_channels(AUD_CHANNELS_INVALID),
 	m_n(0),
 	m_P(0),
 	m_cache_valid(0),
-	m_last_factor(0)
+	m_last_factor(0),
+	m_polyphase(true),
+	m_table_source_rate(0),
+	m_table_target_rate(0)
+{
+}
+
+void AUD_JOSResampleReader::setPolyphase(bool polyphase)
+{
+	m_polyphase = polyphase;
+}
+
+bool AUD_JOSResampleReader::updateTable(double rate)
+{
+	if(rate == m_table_source_rate && m_rate == m_table_target_rate)
+		return m_table.get();
+
+	m_table_source_rate = rate;
+	m_table_target_rate = m_rate;
+	m_table.reset();
+
+	// only integer rates give a short phase cycle
+	int source = int(rate);
+	int target = int(m_rate);
+
+	if(source <= 0 || target <= 0 || source != rate || target != m_rate)
+		return false;
+
+	int gcd = AUD_gcd(source, target);
+	int phases = target / gcd;
+	int step = source / gcd;
+
+	if(phases > AUD_POLYPHASE_MAX_PHASES)
+		return false;
+
+	// for downsampling the filter is stretched to lower the cutoff
+	double factor = AUD_MIN(double(target) / double(source), 1.0);
+	int width = int(ceil(double(m_len) / double(m_L) / factor));
+	width = (width + 3) & ~3;
+
+	if(phases * 2 * width > AUD_POLYPHASE_MAX_SIZE)
+		return false;
+
+	std::pair<int, int> key(phases, step);
+
+	pthread_mutex_lock(&polyphase_mutex);
+
+	AUD_JOSPolyphaseCache::iterator it = polyphase_cache.find(key);
+
+	if(it != polyphase_cache.end())
+		m_table = it->second;
+	else
+	{
+		m_table = boost::shared_ptr<AUD_JOSPolyphaseTable>(new AUD_JOSPolyphaseTable);
+		m_table->phases = phases;
+		m_table->step = step;
+		m_table->width = width;
+		m_table->coeff.assureSize(phases * 2 * width * sizeof(float));
+
+		float* coeff = m_table->coeff.getBuffer();
+
+		for(int k = 0; k < phases; k++)
+		{
+			double P = double(k) / double(phases);
+
+			for(int i = 0; i < width; i++)
+			{
+				// left wing for sample n - i, right wing for sample n + 1 + i
+				double x[2] = {P + i, 1.0 - P + i};
+				float* c[2] = {coeff + width - 1 - i, coeff + width + i};
+
+				for(int w = 0; w < 2; w++)
+				{
+					double pos = x[w] * factor * m_L;
+					int l = int(pos);
+					double eta = pos - l;
+
+					if(l + 1 < m_len)
+						*c[w] = factor * (m_coeff[l] + eta * (m_coeff[l + 1] - m_coeff[l]));
+					else
+						*c[w] = 0;
+				}
+			}
+
+			coeff += 2 * width;
+		}
+
+		polyphase_cache[key] = m_table;
+	}
+
+	pthread_mutex_unlock(&polyphase_mutex);
+
+	return true;
+}
+
+void AUD_JOSResampleReader::updateHistory(int samplesize)
 {
+	int missing = m_table->width - 1 - int(m_n);
+
+	if(missing <= 0)
+		return;
+
+	m_buffer.assureSize((m_cache_valid + missing) * samplesize, true);
+	sample_t* buf = m_buffer.getBuffer();
+	memmove(buf + missing * m_channels, buf, m_cache_valid * samplesize);
+	memset(buf, 0, missing * samplesize);
+	m_n += missing;
+	m_cache_valid += missing;
 }
 
 void AUD_JOSResampleReader::reset()
@@ -103,6 +252,10 @@ void AUD_JOSResampleReader::updateBuffer(int size, double factor, int samplesize
 	if(len + size < num_samples * AUD_RATE_MAX)
 		len = num_samples * AUD_RATE_MAX - size;
 
+	// the filter bank window has to stay complete
+	if(m_table.get() && len < (unsigned int)m_table->width)
+		len = m_table->width;
+
 	if(m_n > len)
 	{
 		sample_t* buf = m_buffer.getBuffer();
@@ -303,6 +456,91 @@ AUD_Specs AUD_JOSResampleReader::getSpecs() const
 	return specs;
 }
 
+void AUD_JOSResampleReader::resample_polyphase(int length, sample_t* buffer)
+{
+	const int phases = m_table->phases;
+	const int step = m_table->step;
+	const int width = m_table->width;
+	const float* coeff = m_table->coeff.getBuffer();
+	sample_t* buf = m_buffer.getBuffer();
+
+	int phase = lrint(m_P * phases);
+	if(phase >= phases)
+	{
+		phase -= phases;
+		m_n++;
+	}
+
+	for(int t = 0; t < length; t++)
+	{
+		const float* c = coeff + phase * 2 * width;
+		const sample_t* data = buf + (int(m_n) + 1 - width) * m_channels;
+		int j = 0;
+
+		switch(m_channels)
+		{
+		case AUD_CHANNELS_MONO:
+		{
+			float sum = 0;
+#ifdef __SSE2__
+			__m128 acc = _mm_setzero_ps();
+			for(; j < 2 * width; j += 4)
+				acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(data + j), _mm_load_ps(c + j)));
+			acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+			acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+			sum = _mm_cvtss_f32(acc);
+#endif
+			for(; j < 2 * width; j++)
+				sum += data[j] * c[j];
+			*buffer++ = sum;
+			break;
+		}
+		case AUD_CHANNELS_STEREO:
+		{
+			float left = 0, right = 0;
+#ifdef __SSE2__
+			__m128 acc0 = _mm_setzero_ps();
+			__m128 acc1 = _mm_setzero_ps();
+			for(; j < 2 * width; j += 4)
+			{
+				// the coefficients duplicated for the interleaved channels
+				const __m128 cc = _mm_load_ps(c + j);
+				acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(data + j * 2), _mm_unpacklo_ps(cc, cc)));
+				acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(data + j * 2 + 4), _mm_unpackhi_ps(cc, cc)));
+			}
+			acc0 = _mm_add_ps(acc0, acc1);
+			acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+			left = _mm_cvtss_f32(acc0);
+			right = _mm_cvtss_f32(_mm_shuffle_ps(acc0, acc0, 1));
+#endif
+			for(; j < 2 * width; j++)
+			{
+				left += data[j * 2] * c[j];
+				right += data[j * 2 + 1] * c[j];
+			}
+			*buffer++ = left;
+			*buffer++ = right;
+			break;
+		}
+		default:
+			for(int channel = 0; channel < m_channels; channel++)
+			{
+				float sum = 0;
+				for(j = 0; j < 2 * width; j++)
+					sum += data[j * m_channels + channel] * c[j];
+				*buffer++ = sum;
+			}
+			break;
+		}
+
+		phase += step;
+		m_n += phase / phases;
+		phase %= phases;
+	}
+
+	m_P = double(phase) / double(phases);
+}
+
 void AUD_JOSResampleReader::read(int& length, bool& eos, sample_t* buffer)
 {
 	if(length == 0)
@@ -365,7 +603,16 @@ void AUD_JOSResampleReader::read(int& length, bool& eos, sample_t* buffer)
 	// use minimum for the following calculations
 	double factor = AUD_MIN(target_factor, m_last_factor);
 
-	if(factor >= 1)
+	bool polyphase = m_polyphase && target_factor == m_last_factor && updateTable(specs.rate);
+	int margin = 0;
+
+	if(polyphase)
+	{
+		updateHistory(samplesize);
+		margin = m_table->width;
+		len = (int(m_n) - m_cache_valid) + int(ceil(length / factor)) + margin + 1;
+	}
+	else if(factor >= 1)
 		len = (int(m_n) - m_cache_valid) + int(ceil(length / factor)) + ceil(num_samples);
 	else
 		len = (int(m_n) - m_cache_valid) + int(ceil(length / factor) + ceil(num_samples / factor));
@@ -374,12 +621,27 @@ void AUD_JOSResampleReader::read(int& length, bool& eos, sample_t* buffer)
 	{
 		int should = len;
 
-		updateBuffer(len, factor, samplesize);
+		updateBuffer(len + margin, factor, samplesize);
 
 		m_reader->read(len, eos, m_buffer.getBuffer() + m_cache_valid * m_channels);
 		m_cache_valid += len;
 
-		if(len < should)
+		// the filter bank reads its whole window, missing samples are zero
+		if(polyphase)
+			memset(m_buffer.getBuffer() + m_cache_valid * m_channels, 0, (should - len + margin) * samplesize);
+
+		if(len < should && polyphase)
+		{
+			if(len == 0 && eos)
+				length = 0;
+			else
+			{
+				len = floor((m_cache_valid - m_n) * factor);
+				if(len < length)
+					length = AUD_MAX(len, 0);
+			}
+		}
+		else if(len < should)
 		{
 			if(len == 0 && eos)
 				length = 0;
@@ -409,7 +671,10 @@ void AUD_JOSResampleReader::read(int& length, bool& eos, sample_t* buffer)
 		}
 	}
 
-	(this->*m_resample)(target_factor, length, buffer);
+	if(polyphase)
+		resample_polyphase(length, buffer);
+	else
+		(this->*m_resample)(target_factor, length, buffer);
 
 	m_last_factor = target_factor;
 
@@ -33,6 +33,10 @@
 #include "AUD_ResampleReader.h"
 #include "AUD_Buffer.h"
 
+#include <boost/shared_ptr.hpp>
+
+struct AUD_JOSPolyphaseTable;
+
 /**
  * This resampling reader uses Julius O. Smith's resampling algorithm.
  */
@@ -96,6 +100,22 @@ private:
 	 */
 	double m_last_factor;
 
+	/**
+	 * Whether constant rational ratios use a precomputed filter bank.
+	 */
+	bool m_polyphase;
+
+	/**
+	 * The filter bank of the current ratio, empty if it has none.
+	 */
+	boost::shared_ptr<AUD_JOSPolyphaseTable> m_table;
+
+	/**
+	 * The source and target rate m_table was looked up for.
+	 */
+	double m_table_source_rate;
+	double m_table_target_rate;
+
 	// hide copy constructor and operator=
 	AUD_JOSResampleReader(const AUD_JOSResampleReader&);
 	AUD_JOSResampleReader& operator=(const AUD_JOSResampleReader&);
@@ -117,6 +137,25 @@ private:
 	void resample_mono(double target_factor, int length, sample_t* buffer);
 	void resample_stereo(double target_factor, int length, sample_t* buffer);
 
+	/**
+	 * Looks up the filter bank for the current rates.
+	 * \param rate The source sample rate.
+	 * \return Whether there is a filter bank for the rates.
+	 */
+	bool updateTable(double rate);
+
+	/**
+	 * Makes sure the whole filter window of the current sample is in the
+	 * cache, missing history is zero like with the truncated filter.
+	 * \param samplesize The size of a sample.
+	 */
+	void updateHistory(int samplesize);
+
+	/**
+	 * Resamples with the filter bank at a constant ratio.
+	 */
+	void resample_polyphase(int length, sample_t* buffer);
+
 public:
 	/**
 	 * Creates a resampling reader.
@@ -125,6 +164,14 @@ public:
 	 */
 	AUD_JOSResampleReader(boost::shared_ptr<AUD_IReader> reader, AUD_Specs specs);
 
+	/**
+	 * Sets whether a precomputed polyphase filter bank is used while the
+	 * ratio between the rates is constant and rational, which is much faster
+	 * than interpolating the filter for every sample. It's on by default.
+	 * \param polyphase Whether to use the filter bank.
+	 */
+	void setPolyphase(bool polyphase);
+
 	virtual void seek(int position);
 	virtual int getLength() const;
 	virtual int getPosition() const;
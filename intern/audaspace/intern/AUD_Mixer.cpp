@@ -32,6 +32,10 @@
 
 #include <cstring>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 AUD_Mixer::AUD_Mixer(AUD_DeviceSpecs specs) :
 	m_specs(specs)
 {
@@ -91,31 +95,100 @@ void AUD_Mixer::mix(sample_t* buffer, int start, int length, float volume)
 	length = (AUD_MIN(m_length, length + start) - start) * m_specs.channels;
 	start *= m_specs.channels;
 
-	for(int i = 0; i < length; i++)
-		out[i + start] += buffer[i] * volume;
+	out += start;
+
+	int i = 0;
+
+#ifdef __SSE2__
+	const __m128 vol = _mm_set1_ps(volume);
+
+	for(; i + 4 <= length; i += 4)
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(buffer + i), vol)));
+#endif
+
+	for(; i < length; i++)
+		out[i] += buffer[i] * volume;
 }
 
 void AUD_Mixer::mix(sample_t* buffer, int start, int length, float volume_to, float volume_from)
 {
+	if(volume_to == volume_from)
+	{
+		mix(buffer, start, length, volume_to);
+		return;
+	}
+
 	sample_t* out = m_buffer.getBuffer();
+	const int channels = m_specs.channels;
 
 	length = (std::min(m_length, length + start) - start);
 
-	for(int i = 0; i < length; i++)
+	if(length <= 0)
+		return;
+
+	out += start * channels;
+
+	// the volume of frame i is volume_from + i * step
+	const float step = (volume_to - volume_from) / float(length);
+
+	int i = 0;
+
+#ifdef __SSE2__
+	// four samples per vector, they span four, two or one frame(s)
+	if(channels == 1 || channels == 2 || channels == 4)
+	{
+		const int frames = 4 / channels;
+		__m128 frame;
+
+		if(channels == 1)
+			frame = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+		else if(channels == 2)
+			frame = _mm_set_ps(1.0f, 1.0f, 0.0f, 0.0f);
+		else
+			frame = _mm_setzero_ps();
+
+		const __m128 from = _mm_set1_ps(volume_from);
+		const __m128 vstep = _mm_set1_ps(step);
+		const __m128 advance = _mm_set1_ps(float(frames));
+
+		for(; i + frames <= length; i += frames)
+		{
+			const __m128 vol = _mm_add_ps(from, _mm_mul_ps(frame, vstep));
+			float* o = out + i * channels;
+			_mm_storeu_ps(o, _mm_add_ps(_mm_loadu_ps(o), _mm_mul_ps(_mm_loadu_ps(buffer + i * channels), vol)));
+			frame = _mm_add_ps(frame, advance);
+		}
+	}
+#endif
+
+	for(; i < length; i++)
 	{
-		float volume = volume_from * (1.0f - i / float(length)) + volume_to * (i / float(length));
+		float volume = volume_from + i * step;
 
-		for(int c = 0; c < m_specs.channels; c++)
-			out[(i + start) * m_specs.channels + c] += buffer[i * m_specs.channels + c] * volume;
+		for(int c = 0; c < channels; c++)
+			out[i * channels + c] += buffer[i * channels + c] * volume;
 	}
 }
 
 void AUD_Mixer::read(data_t* buffer, float volume)
 {
 	sample_t* out = m_buffer.getBuffer();
+	const int length = m_length * m_specs.channels;
 
-	for(int i = 0; i < m_length * m_specs.channels; i++)
-		out[i] *= volume;
+	if(volume != 1.0f)
+	{
+		int i = 0;
+
+#ifdef __SSE2__
+		const __m128 vol = _mm_set1_ps(volume);
+
+		for(; i + 4 <= length; i += 4)
+			_mm_store_ps(out + i, _mm_mul_ps(_mm_load_ps(out + i), vol));
+#endif
+
+		for(; i < length; i++)
+			out[i] *= volume;
+	}
 
-	m_convert(buffer, (data_t*) out, m_length * m_specs.channels);
+	m_convert(buffer, (data_t*) out, length);
 }
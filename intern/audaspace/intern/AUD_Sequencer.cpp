@@ -175,3 +175,20 @@ void AUD_Sequencer::remove(boost::shared_ptr<AUD_SequencerEntry> entry)
 	m_entries.remove(entry);
 	m_entry_status++;
 }
+
+bool AUD_Sequencer::isResampled()
+{
+	AUD_MutexLock lock(*this);
+
+	// a moving listener causes doppler effects
+	if(m_location.isAnimated())
+		return true;
+
+	for(std::list<boost::shared_ptr<AUD_SequencerEntry> >::iterator it = m_entries.begin(); it != m_entries.end(); it++)
+	{
+		if((*it)->isResampled(m_specs.rate))
+			return true;
+	}
+
+	return false;
+}
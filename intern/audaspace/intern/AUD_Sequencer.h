@@ -201,6 +201,14 @@ public:
 	 * \param entry The entry to remove.
 	 */
 	void remove(boost::shared_ptr<AUD_SequencerEntry> entry);
+
+	/**
+	 * Checks whether any entry is resampled while the scene is mixed.
+	 * Resamplers start over when they are seeked, so a resampled mix only
+	 * gives the same samples when it is read through from the start.
+	 * \return Whether any entry is resampled.
+	 */
+	bool isResampled();
 };
 
 #endif //__AUD_SEQUENCER_H__
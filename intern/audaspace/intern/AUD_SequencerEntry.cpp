@@ -317,3 +317,30 @@ void AUD_SequencerEntry::setConeVolumeOuter(float volume)
 	m_cone_volume_outer = volume;
 	m_status++;
 }
+
+bool AUD_SequencerEntry::isResampled(AUD_SampleRate rate)
+{
+	AUD_MutexLock lock(*this);
+
+	if(m_pitch.isAnimated() || m_location.isAnimated())
+		return true;
+
+	float pitch;
+	m_pitch.read(0, &pitch);
+
+	if(pitch != 1.0f)
+		return true;
+
+	if(!m_sound.get())
+		return false;
+
+	try
+	{
+		return m_sound->createReader()->getSpecs().rate != rate;
+	}
+	catch(AUD_Exception&)
+	{
+		// the sound can't be played either
+		return false;
+	}
+}
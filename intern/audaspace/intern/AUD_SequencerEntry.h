@@ -314,6 +314,14 @@ public:
 	 * \return Whether the action succeeded.
 	 */
 	void setConeVolumeOuter(float volume);
+
+	/**
+	 * Checks whether the sound is resampled while it's mixed, because of its
+	 * sample rate, its pitch or the doppler effect of its movement.
+	 * \param rate The sample rate the sound is mixed at.
+	 * \return Whether the sound is resampled.
+	 */
+	bool isResampled(AUD_SampleRate rate);
 };
 
 #endif //__AUD_SEQUENCERENTRY_H__
@@ -112,6 +112,11 @@ void AUD_SequencerFactory::remove(boost::shared_ptr<AUD_SequencerEntry> entry)
 	m_sequence->remove(entry);
 }
 
+bool AUD_SequencerFactory::isResampled()
+{
+	return m_sequence->isResampled();
+}
+
 boost::shared_ptr<AUD_IReader> AUD_SequencerFactory::createQualityReader()
 {
 	return boost::shared_ptr<AUD_IReader>(new AUD_SequencerReader(m_sequence, true));
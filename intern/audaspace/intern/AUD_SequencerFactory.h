@@ -165,6 +165,12 @@ public:
 	 */
 	void remove(boost::shared_ptr<AUD_SequencerEntry> entry);
 
+	/**
+	 * Checks whether any entry is resampled while the scene is mixed.
+	 * \return Whether any entry is resampled.
+	 */
+	bool isResampled();
+
 	/**
 	 * Creates a new reader with high quality resampling.
 	 * \return The new reader.
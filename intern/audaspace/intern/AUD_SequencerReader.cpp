@@ -158,8 +158,7 @@ void AUD_SequencerReader::read(int& length, bool& eos, sample_t* buffer)
 
 	AUD_Specs specs = m_sequence->m_specs;
 	int pos = 0;
-	float time = float(m_position) / float(specs.rate);
-	float volume, frame;
+	float time, volume, frame;
 	int len, cfra;
 	AUD_Vector3 v, v2;
 	AUD_Quaternion q;
@@ -167,10 +166,13 @@ void AUD_SequencerReader::read(int& length, bool& eos, sample_t* buffer)
 
 	while(pos < length)
 	{
+		// derived from the absolute position instead of accumulated, so
+		// that reading after a seek gives the same times as reading through
+		time = float(double(m_position + pos) / specs.rate);
 		frame = time * m_sequence->m_fps;
 		cfra = int(floor(frame));
 
-		len = int(ceil((cfra + 1) / m_sequence->m_fps * specs.rate)) - m_position;
+		len = int(ceil((cfra + 1) / m_sequence->m_fps * specs.rate)) - (m_position + pos);
 		len = AUD_MIN(length - pos, len);
 		len = AUD_MAX(len, 1);
 
@@ -192,10 +194,13 @@ void AUD_SequencerReader::read(int& length, bool& eos, sample_t* buffer)
 		v2 -= v;
 		m_device.setListenerVelocity(v2 * m_sequence->m_fps);
 
+		// mixing only uses this reader's handles, so other readers of the
+		// sequence (e.g. parallel mixdown) don't have to wait for it
+		m_sequence->unlock();
 		m_device.read(reinterpret_cast<data_t*>(buffer + specs.channels * pos), len);
+		m_sequence->lock();
 
 		pos += len;
-		time += float(len) / float(specs.rate);
 	}
 
 	m_position += length;
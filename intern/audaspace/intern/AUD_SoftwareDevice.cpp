@@ -35,6 +35,8 @@
 #include "AUD_LinearResampleReader.h"
 #include "AUD_MutexLock.h"
 
+#include "atomic_ops.h"
+
 #include <cstring>
 #include <cmath>
 #include <limits>
@@ -89,11 +91,33 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::pause(bool keep)
 }
 
 AUD_SoftwareDevice::AUD_SoftwareHandle::AUD_SoftwareHandle(AUD_SoftwareDevice* device, boost::shared_ptr<AUD_IReader> reader, boost::shared_ptr<AUD_PitchReader> pitch, boost::shared_ptr<AUD_ResampleReader> resampler, boost::shared_ptr<AUD_ChannelMapperReader> mapper, bool keep) :
-	m_reader(reader), m_pitch(pitch), m_resampler(resampler), m_mapper(mapper), m_keep(keep), m_user_pitch(1.0f), m_user_volume(1.0f), m_user_pan(0.0f), m_volume(1.0f), m_old_volume(1.0f), m_loopcount(0),
-	m_relative(true), m_volume_max(1.0f), m_volume_min(0), m_distance_max(std::numeric_limits<float>::max()),
-	m_distance_reference(1.0f), m_attenuation(1.0f), m_cone_angle_outer(M_PI), m_cone_angle_inner(M_PI), m_cone_volume_outer(0),
-	m_flags(AUD_RENDER_CONE), m_stop(NULL), m_stop_data(NULL), m_status(AUD_STATUS_PLAYING), m_device(device)
+	m_reader(reader), m_pitch(pitch), m_resampler(resampler), m_mapper(mapper), m_keep(keep), m_volume(1.0f), m_old_volume(1.0f), m_loopcount(0),
+	m_stop(NULL), m_stop_data(NULL), m_status(AUD_STATUS_PLAYING), m_device(device)
 {
+	m_parameters.pitch = 1.0f;
+	m_parameters.volume = 1.0f;
+	m_parameters.pan = 0.0f;
+	m_parameters.relative = true;
+	m_parameters.volume_max = 1.0f;
+	m_parameters.volume_min = 0;
+	m_parameters.distance_max = std::numeric_limits<float>::max();
+	m_parameters.distance_reference = 1.0f;
+	m_parameters.attenuation = 1.0f;
+	m_parameters.cone_angle_outer = M_PI;
+	m_parameters.cone_angle_inner = M_PI;
+	m_parameters.cone_volume_outer = 0;
+	m_parameters.flags = AUD_RENDER_CONE;
+
+	m_mixing = m_parameters;
+}
+
+void AUD_SoftwareDevice::AUD_SoftwareHandle::commit()
+{
+	AUD_HandleCommand command;
+	command.handle = shared_from_this();
+	command.parameters = m_parameters;
+
+	m_device->pushCommand(command);
 }
 
 void AUD_SoftwareDevice::AUD_SoftwareHandle::update()
@@ -103,10 +127,10 @@ void AUD_SoftwareDevice::AUD_SoftwareHandle::update()
 	m_old_volume = m_volume;
 
 	AUD_Vector3 SL;
-	if(m_relative)
-		SL = -m_location;
+	if(m_mixing.relative)
+		SL = -m_mixing.location;
 	else
-		SL = m_device->m_location - m_location;
+		SL = m_device->m_mixing.location - m_mixing.location;
 	float distance = SL * SL;
 
 	if(distance > 0)
@@ -116,24 +140,24 @@ void AUD_SoftwareDevice::AUD_SoftwareHandle::update()
 
 	if(m_pitch->getSpecs().channels != AUD_CHANNELS_MONO)
 	{
-		m_volume = m_user_volume;
-		m_pitch->setPitch(m_user_pitch);
+		m_volume = m_mixing.volume;
+		m_pitch->setPitch(m_mixing.pitch);
 		return;
 	}
 
-	flags = ~(flags | m_flags | m_device->m_flags);
+	flags = ~(flags | m_mixing.flags | m_device->m_mixing.flags);
 
 	// Doppler and Pitch
 
 	if(flags & AUD_RENDER_DOPPLER)
 	{
 		float vls;
-		if(m_relative)
+		if(m_mixing.relative)
 			vls = 0;
 		else
-			vls = SL * m_device->m_velocity / distance;
-		float vss = SL * m_velocity / distance;
-		float max = m_device->m_speed_of_sound / m_device->m_doppler_factor;
+			vls = SL * m_device->m_mixing.velocity / distance;
+		float vss = SL * m_mixing.velocity / distance;
+		float max = m_device->m_mixing.speed_of_sound / m_device->m_mixing.doppler_factor;
 		if(vss >= max)
 		{
 			m_pitch->setPitch(AUD_PITCH_MAX);
@@ -143,11 +167,11 @@ void AUD_SoftwareDevice::AUD_SoftwareHandle::update()
 			if(vls > max)
 				vls = max;
 
-			m_pitch->setPitch((m_device->m_speed_of_sound - m_device->m_doppler_factor * vls) / (m_device->m_speed_of_sound - m_device->m_doppler_factor * vss) * m_user_pitch);
+			m_pitch->setPitch((m_device->m_mixing.speed_of_sound - m_device->m_mixing.doppler_factor * vls) / (m_device->m_mixing.speed_of_sound - m_device->m_mixing.doppler_factor * vss) * m_mixing.pitch);
 		}
 	}
 	else
-		m_pitch->setPitch(m_user_pitch);
+		m_pitch->setPitch(m_mixing.pitch);
 
 	if(flags & AUD_RENDER_VOLUME)
 	{
@@ -155,40 +179,40 @@ void AUD_SoftwareDevice::AUD_SoftwareHandle::update()
 
 		if(flags & AUD_RENDER_DISTANCE)
 		{
-			if(m_device->m_distance_model == AUD_DISTANCE_MODEL_INVERSE_CLAMPED ||
-			   m_device->m_distance_model == AUD_DISTANCE_MODEL_LINEAR_CLAMPED ||
-			   m_device->m_distance_model == AUD_DISTANCE_MODEL_EXPONENT_CLAMPED)
+			if(m_device->m_mixing.distance_model == AUD_DISTANCE_MODEL_INVERSE_CLAMPED ||
+			   m_device->m_mixing.distance_model == AUD_DISTANCE_MODEL_LINEAR_CLAMPED ||
+			   m_device->m_mixing.distance_model == AUD_DISTANCE_MODEL_EXPONENT_CLAMPED)
 			{
-				distance = AUD_MAX(AUD_MIN(m_distance_max, distance), m_distance_reference);
+				distance = AUD_MAX(AUD_MIN(m_mixing.distance_max, distance), m_mixing.distance_reference);
 			}
 
-			switch(m_device->m_distance_model)
+			switch(m_device->m_mixing.distance_model)
 			{
 			case AUD_DISTANCE_MODEL_INVERSE:
 			case AUD_DISTANCE_MODEL_INVERSE_CLAMPED:
-				m_volume = m_distance_reference / (m_distance_reference + m_attenuation * (distance - m_distance_reference));
+				m_volume = m_mixing.distance_reference / (m_mixing.distance_reference + m_mixing.attenuation * (distance - m_mixing.distance_reference));
 				break;
 			case AUD_DISTANCE_MODEL_LINEAR:
 			case AUD_DISTANCE_MODEL_LINEAR_CLAMPED:
 			{
-				float temp = m_distance_max - m_distance_reference;
+				float temp = m_mixing.distance_max - m_mixing.distance_reference;
 				if(temp == 0)
 				{
-					if(distance > m_distance_reference)
+					if(distance > m_mixing.distance_reference)
 						m_volume = 0.0f;
 					else
 						m_volume = 1.0f;
 				}
 				else
-					m_volume = 1.0f - m_attenuation * (distance - m_distance_reference) / (m_distance_max - m_distance_reference);
+					m_volume = 1.0f - m_mixing.attenuation * (distance - m_mixing.distance_reference) / (m_mixing.distance_max - m_mixing.distance_reference);
 				break;
 			}
 			case AUD_DISTANCE_MODEL_EXPONENT:
 			case AUD_DISTANCE_MODEL_EXPONENT_CLAMPED:
-				if(m_distance_reference == 0)
+				if(m_mixing.distance_reference == 0)
 					m_volume = 0;
 				else
-					m_volume = pow(distance / m_distance_reference, -m_attenuation);
+					m_volume = pow(distance / m_mixing.distance_reference, -m_mixing.attenuation);
 				break;
 			default:
 				m_volume = 1.0f;
@@ -201,36 +225,36 @@ void AUD_SoftwareDevice::AUD_SoftwareHandle::update()
 
 		if(flags & AUD_RENDER_CONE)
 		{
-			AUD_Vector3 SZ = m_orientation.getLookAt();
+			AUD_Vector3 SZ = m_mixing.orientation.getLookAt();
 
 			float phi = acos(float(SZ * SL / (SZ.length() * SL.length())));
-			float t = (phi - m_cone_angle_inner)/(m_cone_angle_outer - m_cone_angle_inner);
+			float t = (phi - m_mixing.cone_angle_inner)/(m_mixing.cone_angle_outer - m_mixing.cone_angle_inner);
 
 			if(t > 0)
 			{
 				if(t > 1)
-					m_volume *= m_cone_volume_outer;
+					m_volume *= m_mixing.cone_volume_outer;
 				else
-					m_volume *= 1 + t * (m_cone_volume_outer - 1);
+					m_volume *= 1 + t * (m_mixing.cone_volume_outer - 1);
 			}
 		}
 
-		if(m_volume > m_volume_max)
-			m_volume = m_volume_max;
-		else if(m_volume < m_volume_min)
-			m_volume = m_volume_min;
+		if(m_volume > m_mixing.volume_max)
+			m_volume = m_mixing.volume_max;
+		else if(m_volume < m_mixing.volume_min)
+			m_volume = m_mixing.volume_min;
 
 		// Volume
 
-		m_volume *= m_user_volume;
+		m_volume *= m_mixing.volume;
 	}
 
 	// 3D Cue
 
 	AUD_Quaternion orientation;
 
-	if(!m_relative)
-		orientation = m_device->m_orientation;
+	if(!m_mixing.relative)
+		orientation = m_device->m_mixing.orientation;
 
 	AUD_Vector3 Z = orientation.getLookAt();
 	AUD_Vector3 N = orientation.getUp();
@@ -247,7 +271,7 @@ void AUD_SoftwareDevice::AUD_SoftwareHandle::update()
 		m_mapper->setMonoAngle(phi);
 	}
 	else
-		m_mapper->setMonoAngle(m_relative ? m_user_pan * M_PI / 2.0 : 0);
+		m_mapper->setMonoAngle(m_mixing.relative ? m_mixing.pan * M_PI / 2.0 : 0);
 }
 
 void AUD_SoftwareDevice::AUD_SoftwareHandle::setSpecs(AUD_Specs specs)
@@ -365,7 +389,8 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::seek(float position)
 	if(!m_status)
 		return false;
 
-	m_reader->seek((int)(position * m_reader->getSpecs().rate));
+	// rounded, the position in seconds is rarely exact
+	m_reader->seek((int)floor(position * m_reader->getSpecs().rate + 0.5));
 
 	if(m_status == AUD_STATUS_STOPPED)
 		m_status = AUD_STATUS_PAUSED;
@@ -395,29 +420,28 @@ AUD_Status AUD_SoftwareDevice::AUD_SoftwareHandle::getStatus()
 
 float AUD_SoftwareDevice::AUD_SoftwareHandle::getVolume()
 {
-	return m_user_volume;
+	return m_parameters.volume;
 }
 
 bool AUD_SoftwareDevice::AUD_SoftwareHandle::setVolume(float volume)
 {
 	if(!m_status)
 		return false;
-	m_user_volume = volume;
+	m_parameters.volume = volume;
 
 	if(volume == 0)
-	{
-		m_old_volume = m_volume = volume;
-		m_flags |= AUD_RENDER_VOLUME;
-	}
+		m_parameters.flags |= AUD_RENDER_VOLUME;
 	else
-		m_flags &= ~AUD_RENDER_VOLUME;
+		m_parameters.flags &= ~AUD_RENDER_VOLUME;
+
+	commit();
 
 	return true;
 }
 
 float AUD_SoftwareDevice::AUD_SoftwareHandle::getPitch()
 {
-	return m_user_pitch;
+	return m_parameters.pitch;
 }
 
 bool AUD_SoftwareDevice::AUD_SoftwareHandle::setPitch(float pitch)
@@ -426,7 +450,10 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::setPitch(float pitch)
 		return false;
 	if(pitch <= 0)
 		pitch = 1;
-	m_user_pitch = pitch;
+	m_parameters.pitch = pitch;
+
+	commit();
+
 	return true;
 }
 
@@ -477,7 +504,7 @@ AUD_Vector3 AUD_SoftwareDevice::AUD_SoftwareHandle::getSourceLocation()
 	if(!m_status)
 		return AUD_Vector3();
 
-	return m_location;
+	return m_parameters.location;
 }
 
 bool AUD_SoftwareDevice::AUD_SoftwareHandle::setSourceLocation(const AUD_Vector3& location)
@@ -485,7 +512,9 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::setSourceLocation(const AUD_Vector3
 	if(!m_status)
 		return false;
 
-	m_location = location;
+	m_parameters.location = location;
+
+	commit();
 
 	return true;
 }
@@ -495,7 +524,7 @@ AUD_Vector3 AUD_SoftwareDevice::AUD_SoftwareHandle::getSourceVelocity()
 	if(!m_status)
 		return AUD_Vector3();
 
-	return m_velocity;
+	return m_parameters.velocity;
 }
 
 bool AUD_SoftwareDevice::AUD_SoftwareHandle::setSourceVelocity(const AUD_Vector3& velocity)
@@ -503,7 +532,9 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::setSourceVelocity(const AUD_Vector3
 	if(!m_status)
 		return false;
 
-	m_velocity = velocity;
+	m_parameters.velocity = velocity;
+
+	commit();
 
 	return true;
 }
@@ -513,7 +544,7 @@ AUD_Quaternion AUD_SoftwareDevice::AUD_SoftwareHandle::getSourceOrientation()
 	if(!m_status)
 		return AUD_Quaternion();
 
-	return m_orientation;
+	return m_parameters.orientation;
 }
 
 bool AUD_SoftwareDevice::AUD_SoftwareHandle::setSourceOrientation(const AUD_Quaternion& orientation)
@@ -521,7 +552,9 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::setSourceOrientation(const AUD_Quat
 	if(!m_status)
 		return false;
 
-	m_orientation = orientation;
+	m_parameters.orientation = orientation;
+
+	commit();
 
 	return true;
 }
@@ -531,7 +564,7 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::isRelative()
 	if(!m_status)
 		return false;
 
-	return m_relative;
+	return m_parameters.relative;
 }
 
 bool AUD_SoftwareDevice::AUD_SoftwareHandle::setRelative(bool relative)
@@ -539,7 +572,9 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::setRelative(bool relative)
 	if(!m_status)
 		return false;
 
-	m_relative = relative;
+	m_parameters.relative = relative;
+
+	commit();
 
 	return true;
 }
@@ -549,7 +584,7 @@ float AUD_SoftwareDevice::AUD_SoftwareHandle::getVolumeMaximum()
 	if(!m_status)
 		return std::numeric_limits<float>::quiet_NaN();
 
-	return m_volume_max;
+	return m_parameters.volume_max;
 }
 
 bool AUD_SoftwareDevice::AUD_SoftwareHandle::setVolumeMaximum(float volume)
@@ -557,7 +592,9 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::setVolumeMaximum(float volume)
 	if(!m_status)
 		return false;
 
-	m_volume_max = volume;
+	m_parameters.volume_max = volume;
+
+	commit();
 
 	return true;
 }
@@ -567,7 +604,7 @@ float AUD_SoftwareDevice::AUD_SoftwareHandle::getVolumeMinimum()
 	if(!m_status)
 		return std::numeric_limits<float>::quiet_NaN();
 
-	return m_volume_min;
+	return m_parameters.volume_min;
 }
 
 bool AUD_SoftwareDevice::AUD_SoftwareHandle::setVolumeMinimum(float volume)
@@ -575,7 +612,9 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::setVolumeMinimum(float volume)
 	if(!m_status)
 		return false;
 
-	m_volume_min = volume;
+	m_parameters.volume_min = volume;
+
+	commit();
 
 	return true;
 }
@@ -585,7 +624,7 @@ float AUD_SoftwareDevice::AUD_SoftwareHandle::getDistanceMaximum()
 	if(!m_status)
 		return std::numeric_limits<float>::quiet_NaN();
 
-	return m_distance_max;
+	return m_parameters.distance_max;
 }
 
 bool AUD_SoftwareDevice::AUD_SoftwareHandle::setDistanceMaximum(float distance)
@@ -593,7 +632,9 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::setDistanceMaximum(float distance)
 	if(!m_status)
 		return false;
 
-	m_distance_max = distance;
+	m_parameters.distance_max = distance;
+
+	commit();
 
 	return true;
 }
@@ -603,7 +644,7 @@ float AUD_SoftwareDevice::AUD_SoftwareHandle::getDistanceReference()
 	if(!m_status)
 		return std::numeric_limits<float>::quiet_NaN();
 
-	return m_distance_reference;
+	return m_parameters.distance_reference;
 }
 
 bool AUD_SoftwareDevice::AUD_SoftwareHandle::setDistanceReference(float distance)
@@ -611,7 +652,9 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::setDistanceReference(float distance
 	if(!m_status)
 		return false;
 
-	m_distance_reference = distance;
+	m_parameters.distance_reference = distance;
+
+	commit();
 
 	return true;
 }
@@ -621,7 +664,7 @@ float AUD_SoftwareDevice::AUD_SoftwareHandle::getAttenuation()
 	if(!m_status)
 		return std::numeric_limits<float>::quiet_NaN();
 
-	return m_attenuation;
+	return m_parameters.attenuation;
 }
 
 bool AUD_SoftwareDevice::AUD_SoftwareHandle::setAttenuation(float factor)
@@ -629,12 +672,14 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::setAttenuation(float factor)
 	if(!m_status)
 		return false;
 
-	m_attenuation = factor;
+	m_parameters.attenuation = factor;
 
 	if(factor == 0)
-		m_flags |= AUD_RENDER_DISTANCE;
+		m_parameters.flags |= AUD_RENDER_DISTANCE;
 	else
-		m_flags &= ~AUD_RENDER_DISTANCE;
+		m_parameters.flags &= ~AUD_RENDER_DISTANCE;
+
+	commit();
 
 	return true;
 }
@@ -644,7 +689,7 @@ float AUD_SoftwareDevice::AUD_SoftwareHandle::getConeAngleOuter()
 	if(!m_status)
 		return std::numeric_limits<float>::quiet_NaN();
 
-	return m_cone_angle_outer * 360.0f / M_PI;
+	return m_parameters.cone_angle_outer * 360.0f / M_PI;
 }
 
 bool AUD_SoftwareDevice::AUD_SoftwareHandle::setConeAngleOuter(float angle)
@@ -652,7 +697,9 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::setConeAngleOuter(float angle)
 	if(!m_status)
 		return false;
 
-	m_cone_angle_outer = angle * M_PI / 360.0f;
+	m_parameters.cone_angle_outer = angle * M_PI / 360.0f;
+
+	commit();
 
 	return true;
 }
@@ -662,7 +709,7 @@ float AUD_SoftwareDevice::AUD_SoftwareHandle::getConeAngleInner()
 	if(!m_status)
 		return std::numeric_limits<float>::quiet_NaN();
 
-	return m_cone_angle_inner * 360.0f / M_PI;
+	return m_parameters.cone_angle_inner * 360.0f / M_PI;
 }
 
 bool AUD_SoftwareDevice::AUD_SoftwareHandle::setConeAngleInner(float angle)
@@ -671,11 +718,13 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::setConeAngleInner(float angle)
 		return false;
 
 	if(angle >= 360)
-		m_flags |= AUD_RENDER_CONE;
+		m_parameters.flags |= AUD_RENDER_CONE;
 	else
-		m_flags &= ~AUD_RENDER_CONE;
+		m_parameters.flags &= ~AUD_RENDER_CONE;
 
-	m_cone_angle_inner = angle * M_PI / 360.0f;
+	m_parameters.cone_angle_inner = angle * M_PI / 360.0f;
+
+	commit();
 
 	return true;
 }
@@ -685,7 +734,7 @@ float AUD_SoftwareDevice::AUD_SoftwareHandle::getConeVolumeOuter()
 	if(!m_status)
 		return std::numeric_limits<float>::quiet_NaN();
 
-	return m_cone_volume_outer;
+	return m_parameters.cone_volume_outer;
 }
 
 bool AUD_SoftwareDevice::AUD_SoftwareHandle::setConeVolumeOuter(float volume)
@@ -693,7 +742,9 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::setConeVolumeOuter(float volume)
 	if(!m_status)
 		return false;
 
-	m_cone_volume_outer = volume;
+	m_parameters.cone_volume_outer = volume;
+
+	commit();
 
 	return true;
 }
@@ -705,13 +756,18 @@ bool AUD_SoftwareDevice::AUD_SoftwareHandle::setConeVolumeOuter(float volume)
 void AUD_SoftwareDevice::create()
 {
 	m_playback = false;
-	m_volume = 1.0f;
 	m_mixer = boost::shared_ptr<AUD_Mixer>(new AUD_Mixer(m_specs));
-	m_speed_of_sound = 343.3f;
-	m_doppler_factor = 1.0f;
-	m_distance_model = AUD_DISTANCE_MODEL_INVERSE_CLAMPED;
-	m_flags = 0;
+	m_parameters.volume = 1.0f;
+	m_parameters.speed_of_sound = 343.3f;
+	m_parameters.doppler_factor = 1.0f;
+	m_parameters.distance_model = AUD_DISTANCE_MODEL_INVERSE_CLAMPED;
+	m_parameters.flags = 0;
+	m_mixing = m_parameters;
 	m_quality = false;
+	m_polyphase = true;
+	m_lock_waits = 0;
+
+	pthread_mutex_init(&m_command_mutex, NULL);
 
 	pthread_mutexattr_t attr;
 	pthread_mutexattr_init(&attr);
@@ -733,6 +789,10 @@ void AUD_SoftwareDevice::destroy()
 	while(!m_pausedSounds.empty())
 		m_pausedSounds.front()->stop();
 
+	// releases the handles still referenced by commands
+	applyCommands();
+
+	pthread_mutex_destroy(&m_command_mutex);
 	pthread_mutex_destroy(&m_mutex);
 }
 
@@ -740,9 +800,18 @@ void AUD_SoftwareDevice::mix(data_t* buffer, int length)
 {
 	m_buffer.assureSize(length * AUD_SAMPLE_SIZE(m_specs));
 
-	AUD_MutexLock lock(*this);
+	// count how often another thread holds the device while mixing
+	if(pthread_mutex_trylock(&m_mutex))
+		atomic_add_and_fetch_uint32(&m_lock_waits, 1);
+	else
+		pthread_mutex_unlock(&m_mutex);
 
 	{
+		AUD_MutexLock lock(*this);
+
+		// parameter changes take effect at buffer boundaries
+		applyCommands();
+
 		boost::shared_ptr<AUD_SoftwareDevice::AUD_SoftwareHandle> sound;
 		int len;
 		int pos;
@@ -807,7 +876,7 @@ void AUD_SoftwareDevice::mix(data_t* buffer, int length)
 		}
 
 		// superpose
-		m_mixer->read(buffer, m_volume);
+		m_mixer->read(buffer, m_mixing.volume);
 
 		// cleanup
 		for(it = pauseSounds.begin(); it != pauseSounds.end(); it++)
@@ -821,10 +890,67 @@ void AUD_SoftwareDevice::mix(data_t* buffer, int length)
 	}
 }
 
+void AUD_SoftwareDevice::pushCommand(const AUD_HandleCommand& command)
+{
+	pthread_mutex_lock(&m_command_mutex);
+	bool pushed = m_handle_commands.push(command);
+	pthread_mutex_unlock(&m_command_mutex);
+
+	if(pushed)
+		return;
+
+	// the mixing thread is behind, apply the queued changes ourselves
+	AUD_MutexLock lock(*this);
+
+	applyCommands();
+
+	pthread_mutex_lock(&m_command_mutex);
+	m_handle_commands.push(command);
+	pthread_mutex_unlock(&m_command_mutex);
+}
+
+void AUD_SoftwareDevice::commit()
+{
+	pthread_mutex_lock(&m_command_mutex);
+	bool pushed = m_listener_commands.push(m_parameters);
+	pthread_mutex_unlock(&m_command_mutex);
+
+	if(pushed)
+		return;
+
+	AUD_MutexLock lock(*this);
+
+	applyCommands();
+
+	pthread_mutex_lock(&m_command_mutex);
+	m_listener_commands.push(m_parameters);
+	pthread_mutex_unlock(&m_command_mutex);
+}
+
+void AUD_SoftwareDevice::applyCommands()
+{
+	AUD_HandleCommand command;
+
+	while(m_handle_commands.pop(command))
+	{
+		AUD_SoftwareHandle* handle = command.handle.get();
+
+		handle->m_mixing = command.parameters;
+
+		// muted sounds don't fade out
+		if(command.parameters.volume == 0)
+			handle->m_old_volume = handle->m_volume = 0;
+	}
+
+	// the device parameters are complete snapshots, only the last one counts
+	while(m_listener_commands.pop(m_mixing));
+}
+
 void AUD_SoftwareDevice::setPanning(AUD_IHandle* handle, float pan)
 {
 	AUD_SoftwareDevice::AUD_SoftwareHandle* h = dynamic_cast<AUD_SoftwareDevice::AUD_SoftwareHandle*>(handle);
-	h->m_user_pan = pan;
+	h->m_parameters.pan = pan;
+	h->commit();
 }
 
 void AUD_SoftwareDevice::setQuality(bool quality)
@@ -832,6 +958,16 @@ void AUD_SoftwareDevice::setQuality(bool quality)
 	m_quality = quality;
 }
 
+void AUD_SoftwareDevice::setPolyphase(bool polyphase)
+{
+	m_polyphase = polyphase;
+}
+
+unsigned int AUD_SoftwareDevice::getLockWaits()
+{
+	return atomic_fetch_and_add_uint32(&m_lock_waits, 0);
+}
+
 void AUD_SoftwareDevice::setSpecs(AUD_Specs specs)
 {
 	m_specs.specs = specs;
@@ -860,7 +996,11 @@ boost::shared_ptr<AUD_IHandle> AUD_SoftwareDevice::play(boost::shared_ptr<AUD_IR
 
 	// resample
 	if(m_quality)
-		resampler = boost::shared_ptr<AUD_ResampleReader>(new AUD_JOSResampleReader(reader, m_specs.specs));
+	{
+		boost::shared_ptr<AUD_JOSResampleReader> jos(new AUD_JOSResampleReader(reader, m_specs.specs));
+		jos->setPolyphase(m_polyphase);
+		resampler = jos;
+	}
 	else
 		resampler = boost::shared_ptr<AUD_ResampleReader>(new AUD_LinearResampleReader(reader, m_specs.specs));
 	reader = boost::shared_ptr<AUD_IReader>(resampler);
@@ -913,12 +1053,14 @@ void AUD_SoftwareDevice::unlock()
 
 float AUD_SoftwareDevice::getVolume() const
 {
-	return m_volume;
+	return m_parameters.volume;
 }
 
 void AUD_SoftwareDevice::setVolume(float volume)
 {
-	m_volume = volume;
+	m_parameters.volume = volume;
+
+	commit();
 }
 
 /******************************************************************************/
@@ -927,68 +1069,80 @@ void AUD_SoftwareDevice::setVolume(float volume)
 
 AUD_Vector3 AUD_SoftwareDevice::getListenerLocation() const
 {
-	return m_location;
+	return m_parameters.location;
 }
 
 void AUD_SoftwareDevice::setListenerLocation(const AUD_Vector3& location)
 {
-	m_location = location;
+	m_parameters.location = location;
+
+	commit();
 }
 
 AUD_Vector3 AUD_SoftwareDevice::getListenerVelocity() const
 {
-	return m_velocity;
+	return m_parameters.velocity;
 }
 
 void AUD_SoftwareDevice::setListenerVelocity(const AUD_Vector3& velocity)
 {
-	m_velocity = velocity;
+	m_parameters.velocity = velocity;
+
+	commit();
 }
 
 AUD_Quaternion AUD_SoftwareDevice::getListenerOrientation() const
 {
-	return m_orientation;
+	return m_parameters.orientation;
 }
 
 void AUD_SoftwareDevice::setListenerOrientation(const AUD_Quaternion& orientation)
 {
-	m_orientation = orientation;
+	m_parameters.orientation = orientation;
+
+	commit();
 }
 
 float AUD_SoftwareDevice::getSpeedOfSound() const
 {
-	return m_speed_of_sound;
+	return m_parameters.speed_of_sound;
 }
 
 void AUD_SoftwareDevice::setSpeedOfSound(float speed)
 {
-	m_speed_of_sound = speed;
+	m_parameters.speed_of_sound = speed;
+
+	commit();
 }
 
 float AUD_SoftwareDevice::getDopplerFactor() const
 {
-	return m_doppler_factor;
+	return m_parameters.doppler_factor;
 }
 
 void AUD_SoftwareDevice::setDopplerFactor(float factor)
 {
-	m_doppler_factor = factor;
+	m_parameters.doppler_factor = factor;
 	if(factor == 0)
-		m_flags |= AUD_RENDER_DOPPLER;
+		m_parameters.flags |= AUD_RENDER_DOPPLER;
 	else
-		m_flags &= ~AUD_RENDER_DOPPLER;
+		m_parameters.flags &= ~AUD_RENDER_DOPPLER;
+
+	commit();
 }
 
 AUD_DistanceModel AUD_SoftwareDevice::getDistanceModel() const
 {
-	return m_distance_model;
+	return m_parameters.distance_model;
 }
 
 void AUD_SoftwareDevice::setDistanceModel(AUD_DistanceModel model)
 {
-	m_distance_model = model;
+	m_parameters.distance_model = model;
 	if(model == AUD_DISTANCE_MODEL_INVALID)
-		m_flags |= AUD_RENDER_DISTANCE;
+		m_parameters.flags |= AUD_RENDER_DISTANCE;
 	else
-		m_flags &= ~AUD_RENDER_DISTANCE;
+		m_parameters.flags &= ~AUD_RENDER_DISTANCE;
+
+	commit();
 }
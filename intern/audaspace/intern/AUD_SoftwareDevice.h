@@ -39,7 +39,9 @@
 #include "AUD_PitchReader.h"
 #include "AUD_ResampleReader.h"
 #include "AUD_ChannelMapperReader.h"
+#include "AUD_CommandQueue.h"
 
+#include <boost/enable_shared_from_this.hpp>
 #include <list>
 #include <pthread.h>
 
@@ -54,79 +56,117 @@
 class AUD_SoftwareDevice : public AUD_IDevice, public AUD_I3DDevice
 {
 protected:
-	/// Saves the data for playback.
-	class AUD_SoftwareHandle : public AUD_IHandle, public AUD_I3DHandle
+	/// The parameters of a handle that can be changed during playback.
+	struct AUD_HandleParameters
 	{
-	public:
-		/// The reader source.
-		boost::shared_ptr<AUD_IReader> m_reader;
-
-		/// The pitch reader in between.
-		boost::shared_ptr<AUD_PitchReader> m_pitch;
-
-		/// The resample reader in between.
-		boost::shared_ptr<AUD_ResampleReader> m_resampler;
-
-		/// The channel mapper reader in between.
-		boost::shared_ptr<AUD_ChannelMapperReader> m_mapper;
-
-		/// Whether to keep the source if end of it is reached.
-		bool m_keep;
-
 		/// The user set pitch of the source.
-		float m_user_pitch;
+		float pitch;
 
 		/// The user set volume of the source.
-		float m_user_volume;
+		float volume;
 
 		/// The user set panning for non-3D sources
-		float m_user_pan;
-
-		/// The calculated final volume of the source.
-		float m_volume;
-		float m_old_volume;
-
-		/// The loop count of the source.
-		int m_loopcount;
+		float pan;
 
 		/// Location in 3D Space.
-		AUD_Vector3 m_location;
+		AUD_Vector3 location;
 
 		/// Velocity in 3D Space.
-		AUD_Vector3 m_velocity;
+		AUD_Vector3 velocity;
 
 		/// Orientation in 3D Space.
-		AUD_Quaternion m_orientation;
+		AUD_Quaternion orientation;
 
 		/// Whether the position to the listener is relative or absolute
-		bool m_relative;
+		bool relative;
 
 		/// Maximum volume.
-		float m_volume_max;
+		float volume_max;
 
 		/// Minimum volume.
-		float m_volume_min;
+		float volume_min;
 
 		/// Maximum distance.
-		float m_distance_max;
+		float distance_max;
 
 		/// Reference distance;
-		float m_distance_reference;
+		float distance_reference;
 
 		/// Attenuation
-		float m_attenuation;
+		float attenuation;
 
 		/// Cone outer angle.
-		float m_cone_angle_outer;
+		float cone_angle_outer;
 
 		/// Cone inner angle.
-		float m_cone_angle_inner;
+		float cone_angle_inner;
 
 		/// Cone outer volume.
-		float m_cone_volume_outer;
+		float cone_volume_outer;
 
 		/// Rendering flags
-		int m_flags;
+		int flags;
+	};
+
+	/// The parameters of the device and its listener.
+	struct AUD_ListenerParameters
+	{
+		/// The overall volume of the device.
+		float volume;
+
+		/// Listener location.
+		AUD_Vector3 location;
+
+		/// Listener velocity.
+		AUD_Vector3 velocity;
+
+		/// Listener orientation.
+		AUD_Quaternion orientation;
+
+		/// Speed of Sound.
+		float speed_of_sound;
+
+		/// Doppler factor.
+		float doppler_factor;
+
+		/// Distance model.
+		AUD_DistanceModel distance_model;
+
+		/// Rendering flags
+		int flags;
+	};
+
+	/// Saves the data for playback.
+	class AUD_SoftwareHandle : public AUD_IHandle, public AUD_I3DHandle, public boost::enable_shared_from_this<AUD_SoftwareHandle>
+	{
+	public:
+		/// The reader source.
+		boost::shared_ptr<AUD_IReader> m_reader;
+
+		/// The pitch reader in between.
+		boost::shared_ptr<AUD_PitchReader> m_pitch;
+
+		/// The resample reader in between.
+		boost::shared_ptr<AUD_ResampleReader> m_resampler;
+
+		/// The channel mapper reader in between.
+		boost::shared_ptr<AUD_ChannelMapperReader> m_mapper;
+
+		/// Whether to keep the source if end of it is reached.
+		bool m_keep;
+
+		/// The playback parameters as set by the user.
+		AUD_HandleParameters m_parameters;
+
+		/// The playback parameters the mixing thread currently uses.
+		AUD_HandleParameters m_mixing;
+
+		/// The calculated final volume of the source.
+		float m_volume;
+		float m_old_volume;
+
+		/// The loop count of the source.
+		int m_loopcount;
 
 		/// The stop callback.
 		stopCallback m_stop;
@@ -142,6 +182,11 @@ protected:
 
 		bool pause(bool keep);
 
+		/**
+		 * Sends the user set parameters to the mixing thread.
+		 */
+		void commit();
+
 	public:
 
 		/**
@@ -226,6 +271,11 @@ protected:
 	 */
 	bool m_quality;
 
+	/**
+	 * Whether high quality resampling uses filter banks for fixed ratios.
+	 */
+	bool m_polyphase;
+
 	/**
 	 * Initializes member variables.
 	 */
@@ -238,6 +288,9 @@ protected:
 
 	/**
 	 * Mixes the next samples into the buffer.
+	 * Parameter changes are taken from the command queues, but playing,
+	 * pausing and stopping sounds still needs the device lock, so mixing
+	 * takes it for every buffer and waits while another thread holds it.
 	 * \param buffer The target buffer.
 	 * \param length The length in samples to be filled.
 	 */
@@ -282,30 +335,61 @@ private:
 	pthread_mutex_t m_mutex;
 
 	/**
-	 * The overall volume of the device.
+	 * The parameters of the device as set by the user.
+	 */
+	AUD_ListenerParameters m_parameters;
+
+	/**
+	 * The parameters of the device the mixing thread currently uses.
 	 */
-	float m_volume;
+	AUD_ListenerParameters m_mixing;
 
-	/// Listener location.
-	AUD_Vector3 m_location;
+	/// A parameter change of a handle.
+	struct AUD_HandleCommand
+	{
+		/// The changed handle.
+		boost::shared_ptr<AUD_SoftwareHandle> handle;
+
+		/// The new parameters.
+		AUD_HandleParameters parameters;
+	};
+
+	/**
+	 * Parameter changes of handles, applied before mixing the next buffer.
+	 */
+	AUD_CommandQueue<AUD_HandleCommand, 4096> m_handle_commands;
 
-	/// Listener velocity.
-	AUD_Vector3 m_velocity;
+	/**
+	 * Parameter changes of the device, applied before mixing the next buffer.
+	 */
+	AUD_CommandQueue<AUD_ListenerParameters, 64> m_listener_commands;
 
-	/// Listener orientation.
-	AUD_Quaternion m_orientation;
+	/**
+	 * Serializes the threads pushing commands, the mixing thread never
+	 * waits for it. If both are taken, the device mutex goes first.
+	 */
+	pthread_mutex_t m_command_mutex;
 
-	/// Speed of Sound.
-	float m_speed_of_sound;
+	/**
+	 * The number of buffers the mixing thread had to wait for the device lock.
+	 */
+	uint32_t m_lock_waits;
 
-	/// Doppler factor.
-	float m_doppler_factor;
+	/**
+	 * Sends a parameter change of a handle to the mixing thread.
+	 * \param command The parameter change.
+	 */
+	void pushCommand(const AUD_HandleCommand& command);
 
-	/// Distance model.
-	AUD_DistanceModel m_distance_model;
+	/**
+	 * Sends the user set device parameters to the mixing thread.
+	 */
+	void commit();
 
-	/// Rendering flags
-	int m_flags;
+	/**
+	 * Applies all queued parameter changes, the device has to be locked.
+	 */
+	void applyCommands();
 
 public:
 
@@ -322,6 +406,20 @@ public:
 	 */
 	void setQuality(bool quality);
 
+	/**
+	 * Sets whether high quality resampling of sounds played afterwards uses
+	 * precomputed polyphase filter banks while the ratio is fixed.
+	 * \param polyphase Whether to use the filter banks, the default.
+	 */
+	void setPolyphase(bool polyphase);
+
+	/**
+	 * Returns the number of buffers for which the mixing thread had to wait
+	 * because another thread held the device lock. Not every wait is an
+	 * audible dropout, it only tells how contended the device is.
+	 */
+	unsigned int getLockWaits();
+
 	virtual AUD_DeviceSpecs getSpecs() const;
 	virtual boost::shared_ptr<AUD_IHandle> play(boost::shared_ptr<AUD_IReader> reader, bool keep = false);
 	virtual boost::shared_ptr<AUD_IHandle> play(boost::shared_ptr<AUD_IFactory> factory, bool keep = false);
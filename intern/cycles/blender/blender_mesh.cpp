@@ -30,11 +30,27 @@
 #include "util_foreach.h"
 #include "util_logging.h"
 #include "util_math.h"
+#include "util_task.h"
+#include "util_time.h"
 
 #include "mikktspace.h"
 
+/* Mesh arrays are read directly, going through the RNA iterators for every
+ * element is too slow for meshes with millions of faces. */
+extern "C" {
+#include "DNA_customdata_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+}
+
 CCL_NAMESPACE_BEGIN
 
+/* Number of elements converted by a single task. */
+#define MESH_RANGE_CHUNK_SIZE 16384
+
+/* Number of meshes collected per thread before they are converted. */
+#define MESH_SYNC_TASKS_PER_THREAD 4
+
 /* Per-face bit flags. */
 enum {
 	/* Face has no special flags. */
@@ -77,6 +93,43 @@ inline void face_split_tri_indices(const int num_verts,
 	}
 }
 
+/* Blender Mesh Data */
+
+static inline const ::Mesh *mesh_dna(BL::Mesh& b_mesh)
+{
+	return (const ::Mesh*)b_mesh.ptr.data;
+}
+
+/* Same as CustomData_get_layer(), the active layer of the given type. */
+static inline const void *mesh_custom_data_layer(const CustomData *data, int type)
+{
+	const int layer_index = data->typemap[type];
+	if(layer_index == -1)
+		return NULL;
+	return data->layers[layer_index + data->layers[layer_index].active].data;
+}
+
+static inline float3 mesh_short_normal(const short no[3])
+{
+	return make_float3(no[0], no[1], no[2]) * (1.0f / 32767.0f);
+}
+
+/* Calls range_func(start, end) for chunks of the range [0, num), in parallel
+ * when the range is large enough. */
+static void mesh_parallel_range(int num, const function<void(int, int)>& range_func)
+{
+	if(num <= MESH_RANGE_CHUNK_SIZE || TaskScheduler::num_threads() <= 1) {
+		range_func(0, num);
+		return;
+	}
+
+	TaskPool pool;
+	for(int start = 0; start < num; start += MESH_RANGE_CHUNK_SIZE) {
+		pool.push(function_bind(range_func, start, min(start + MESH_RANGE_CHUNK_SIZE, num)));
+	}
+	pool.wait_work();
+}
+
 /* Tangent Space */
 
 struct MikkUserData {
@@ -330,13 +383,56 @@ static void create_mesh_volume_attributes(Scene *scene,
 }
 
 /* Create vertex color attributes. */
+
+static inline uchar4 mesh_tessface_color(const MCol *mcol)
+{
+	/* Tessellated face colors are stored in BGR order. */
+	const uchar *bgr = &mcol->r;
+	float3 color = make_float3(bgr[2] / 255.0f, bgr[1] / 255.0f, bgr[0] / 255.0f);
+	return color_float_to_byte(color_srgb_to_scene_linear(color));
+}
+
+static void mesh_tessface_colors_range(const MCol *mcol,
+                                       const vector<int> *nverts,
+                                       const vector<int> *face_flags,
+                                       const vector<int> *tri_offset,
+                                       uchar4 *cdata,
+                                       int start,
+                                       int end)
+{
+	for(int i = start; i < end; i++) {
+		const int n = (*nverts)[i];
+		int tri_a[3], tri_b[3];
+		face_split_tri_indices(n, (*face_flags)[i], tri_a, tri_b);
+
+		uchar4 colors[4];
+		for(int j = 0; j < n; j++) {
+			colors[j] = mesh_tessface_color(&mcol[i*4 + j]);
+		}
+
+		uchar4 *face_cdata = cdata + (*tri_offset)[i]*3;
+		face_cdata[0] = colors[tri_a[0]];
+		face_cdata[1] = colors[tri_a[1]];
+		face_cdata[2] = colors[tri_a[2]];
+
+		if(n == 4) {
+			face_cdata[3] = colors[tri_b[0]];
+			face_cdata[4] = colors[tri_b[1]];
+			face_cdata[5] = colors[tri_b[2]];
+		}
+	}
+}
+
 static void attr_create_vertex_color(Scene *scene,
                                      Mesh *mesh,
                                      BL::Mesh& b_mesh,
                                      const vector<int>& nverts,
                                      const vector<int>& face_flags,
+                                     const vector<int>& tri_offset,
                                      bool subdivision)
 {
+	const ::Mesh *me = mesh_dna(b_mesh);
+
 	if(subdivision) {
 		BL::Mesh::vertex_colors_iterator l;
 
@@ -348,13 +444,14 @@ static void attr_create_vertex_color(Scene *scene,
 			                                            TypeDesc::TypeColor,
 			                                            ATTR_ELEMENT_CORNER_BYTE);
 
-			BL::Mesh::polygons_iterator p;
+			const MLoopCol *mloopcol = (const MLoopCol*)((const CustomDataLayer*)l->ptr.data)->data;
 			uchar4 *cdata = attr->data_uchar4();
 
-			for(b_mesh.polygons.begin(p); p != b_mesh.polygons.end(); ++p) {
-				int n = p->loop_total();
-				for(int i = 0; i < n; i++) {
-					float3 color = get_float3(l->data[p->loop_start() + i].color());
+			for(int p = 0; p < me->totpoly; p++) {
+				const MPoly& mp = me->mpoly[p];
+				for(int i = 0; i < mp.totloop; i++) {
+					const MLoopCol& mc = mloopcol[mp.loopstart + i];
+					float3 color = make_float3(mc.r / 255.0f, mc.g / 255.0f, mc.b / 255.0f);
 					*(cdata++) = color_float_to_byte(color_srgb_to_scene_linear(color));
 				}
 			}
@@ -370,48 +467,65 @@ static void attr_create_vertex_color(Scene *scene,
 			                                       TypeDesc::TypeColor,
 			                                       ATTR_ELEMENT_CORNER_BYTE);
 
-			BL::MeshColorLayer::data_iterator c;
-			uchar4 *cdata = attr->data_uchar4();
-			size_t i = 0;
+			const MCol *mcol = (const MCol*)((const CustomDataLayer*)l->ptr.data)->data;
+
+			mesh_parallel_range(nverts.size(),
+			                    function_bind(&mesh_tessface_colors_range,
+			                                  mcol,
+			                                  &nverts,
+			                                  &face_flags,
+			                                  &tri_offset,
+			                                  attr->data_uchar4(),
+			                                  _1,
+			                                  _2));
+		}
+	}
+}
 
-			for(l->data.begin(c); c != l->data.end(); ++c, ++i) {
-				int tri_a[3], tri_b[3];
-				face_split_tri_indices(nverts[i], face_flags[i], tri_a, tri_b);
+/* Create uv map attributes. */
 
-				uchar4 colors[4];
-				colors[0] = color_float_to_byte(color_srgb_to_scene_linear(get_float3(c->color1())));
-				colors[1] = color_float_to_byte(color_srgb_to_scene_linear(get_float3(c->color2())));
-				colors[2] = color_float_to_byte(color_srgb_to_scene_linear(get_float3(c->color3())));
-				if(nverts[i] == 4) {
-					colors[3] = color_float_to_byte(color_srgb_to_scene_linear(get_float3(c->color4())));
-				}
+static void mesh_tessface_uvs_range(const MTFace *mtface,
+                                    const vector<int> *nverts,
+                                    const vector<int> *face_flags,
+                                    const vector<int> *tri_offset,
+                                    float3 *fdata,
+                                    int start,
+                                    int end)
+{
+	for(int i = start; i < end; i++) {
+		const int n = (*nverts)[i];
+		int tri_a[3], tri_b[3];
+		face_split_tri_indices(n, (*face_flags)[i], tri_a, tri_b);
 
-				cdata[0] = colors[tri_a[0]];
-				cdata[1] = colors[tri_a[1]];
-				cdata[2] = colors[tri_a[2]];
+		float3 uvs[4];
+		for(int j = 0; j < n; j++) {
+			uvs[j] = make_float3(mtface[i].uv[j][0], mtface[i].uv[j][1], 0.0f);
+		}
 
-				if(nverts[i] == 4) {
-					cdata[3] = colors[tri_b[0]];
-					cdata[4] = colors[tri_b[1]];
-					cdata[5] = colors[tri_b[2]];
-					cdata += 6;
-				}
-				else
-					cdata += 3;
-			}
+		float3 *face_fdata = fdata + (*tri_offset)[i]*3;
+		face_fdata[0] = uvs[tri_a[0]];
+		face_fdata[1] = uvs[tri_a[1]];
+		face_fdata[2] = uvs[tri_a[2]];
+
+		if(n == 4) {
+			face_fdata[3] = uvs[tri_b[0]];
+			face_fdata[4] = uvs[tri_b[1]];
+			face_fdata[5] = uvs[tri_b[2]];
 		}
 	}
 }
 
-/* Create uv map attributes. */
 static void attr_create_uv_map(Scene *scene,
                                Mesh *mesh,
                                BL::Mesh& b_mesh,
                                const vector<int>& nverts,
                                const vector<int>& face_flags,
+                               const vector<int>& tri_offset,
                                bool subdivision,
                                bool subdivide_uvs)
 {
+	const ::Mesh *me = mesh_dna(b_mesh);
+
 	if(subdivision) {
 		BL::Mesh::uv_layers_iterator l;
 		int i = 0;
@@ -434,13 +548,14 @@ static void attr_create_uv_map(Scene *scene,
 					attr->flags |= ATTR_SUBDIVIDED;
 				}
 
-				BL::Mesh::polygons_iterator p;
+				const MLoopUV *mloopuv = (const MLoopUV*)((const CustomDataLayer*)l->ptr.data)->data;
 				float3 *fdata = attr->data_float3();
 
-				for(b_mesh.polygons.begin(p); p != b_mesh.polygons.end(); ++p) {
-					int n = p->loop_total();
-					for(int j = 0; j < n; j++) {
-						*(fdata++) = get_float3(l->data[p->loop_start() + j].uv());
+				for(int p = 0; p < me->totpoly; p++) {
+					const MPoly& mp = me->mpoly[p];
+					for(int j = 0; j < mp.totloop; j++) {
+						const float *uv = mloopuv[mp.loopstart + j].uv;
+						*(fdata++) = make_float3(uv[0], uv[1], 0.0f);
 					}
 				}
 			}
@@ -463,34 +578,17 @@ static void attr_create_uv_map(Scene *scene,
 				else
 					attr = mesh->attributes.add(name, TypeDesc::TypePoint, ATTR_ELEMENT_CORNER);
 
-				BL::MeshTextureFaceLayer::data_iterator t;
-				float3 *fdata = attr->data_float3();
-				size_t i = 0;
-
-				for(l->data.begin(t); t != l->data.end(); ++t, ++i) {
-					int tri_a[3], tri_b[3];
-					face_split_tri_indices(nverts[i], face_flags[i], tri_a, tri_b);
-
-					float3 uvs[4];
-					uvs[0] = get_float3(t->uv1());
-					uvs[1] = get_float3(t->uv2());
-					uvs[2] = get_float3(t->uv3());
-					if(nverts[i] == 4) {
-						uvs[3] = get_float3(t->uv4());
-					}
-
-					fdata[0] = uvs[tri_a[0]];
-					fdata[1] = uvs[tri_a[1]];
-					fdata[2] = uvs[tri_a[2]];
-					fdata += 3;
-
-					if(nverts[i] == 4) {
-						fdata[0] = uvs[tri_b[0]];
-						fdata[1] = uvs[tri_b[1]];
-						fdata[2] = uvs[tri_b[2]];
-						fdata += 3;
-					}
-				}
+				const MTFace *mtface = (const MTFace*)((const CustomDataLayer*)l->ptr.data)->data;
+
+				mesh_parallel_range(nverts.size(),
+				                    function_bind(&mesh_tessface_uvs_range,
+				                                  mtface,
+				                                  &nverts,
+				                                  &face_flags,
+				                                  &tri_offset,
+				                                  attr->data_float3(),
+				                                  _1,
+				                                  _2));
 			}
 
 			/* UV tangent */
@@ -531,7 +629,11 @@ static void attr_create_pointiness(Scene *scene,
                                    bool subdivision)
 {
 	if(mesh->need_attribute(scene, ATTR_STD_POINTINESS)) {
-		const int numverts = b_mesh.vertices.length();
+		const ::Mesh *me = mesh_dna(b_mesh);
+		const MVert *mvert = me->mvert;
+		const MEdge *medge = me->medge;
+		const int numverts = me->totvert;
+		const int numedges = me->totedge;
 		AttributeSet& attributes = (subdivision)? mesh->subd_attributes: mesh->attributes;
 		Attribute *attr = attributes.add(ATTR_STD_POINTINESS);
 		float *data = attr->data_float();
@@ -543,24 +645,20 @@ static void attr_create_pointiness(Scene *scene,
 		memset(counter, 0, sizeof(int) * numverts);
 		memset(raw_data, 0, sizeof(float) * numverts);
 		memset(edge_accum, 0, sizeof(float3) * numverts);
-		BL::Mesh::edges_iterator e;
-		int i = 0;
-		for(b_mesh.edges.begin(e); e != b_mesh.edges.end(); ++e, ++i) {
-			int v0 = b_mesh.edges[i].vertices()[0],
-			    v1 = b_mesh.edges[i].vertices()[1];
-			float3 co0 = get_float3(b_mesh.vertices[v0].co()),
-			       co1 = get_float3(b_mesh.vertices[v1].co());
+		for(int i = 0; i < numedges; ++i) {
+			int v0 = medge[i].v1,
+			    v1 = medge[i].v2;
+			float3 co0 = make_float3(mvert[v0].co[0], mvert[v0].co[1], mvert[v0].co[2]),
+			       co1 = make_float3(mvert[v1].co[0], mvert[v1].co[1], mvert[v1].co[2]);
 			float3 edge = normalize(co1 - co0);
 			edge_accum[v0] += edge;
 			edge_accum[v1] += -edge;
 			++counter[v0];
 			++counter[v1];
 		}
-		i = 0;
-		BL::Mesh::vertices_iterator v;
-		for(b_mesh.vertices.begin(v); v != b_mesh.vertices.end(); ++v, ++i) {
+		for(int i = 0; i < numverts; ++i) {
 			if(counter[i] > 0) {
-				float3 normal = get_float3(b_mesh.vertices[i].normal());
+				float3 normal = mesh_short_normal(mvert[i].no);
 				float angle = safe_acosf(dot(normal, edge_accum[i] / counter[i]));
 				raw_data[i] = angle * M_1_PI_F;
 			}
@@ -572,16 +670,15 @@ static void attr_create_pointiness(Scene *scene,
 		/* Blur vertices to approximate 2 ring neighborhood. */
 		memset(counter, 0, sizeof(int) * numverts);
 		memcpy(data, raw_data, sizeof(float) * numverts);
-		i = 0;
-		for(b_mesh.edges.begin(e); e != b_mesh.edges.end(); ++e, ++i) {
-			int v0 = b_mesh.edges[i].vertices()[0],
-			    v1 = b_mesh.edges[i].vertices()[1];
+		for(int i = 0; i < numedges; ++i) {
+			int v0 = medge[i].v1,
+			    v1 = medge[i].v2;
 			data[v0] += raw_data[v1];
 			data[v1] += raw_data[v0];
 			++counter[v0];
 			++counter[v1];
 		}
-		for(i = 0; i < numverts; ++i) {
+		for(int i = 0; i < numverts; ++i) {
 			data[i] /= counter[i] + 1;
 		}
 
@@ -593,6 +690,91 @@ static void attr_create_pointiness(Scene *scene,
 
 /* Create Mesh */
 
+static void mesh_verts_range(const MVert *mvert,
+                             float3 *P,
+                             float3 *N,
+                             int start,
+                             int end)
+{
+	for(int i = start; i < end; i++) {
+		P[i] = make_float3(mvert[i].co[0], mvert[i].co[1], mvert[i].co[2]);
+		N[i] = mesh_short_normal(mvert[i].no);
+	}
+}
+
+static void mesh_generated_range(const MVert *mvert,
+                                 float3 loc,
+                                 float3 size,
+                                 float3 *generated,
+                                 int start,
+                                 int end)
+{
+	for(int i = start; i < end; i++) {
+		generated[i] = make_float3(mvert[i].co[0], mvert[i].co[1], mvert[i].co[2])*size - loc;
+	}
+}
+
+/* Write the triangles of a tessellated face starting at triangle index t,
+ * returns the face flag telling how a quad was split. */
+static int mesh_tessface_triangulate(Mesh *mesh,
+                                     const int vi[4],
+                                     int n,
+                                     int t,
+                                     int shader,
+                                     bool smooth)
+{
+	int *tri = &mesh->triangles[t*3];
+	int face_flag;
+
+	if(n == 4) {
+		const float3 *verts = mesh->verts.data();
+
+		if(is_zero(cross(verts[vi[1]] - verts[vi[0]], verts[vi[2]] - verts[vi[0]])) ||
+		   is_zero(cross(verts[vi[2]] - verts[vi[0]], verts[vi[3]] - verts[vi[0]])))
+		{
+			tri[0] = vi[0]; tri[1] = vi[1]; tri[2] = vi[3];
+			tri[3] = vi[2]; tri[4] = vi[3]; tri[5] = vi[1];
+			face_flag = FACE_FLAG_DIVIDE_24;
+		}
+		else {
+			tri[0] = vi[0]; tri[1] = vi[1]; tri[2] = vi[2];
+			tri[3] = vi[0]; tri[4] = vi[2]; tri[5] = vi[3];
+			face_flag = FACE_FLAG_DIVIDE_13;
+		}
+
+		mesh->shader[t + 1] = shader;
+		mesh->smooth[t + 1] = smooth;
+	}
+	else {
+		tri[0] = vi[0]; tri[1] = vi[1]; tri[2] = vi[2];
+		face_flag = FACE_FLAG_NONE;
+	}
+
+	mesh->shader[t] = shader;
+	mesh->smooth[t] = smooth;
+
+	return face_flag;
+}
+
+static void mesh_tessfaces_range(Mesh *mesh,
+                                 const MFace *mface,
+                                 const vector<int> *tri_offset,
+                                 int max_shader,
+                                 vector<int> *face_flags,
+                                 int start,
+                                 int end)
+{
+	for(int i = start; i < end; i++) {
+		const MFace& mf = mface[i];
+		const int vi[4] = {(int)mf.v1, (int)mf.v2, (int)mf.v3, (int)mf.v4};
+		const int n = (mf.v4 == 0)? 3: 4;
+		const int shader = clamp(mf.mat_nr, 0, max_shader);
+		const bool smooth = (mf.flag & ME_SMOOTH) != 0;
+
+		(*face_flags)[i] = mesh_tessface_triangulate(mesh, vi, n, (*tri_offset)[i], shader, smooth);
+	}
+}
+
 static void create_mesh(Scene *scene,
                         Mesh *mesh,
                         BL::Mesh& b_mesh,
@@ -600,46 +782,54 @@ static void create_mesh(Scene *scene,
                         bool subdivision=false,
                         bool subdivide_uvs=true)
 {
+	const ::Mesh *me = mesh_dna(b_mesh);
+	const MVert *mvert = me->mvert;
+	const MFace *mface = me->mface;
+	const MPoly *mpoly = me->mpoly;
+	const MLoop *mloop = me->mloop;
+
 	/* count vertices and faces */
-	int numverts = b_mesh.vertices.length();
-	int numfaces = (!subdivision) ? b_mesh.tessfaces.length() : b_mesh.polygons.length();
+	int numverts = me->totvert;
+	int numfaces = (!subdivision) ? me->totface : me->totpoly;
 	int numtris = 0;
 	int numcorners = 0;
 	int numngons = 0;
+	int max_shader = used_shaders.size()-1;
 	bool use_loop_normals = b_mesh.use_auto_smooth() && (mesh->subdivision_type != Mesh::SUBDIVISION_CATMULL_CLARK);
 
-	BL::Mesh::vertices_iterator v;
-	BL::Mesh::tessfaces_iterator f;
-	BL::Mesh::polygons_iterator p;
+	/* triangles of each tessellated face are written starting at tri_offset */
+	vector<int> tri_offset;
 
 	if(!subdivision) {
-		for(b_mesh.tessfaces.begin(f); f != b_mesh.tessfaces.end(); ++f) {
-			int4 vi = get_int4(f->vertices_raw());
-			numtris += (vi[3] == 0)? 1: 2;
+		tri_offset.resize(numfaces);
+		for(int i = 0; i < numfaces; i++) {
+			tri_offset[i] = numtris;
+			numtris += (mface[i].v4 == 0)? 1: 2;
 		}
 	}
 	else {
-		for(b_mesh.polygons.begin(p); p != b_mesh.polygons.end(); ++p) {
-			numngons += (p->loop_total() == 4)? 0: 1;
-			numcorners += p->loop_total();
+		for(int i = 0; i < numfaces; i++) {
+			numngons += (mpoly[i].totloop == 4)? 0: 1;
+			numcorners += mpoly[i].totloop;
 		}
 	}
 
 	/* allocate memory */
-	mesh->reserve_mesh(numverts, numtris);
+	mesh->resize_mesh(numverts, numtris);
 	mesh->reserve_subd_faces(numfaces, numngons, numcorners);
 
 	/* create vertex coordinates and normals */
-	for(b_mesh.vertices.begin(v); v != b_mesh.vertices.end(); ++v)
-		mesh->add_vertex(get_float3(v->co()));
-
 	AttributeSet& attributes = (subdivision)? mesh->subd_attributes: mesh->attributes;
 	Attribute *attr_N = attributes.add(ATTR_STD_VERTEX_NORMAL);
 	float3 *N = attr_N->data_float3();
 
-	for(b_mesh.vertices.begin(v); v != b_mesh.vertices.end(); ++v, ++N)
-		*N = get_float3(v->normal());
-	N = attr_N->data_float3();
+	mesh_parallel_range(numverts,
+	                    function_bind(&mesh_verts_range,
+	                                  mvert,
+	                                  mesh->verts.data(),
+	                                  N,
+	                                  _1,
+	                                  _2));
 
 	/* create generated coordinates from undeformed coordinates */
 	if(mesh->need_attribute(scene, ATTR_STD_GENERATED)) {
@@ -650,10 +840,25 @@ static void create_mesh(Scene *scene,
 		mesh_texture_space(b_mesh, loc, size);
 
 		float3 *generated = attr->data_float3();
-		size_t i = 0;
 
-		for(b_mesh.vertices.begin(v); v != b_mesh.vertices.end(); ++v)
-			generated[i++] = get_float3(v->undeformed_co())*size - loc;
+		if(mesh_custom_data_layer(&me->vdata, CD_ORCO) == NULL) {
+			/* undeformed coordinates are the vertex coordinates */
+			mesh_parallel_range(numverts,
+			                    function_bind(&mesh_generated_range,
+			                                  mvert,
+			                                  loc,
+			                                  size,
+			                                  generated,
+			                                  _1,
+			                                  _2));
+		}
+		else {
+			BL::Mesh::vertices_iterator v;
+			size_t i = 0;
+
+			for(b_mesh.vertices.begin(v); v != b_mesh.vertices.end(); ++v)
+				generated[i++] = get_float3(v->undeformed_co())*size - loc;
+		}
 	}
 
 	/* Create needed vertex attributes. */
@@ -662,24 +867,39 @@ static void create_mesh(Scene *scene,
 	/* create faces */
 	vector<int> nverts(numfaces);
 	vector<int> face_flags(numfaces, FACE_FLAG_NONE);
-	int fi = 0;
 
 	if(!subdivision) {
-		for(b_mesh.tessfaces.begin(f); f != b_mesh.tessfaces.end(); ++f, ++fi) {
-			int4 vi = get_int4(f->vertices_raw());
-			int n = (vi[3] == 0)? 3: 4;
-			int shader = clamp(f->material_index(), 0, used_shaders.size()-1);
-			bool smooth = f->use_smooth() || use_loop_normals;
-
-			/* split vertices if normal is different
-			 *
-			 * note all vertex attributes must have been set here so we can split
-			 * and copy attributes in split_vertex without remapping later */
-			if(use_loop_normals) {
-				BL::Array<float, 12> loop_normals = f->split_normals();
+		for(int fi = 0; fi < numfaces; fi++) {
+			nverts[fi] = (mface[fi].v4 == 0)? 3: 4;
+		}
 
+		if(!use_loop_normals) {
+			mesh_parallel_range(numfaces,
+			                    function_bind(&mesh_tessfaces_range,
+			                                  mesh,
+			                                  mface,
+			                                  &tri_offset,
+			                                  max_shader,
+			                                  &face_flags,
+			                                  _1,
+			                                  _2));
+		}
+		else {
+			const short (*tess_normals)[4][3] =
+			        (const short (*)[4][3])mesh_custom_data_layer(&me->fdata, CD_TESSLOOPNORMAL);
+
+			for(int fi = 0; fi < numfaces; fi++) {
+				const MFace& mf = mface[fi];
+				int vi[4] = {(int)mf.v1, (int)mf.v2, (int)mf.v3, (int)mf.v4};
+				int n = nverts[fi];
+				int shader = clamp(mf.mat_nr, 0, max_shader);
+
+				/* split vertices if normal is different
+				 *
+				 * note all vertex attributes must have been set here so we can split
+				 * and copy attributes in split_vertex without remapping later */
 				for(int i = 0; i < n; i++) {
-					float3 loop_N = make_float3(loop_normals[i * 3], loop_normals[i * 3 + 1], loop_normals[i * 3 + 2]);
+					float3 loop_N = (tess_normals)? mesh_short_normal(tess_normals[fi][i]): make_float3(0.0f, 0.0f, 0.0f);
 
 					if(N[vi[i]] != loop_N) {
 						int new_vi = mesh->split_vertex(vi[i]);
@@ -690,48 +910,33 @@ static void create_mesh(Scene *scene,
 						vi[i] = new_vi;
 					}
 				}
-			}
 
-			/* create triangles */
-			if(n == 4) {
-				if(is_zero(cross(mesh->verts[vi[1]] - mesh->verts[vi[0]], mesh->verts[vi[2]] - mesh->verts[vi[0]])) ||
-				   is_zero(cross(mesh->verts[vi[2]] - mesh->verts[vi[0]], mesh->verts[vi[3]] - mesh->verts[vi[0]])))
-				{
-					mesh->add_triangle(vi[0], vi[1], vi[3], shader, smooth);
-					mesh->add_triangle(vi[2], vi[3], vi[1], shader, smooth);
-					face_flags[fi] |= FACE_FLAG_DIVIDE_24;
-				}
-				else {
-					mesh->add_triangle(vi[0], vi[1], vi[2], shader, smooth);
-					mesh->add_triangle(vi[0], vi[2], vi[3], shader, smooth);
-					face_flags[fi] |= FACE_FLAG_DIVIDE_13;
-				}
-			}
-			else {
-				mesh->add_triangle(vi[0], vi[1], vi[2], shader, smooth);
+				/* create triangles */
+				face_flags[fi] = mesh_tessface_triangulate(mesh, vi, n, tri_offset[fi], shader, true);
 			}
-
-			nverts[fi] = n;
 		}
 	}
 	else {
+		const float (*loop_normals)[3] = (const float (*)[3])mesh_custom_data_layer(&me->ldata, CD_NORMAL);
 		vector<int> vi;
 
-		for(b_mesh.polygons.begin(p); p != b_mesh.polygons.end(); ++p) {
-			int n = p->loop_total();
-			int shader = clamp(p->material_index(), 0, used_shaders.size()-1);
-			bool smooth = p->use_smooth() || use_loop_normals;
+		for(int fi = 0; fi < numfaces; fi++) {
+			const MPoly& mp = mpoly[fi];
+			int n = mp.totloop;
+			int shader = clamp(mp.mat_nr, 0, max_shader);
+			bool smooth = (mp.flag & ME_SMOOTH) || use_loop_normals;
 
-			vi.reserve(n);
+			vi.resize(n);
 			for(int i = 0; i < n; i++) {
-				vi[i] = b_mesh.loops[p->loop_start() + i].vertex_index();
+				vi[i] = mloop[mp.loopstart + i].v;
 
 				/* split vertices if normal is different
 				 *
 				 * note all vertex attributes must have been set here so we can split
 				 * and copy attributes in split_vertex without remapping later */
 				if(use_loop_normals) {
-					float3 loop_N = get_float3(b_mesh.loops[p->loop_start() + i].normal());
+					const float *lnor = (loop_normals)? loop_normals[mp.loopstart + i]: NULL;
+					float3 loop_N = (lnor)? make_float3(lnor[0], lnor[1], lnor[2]): make_float3(0.0f, 0.0f, 0.0f);
 
 					if(N[vi[i]] != loop_N) {
 						int new_vi = mesh->split_vertex(vi[i]);
@@ -752,8 +957,8 @@ static void create_mesh(Scene *scene,
 	/* Create all needed attributes.
 	 * The calculate functions will check whether they're needed or not.
 	 */
-	attr_create_vertex_color(scene, mesh, b_mesh, nverts, face_flags, subdivision);
-	attr_create_uv_map(scene, mesh, b_mesh, nverts, face_flags, subdivision, subdivide_uvs);
+	attr_create_vertex_color(scene, mesh, b_mesh, nverts, face_flags, tri_offset, subdivision);
+	attr_create_uv_map(scene, mesh, b_mesh, nverts, face_flags, tri_offset, subdivision, subdivide_uvs);
 
 	/* for volume objects, create a matrix to transform from object space to
 	 * mesh texture space. this does not work with deformations but that can
@@ -783,11 +988,12 @@ static void create_subd_mesh(Scene *scene,
 	create_mesh(scene, mesh, b_mesh, used_shaders, true, subdivide_uvs);
 
 	/* export creases */
+	const ::Mesh *me = mesh_dna(b_mesh);
+	const MEdge *medge = me->medge;
 	size_t num_creases = 0;
-	BL::Mesh::edges_iterator e;
 
-	for(b_mesh.edges.begin(e); e != b_mesh.edges.end(); ++e) {
-		if(e->crease() != 0.0f) {
+	for(int i = 0; i < me->totedge; i++) {
+		if(medge[i].crease != 0) {
 			num_creases++;
 		}
 	}
@@ -795,11 +1001,11 @@ static void create_subd_mesh(Scene *scene,
 	mesh->subd_creases.resize(num_creases);
 
 	Mesh::SubdEdgeCrease* crease = mesh->subd_creases.data();
-	for(b_mesh.edges.begin(e); e != b_mesh.edges.end(); ++e) {
-		if(e->crease() != 0.0f) {
-			crease->v[0] = e->vertices()[0];
-			crease->v[1] = e->vertices()[1];
-			crease->crease = e->crease();
+	for(int i = 0; i < me->totedge; i++) {
+		if(medge[i].crease != 0) {
+			crease->v[0] = medge[i].v1;
+			crease->v[1] = medge[i].v2;
+			crease->crease = medge[i].crease / 255.0f;
 
 			crease++;
 		}
@@ -816,7 +1022,7 @@ static void create_subd_mesh(Scene *scene,
 	sdparams.dicing_rate = max(0.1f, RNA_float_get(&cobj, "dicing_rate") * dicing_rate);
 	sdparams.max_level = max_subdivisions;
 
-	scene->camera->update();
+	/* camera is updated by sync_mesh(), before meshes are converted in parallel */
 	sdparams.camera = scene->camera;
 	sdparams.objecttoworld = get_transform(b_ob.matrix_world());
 }
@@ -864,14 +1070,6 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
                              bool object_updated,
                              bool hide_tris)
 {
-	/* When viewport display is not needed during render we can force some
-	 * caches to be releases from blender side in order to reduce peak memory
-	 * footprint during synchronization process.
-	 */
-	const bool is_interface_locked = b_engine.render() &&
-	                                 b_engine.render().use_lock_interface();
-	const bool can_free_caches = BlenderSession::headless || is_interface_locked;
-
 	/* test if we can instance or if the object is modified */
 	BL::ID b_ob_data = b_ob.data();
 	BL::ID key = (BKE_object_is_modified(b_ob))? b_ob: b_ob_data;
@@ -935,13 +1133,15 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 	
 	mesh_synced.insert(mesh);
 
+	MeshSyncTask *task = new MeshSyncTask(b_ob, mesh, hide_tris);
+
 	/* create derived mesh */
-	array<int> oldtriangle = mesh->triangles;
+	task->oldtriangle = mesh->triangles;
 	
 	/* compares curve_keys rather than strands in order to handle quick hair
 	 * adjustments in dynamic BVH - other methods could probably do this better*/
-	array<float3> oldcurve_keys = mesh->curve_keys;
-	array<float> oldcurve_radius = mesh->curve_radius;
+	task->oldcurve_keys = mesh->curve_keys;
+	task->oldcurve_radius = mesh->curve_radius;
 
 	mesh->clear();
 	mesh->used_shaders = used_shaders;
@@ -961,62 +1161,135 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 
 		mesh->subdivision_type = object_subdivision_type(b_ob, preview, experimental);
 
-		BL::Mesh b_mesh = object_to_mesh(b_data, b_ob, b_scene, true, !preview, need_undeformed, mesh->subdivision_type);
+		task->b_mesh = object_to_mesh(b_data, b_ob, b_scene, true, !preview, need_undeformed, mesh->subdivision_type);
 
-		if(b_mesh) {
-			if(render_layer.use_surfaces && !hide_tris) {
-				if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
-					create_subd_mesh(scene, mesh, b_ob, b_mesh, used_shaders,
-					                 dicing_rate, max_subdivisions);
-				else
-					create_mesh(scene, mesh, b_mesh, used_shaders, false);
+		/* dicing uses the camera, which can't be updated from the tasks */
+		if(task->b_mesh && mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
+			scene->camera->update();
+	}
+	mesh->geometry_flags = requested_geometry_flags;
 
-				create_mesh_volume_attributes(scene, b_ob, mesh, b_scene.frame_current());
-			}
+	/* the mesh is fully tagged once converted, objects using it need to
+	 * know it changed already */
+	mesh->need_update = true;
+
+	/* convert the geometry along with other meshes, the number of pending
+	 * meshes is limited since they keep their Blender mesh alive until then */
+	mesh_sync_tasks.push_back(task);
+
+	const size_t max_tasks = max(TaskScheduler::num_threads(), 1) * MESH_SYNC_TASKS_PER_THREAD;
+
+	if(mesh_sync_tasks.size() >= max_tasks)
+		sync_meshes();
 
+	return mesh;
+}
+
+/* Converts the Blender mesh of a task, runs in a task pool so only the
+ * Cycles mesh of the task may be modified. */
+void BlenderSync::sync_mesh_geometry(MeshSyncTask *task)
+{
+	Mesh *mesh = task->mesh;
+
+	if(!task->b_mesh || !render_layer.use_surfaces || task->hide_tris)
+		return;
+
+	double sync_time = time_dt();
+
+	if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
+		create_subd_mesh(scene, mesh, task->b_ob, task->b_mesh, mesh->used_shaders,
+		                 dicing_rate, max_subdivisions);
+	else
+		create_mesh(scene, mesh, task->b_mesh, mesh->used_shaders, false);
+
+	{
+		/* volume attributes add images to the shared image manager */
+		thread_scoped_lock scene_lock(scene_mutex);
+		create_mesh_volume_attributes(scene, task->b_ob, mesh, b_scene.frame_current());
+	}
+
+	VLOG(1) << "Synced mesh " << mesh->name << " ("
+	        << mesh->verts.size() << " vertices, "
+	        << mesh->num_triangles() << " triangles) in "
+	        << time_dt() - sync_time << " seconds.";
+}
+
+/* Converts all meshes collected by sync_mesh() and tags them for update. */
+void BlenderSync::sync_meshes()
+{
+	if(mesh_sync_tasks.empty())
+		return;
+
+	/* When viewport display is not needed during render we can force some
+	 * caches to be releases from blender side in order to reduce peak memory
+	 * footprint during synchronization process.
+	 */
+	const bool is_interface_locked = b_engine.render() &&
+	                                 b_engine.render().use_lock_interface();
+	const bool can_free_caches = BlenderSession::headless || is_interface_locked;
+
+	double sync_time = time_dt();
+
+	TaskPool pool;
+	foreach(MeshSyncTask *task, mesh_sync_tasks)
+		pool.push(function_bind(&BlenderSync::sync_mesh_geometry, this, task));
+	pool.wait_work();
+
+	/* hair and freeing Blender data modify Blender side data, done serially */
+	foreach(MeshSyncTask *task, mesh_sync_tasks) {
+		Mesh *mesh = task->mesh;
+
+		if(task->b_mesh) {
 			if(render_layer.use_hair && mesh->subdivision_type == Mesh::SUBDIVISION_NONE)
-				sync_curves(mesh, b_mesh, b_ob, false);
+				sync_curves(mesh, task->b_mesh, task->b_ob, false);
 
 			if(can_free_caches) {
-				b_ob.cache_release();
+				task->b_ob.cache_release();
 			}
 
 			/* free derived mesh */
-			b_data.meshes.remove(b_mesh, false);
+			b_data.meshes.remove(task->b_mesh, false);
 		}
-	}
-	mesh->geometry_flags = requested_geometry_flags;
 
-	/* fluid motion */
-	sync_mesh_fluid_motion(b_ob, scene, mesh);
+		/* fluid motion */
+		sync_mesh_fluid_motion(task->b_ob, scene, mesh);
 
-	/* tag update */
-	bool rebuild = false;
+		/* tag update */
+		bool rebuild = false;
+		array<int>& oldtriangle = task->oldtriangle;
+		array<float3>& oldcurve_keys = task->oldcurve_keys;
+		array<float>& oldcurve_radius = task->oldcurve_radius;
 
-	if(oldtriangle.size() != mesh->triangles.size())
-		rebuild = true;
-	else if(oldtriangle.size()) {
-		if(memcmp(&oldtriangle[0], &mesh->triangles[0], sizeof(int)*oldtriangle.size()) != 0)
+		if(oldtriangle.size() != mesh->triangles.size())
 			rebuild = true;
-	}
+		else if(oldtriangle.size()) {
+			if(memcmp(&oldtriangle[0], &mesh->triangles[0], sizeof(int)*oldtriangle.size()) != 0)
+				rebuild = true;
+		}
 
-	if(oldcurve_keys.size() != mesh->curve_keys.size())
-		rebuild = true;
-	else if(oldcurve_keys.size()) {
-		if(memcmp(&oldcurve_keys[0], &mesh->curve_keys[0], sizeof(float3)*oldcurve_keys.size()) != 0)
+		if(oldcurve_keys.size() != mesh->curve_keys.size())
 			rebuild = true;
-	}
+		else if(oldcurve_keys.size()) {
+			if(memcmp(&oldcurve_keys[0], &mesh->curve_keys[0], sizeof(float3)*oldcurve_keys.size()) != 0)
+				rebuild = true;
+		}
 
-	if(oldcurve_radius.size() != mesh->curve_radius.size())
-		rebuild = true;
-	else if(oldcurve_radius.size()) {
-		if(memcmp(&oldcurve_radius[0], &mesh->curve_radius[0], sizeof(float)*oldcurve_radius.size()) != 0)
+		if(oldcurve_radius.size() != mesh->curve_radius.size())
 			rebuild = true;
+		else if(oldcurve_radius.size()) {
+			if(memcmp(&oldcurve_radius[0], &mesh->curve_radius[0], sizeof(float)*oldcurve_radius.size()) != 0)
+				rebuild = true;
+		}
+
+		mesh->tag_update(scene, rebuild);
+
+		delete task;
 	}
-	
-	mesh->tag_update(scene, rebuild);
 
-	return mesh;
+	VLOG(1) << "Synced " << mesh_sync_tasks.size() << " meshes in "
+	        << time_dt() - sync_time << " seconds.";
+
+	mesh_sync_tasks.clear();
 }
 
 void BlenderSync::sync_mesh_motion(BL::Object& b_ob,
@@ -736,6 +736,10 @@ void BlenderSync::sync_objects(BL::SpaceView3D& b_v3d, float motion_time)
 		}
 	}
 
+	/* convert remaining meshes, also when cancelled to free Blender meshes */
+	if(!motion)
+		sync_meshes();
+
 	progress.set_sync_status("");
 
 	if(!cancel && !motion) {
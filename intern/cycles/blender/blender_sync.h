@@ -29,6 +29,7 @@
 
 #include "util_map.h"
 #include "util_set.h"
+#include "util_thread.h"
 #include "util_transform.h"
 #include "util_vector.h"
 
@@ -111,6 +112,7 @@ private:
 
 	void sync_nodes(Shader *shader, BL::ShaderNodeTree& b_ntree);
 	Mesh *sync_mesh(BL::Object& b_ob, bool object_updated, bool hide_tris);
+	void sync_meshes();
 	void sync_curves(Mesh *mesh,
 	                 BL::Mesh& b_mesh,
 	                 BL::Object& b_ob,
@@ -147,6 +149,26 @@ private:
 	/* Images. */
 	void sync_images();
 
+	/* Meshes are converted in a task pool once a batch of them was collected
+	 * by the object loop, see sync_mesh() and sync_meshes(). */
+	struct MeshSyncTask {
+		MeshSyncTask(BL::Object& b_ob_, Mesh *mesh_, bool hide_tris_)
+		: b_ob(b_ob_), b_mesh(PointerRNA_NULL), mesh(mesh_), hide_tris(hide_tris_)
+		{}
+
+		BL::Object b_ob;
+		BL::Mesh b_mesh;
+		Mesh *mesh;
+		bool hide_tris;
+
+		/* Geometry before the sync, to detect if the BVH must be rebuilt. */
+		array<int> oldtriangle;
+		array<float3> oldcurve_keys;
+		array<float> oldcurve_radius;
+	};
+
+	void sync_mesh_geometry(MeshSyncTask *task);
+
 	/* util */
 	void find_shader(BL::ID& id, vector<Shader*>& used_shaders, Shader *default_shader);
 	bool BKE_object_is_modified(BL::Object& b_ob);
@@ -165,6 +187,9 @@ private:
 	id_map<ParticleSystemKey, ParticleSystem> particle_system_map;
 	set<Mesh*> mesh_synced;
 	set<Mesh*> mesh_motion_synced;
+	vector<MeshSyncTask*> mesh_sync_tasks;
+	/* Guards scene data shared by the mesh sync tasks. */
+	thread_mutex scene_mutex;
 	set<float> motion_times;
 	void *world_map;
 	bool world_recalc;
@@ -25,8 +25,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define HEAP_BASE 16
+#define HEAP_BASE_MIN 8
 #define UCHAR unsigned char
 
 /**
@@ -63,88 +65,68 @@ virtual int getBytes( ) = 0;
 /**
  * Dynamic memory allocator - allows allocation/deallocation
  *
- * Note: there are 4 bytes overhead for each allocated yet unused object.
+ * Objects are taken from data blocks which grow in size as they fill up,
+ * deallocated objects are linked into a free list stored in the objects themselves,
+ * so there is no per-object overhead and little memory is used for small trees.
  */
 template < int N >
 class MemoryAllocator : public VirtualMemoryAllocator
 {
 private:
 
-/// Constants
-int HEAP_UNIT, HEAP_MASK;
+/// Objects need to be able to store the free list link
+typedef char size_check[(N >= (int)sizeof(UCHAR *)) ? 1 : -1];
 
 /// Data array
 UCHAR **data;
 
-/// Allocation stack
-UCHAR ***stack;
-
 /// Number of data blocks
 int datablocknum;
 
-/// Number of stack blocks
-int stackblocknum;
+/// Number of objects in the last data block, and how many of those are used
+int blocksize;
+int blockused;
+
+/// Total number of objects in all data blocks
+int total;
 
-/// Size of stack
-int stacksize;
+/// Number of allocated objects
+int allocated;
 
-/// Number of available objects on stack
-int available;
+/// Head of the list of deallocated objects
+UCHAR *freelist;
 
 /**
- * Allocate a memory block
+ * Allocate a memory block, twice the size of the previous one up to 2^HEAP_BASE objects
  */
 void allocateDataBlock( )
 {
-	// Allocate a data block
+	if (datablocknum != 0 && blocksize < (1 << HEAP_BASE)) {
+		blocksize <<= 1;
+	}
+
 	datablocknum += 1;
 	data = ( UCHAR ** )realloc(data, sizeof (UCHAR *) * datablocknum);
-	data[datablocknum - 1] = ( UCHAR * )malloc(HEAP_UNIT * N);
+	data[datablocknum - 1] = ( UCHAR * )malloc(blocksize * N);
 
-	// Update allocation stack
-	for (int i = 0; i < HEAP_UNIT; i++)
-	{
-		stack[0][i] = (data[datablocknum - 1] + i * N);
-	}
-	available = HEAP_UNIT;
-}
-
-/**
- * Allocate a stack block, to store more deallocated objects
- */
-void allocateStackBlock( )
-{
-	// Allocate a stack block
-	stackblocknum += 1;
-	stacksize += HEAP_UNIT;
-	stack = ( UCHAR *** )realloc(stack, sizeof (UCHAR * *) * stackblocknum);
-	stack[stackblocknum - 1] = ( UCHAR ** )malloc(HEAP_UNIT * sizeof (UCHAR *) );
+	blockused = 0;
+	total += blocksize;
 }
 
 
 public:
 /**
- * Constructor
+ * Constructor, no memory is allocated until the first object is
  */
 MemoryAllocator( )
 {
-	HEAP_UNIT = 1 << HEAP_BASE;
-	HEAP_MASK = (1 << HEAP_BASE) - 1;
-
-	data = ( UCHAR ** )malloc(sizeof(UCHAR *) );
-	data[0] = ( UCHAR * )malloc(HEAP_UNIT * N);
-	datablocknum = 1;
-
-	stack = ( UCHAR *** )malloc(sizeof (UCHAR * *) );
-	stack[0] = ( UCHAR ** )malloc(HEAP_UNIT * sizeof (UCHAR *) );
-	stackblocknum = 1;
-	stacksize = HEAP_UNIT;
-	available = HEAP_UNIT;
-
-	for (int i = 0; i < HEAP_UNIT; i++)
-	{
-		stack[0][i] = (data[0] + i * N);
-	}
+	data = NULL;
+	datablocknum = 0;
+	blocksize = 1 << HEAP_BASE_MIN;
+	blockused = blocksize;
+	total = 0;
+	allocated = 0;
+	freelist = NULL;
 }
 
 /**
@@ -152,17 +134,19 @@ MemoryAllocator( )
  */
 void destroy( )
 {
-	int i;
-	for (i = 0; i < datablocknum; i++)
+	for (int i = 0; i < datablocknum; i++)
 	{
 		free(data[i]);
 	}
-	for (i = 0; i < stackblocknum; i++)
-	{
-		free(stack[i]);
-	}
 	free(data);
-	free(stack);
+
+	data = NULL;
+	datablocknum = 0;
+	blocksize = 1 << HEAP_BASE_MIN;
+	blockused = blocksize;
+	total = 0;
+	allocated = 0;
+	freelist = NULL;
 }
 
 /**
@@ -170,14 +154,25 @@ void destroy( )
  */
 void *allocate( )
 {
-	if (available == 0)
+	UCHAR *obj;
+
+	if (freelist)
+	{
+		obj = freelist;
+		memcpy(&freelist, obj, sizeof(UCHAR *));
+	}
+	else
 	{
-		allocateDataBlock( );
+		if (blockused == blocksize)
+		{
+			allocateDataBlock( );
+		}
+		obj = data[datablocknum - 1] + blockused * N;
+		blockused++;
 	}
 
-	// printf("Allocating %d\n", header[ allocated ]) ;
-	available--;
-	return (void *)stack[available >> HEAP_BASE][available & HEAP_MASK];
+	allocated++;
+	return (void *)obj;
 }
 
 /**
@@ -185,15 +180,9 @@ void *allocate( )
  */
 void deallocate(void *obj)
 {
-	if (available == stacksize)
-	{
-		allocateStackBlock( );
-	}
-
-	// printf("De-allocating %d\n", ( obj - data ) / N ) ;
-	stack[available >> HEAP_BASE][available & HEAP_MASK] = (UCHAR *)obj;
-	available++;
-	// printf("%d %d\n", allocated, header[ allocated ]) ;
+	memcpy(obj, &freelist, sizeof(UCHAR *));
+	freelist = (UCHAR *)obj;
+	allocated--;
 }
 
 /**
@@ -201,7 +190,7 @@ void deallocate(void *obj)
  */
 void printInfo( )
 {
-	printf("Bytes: %d Used: %d Allocated: %d Maxfree: %d\n", getBytes(), getAllocated(), getAll(), stacksize);
+	printf("Bytes: %d Used: %d Allocated: %d Blocks: %d\n", getBytes(), getAllocated(), getAll(), datablocknum);
 }
 
 /**
@@ -209,12 +198,12 @@ void printInfo( )
  */
 int getAllocated( )
 {
-	return HEAP_UNIT * datablocknum - available;
+	return allocated;
 };
 
 int getAll( )
 {
-	return HEAP_UNIT * datablocknum;
+	return total;
 };
 
 int getBytes( )
@@ -26,6 +26,7 @@
 
 #include "octree.h"
 #include <Eigen/Dense>
+#include <algorithm>
 #include <limits>
 #include <time.h>
 
@@ -88,6 +89,9 @@ Octree::Octree(ModelReader *mr,
 
 	maxTrianglePerCell = 0;
 
+	subtree_allocators = NULL;
+	subtree_allocators_num = 0;
+
 	// Initialize memory
 #ifdef IN_VERBOSE_MODE
 	dc_printf("Range: %f origin: %f, %f,%f \n", range, origin[0], origin[1], origin[2]);
@@ -206,32 +210,49 @@ void Octree::scanConvert()
 
 void Octree::initMemory()
 {
-	leafalloc[0] = new MemoryAllocator<sizeof(LeafNode)>();
-	leafalloc[1] = new MemoryAllocator<sizeof(LeafNode) + sizeof(float) *EDGE_FLOATS>();
-	leafalloc[2] = new MemoryAllocator<sizeof(LeafNode) + sizeof(float) *EDGE_FLOATS * 2>();
-	leafalloc[3] = new MemoryAllocator<sizeof(LeafNode) + sizeof(float) *EDGE_FLOATS * 3>();
+	initMemory(&allocators);
+}
 
-	alloc[0] = new MemoryAllocator<sizeof(InternalNode)>();
-	alloc[1] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *)>();
-	alloc[2] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 2>();
-	alloc[3] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 3>();
-	alloc[4] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 4>();
-	alloc[5] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 5>();
-	alloc[6] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 6>();
-	alloc[7] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 7>();
-	alloc[8] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 8>();
+void Octree::initMemory(NodeAllocators *mem)
+{
+	mem->leafalloc[0] = new MemoryAllocator<sizeof(LeafNode)>();
+	mem->leafalloc[1] = new MemoryAllocator<sizeof(LeafNode) + sizeof(float) *EDGE_FLOATS>();
+	mem->leafalloc[2] = new MemoryAllocator<sizeof(LeafNode) + sizeof(float) *EDGE_FLOATS * 2>();
+	mem->leafalloc[3] = new MemoryAllocator<sizeof(LeafNode) + sizeof(float) *EDGE_FLOATS * 3>();
+
+	mem->alloc[0] = new MemoryAllocator<sizeof(InternalNode)>();
+	mem->alloc[1] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *)>();
+	mem->alloc[2] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 2>();
+	mem->alloc[3] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 3>();
+	mem->alloc[4] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 4>();
+	mem->alloc[5] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 5>();
+	mem->alloc[6] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 6>();
+	mem->alloc[7] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 7>();
+	mem->alloc[8] = new MemoryAllocator<sizeof(InternalNode) + sizeof(Node *) * 8>();
 }
 
 void Octree::freeMemory()
+{
+	freeMemory(&allocators);
+
+	for (int i = 0; i < subtree_allocators_num; i++) {
+		freeMemory(&subtree_allocators[i]);
+	}
+	delete[] subtree_allocators;
+	subtree_allocators = NULL;
+	subtree_allocators_num = 0;
+}
+
+void Octree::freeMemory(NodeAllocators *mem)
 {
 	for (int i = 0; i < 9; i++) {
-		alloc[i]->destroy();
-		delete alloc[i];
+		mem->alloc[i]->destroy();
+		delete mem->alloc[i];
 	}
 
 	for (int i = 0; i < 4; i++) {
-		leafalloc[i]->destroy();
-		delete leafalloc[i];
+		mem->leafalloc[i]->destroy();
+		delete mem->leafalloc[i];
 	}
 }
 
@@ -240,17 +261,27 @@ void Octree::printMemUsage()
 	int totalbytes = 0;
 	dc_printf("********* Internal nodes: \n");
 	for (int i = 0; i < 9; i++) {
-		alloc[i]->printInfo();
+		allocators.alloc[i]->printInfo();
 
-		totalbytes += alloc[i]->getAll() * alloc[i]->getBytes();
+		totalbytes += allocators.alloc[i]->getAll() * allocators.alloc[i]->getBytes();
 	}
 	dc_printf("********* Leaf nodes: \n");
 	int totalLeafs = 0;
 	for (int i = 0; i < 4; i++) {
-		leafalloc[i]->printInfo();
+		allocators.leafalloc[i]->printInfo();
 
-		totalbytes += leafalloc[i]->getAll() * leafalloc[i]->getBytes();
-		totalLeafs += leafalloc[i]->getAllocated();
+		totalbytes += allocators.leafalloc[i]->getAll() * allocators.leafalloc[i]->getBytes();
+		totalLeafs += allocators.leafalloc[i]->getAllocated();
+	}
+
+	for (int j = 0; j < subtree_allocators_num; j++) {
+		for (int i = 0; i < 9; i++) {
+			totalbytes += subtree_allocators[j].alloc[i]->getAll() * subtree_allocators[j].alloc[i]->getBytes();
+		}
+		for (int i = 0; i < 4; i++) {
+			totalbytes += subtree_allocators[j].leafalloc[i]->getAll() * subtree_allocators[j].leafalloc[i]->getBytes();
+			totalLeafs += subtree_allocators[j].leafalloc[i]->getAllocated();
+		}
 	}
 
 	dc_printf("Total allocated bytes on disk: %d \n", totalbytes);
@@ -275,6 +306,23 @@ void Octree::addAllTriangles()
 
 	srand(0);
 
+	/* Subtrees below this level are scan converted in parallel,
+	 * they need to be at least one level above the leaves. */
+	const int subtree_level = std::min(SUBTREE_LEVEL, maxDepth - 1);
+
+	if (subtree_level > 0) {
+		std::vector<Triangle> triangles;
+		triangles.reserve(reader->getNumTriangles());
+
+		while ((trian = reader->getNextTriangle()) != NULL) {
+			triangles.push_back(*trian);
+			delete trian;
+		}
+
+		addAllTrianglesParallel(triangles, subtree_level);
+		return;
+	}
+
 	while ((trian = reader->getNextTriangle()) != NULL) {
 		// Drop triangles
 		{
@@ -321,25 +369,33 @@ void Octree::addAllTriangles()
 	putchar(13);
 }
 
+/* Project the triangle's coordinates into the grid */
+static void project_triangle(Triangle *trian, const float origin[3], float range, int dimen)
+{
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++)
+			trian->vt[i][j] = dimen * (trian->vt[i][j] - origin[j]) / range;
+	}
+}
+
+static void triangle_grid_coords(const Triangle *trian, int64_t trig[3][3])
+{
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++)
+			trig[i][j] = (int64_t)(trian->vt[i][j]);
+	}
+}
+
 /* Prepare a triangle for insertion into the octree; call the other
    addTriangle() to (recursively) build the octree */
 void Octree::addTriangle(Triangle *trian, int triind)
 {
-	int i, j;
-
-	/* Project the triangle's coordinates into the grid */
-	for (i = 0; i < 3; i++) {
-		for (j = 0; j < 3; j++)
-			trian->vt[i][j] = dimen * (trian->vt[i][j] - origin[j]) / range;
-	}
+	project_triangle(trian, origin, range, dimen);
 
 	/* Generate projections */
 	int64_t cube[2][3] = {{0, 0, 0}, {dimen, dimen, dimen}};
 	int64_t trig[3][3];
-	for (i = 0; i < 3; i++) {
-		for (j = 0; j < 3; j++)
-			trig[i][j] = (int64_t)(trian->vt[i][j]);
-	}
+	triangle_grid_coords(trian, trig);
 
 	/* Add triangle to the octree */
 	int64_t errorvec = (int64_t)(0);
@@ -350,6 +406,184 @@ void Octree::addTriangle(Triangle *trian, int triind)
 	delete proj;
 }
 
+/* Scan convert the subtrees of all cells at subtree_level in parallel.
+
+   Each cell gets the triangles overlapping its bounds in their original
+   order, and goes through the same tests as the serial scan conversion to
+   get there, so the resulting octree is the same. Nodes are allocated from
+   the subtree's own allocators, which stay alive with the octree. */
+void Octree::addAllTrianglesParallel(std::vector<Triangle>& triangles, int subtree_level)
+{
+	const int tottri = (int)triangles.size();
+	const int cells_axis = 1 << subtree_level;
+	const int cells_num = cells_axis * cells_axis * cells_axis;
+	const int cell_shift = GRID_DIMENSION - subtree_level;
+
+#pragma omp parallel for schedule(static)
+	for (int t = 0; t < tottri; t++) {
+		project_triangle(&triangles[t], origin, range, dimen);
+	}
+
+	/* Bin triangles by their (slightly enlarged) bounds,
+	 * the intersection tests of each level are inside these.
+	 * First count the triangles of each cell, then fill them in. */
+	std::vector<int> cell_offsets(cells_num + 1, 0);
+	std::vector<int> cell_triangles;
+
+	for (int pass = 0; pass < 2; pass++) {
+		if (pass == 1) {
+			for (int c = 0; c < cells_num; c++) {
+				cell_offsets[c + 1] += cell_offsets[c];
+			}
+			cell_triangles.resize(cell_offsets[cells_num]);
+		}
+
+		for (int t = 0; t < tottri; t++) {
+			int64_t trig[3][3];
+			int cmin[3], cmax[3];
+			triangle_grid_coords(&triangles[t], trig);
+
+			for (int j = 0; j < 3; j++) {
+				int64_t bmin = std::min(trig[0][j], std::min(trig[1][j], trig[2][j])) - 1;
+				int64_t bmax = std::max(trig[0][j], std::max(trig[1][j], trig[2][j])) + 1;
+				bmin = std::max(bmin, (int64_t)0);
+				bmax = std::min(bmax, (int64_t)dimen - 1);
+				cmin[j] = (int)(bmin >> cell_shift);
+				cmax[j] = (int)(bmax >> cell_shift);
+			}
+
+			for (int x = cmin[0]; x <= cmax[0]; x++) {
+				for (int y = cmin[1]; y <= cmax[1]; y++) {
+					for (int z = cmin[2]; z <= cmax[2]; z++) {
+						const int c = (x * cells_axis + y) * cells_axis + z;
+						if (pass == 0) {
+							cell_offsets[c + 1]++;
+						}
+						else {
+							cell_triangles[cell_offsets[c]++] = t;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	/* Filling in moved the offsets to the end of each cell */
+	for (int c = cells_num; c > 0; c--) {
+		cell_offsets[c] = cell_offsets[c - 1];
+	}
+	cell_offsets[0] = 0;
+
+	subtree_allocators = new NodeAllocators[cells_num];
+	subtree_allocators_num = cells_num;
+	for (int c = 0; c < cells_num; c++) {
+		initMemory(&subtree_allocators[c]);
+	}
+
+	std::vector<InternalNode *> subtrees(cells_num);
+	/* Bit N set when a triangle intersected the cell at level N + 1 */
+	std::vector<unsigned char> subtree_used(cells_num);
+
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int c = 0; c < cells_num; c++) {
+		NodeAllocators *mem = &subtree_allocators[c];
+		const int cell[3] = {c / (cells_axis * cells_axis), (c / cells_axis) % cells_axis, c % cells_axis};
+		InternalNode *node = createInternal(0, mem);
+		unsigned char used = 0;
+
+		/* Child index of the cell at each level */
+		int path[SUBTREE_LEVEL];
+		for (int k = 0; k < subtree_level; k++) {
+			const int bit = subtree_level - 1 - k;
+			path[k] = (((cell[0] >> bit) & 1) << 2) | (((cell[1] >> bit) & 1) << 1) | ((cell[2] >> bit) & 1);
+		}
+
+		for (int i = cell_offsets[c]; i < cell_offsets[c + 1]; i++) {
+			const int t = cell_triangles[i];
+			int64_t cube[2][3] = {{0, 0, 0}, {dimen, dimen, dimen}};
+			int64_t trig[3][3];
+			triangle_grid_coords(&triangles[t], trig);
+
+			/* Same tests as addTriangle() on the way down to the cell */
+			CubeTriangleIsect proj[SUBTREE_LEVEL + 1];
+			proj[0] = CubeTriangleIsect(cube, trig, (int64_t)(0), t);
+
+			bool inside = true;
+			for (int k = 0; k < subtree_level; k++) {
+				int off[3] = {vertmap[path[k]][0], vertmap[path[k]][1], vertmap[path[k]][2]};
+
+				if (!(proj[k].getBoxMask() & (1 << path[k]))) {
+					inside = false;
+					break;
+				}
+
+				proj[k + 1] = CubeTriangleIsect(&proj[k]);
+				proj[k + 1].shift(off);
+
+				if (!proj[k + 1].isIntersecting()) {
+					inside = false;
+					break;
+				}
+				used |= (1 << k);
+			}
+
+			if (inside) {
+				node = addTriangle(node, &proj[subtree_level], maxDepth - subtree_level, mem);
+			}
+
+			delete proj[0].inherit;
+		}
+
+		subtrees[c] = node;
+		subtree_used[c] = used;
+	}
+
+	const int cell[3] = {0, 0, 0};
+	removeInternal(0, &root->internal);
+	root = (Node *)linkSubtrees(&subtrees[0], &subtree_used[0], subtree_level, 0, cell);
+}
+
+/* Create the nodes above the subtrees, only where triangles intersected them */
+InternalNode *Octree::linkSubtrees(InternalNode **subtrees, const unsigned char *subtree_used,
+                                   int subtree_level, int depth, const int cell[3])
+{
+	const int cells_axis = 1 << subtree_level;
+
+	if (depth == subtree_level) {
+		return subtrees[(cell[0] * cells_axis + cell[1]) * cells_axis + cell[2]];
+	}
+
+	InternalNode *node = createInternal(0);
+	int count = 0;
+
+	for (int i = 0; i < 8; i++) {
+		const int chd_cell[3] = {cell[0] * 2 + vertmap[i][0],
+		                         cell[1] * 2 + vertmap[i][1],
+		                         cell[2] * 2 + vertmap[i][2]};
+
+		/* Check all subtrees below the child */
+		const int span = 1 << (subtree_level - depth - 1);
+		bool used = false;
+		for (int x = 0; x < span && !used; x++) {
+			for (int y = 0; y < span && !used; y++) {
+				for (int z = 0; z < span && !used; z++) {
+					const int c = (((chd_cell[0] * span + x) * cells_axis) +
+					               (chd_cell[1] * span + y)) * cells_axis + (chd_cell[2] * span + z);
+					used = (subtree_used[c] & (1 << depth)) != 0;
+				}
+			}
+		}
+
+		if (used) {
+			node = addInternalChild(node, i, count,
+			                        linkSubtrees(subtrees, subtree_used, subtree_level, depth + 1, chd_cell));
+			count++;
+		}
+	}
+
+	return node;
+}
+
 #if 0
 static void print_depth(int height, int maxDepth)
 {
@@ -358,7 +592,8 @@ static void print_depth(int height, int maxDepth)
 }
 #endif
 
-InternalNode *Octree::addTriangle(InternalNode *node, CubeTriangleIsect *p, int height)
+InternalNode *Octree::addTriangle(InternalNode *node, CubeTriangleIsect *p, int height,
+                                  NodeAllocators *mem)
 {
 	int i;
 	const int vertdiff[8][3] = {
@@ -391,16 +626,16 @@ InternalNode *Octree::addTriangle(InternalNode *node, CubeTriangleIsect *p, int
 			if (subp->isIntersecting()) {
 				if (!node->has_child(i)) {
 					if (height == 1)
-						node = addLeafChild(node, i, count, createLeaf(0));
+						node = addLeafChild(node, i, count, createLeaf(0, mem), mem);
 					else
-						node = addInternalChild(node, i, count, createInternal(0));
+						node = addInternalChild(node, i, count, createInternal(0, mem), mem);
 				}
 				Node *chd = node->get_child(count);
 
 				if (node->is_child_leaf(i))
-					node->set_child(count, (Node *)updateCell(&chd->leaf, subp));
+					node->set_child(count, (Node *)updateCell(&chd->leaf, subp, mem));
 				else
-					node->set_child(count, (Node *)addTriangle(&chd->internal, subp, height - 1));
+					node->set_child(count, (Node *)addTriangle(&chd->internal, subp, height - 1, mem));
 			}
 		}
 
@@ -413,7 +648,7 @@ InternalNode *Octree::addTriangle(InternalNode *node, CubeTriangleIsect *p, int
 	return node;
 }
 
-LeafNode *Octree::updateCell(LeafNode *node, CubeTriangleIsect *p)
+LeafNode *Octree::updateCell(LeafNode *node, CubeTriangleIsect *p, NodeAllocators *mem)
 {
 	int i;
 
@@ -445,7 +680,7 @@ LeafNode *Octree::updateCell(LeafNode *node, CubeTriangleIsect *p)
 
 	if (newc > oldc) {
 		// New offsets added, update this node
-		node = updateEdgeOffsetsNormals(node, oldc, newc, offs, a, b, c);
+		node = updateEdgeOffsetsNormals(node, oldc, newc, offs, a, b, c, mem);
 	}
 
 	return node;
@@ -2063,11 +2298,44 @@ void Octree::writeOut()
 	actualVerts = 0;
 	actualQuads = 0;
 
-	generateMinimizer(root, st, dimen, maxDepth, offset);
-	cellProcContour(root, 0, maxDepth);
+	std::vector<MinimizerCell> cells;
+	cells.reserve(MINIMIZER_BATCH);
+	generateMinimizer(root, st, dimen, maxDepth, offset, cells);
+	addMinimizers(cells);
+
+	// Then contour the branches of the root in parallel,
+	// the quads are output in the same order as a single traversal
+	Node *chd[8];
+	for (int i = 0; i < 8; i++) {
+		chd[i] = root->internal.has_child(i) ?
+		         root->internal.get_child(root->internal.get_child_count(i)) : NULL;
+	}
+
+#pragma omp parallel for ordered schedule(dynamic, 1)
+	for (int i = 0; i < 8; i++) {
+		std::vector<int> quads;
+		cellProcContour(chd[i], root->internal.is_child_leaf(i), maxDepth - 1, quads);
+#pragma omp ordered
+		{
+			addQuads(quads);
+		}
+	}
+
+	std::vector<int> quads;
+	cellProcContourFaceEdge(root, chd, maxDepth, quads);
+	addQuads(quads);
+
 	dc_printf("Vertices written: %d Quads written: %d \n", offset, actualQuads);
 }
 
+void Octree::addQuads(const std::vector<int>& quads)
+{
+	for (size_t i = 0; i < quads.size(); i += 4) {
+		add_quad(output_mesh, &quads[i]);
+		actualQuads++;
+	}
+}
+
 void Octree::countIntersection(Node *node, int height, int& nedge, int& ncell, int& nface)
 {
 	if (height > 0) {
@@ -2257,27 +2525,13 @@ void Octree::computeMinimizer(const LeafNode *leaf, int st[3], int len,
 	}
 }
 
-void Octree::generateMinimizer(Node *node, int st[3], int len, int height, int& offset)
+void Octree::generateMinimizer(Node *node, int st[3], int len, int height, int& offset,
+                               std::vector<MinimizerCell>& cells)
 {
-	int i, j;
+	int i;
 
 	if (height == 0) {
-		// Leaf cell, generate
-
-		// First, find minimizer
-		float rvalue[3];
-		rvalue[0] = (float) st[0] + len / 2;
-		rvalue[1] = (float) st[1] + len / 2;
-		rvalue[2] = (float) st[2] + len / 2;
-		computeMinimizer(&node->leaf, st, len, rvalue);
-
-		// Update
-		//float fnst[3];
-		for (j = 0; j < 3; j++) {
-			rvalue[j] = rvalue[j] * range / dimen + origin[j];
-			//fnst[j] = st[j] * range / dimen + origin[j];
-		}
-
+		// Leaf cell, the minimizer is computed later (see writeOut)
 		int mult = 0, smask = getSignMask(&node->leaf);
 
 		if (use_manifold) {
@@ -2289,8 +2543,19 @@ void Octree::generateMinimizer(Node *node, int st[3], int len, int height, int&
 			}
 		}
 
-		for (j = 0; j < mult; j++) {
-			add_vert(output_mesh, rvalue);
+		if (mult) {
+			MinimizerCell cell;
+			cell.leaf = &node->leaf;
+			cell.st[0] = st[0];
+			cell.st[1] = st[1];
+			cell.st[2] = st[2];
+			cell.len = len;
+			cell.mult = mult;
+			cells.push_back(cell);
+
+			if (cells.size() == MINIMIZER_BATCH) {
+				addMinimizers(cells);
+			}
 		}
 
 		// Store the index
@@ -2310,14 +2575,43 @@ void Octree::generateMinimizer(Node *node, int st[3], int len, int height, int&
 				nst[2] = st[2] + vertmap[i][2] * len;
 
 				generateMinimizer(node->internal.get_child(count),
-				                  nst, len, height - 1, offset);
+				                  nst, len, height - 1, offset, cells);
 				count++;
 			}
 		}
 	}
 }
 
-void Octree::processEdgeWrite(Node *node[4], int /*depth*/[4], int /*maxdep*/, int dir)
+/* Compute the minimizers of a batch of cells in parallel, then output them in order */
+void Octree::addMinimizers(std::vector<MinimizerCell>& cells)
+{
+	const int totcell = (int)cells.size();
+
+#pragma omp parallel for schedule(dynamic, 64)
+	for (int i = 0; i < totcell; i++) {
+		MinimizerCell& cell = cells[i];
+		float *rvalue = cell.co;
+
+		rvalue[0] = (float) cell.st[0] + cell.len / 2;
+		rvalue[1] = (float) cell.st[1] + cell.len / 2;
+		rvalue[2] = (float) cell.st[2] + cell.len / 2;
+		computeMinimizer(cell.leaf, cell.st, cell.len, rvalue);
+
+		for (int j = 0; j < 3; j++) {
+			rvalue[j] = rvalue[j] * range / dimen + origin[j];
+		}
+	}
+
+	for (int i = 0; i < totcell; i++) {
+		for (int j = 0; j < cells[i].mult; j++) {
+			add_vert(output_mesh, cells[i].co);
+		}
+	}
+
+	cells.clear();
+}
+
+void Octree::processEdgeWrite(Node *node[4], int /*depth*/[4], int /*maxdep*/, int dir, std::vector<int>& quads)
 {
 	//int color = 0;
 
@@ -2369,7 +2663,7 @@ void Octree::processEdgeWrite(Node *node[4], int /*depth*/[4], int /*maxdep*/, i
 						ind[3] = getMinimizerIndex((LeafNode *)(node[2]));
 					}
 
-					add_quad(output_mesh, ind);
+					quads.insert(quads.end(), ind, ind + 4);
 				}
 			}
 			return;
@@ -2381,13 +2675,13 @@ void Octree::processEdgeWrite(Node *node[4], int /*depth*/[4], int /*maxdep*/, i
 }
 
 
-void Octree::edgeProcContour(Node *node[4], int leaf[4], int depth[4], int maxdep, int dir)
+void Octree::edgeProcContour(Node *node[4], int leaf[4], int depth[4], int maxdep, int dir, std::vector<int>& quads)
 {
 	if (!(node[0] && node[1] && node[2] && node[3])) {
 		return;
 	}
 	if (leaf[0] && leaf[1] && leaf[2] && leaf[3]) {
-		processEdgeWrite(node, depth, maxdep, dir);
+		processEdgeWrite(node, depth, maxdep, dir, quads);
 	}
 	else {
 		int i, j;
@@ -2423,13 +2717,13 @@ void Octree::edgeProcContour(Node *node[4], int leaf[4], int depth[4], int maxde
 				}
 			}
 
-			edgeProcContour(ne, le, de, maxdep - 1, edgeProcEdgeMask[dir][i][4]);
+			edgeProcContour(ne, le, de, maxdep - 1, edgeProcEdgeMask[dir][i][4], quads);
 		}
 
 	}
 }
 
-void Octree::faceProcContour(Node *node[2], int leaf[2], int depth[2], int maxdep, int dir)
+void Octree::faceProcContour(Node *node[2], int leaf[2], int depth[2], int maxdep, int dir, std::vector<int>& quads)
 {
 	if (!(node[0] && node[1])) {
 		return;
@@ -2465,7 +2759,7 @@ void Octree::faceProcContour(Node *node[2], int leaf[2], int depth[2], int maxde
 					df[j] = depth[j] - 1;
 				}
 			}
-			faceProcContour(nf, lf, df, maxdep - 1, faceProcFaceMask[dir][i][2]);
+			faceProcContour(nf, lf, df, maxdep - 1, faceProcFaceMask[dir][i][2], quads);
 		}
 
 		// 4 edge calls
@@ -2492,13 +2786,13 @@ void Octree::faceProcContour(Node *node[2], int leaf[2], int depth[2], int maxde
 				}
 			}
 
-			edgeProcContour(ne, le, de, maxdep - 1, faceProcEdgeMask[dir][i][5]);
+			edgeProcContour(ne, le, de, maxdep - 1, faceProcEdgeMask[dir][i][5], quads);
 		}
 	}
 }
 
 
-void Octree::cellProcContour(Node *node, int leaf, int depth)
+void Octree::cellProcContour(Node *node, int leaf, int depth, std::vector<int>& quads)
 {
 	if (node == NULL) {
 		return;
@@ -2516,41 +2810,49 @@ void Octree::cellProcContour(Node *node, int leaf, int depth)
 
 		// 8 Cell calls
 		for (i = 0; i < 8; i++) {
-			cellProcContour(chd[i], node->internal.is_child_leaf(i), depth - 1);
+			cellProcContour(chd[i], node->internal.is_child_leaf(i), depth - 1, quads);
 		}
 
-		// 12 face calls
-		Node *nf[2];
-		int lf[2];
-		int df[2] = {depth - 1, depth - 1};
-		for (i = 0; i < 12; i++) {
-			int c[2] = {cellProcFaceMask[i][0], cellProcFaceMask[i][1]};
+		cellProcContourFaceEdge(node, chd, depth, quads);
+	}
 
-			lf[0] = node->internal.is_child_leaf(c[0]);
-			lf[1] = node->internal.is_child_leaf(c[1]);
+}
 
-			nf[0] = chd[c[0]];
-			nf[1] = chd[c[1]];
+/* Faces and edges between the children of an internal node */
+void Octree::cellProcContourFaceEdge(Node *node, Node *chd[8], int depth, std::vector<int>& quads)
+{
+	int i;
 
-			faceProcContour(nf, lf, df, depth - 1, cellProcFaceMask[i][2]);
-		}
+	// 12 face calls
+	Node *nf[2];
+	int lf[2];
+	int df[2] = {depth - 1, depth - 1};
+	for (i = 0; i < 12; i++) {
+		int c[2] = {cellProcFaceMask[i][0], cellProcFaceMask[i][1]};
 
-		// 6 edge calls
-		Node *ne[4];
-		int le[4];
-		int de[4] = {depth - 1, depth - 1, depth - 1, depth - 1};
-		for (i = 0; i < 6; i++) {
-			int c[4] = {cellProcEdgeMask[i][0], cellProcEdgeMask[i][1], cellProcEdgeMask[i][2], cellProcEdgeMask[i][3]};
+		lf[0] = node->internal.is_child_leaf(c[0]);
+		lf[1] = node->internal.is_child_leaf(c[1]);
 
-			for (int j = 0; j < 4; j++) {
-				le[j] = node->internal.is_child_leaf(c[j]);
-				ne[j] = chd[c[j]];
-			}
+		nf[0] = chd[c[0]];
+		nf[1] = chd[c[1]];
 
-			edgeProcContour(ne, le, de, depth - 1, cellProcEdgeMask[i][4]);
-		}
+		faceProcContour(nf, lf, df, depth - 1, cellProcFaceMask[i][2], quads);
 	}
 
+	// 6 edge calls
+	Node *ne[4];
+	int le[4];
+	int de[4] = {depth - 1, depth - 1, depth - 1, depth - 1};
+	for (i = 0; i < 6; i++) {
+		int c[4] = {cellProcEdgeMask[i][0], cellProcEdgeMask[i][1], cellProcEdgeMask[i][2], cellProcEdgeMask[i][3]};
+
+		for (int j = 0; j < 4; j++) {
+			le[j] = node->internal.is_child_leaf(c[j]);
+			ne[j] = chd[c[j]];
+		}
+
+		edgeProcContour(ne, le, de, depth - 1, cellProcEdgeMask[i][4], quads);
+	}
 }
 
 void Octree::processEdgeParity(LeafNode *node[4], int /*depth*/[4], int /*maxdep*/, int dir)
@@ -27,6 +27,7 @@
 #include <cstring>
 #include <stdio.h>
 #include <math.h>
+#include <vector>
 #include "GeoCommon.h"
 #include "Projections.h"
 #include "ModelReader.h"
@@ -55,6 +56,12 @@
 
 #define EDGE_FLOATS 4
 
+/* Scan convert the subtrees below this level in parallel (up to 8^N of them) */
+#define SUBTREE_LEVEL 2
+
+/* Number of cells to compute minimizers for at once */
+#define MINIMIZER_BATCH 16384
+
 union Node;
 struct LeafNode;
 
@@ -223,6 +230,15 @@ struct PathList {
 };
 
 
+/**
+ * Allocators for internal nodes (by number of children)
+ * and leaf nodes (by number of stored edge intersections)
+ */
+struct NodeAllocators {
+	VirtualMemoryAllocator *alloc[9];
+	VirtualMemoryAllocator *leafalloc[4];
+};
+
 /**
  * Class for building and processing an octree
  */
@@ -232,8 +248,12 @@ class Octree
 	/* Public members */
 
 	/// Memory allocators
-	VirtualMemoryAllocator *alloc[9];
-	VirtualMemoryAllocator *leafalloc[4];
+	NodeAllocators allocators;
+
+	/// Allocators of the subtrees which are scan converted in parallel,
+	/// their nodes are part of the octree until it's freed
+	NodeAllocators *subtree_allocators;
+	int subtree_allocators_num;
 
 	/// Root node
 	Node *root;
@@ -309,11 +329,13 @@ class Octree
 	 * Initialize memory allocators
 	 */
 	void initMemory();
+	static void initMemory(NodeAllocators *mem);
 
 	/**
 	 * Release memory
 	 */
 	void freeMemory();
+	static void freeMemory(NodeAllocators *mem);
 
 	/**
 	 * Print memory usage
@@ -337,12 +359,20 @@ class Octree
 	 */
 	void addAllTriangles();
 	void addTriangle(Triangle *trian, int triind);
-	InternalNode *addTriangle(InternalNode *node, CubeTriangleIsect *p, int height);
+	InternalNode *addTriangle(InternalNode *node, CubeTriangleIsect *p, int height,
+	                          NodeAllocators *mem = NULL);
+
+	/**
+	 * Scan convert the triangles into separate subtrees in parallel, then link them to the root
+	 */
+	void addAllTrianglesParallel(std::vector<Triangle>& triangles, int level);
+	InternalNode *linkSubtrees(InternalNode **subtrees, const unsigned char *subtree_used,
+	                           int level, int depth, const int cell[3]);
 
 	/**
 	 * Method to update minimizer in a cell: update edge intersections instead
 	 */
-	LeafNode *updateCell(LeafNode *node, CubeTriangleIsect *p);
+	LeafNode *updateCell(LeafNode *node, CubeTriangleIsect *p, NodeAllocators *mem = NULL);
 
 	/* Routines to detect and patch holes */
 	int numRings;
@@ -421,17 +451,31 @@ class Octree
 	void writeOut();
 
 	void countIntersection(Node *node, int height, int& nedge, int& ncell, int& nface);
-	void generateMinimizer(Node *node, int st[3], int len, int height, int& offset);
+
+	/// Leaf cell which outputs vertices,
+	/// minimizers are computed in parallel for batches of these
+	struct MinimizerCell {
+		LeafNode *leaf;
+		int st[3];
+		int len;
+		int mult;
+		float co[3];
+	};
+	void generateMinimizer(Node *node, int st[3], int len, int height, int& offset,
+	                       std::vector<MinimizerCell>& cells);
+	void addMinimizers(std::vector<MinimizerCell>& cells);
+	void addQuads(const std::vector<int>& quads);
 	void computeMinimizer(const LeafNode * leaf, int st[3], int len,
 	                      float rvalue[3]) const;
 	/**
-	 * Traversal functions to generate polygon model
-	 * op: 0 for counting, 1 for writing OBJ, 2 for writing OFF, 3 for writing PLY
+	 * Traversal functions to generate polygon model,
+	 * quads are collected per branch of the octree (4 indices each) and output in order
 	 */
-	void cellProcContour(Node *node, int leaf, int depth);
-	void faceProcContour(Node * node[2], int leaf[2], int depth[2], int maxdep, int dir);
-	void edgeProcContour(Node * node[4], int leaf[4], int depth[4], int maxdep, int dir);
-	void processEdgeWrite(Node * node[4], int depths[4], int maxdep, int dir);
+	void cellProcContour(Node *node, int leaf, int depth, std::vector<int>& quads);
+	void cellProcContourFaceEdge(Node *node, Node *chd[8], int depth, std::vector<int>& quads);
+	void faceProcContour(Node * node[2], int leaf[2], int depth[2], int maxdep, int dir, std::vector<int>& quads);
+	void edgeProcContour(Node * node[4], int leaf[4], int depth[4], int maxdep, int dir, std::vector<int>& quads);
+	void processEdgeWrite(Node * node[4], int depths[4], int maxdep, int dir, std::vector<int>& quads);
 
 	/* output callbacks/data */
 	DualConAllocOutput alloc_output;
@@ -1143,17 +1187,18 @@ class Octree
 
 
 	/// Update method
-	LeafNode *updateEdgeOffsetsNormals(LeafNode *leaf, int oldlen, int newlen, float offs[3], float a[3], float b[3], float c[3])
+	LeafNode *updateEdgeOffsetsNormals(LeafNode *leaf, int oldlen, int newlen, float offs[3], float a[3], float b[3], float c[3],
+	                                   NodeAllocators *mem = NULL)
 	{
 		// First, create a new leaf node
-		LeafNode *nleaf = createLeaf(newlen);
+		LeafNode *nleaf = createLeaf(newlen, mem);
 		*nleaf = *leaf;
 
 		// Next, fill in the offsets
 		setEdgeOffsetsNormals(nleaf, offs, a, b, c, newlen);
 
 		// Finally, delete the old leaf
-		removeLeaf(oldlen, leaf);
+		removeLeaf(oldlen, leaf, mem);
 
 		return nleaf;
 	}
@@ -1306,20 +1351,27 @@ class Octree
 		return rnode;
 	}
 
+	/// Allocators to use, NULL for the octree's own
+	/// (others are only used while scan converting subtrees in parallel)
+	NodeAllocators *getAllocators(NodeAllocators *mem)
+	{
+		return mem ? mem : &allocators;
+	}
+
 	/// Allocate a node
-	InternalNode *createInternal(int length)
+	InternalNode *createInternal(int length, NodeAllocators *mem = NULL)
 	{
-		InternalNode *inode = (InternalNode *)alloc[length]->allocate();
+		InternalNode *inode = (InternalNode *)getAllocators(mem)->alloc[length]->allocate();
 		inode->has_child_bitfield = 0;
 		inode->child_is_leaf_bitfield = 0;
 		return inode;
 	}
 
-	LeafNode *createLeaf(int length)
+	LeafNode *createLeaf(int length, NodeAllocators *mem = NULL)
 	{
 		assert(length <= 3);
 
-		LeafNode *lnode = (LeafNode *)leafalloc[length]->allocate();
+		LeafNode *lnode = (LeafNode *)getAllocators(mem)->leafalloc[length]->allocate();
 		lnode->edge_parity = 0;
 		lnode->primary_edge_intersections = 0;
 		lnode->signs = 0;
@@ -1327,23 +1379,23 @@ class Octree
 		return lnode;
 	}
 
-	void removeInternal(int num, InternalNode *node)
+	void removeInternal(int num, InternalNode *node, NodeAllocators *mem = NULL)
 	{
-		alloc[num]->deallocate(node);
+		getAllocators(mem)->alloc[num]->deallocate(node);
 	}
 
-	void removeLeaf(int num, LeafNode *leaf)
+	void removeLeaf(int num, LeafNode *leaf, NodeAllocators *mem = NULL)
 	{
 		assert(num >= 0 && num <= 3);
-		leafalloc[num]->deallocate(leaf);
+		getAllocators(mem)->leafalloc[num]->deallocate(leaf);
 	}
 
 	/// Add a leaf (by creating a new par node with the leaf added)
 	InternalNode *addLeafChild(InternalNode *par, int index, int count,
-							   LeafNode *leaf)
+							   LeafNode *leaf, NodeAllocators *mem = NULL)
 	{
 		int num = par->get_num_children() + 1;
-		InternalNode *npar = createInternal(num);
+		InternalNode *npar = createInternal(num, mem);
 		*npar = *par;
 
 		if (num == 1) {
@@ -1360,15 +1412,15 @@ class Octree
 			}
 		}
 
-		removeInternal(num - 1, par);
+		removeInternal(num - 1, par, mem);
 		return npar;
 	}
 
 	InternalNode *addInternalChild(InternalNode *par, int index, int count,
-								   InternalNode *node)
+								   InternalNode *node, NodeAllocators *mem = NULL)
 	{
 		int num = par->get_num_children() + 1;
-		InternalNode *npar = createInternal(num);
+		InternalNode *npar = createInternal(num, mem);
 		*npar = *par;
 
 		if (num == 1) {
@@ -1385,7 +1437,7 @@ class Octree
 			}
 		}
 
-		removeInternal(num - 1, par);
+		removeInternal(num - 1, par, mem);
 		return npar;
 	}
 
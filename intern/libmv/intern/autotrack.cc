@@ -75,6 +75,36 @@ int libmv_autoTrackMarker(libmv_AutoTrack* libmv_autotrack,
   return ok && result.is_usable();
 }
 
+void libmv_autoTrackMarkers(libmv_AutoTrack* libmv_autotrack,
+                            const libmv_TrackRegionOptions* libmv_options,
+                            libmv_Marker *libmv_tracked_markers,
+                            libmv_TrackRegionResult* libmv_results,
+                            int *success,
+                            int num_markers) {
+  libmv::vector<Marker> tracked_markers;
+  libmv::vector<TrackRegionOptions> options;
+  libmv::vector<TrackRegionResult> results;
+  libmv::vector<bool> tracked;
+  tracked_markers.resize(num_markers);
+  options.resize(num_markers);
+  for (int i = 0; i < num_markers; ++i) {
+    libmv_apiMarkerToMarker(libmv_tracked_markers[i], &tracked_markers[i]);
+    libmv_configureTrackRegionOptions(libmv_options[i], &options[i]);
+    // All markers share the same frames here, the coarse to fine brute
+    // search keeps wide search areas from dominating the tracking time.
+    options[i].use_brute_pyramid = true;
+  }
+  ((AutoTrack*) libmv_autotrack)->TrackMarkers(&tracked_markers,
+                                               options,
+                                               &results,
+                                               &tracked);
+  for (int i = 0; i < num_markers; ++i) {
+    libmv_markerToApiMarker(tracked_markers[i], &libmv_tracked_markers[i]);
+    libmv_regionTrackergetResult(results[i], &libmv_results[i]);
+    success[i] = tracked[i] && results[i].is_usable();
+  }
+}
+
 void libmv_autoTrackAddMarker(libmv_AutoTrack* libmv_autotrack,
                               const libmv_Marker* libmv_marker) {
   Marker marker;
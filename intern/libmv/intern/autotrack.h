@@ -55,6 +55,17 @@ int libmv_autoTrackMarker(libmv_AutoTrack* libmv_autotrack,
                           libmv_Marker *libmv_tracker_marker,
                           libmv_TrackRegionResult* libmv_result);
 
+// Track all the markers at once, with one set of options per marker. The
+// frames are prepared only once for all markers and the markers are tracked
+// in parallel. success[i] is what libmv_autoTrackMarker() returns for the
+// i-th marker.
+void libmv_autoTrackMarkers(libmv_AutoTrack* libmv_autotrack,
+                            const libmv_TrackRegionOptions* libmv_options,
+                            libmv_Marker *libmv_tracked_markers,
+                            libmv_TrackRegionResult* libmv_results,
+                            int *success,
+                            int num_markers);
+
 void libmv_autoTrackAddMarker(libmv_AutoTrack* libmv_autotrack,
                               const libmv_Marker* libmv_marker);
 
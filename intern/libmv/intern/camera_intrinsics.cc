@@ -283,6 +283,41 @@ void libmv_cameraIntrinsicsInvert(
   intrinsics->InvertIntrinsics(x, y, x1, y1);
 }
 
+void libmv_cameraIntrinsicsUpdatePointGrids(
+    libmv_CameraIntrinsics* libmv_intrinsics) {
+  CameraIntrinsics *intrinsics = (CameraIntrinsics *) libmv_intrinsics;
+  intrinsics->UpdatePointLookupGrids();
+}
+
+void libmv_cameraIntrinsicsCopyPointGrids(
+    const libmv_CameraIntrinsics* libmv_intrinsics_from,
+    libmv_CameraIntrinsics* libmv_intrinsics_to) {
+  const CameraIntrinsics *intrinsics_from =
+    (const CameraIntrinsics *) libmv_intrinsics_from;
+  CameraIntrinsics *intrinsics_to = (CameraIntrinsics *) libmv_intrinsics_to;
+  intrinsics_to->CopyPointLookupGrids(*intrinsics_from);
+}
+
+void libmv_cameraIntrinsicsDistortPoint(
+    const struct libmv_CameraIntrinsics* libmv_intrinsics,
+    double x,
+    double y,
+    double* x1,
+    double* y1) {
+  CameraIntrinsics *intrinsics = (CameraIntrinsics *) libmv_intrinsics;
+  intrinsics->DistortPoint(x, y, x1, y1);
+}
+
+void libmv_cameraIntrinsicsUndistortPoint(
+    const struct libmv_CameraIntrinsics* libmv_intrinsics,
+    double x,
+    double y,
+    double* x1,
+    double* y1) {
+  CameraIntrinsics *intrinsics = (CameraIntrinsics *) libmv_intrinsics;
+  intrinsics->UndistortPoint(x, y, x1, y1);
+}
+
 static void libmv_cameraIntrinsicsFillFromOptions(
     const libmv_CameraIntrinsicsOptions* camera_intrinsics_options,
     CameraIntrinsics* camera_intrinsics) {
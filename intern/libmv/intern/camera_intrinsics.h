@@ -121,6 +121,27 @@ void libmv_cameraIntrinsicsInvert(
     double* x1,
     double* y1);
 
+void libmv_cameraIntrinsicsUpdatePointGrids(
+    libmv_CameraIntrinsics* libmv_intrinsics);
+
+void libmv_cameraIntrinsicsCopyPointGrids(
+    const libmv_CameraIntrinsics* libmv_intrinsics_from,
+    libmv_CameraIntrinsics* libmv_intrinsics_to);
+
+void libmv_cameraIntrinsicsDistortPoint(
+    const struct libmv_CameraIntrinsics* libmv_intrinsics,
+    double x,
+    double y,
+    double* x1,
+    double* y1);
+
+void libmv_cameraIntrinsicsUndistortPoint(
+    const struct libmv_CameraIntrinsics* libmv_intrinsics,
+    double x,
+    double y,
+    double* x1,
+    double* y1);
+
 #ifdef __cplusplus
 }
 #endif
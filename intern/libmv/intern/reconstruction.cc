@@ -48,6 +48,7 @@ using libmv::ProgressUpdateCallback;
 
 using libmv::PolynomialCameraIntrinsics;
 using libmv::Tracks;
+using libmv::CompleteReconstructionOptions;
 using libmv::EuclideanBundle;
 using libmv::EuclideanCompleteReconstruction;
 using libmv::EuclideanReconstructTwoFrames;
@@ -89,6 +90,7 @@ void libmv_solveRefineIntrinsics(
     const Tracks &tracks,
     const int refine_intrinsics,
     const int bundle_constraints,
+    const int num_threads,
     reconstruct_progress_update_cb progress_update_callback,
     void* callback_customdata,
     EuclideanReconstruction* reconstruction,
@@ -115,7 +117,9 @@ void libmv_solveRefineIntrinsics(
                                   bundle_intrinsics,
                                   bundle_constraints,
                                   reconstruction,
-                                  intrinsics);
+                                  intrinsics,
+                                  NULL,
+                                  num_threads);
 }
 
 void finishReconstruction(
@@ -298,11 +302,17 @@ libmv_Reconstruction *libmv_solveReconstruction(
 
   update_callback.invoke(0, "Initial reconstruction");
 
+  CompleteReconstructionOptions complete_options;
+  complete_options.num_threads = libmv_reconstruction_options->num_threads;
+
   EuclideanReconstructTwoFrames(keyframe_markers, &reconstruction);
-  EuclideanBundle(normalized_tracks, &reconstruction);
+  EuclideanBundle(normalized_tracks,
+                  &reconstruction,
+                  libmv_reconstruction_options->num_threads);
   EuclideanCompleteReconstruction(normalized_tracks,
                                   &reconstruction,
-                                  &update_callback);
+                                  &update_callback,
+                                  complete_options);
 
   /* Refinement/ */
   if (libmv_reconstruction_options->refine_intrinsics) {
@@ -310,6 +320,7 @@ libmv_Reconstruction *libmv_solveReconstruction(
                                 tracks,
                                 libmv_reconstruction_options->refine_intrinsics,
                                 libmv::BUNDLE_NO_CONSTRAINTS,
+                                libmv_reconstruction_options->num_threads,
                                 progress_update_callback,
                                 callback_customdata,
                                 &reconstruction,
@@ -365,7 +376,9 @@ libmv_Reconstruction *libmv_solveModal(
                                   libmv::BUNDLE_NO_INTRINSICS,
                                   libmv::BUNDLE_NO_TRANSLATION,
                                   &reconstruction,
-                                  &empty_intrinsics);
+                                  &empty_intrinsics,
+                                  NULL,
+                                  libmv_reconstruction_options->num_threads);
 
   /* Refinement. */
   if (libmv_reconstruction_options->refine_intrinsics) {
@@ -373,6 +386,7 @@ libmv_Reconstruction *libmv_solveModal(
                                 tracks,
                                 libmv_reconstruction_options->refine_intrinsics,
                                 libmv::BUNDLE_NO_TRANSLATION,
+                                libmv_reconstruction_options->num_threads,
                                 progress_update_callback, callback_customdata,
                                 &reconstruction,
                                 camera_intrinsics);
@@ -48,6 +48,7 @@ typedef struct libmv_ReconstructionOptions {
   int select_keyframes;
   int keyframe1, keyframe2;
   int refine_intrinsics;
+  int num_threads;
 } libmv_ReconstructionOptions;
 
 typedef void (*reconstruct_progress_update_cb) (void* customdata,
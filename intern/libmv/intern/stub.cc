@@ -322,6 +322,35 @@ void libmv_cameraIntrinsicsInvert(
   *y1 = 0.0;
 }
 
+void libmv_cameraIntrinsicsUpdatePointGrids(
+    libmv_CameraIntrinsics* /*libmv_intrinsics*/) {
+}
+
+void libmv_cameraIntrinsicsCopyPointGrids(
+    const libmv_CameraIntrinsics* /*libmv_intrinsics_from*/,
+    libmv_CameraIntrinsics* /*libmv_intrinsics_to*/) {
+}
+
+void libmv_cameraIntrinsicsDistortPoint(
+    const struct libmv_CameraIntrinsics* /*libmv_intrinsics*/,
+    double x,
+    double y,
+    double* x1,
+    double* y1) {
+  *x1 = x;
+  *y1 = y;
+}
+
+void libmv_cameraIntrinsicsUndistortPoint(
+    const struct libmv_CameraIntrinsics* /*libmv_intrinsics*/,
+    double x,
+    double y,
+    double* x1,
+    double* y1) {
+  *x1 = x;
+  *y1 = y;
+}
+
 void libmv_homography2DFromCorrespondencesEuc(/* const */ double (* /*x1*/)[2],
                                               /* const */ double (* /*x2*/)[2],
                                               int /*num_points*/,
@@ -356,6 +385,18 @@ int libmv_autoTrackMarker(libmv_AutoTrack* /*libmv_autotrack*/,
   return 0;
 }
 
+void libmv_autoTrackMarkers(libmv_AutoTrack* /*libmv_autotrack*/,
+                            const libmv_TrackRegionOptions* /*libmv_options*/,
+                            libmv_Marker * /*libmv_tracked_markers*/,
+                            libmv_TrackRegionResult* /*libmv_results*/,
+                            int *success,
+                            int num_markers)
+{
+  for (int i = 0; i < num_markers; ++i) {
+    success[i] = 0;
+  }
+}
+
 void libmv_autoTrackAddMarker(libmv_AutoTrack* /*libmv_autotrack*/,
                               const libmv_Marker* /*libmv_marker*/)
 {
@@ -21,10 +21,16 @@
 // Author: mierle@gmail.com (Keir Mierle)
 
 #include "libmv/autotrack/autotrack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
 #include "libmv/autotrack/quad.h"
 #include "libmv/autotrack/frame_accessor.h"
 #include "libmv/autotrack/predict_tracks.h"
 #include "libmv/base/scoped_ptr.h"
+#include "libmv/image/convolve.h"
 #include "libmv/logging/logging.h"
 #include "libmv/numeric/numeric.h"
 
@@ -90,6 +96,25 @@ void MarkerToArrays(const Marker& marker, double* x, double* y) {
   y[4] = marker.center.y() - origin(1);
 }
 
+FrameAccessor::Key GetImage(FrameAccessor* frame_accessor,
+                            int clip,
+                            int frame,
+                            int disabled_channels,
+                            const Region* region,
+                            FloatImage* image) {
+  libmv::scoped_ptr<FrameAccessor::Transform> transform = NULL;
+  if (disabled_channels != 0) {
+    transform.reset(new DisableChannelsTransform(disabled_channels));
+  }
+  return frame_accessor->GetImage(clip,
+                                  frame,
+                                  FrameAccessor::MONO,
+                                  0,  // No downscale for now.
+                                  region,
+                                  transform.get(),
+                                  image);
+}
+
 FrameAccessor::Key GetImageForMarker(const Marker& marker,
                                      FrameAccessor* frame_accessor,
                                      FloatImage* image) {
@@ -98,21 +123,224 @@ FrameAccessor::Key GetImageForMarker(const Marker& marker,
   // do rounding here.
   // Ideally we would need to pass IntRegion to the frame accessor.
   Region region = marker.search_region.Rounded();
-  libmv::scoped_ptr<FrameAccessor::Transform> transform = NULL;
-  if (marker.disabled_channels != 0) {
-    transform.reset(new DisableChannelsTransform(marker.disabled_channels));
+  return GetImage(frame_accessor,
+                  marker.clip,
+                  marker.frame,
+                  marker.disabled_channels,
+                  &region,
+                  image);
+}
+
+// Copy the region out of the image. Pixels outside of the image are set to
+// zero, the same as the frame accessor does for regions crossing the border.
+void CropImage(const FloatImage& image,
+               const Region& region,
+               FloatImage* cropped_image) {
+  const int origin_x = region.min(0), origin_y = region.min(1);
+  const int width = region.max(0) - region.min(0),
+            height = region.max(1) - region.min(1);
+  const int depth = image.Depth();
+  cropped_image->Resize(height, width, depth);
+  cropped_image->Fill(0.0f);
+
+  const int begin_x = std::max(0, -origin_x),
+            end_x = std::min(width, image.Width() - origin_x);
+  if (begin_x >= end_x) {
+    return;
+  }
+  for (int y = std::max(0, -origin_y);
+       y < std::min(height, image.Height() - origin_y);
+       ++y) {
+    memcpy(&(*cropped_image)(y, begin_x, 0),
+           &image(origin_y + y, origin_x + begin_x, 0),
+           sizeof(float) * depth * (end_x - begin_x));
+  }
+}
+
+// Height of the bands of rows a frame is blurred in by different threads.
+const int kFrameBlurBandHeight = 64;
+
+// Same as BlurredImageAndDerivativesChannels() for a whole frame, but done in
+// parallel on bands of rows. The bands overlap by the kernel radius, so the
+// result is exactly the same as when blurring the frame in one piece.
+void BlurredFrameAndDerivativesChannels(const FloatImage& image,
+                                        double sigma,
+                                        FloatImage* blurred_and_gradxy) {
+  libmv::Vec kernel, derivative;
+  libmv::ComputeGaussianKernel(sigma, &kernel, &derivative);
+  const int radius = kernel.size() / 2;
+
+  const int width = image.Width(), height = image.Height();
+  const int num_bands =
+      (height + kFrameBlurBandHeight - 1) / kFrameBlurBandHeight;
+  blurred_and_gradxy->Resize(height, width, 3);
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int band = 0; band < num_bands; ++band) {
+    const int begin_y = band * kFrameBlurBandHeight,
+              end_y = std::min(height, begin_y + kFrameBlurBandHeight);
+    const int padded_begin_y = std::max(0, begin_y - radius),
+              padded_end_y = std::min(height, end_y + radius);
+
+    FloatImage band_image(padded_end_y - padded_begin_y, width, 1);
+    memcpy(band_image.Data(),
+           &image(padded_begin_y, 0, 0),
+           sizeof(float) * width * band_image.Height());
+
+    FloatImage band_blurred_and_gradxy;
+    libmv::BlurredImageAndDerivativesChannels(band_image,
+                                              sigma,
+                                              &band_blurred_and_gradxy);
+    memcpy(&(*blurred_and_gradxy)(begin_y, 0, 0),
+           &band_blurred_and_gradxy(begin_y - padded_begin_y, 0, 0),
+           sizeof(float) * 3 * width * (end_y - begin_y));
   }
-  return frame_accessor->GetImage(marker.clip,
-                                  marker.frame,
-                                  FrameAccessor::MONO,
-                                  0,  // No downscale for now.
-                                  &region,
-                                  transform.get(),
-                                  image);
+}
+
+// Track the marker between the search region images of the reference and
+// tracked markers and update the tracked marker with the result. The blurred
+// images and derivatives are computed here if they are NULL.
+void TrackMarkerInImages(const Marker& reference_marker,
+                         const FloatImage& reference_image,
+                         const FloatImage* reference_image_and_gradient,
+                         const FloatImage& tracked_image,
+                         const FloatImage* tracked_image_and_gradient,
+                         bool predicted_position,
+                         const TrackRegionOptions* track_options,
+                         Marker* tracked_marker,
+                         TrackRegionResult* result) {
+  // Convert markers into the format expected by TrackRegion.
+  double x1[5], y1[5];
+  MarkerToArrays(reference_marker, x1, y1);
+
+  double x2[5], y2[5];
+  MarkerToArrays(*tracked_marker, x2, y2);
+
+  // Store original position befoer tracking, so we can claculate offset later.
+  Vec2f original_center = tracked_marker->center;
+
+  // Do the tracking!
+  TrackRegionOptions local_track_region_options;
+  if (track_options) {
+    local_track_region_options = *track_options;
+  }
+  local_track_region_options.num_extra_points = 1;  // For center point.
+  local_track_region_options.attempt_refine_before_brute = predicted_position;
+  if (reference_image_and_gradient && tracked_image_and_gradient) {
+    TrackRegion(reference_image,
+                *reference_image_and_gradient,
+                tracked_image,
+                *tracked_image_and_gradient,
+                x1, y1,
+                local_track_region_options,
+                x2, y2,
+                result);
+  } else {
+    TrackRegion(reference_image,
+                tracked_image,
+                x1, y1,
+                local_track_region_options,
+                x2, y2,
+                result);
+  }
+
+  // Copy results over the tracked marker.
+  Vec2f tracked_origin = tracked_marker->search_region.Rounded().min;
+  for (int i = 0; i < 4; ++i) {
+    tracked_marker->patch.coordinates(i, 0) = x2[i] + tracked_origin[0];
+    tracked_marker->patch.coordinates(i, 1) = y2[i] + tracked_origin[1];
+  }
+  tracked_marker->center(0) = x2[4] + tracked_origin[0];
+  tracked_marker->center(1) = y2[4] + tracked_origin[1];
+  Vec2f delta = tracked_marker->center - original_center;
+  tracked_marker->search_region.Offset(delta);
+  tracked_marker->source = Marker::TRACKED;
+  tracked_marker->status = Marker::UNKNOWN;
+  tracked_marker->reference_clip  = reference_marker.clip;
+  tracked_marker->reference_frame = reference_marker.frame;
 }
 
 }  // namespace
 
+// A frame is blurred as a whole once the search regions in it add up to this
+// part of its area, otherwise every search region is blurred on its own.
+static const double kMinFrameAreaForFrameBlur = 0.25;
+
+struct AutoTrack::FrameCache {
+  struct Key {
+    int clip;
+    int frame;
+    int disabled_channels;
+    double sigma;
+
+    bool operator<(const Key& other) const {
+      if (clip != other.clip) {
+        return clip < other.clip;
+      }
+      if (frame != other.frame) {
+        return frame < other.frame;
+      }
+      if (disabled_channels != other.disabled_channels) {
+        return disabled_channels < other.disabled_channels;
+      }
+      return sigma < other.sigma;
+    }
+  };
+
+  struct Frame {
+    Frame() : fetched(false), used(false), region_area(0.0) {}
+
+    // Mono frame with the disabled channels already taken into account.
+    FloatImage image;
+
+    // Blurred frame and its derivatives, empty if the search regions are
+    // blurred one by one.
+    FloatImage image_and_gradient;
+
+    // False if the frame accessor had no image for this frame.
+    bool fetched;
+
+    // Set for the frames used by the current TrackMarkers() call.
+    bool used;
+
+    // Sum of the areas of the search regions in this frame.
+    double region_area;
+  };
+
+  // Get the frame of the marker for the current call.
+  Frame* Use(const Marker& marker, double sigma) {
+    Key key;
+    key.clip = marker.clip;
+    key.frame = marker.frame;
+    key.disabled_channels = marker.disabled_channels;
+    key.sigma = sigma;
+
+    Region region = marker.search_region.Rounded();
+    Frame* frame = &frames[key];
+    if (!frame->used) {
+      frame->used = true;
+      frame->region_area = 0.0;
+      used_frames.push_back(std::make_pair(key, frame));
+    }
+    frame->region_area += (region.max(0) - region.min(0)) *
+                          (region.max(1) - region.min(1));
+    return frame;
+  }
+
+  std::map<Key, Frame> frames;
+
+  // Frames used by the current call, in order of first use.
+  std::vector<std::pair<Key, Frame*> > used_frames;
+};
+
+AutoTrack::AutoTrack(FrameAccessor* frame_accessor)
+  : frame_accessor_(frame_accessor),
+    frame_cache_(new FrameCache()) {
+}
+
+AutoTrack::~AutoTrack() {
+}
+
 bool AutoTrack::TrackMarker(Marker* tracked_marker,
                             TrackRegionResult* result,
                             const TrackRegionOptions* track_options) {
@@ -131,13 +359,6 @@ bool AutoTrack::TrackMarker(Marker* tracked_marker,
                     tracked_marker->track,
                     &reference_marker);
 
-  // Convert markers into the format expected by TrackRegion.
-  double x1[5], y1[5];
-  MarkerToArrays(reference_marker, x1, y1);
-
-  double x2[5], y2[5];
-  MarkerToArrays(*tracked_marker, x2, y2);
-
   // TODO(keir): Technically this could take a smaller slice from the source
   // image instead of taking one the size of the search window.
   FloatImage reference_image;
@@ -159,37 +380,15 @@ bool AutoTrack::TrackMarker(Marker* tracked_marker,
     return false;
   }
 
-  // Store original position befoer tracking, so we can claculate offset later.
-  Vec2f original_center = tracked_marker->center;
-
-  // Do the tracking!
-  TrackRegionOptions local_track_region_options;
-  if (track_options) {
-    local_track_region_options = *track_options;
-  }
-  local_track_region_options.num_extra_points = 1;  // For center point.
-  local_track_region_options.attempt_refine_before_brute = predicted_position;
-  TrackRegion(reference_image,
-              tracked_image,
-              x1, y1,
-              local_track_region_options,
-              x2, y2,
-              result);
-
-  // Copy results over the tracked marker.
-  Vec2f tracked_origin = tracked_marker->search_region.Rounded().min;
-  for (int i = 0; i < 4; ++i) {
-    tracked_marker->patch.coordinates(i, 0) = x2[i] + tracked_origin[0];
-    tracked_marker->patch.coordinates(i, 1) = y2[i] + tracked_origin[1];
-  }
-  tracked_marker->center(0) = x2[4] + tracked_origin[0];
-  tracked_marker->center(1) = y2[4] + tracked_origin[1];
-  Vec2f delta = tracked_marker->center - original_center;
-  tracked_marker->search_region.Offset(delta);
-  tracked_marker->source = Marker::TRACKED;
-  tracked_marker->status = Marker::UNKNOWN;
-  tracked_marker->reference_clip  = reference_marker.clip;
-  tracked_marker->reference_frame = reference_marker.frame;
+  TrackMarkerInImages(reference_marker,
+                      reference_image,
+                      NULL,
+                      tracked_image,
+                      NULL,
+                      predicted_position,
+                      track_options,
+                      tracked_marker,
+                      result);
 
   // Release the images from the accessor cache.
   frame_accessor_->ReleaseImage(reference_key);
@@ -201,6 +400,135 @@ bool AutoTrack::TrackMarker(Marker* tracked_marker,
   return true;
 }
 
+void AutoTrack::TrackMarkers(vector<Marker>* tracked_markers,
+                             const vector<TrackRegionOptions>& track_options,
+                             vector<TrackRegionResult>* results,
+                             vector<bool>* success) {
+  const int num_markers = tracked_markers->size();
+  results->resize(num_markers);
+  success->resize(num_markers);
+
+  // Predict the locations first, they decide which parts of the frames are
+  // needed. The tracks are not modified until all markers are tracked.
+  vector<Marker> reference_markers;
+  vector<bool> predicted_position;
+  reference_markers.resize(num_markers);
+  predicted_position.resize(num_markers);
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int i = 0; i < num_markers; ++i) {
+    Marker* tracked_marker = &(*tracked_markers)[i];
+    predicted_position[i] = PredictMarkerPosition(tracks_, tracked_marker);
+    tracks_.GetMarker(tracked_marker->reference_clip,
+                      tracked_marker->reference_frame,
+                      tracked_marker->track,
+                      &reference_markers[i]);
+  }
+
+  // Gather the frames needed by all markers.
+  typedef FrameCache::Frame Frame;
+  std::vector<Frame*> reference_frames(num_markers);
+  std::vector<Frame*> tracked_frames(num_markers);
+  frame_cache_->used_frames.clear();
+  for (int i = 0; i < num_markers; ++i) {
+    reference_frames[i] = frame_cache_->Use(reference_markers[i],
+                                            track_options[i].sigma);
+    tracked_frames[i] = frame_cache_->Use((*tracked_markers)[i],
+                                          track_options[i].sigma);
+  }
+
+  // Fetch the new frames and blur the ones which are covered enough by the
+  // search regions. Frames which are already prepared are reused as they are.
+  for (int i = 0; i < frame_cache_->used_frames.size(); ++i) {
+    const FrameCache::Key& key = frame_cache_->used_frames[i].first;
+    Frame* frame = frame_cache_->used_frames[i].second;
+    if (!frame->fetched) {
+      FrameAccessor::Key image_key = GetImage(frame_accessor_,
+                                              key.clip,
+                                              key.frame,
+                                              key.disabled_channels,
+                                              NULL,
+                                              &frame->image);
+      if (!image_key) {
+        LG << "Couldn't get frame " << key.frame << " of clip " << key.clip;
+        continue;
+      }
+      // The image is a copy, the accessor can have the frame back already.
+      frame_accessor_->ReleaseImage(image_key);
+      frame->fetched = true;
+    }
+    const double frame_area =
+        static_cast<double>(frame->image.Width()) * frame->image.Height();
+    if (frame->image_and_gradient.Size() == 0 &&
+        frame->region_area >= kMinFrameAreaForFrameBlur * frame_area) {
+      BlurredFrameAndDerivativesChannels(frame->image,
+                                         key.sigma,
+                                         &frame->image_and_gradient);
+    }
+  }
+
+  // Track all markers against the shared frames.
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int i = 0; i < num_markers; ++i) {
+    const Frame* reference_frame = reference_frames[i];
+    const Frame* tracked_frame = tracked_frames[i];
+    Marker* tracked_marker = &(*tracked_markers)[i];
+    if (!reference_frame->fetched || !tracked_frame->fetched) {
+      (*success)[i] = false;
+      continue;
+    }
+
+    FloatImage reference_image, reference_image_and_gradient;
+    FloatImage tracked_image, tracked_image_and_gradient;
+    const Region reference_region =
+        reference_markers[i].search_region.Rounded();
+    const Region tracked_region = tracked_marker->search_region.Rounded();
+    CropImage(reference_frame->image, reference_region, &reference_image);
+    CropImage(tracked_frame->image, tracked_region, &tracked_image);
+    if (reference_frame->image_and_gradient.Size() != 0) {
+      CropImage(reference_frame->image_and_gradient,
+                reference_region,
+                &reference_image_and_gradient);
+    } else {
+      libmv::BlurredImageAndDerivativesChannels(reference_image,
+                                                track_options[i].sigma,
+                                                &reference_image_and_gradient);
+    }
+    if (tracked_frame->image_and_gradient.Size() != 0) {
+      CropImage(tracked_frame->image_and_gradient,
+                tracked_region,
+                &tracked_image_and_gradient);
+    } else {
+      libmv::BlurredImageAndDerivativesChannels(tracked_image,
+                                                track_options[i].sigma,
+                                                &tracked_image_and_gradient);
+    }
+
+    TrackMarkerInImages(reference_markers[i],
+                        reference_image,
+                        &reference_image_and_gradient,
+                        tracked_image,
+                        &tracked_image_and_gradient,
+                        predicted_position[i],
+                        &track_options[i],
+                        tracked_marker,
+                        &(*results)[i]);
+    (*success)[i] = true;
+  }
+
+  // Only keep the frames of this call, the next one most likely tracks from
+  // the frames tracked to now.
+  std::map<FrameCache::Key, Frame>::iterator it = frame_cache_->frames.begin();
+  while (it != frame_cache_->frames.end()) {
+    if (it->second.used && it->second.fetched) {
+      it->second.used = false;
+      ++it;
+    } else {
+      frame_cache_->frames.erase(it++);
+    }
+  }
+  frame_cache_->used_frames.clear();
+}
+
 void AutoTrack::AddMarker(const Marker& marker) {
   tracks_.AddMarker(marker);
 }
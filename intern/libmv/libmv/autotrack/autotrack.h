@@ -25,6 +25,7 @@
 
 #include "libmv/autotrack/tracks.h"
 #include "libmv/autotrack/region.h"
+#include "libmv/base/scoped_ptr.h"
 #include "libmv/tracking/track_region.h"
 
 namespace libmv {
@@ -74,8 +75,8 @@ class AutoTrack {
     Region search_region;
   };
 
-  AutoTrack(FrameAccessor* frame_accessor)
-    : frame_accessor_(frame_accessor) {}
+  AutoTrack(FrameAccessor* frame_accessor);
+  ~AutoTrack();
 
   // Marker manipulation.
   // Clip manipulation.
@@ -92,6 +93,21 @@ class AutoTrack {
                    TrackRegionResult* result,
                    const TrackRegionOptions* track_options=NULL);
 
+  // Find the markers for their tracks in the frames indicated by the markers,
+  // the same as calling TrackMarker() for each one of them. However every
+  // frame is fetched from the accessor and blurred only once for all markers
+  // tracked in or from it, and the markers are tracked in parallel. Frames are
+  // kept until the next call, so the frame tracked to now is ready when it is
+  // used as reference next time.
+  //
+  // track_options holds the options of each marker. success[i] is false if
+  // the frames of the i-th marker could not be fetched, results[i] is only
+  // meaningful otherwise.
+  void TrackMarkers(vector<Marker>* tracked_markers,
+                    const vector<TrackRegionOptions>& track_options,
+                    vector<TrackRegionResult>* results,
+                    vector<bool>* success);
+
   // Wrapper around Tracks API; however these may add additional processing.
   void AddMarker(const Marker& tracked_marker);
   void SetMarkers(vector<Marker>* markers);
@@ -211,6 +227,10 @@ class AutoTrack {
   // TODO(keir): What about masking for clips and frames to prevent various
   // things like reconstruction or tracking from happening on certain frames?
   FrameAccessor* frame_accessor_;
+
+  // Frames prepared for tracking by TrackMarkers().
+  struct FrameCache;
+  libmv::scoped_ptr<FrameCache> frame_cache_;
   //int num_clips_;
   //vector<int> num_frames_;  // Indexed by clip.
 
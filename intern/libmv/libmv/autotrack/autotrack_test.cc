@@ -0,0 +1,330 @@
+// Copyright (c) 2016 libmv authors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "libmv/autotrack/autotrack.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+#include "libmv/autotrack/frame_accessor.h"
+#include "libmv/autotrack/marker.h"
+#include "libmv/autotrack/region.h"
+#include "libmv/image/convolve.h"
+#include "testing/testing.h"
+
+namespace mv {
+
+namespace {
+
+const int kFrameWidth = 640;
+const int kFrameHeight = 480;
+
+// Motion of the whole image between consecutive frames, in pixels.
+const int kShiftX = 3;
+const int kShiftY = -2;
+
+// A clip of blurred noise moving by a constant shift every frame, so the
+// position of every marker is known exactly.
+class ShiftingNoiseAccessor : public FrameAccessor {
+ public:
+  explicit ShiftingNoiseAccessor(int num_frames)
+      : num_frames_(num_frames),
+        margin_(num_frames * std::max(abs(kShiftX), abs(kShiftY))) {
+    FloatImage noise(kFrameHeight + 2 * margin_, kFrameWidth + 2 * margin_);
+    unsigned int seed = 1;
+    for (int y = 0; y < noise.Height(); ++y) {
+      for (int x = 0; x < noise.Width(); ++x) {
+        seed = seed * 1103515245 + 12345;
+        noise(y, x) = ((seed >> 16) & 0xff) / 255.0f;
+      }
+    }
+    libmv::ConvolveGaussian(noise, 1.5, &texture_);
+  }
+
+  Key GetImage(int /*clip*/,
+               int frame,
+               InputMode /*input_mode*/,
+               int /*downscale*/,
+               const Region* region,
+               const Transform* /*transform*/,
+               FloatImage* destination) {
+    if (frame < 0 || frame >= num_frames_) {
+      return NULL;
+    }
+    int origin_x = 0, origin_y = 0;
+    int width = kFrameWidth, height = kFrameHeight;
+    if (region) {
+      origin_x = region->min(0);
+      origin_y = region->min(1);
+      width = region->max(0) - region->min(0);
+      height = region->max(1) - region->min(1);
+    }
+    destination->Resize(height, width, 1);
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        const int frame_x = origin_x + x, frame_y = origin_y + y;
+        if (frame_x < 0 || frame_x >= kFrameWidth ||
+            frame_y < 0 || frame_y >= kFrameHeight) {
+          (*destination)(y, x) = 0.0f;
+        } else {
+          // The content moves by the shift, so look it up backwards.
+          (*destination)(y, x) = texture_(margin_ + frame_y - frame * kShiftY,
+                                          margin_ + frame_x - frame * kShiftX);
+        }
+      }
+    }
+    return this;
+  }
+
+  void ReleaseImage(Key /*key*/) {
+  }
+
+  bool GetClipDimensions(int /*clip*/, int* width, int* height) {
+    *width = kFrameWidth;
+    *height = kFrameHeight;
+    return true;
+  }
+
+  int NumClips() {
+    return 1;
+  }
+
+  int NumFrames(int /*clip*/) {
+    return num_frames_;
+  }
+
+ private:
+  int num_frames_;
+  int margin_;
+  FloatImage texture_;
+};
+
+Marker MakeMarker(int track, float x, float y) {
+  Marker marker;
+  marker.clip = 0;
+  marker.frame = 0;
+  marker.track = track;
+  marker.center << x, y;
+  marker.patch.coordinates << x - 10, y - 10,
+                              x + 10, y - 10,
+                              x + 10, y + 10,
+                              x - 10, y + 10;
+  marker.weight = 1.0f;
+  marker.source = Marker::MANUAL;
+  marker.status = Marker::UNKNOWN;
+  marker.search_region.min << x - 30, y - 30;
+  marker.search_region.max << x + 30, y + 30;
+  marker.reference_clip = 0;
+  marker.reference_frame = 0;
+  marker.model_type = Marker::POINT;
+  marker.model_id = 0;
+  marker.disabled_channels = 0;
+  return marker;
+}
+
+// Markers on a regular grid in the first frame, kept away from the borders
+// so they stay inside the frame for the whole clip.
+void AddGridMarkers(int num_x, int num_y, AutoTrack* autotrack,
+                    vector<Marker>* markers) {
+  for (int j = 0; j < num_y; ++j) {
+    for (int i = 0; i < num_x; ++i) {
+      float x = 100.0f + i * (kFrameWidth - 200.0f) / std::max(1, num_x - 1);
+      float y = 100.0f + j * (kFrameHeight - 200.0f) / std::max(1, num_y - 1);
+      Marker marker = MakeMarker(j * num_x + i, x, y);
+      autotrack->AddMarker(marker);
+      markers->push_back(marker);
+    }
+  }
+}
+
+// Markers of the next frame, to be tracked from the given ones.
+void NextFrameMarkers(const vector<Marker>& markers,
+                      vector<Marker>* next_markers) {
+  next_markers->clear();
+  for (int i = 0; i < markers.size(); ++i) {
+    Marker marker = markers[i];
+    marker.reference_frame = marker.frame;
+    marker.frame++;
+    next_markers->push_back(marker);
+  }
+}
+
+double Seconds() {
+#ifdef _OPENMP
+  return omp_get_wtime();
+#else
+  return static_cast<double>(clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+}  // namespace
+
+TEST(AutoTrack, TrackMarkersMatchesTrackMarker) {
+  ShiftingNoiseAccessor accessor(2);
+  AutoTrack single_autotrack(&accessor), batch_autotrack(&accessor);
+  vector<Marker> markers, dummy;
+  AddGridMarkers(5, 4, &single_autotrack, &markers);
+  AddGridMarkers(5, 4, &batch_autotrack, &dummy);
+
+  vector<Marker> tracked_markers;
+  NextFrameMarkers(markers, &tracked_markers);
+  vector<TrackRegionOptions> options;
+  options.resize(tracked_markers.size());
+  vector<TrackRegionResult> results;
+  vector<bool> success;
+  batch_autotrack.TrackMarkers(&tracked_markers, options, &results, &success);
+
+  ASSERT_EQ(markers.size(), tracked_markers.size());
+  for (int i = 0; i < markers.size(); ++i) {
+    Marker single_marker = markers[i];
+    single_marker.reference_frame = 0;
+    single_marker.frame = 1;
+    TrackRegionResult single_result;
+    EXPECT_TRUE(single_autotrack.TrackMarker(&single_marker,
+                                             &single_result,
+                                             &options[i]));
+    EXPECT_TRUE(single_result.is_usable());
+
+    EXPECT_TRUE(success[i]);
+    EXPECT_TRUE(results[i].is_usable());
+    EXPECT_EQ(1, tracked_markers[i].frame);
+    EXPECT_EQ(0, tracked_markers[i].reference_frame);
+    EXPECT_EQ(Marker::TRACKED, tracked_markers[i].source);
+    EXPECT_NEAR(markers[i].center.x() + kShiftX,
+                tracked_markers[i].center.x(), 0.05);
+    EXPECT_NEAR(markers[i].center.y() + kShiftY,
+                tracked_markers[i].center.y(), 0.05);
+    EXPECT_NEAR(single_marker.center.x(), tracked_markers[i].center.x(), 0.05);
+    EXPECT_NEAR(single_marker.center.y(), tracked_markers[i].center.y(), 0.05);
+  }
+}
+
+TEST(AutoTrack, TrackMarkersMissingFrame) {
+  ShiftingNoiseAccessor accessor(2);
+  AutoTrack autotrack(&accessor);
+  vector<Marker> markers;
+  AddGridMarkers(2, 1, &autotrack, &markers);
+
+  // The second marker is tracked into a frame which is not in the clip.
+  vector<Marker> tracked_markers;
+  NextFrameMarkers(markers, &tracked_markers);
+  tracked_markers[1].frame = 5;
+  vector<TrackRegionOptions> options;
+  options.resize(tracked_markers.size());
+  vector<TrackRegionResult> results;
+  vector<bool> success;
+  autotrack.TrackMarkers(&tracked_markers, options, &results, &success);
+
+  EXPECT_TRUE(success[0]);
+  EXPECT_FALSE(success[1]);
+}
+
+TEST(AutoTrack, TrackMarkersBrutePyramid) {
+  ShiftingNoiseAccessor accessor(2);
+  AutoTrack autotrack(&accessor);
+  vector<Marker> markers;
+  AddGridMarkers(4, 3, &autotrack, &markers);
+
+  // Start far enough from the real position that the brute search is needed.
+  vector<Marker> tracked_markers;
+  NextFrameMarkers(markers, &tracked_markers);
+  vector<TrackRegionOptions> options;
+  options.resize(tracked_markers.size());
+  for (int i = 0; i < tracked_markers.size(); ++i) {
+    Vec2f offset(9.0f, -7.0f);
+    tracked_markers[i].center += offset;
+    tracked_markers[i].patch.coordinates.rowwise() += offset.transpose();
+    tracked_markers[i].search_region.Offset(offset);
+    options[i].use_brute_pyramid = true;
+  }
+  vector<TrackRegionResult> results;
+  vector<bool> success;
+  autotrack.TrackMarkers(&tracked_markers, options, &results, &success);
+
+  for (int i = 0; i < markers.size(); ++i) {
+    EXPECT_TRUE(success[i]);
+    EXPECT_TRUE(results[i].is_usable());
+    EXPECT_NEAR(markers[i].center.x() + kShiftX,
+                tracked_markers[i].center.x(), 0.05);
+    EXPECT_NEAR(markers[i].center.y() + kShiftY,
+                tracked_markers[i].center.y(), 0.05);
+  }
+}
+
+// Not a correctness test: reports the tracking speed of marker by marker
+// tracking and of tracking all markers of a frame at once on the same clip.
+TEST(AutoTrack, TrackingSpeed) {
+  const int num_frames = 10;
+  ShiftingNoiseAccessor accessor(num_frames);
+
+  double seconds[2];
+  int num_tracked[2] = {0, 0};
+  for (int batch = 0; batch < 2; ++batch) {
+    AutoTrack autotrack(&accessor);
+    vector<Marker> markers;
+    AddGridMarkers(8, 6, &autotrack, &markers);
+
+    double start = Seconds();
+    for (int frame = 1; frame < num_frames; ++frame) {
+      vector<Marker> tracked_markers;
+      NextFrameMarkers(markers, &tracked_markers);
+      vector<TrackRegionOptions> options;
+      options.resize(tracked_markers.size());
+      vector<TrackRegionResult> results;
+      vector<bool> success;
+      if (batch) {
+        for (int i = 0; i < options.size(); ++i) {
+          options[i].use_brute_pyramid = true;
+        }
+        autotrack.TrackMarkers(&tracked_markers, options, &results, &success);
+      } else {
+        results.resize(tracked_markers.size());
+        success.resize(tracked_markers.size());
+        for (int i = 0; i < tracked_markers.size(); ++i) {
+          success[i] = autotrack.TrackMarker(&tracked_markers[i],
+                                             &results[i],
+                                             &options[i]);
+        }
+      }
+      for (int i = 0; i < tracked_markers.size(); ++i) {
+        if (success[i] && results[i].is_usable()) {
+          autotrack.AddMarker(tracked_markers[i]);
+          num_tracked[batch]++;
+        }
+      }
+      markers = tracked_markers;
+    }
+    seconds[batch] = Seconds() - start;
+  }
+
+  EXPECT_EQ(num_tracked[0], num_tracked[1]);
+  printf("Marker by marker: %d tracks in %.3f s, %.1f tracks/second\n",
+         num_tracked[0], seconds[0], num_tracked[0] / seconds[0]);
+  printf("All markers at once: %d tracks in %.3f s, %.1f tracks/second\n",
+         num_tracked[1], seconds[1], num_tracked[1] / seconds[1]);
+}
+
+}  // namespace mv
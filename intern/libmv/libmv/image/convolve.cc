@@ -22,6 +22,10 @@
 
 #include <cmath>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "libmv/image/image.h"
 
 namespace libmv {
@@ -63,6 +67,80 @@ void ComputeGaussianKernel(double sigma, Vec *kernel, Vec *derivative) {
   *derivative /= factor;
 }
 
+#ifdef __SSE2__
+// Load two consecutive floats as doubles.
+inline __m128d LoadFloat2(const float *p) {
+  return _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double *) p)));
+}
+
+// Sum of the 2 * size + 1 floats at src + k * step, k = -size..size, weighted
+// by the coefficients, for the two pixels at src and src + 1. The products are
+// summed in the same order and precision as the scalar code does.
+template <int size>
+inline void ConvolvePixelPair(const double *coefficients,
+                              const float *src, int step,
+                              float *dst) {
+  __m128d sum = _mm_setzero_pd();
+  for (int k = -size; k <= size; ++k) {
+    sum = _mm_add_pd(sum, _mm_mul_pd(LoadFloat2(src + k * step),
+                                     _mm_set1_pd(coefficients[k + size])));
+  }
+  _mm_store_sd((double *) dst,
+               _mm_castps_pd(_mm_cvtpd_ps(sum)));
+}
+
+// Same as FastConvolve() for single channel images, where two neighbour
+// pixels of a row are computed at once. The pixels for which the kernel
+// crosses the image border are done one by one.
+template <int size, bool vertical>
+void FastConvolveSingleChannel(const double *coefficients,
+                               int width, int height,
+                               const float* src, int src_line_stride,
+                               float* dst) {
+  for (int y = 0; y < height; ++y) {
+    const float *src_row = src + y * src_line_stride;
+    float *dst_row = dst + y * width;
+    int x = 0;
+    if (vertical) {
+      if (y >= size && y < height - size) {
+        for (; x + 1 < width; x += 2) {
+          ConvolvePixelPair<size>(coefficients, src_row + x, src_line_stride,
+                                  dst_row + x);
+        }
+      }
+    } else {
+      for (; x < size && x < width; ++x) {
+        double sum = 0;
+        for (int k = -size; k <= size; ++k) {
+          if (x + k >= 0 && x + k < width) {
+            sum += src_row[x + k] * coefficients[k + size];
+          }
+        }
+        dst_row[x] = static_cast<float>(sum);
+      }
+      for (; x + 1 < width - size; x += 2) {
+        ConvolvePixelPair<size>(coefficients, src_row + x, 1, dst_row + x);
+      }
+    }
+    for (; x < width; ++x) {
+      double sum = 0;
+      for (int k = -size; k <= size; ++k) {
+        if (vertical) {
+          if (y + k >= 0 && y + k < height) {
+            sum += src_row[x + k * src_line_stride] * coefficients[k + size];
+          }
+        } else {
+          if (x + k >= 0 && x + k < width) {
+            sum += src_row[x + k] * coefficients[k + size];
+          }
+        }
+      }
+      dst_row[x] = static_cast<float>(sum);
+    }
+  }
+}
+#endif
+
 template <int size, bool vertical>
 void FastConvolve(const Vec &kernel, int width, int height,
                   const float* src, int src_stride, int src_line_stride,
@@ -71,6 +149,15 @@ void FastConvolve(const Vec &kernel, int width, int height,
   for (int k = 0; k < 2 * size + 1; ++k) {
     coefficients[k] = kernel(2 * size - k);
   }
+#ifdef __SSE2__
+  if (src_stride == 1 && dst_stride == 1) {
+    FastConvolveSingleChannel<size, vertical>(coefficients,
+                                              width, height,
+                                              src, src_line_stride,
+                                              dst);
+    return;
+  }
+#endif
   // Fast path: if the kernel has a certain size, use the constant sized loops.
   for (int y = 0; y < height; ++y) {
     for (int x = 0; x < width; ++x) {
@@ -21,6 +21,10 @@
 #ifndef LIBMV_IMAGE_SAMPLE_H_
 #define LIBMV_IMAGE_SAMPLE_H_
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "libmv/image/image.h"
 
 namespace libmv {
@@ -92,6 +96,54 @@ inline void SampleLinear(const Array3D<T> &image, float y, float x, T *sample) {
   }
 }
 
+/// Linear interpolation of all channels of a float image. The tracker samples
+/// images with 3 channels (intensity and both derivatives) for every residual,
+/// for those the 4 neighbours are blended with SSE2 all channels at once.
+inline void SampleLinear(const Array3Df &image,
+                         float y, float x,
+                         float *sample) {
+  int x1, y1, x2, y2;
+  float dx, dy;
+
+  LinearInitAxis(y, image.Height(), &y1, &y2, &dy);
+  LinearInitAxis(x, image.Width(),  &x1, &x2, &dx);
+
+#ifdef __SSE2__
+  if (image.Depth() == 3) {
+    // Load 3 floats per pixel without reading past the end of the image.
+    const float *p11 = &image(y1, x1, 0);
+    const float *p12 = &image(y1, x2, 0);
+    const float *p21 = &image(y2, x1, 0);
+    const float *p22 = &image(y2, x2, 0);
+#define LOAD_PIXEL(p) \
+    _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) (p)), \
+                  _mm_load_ss((p) + 2))
+    __m128 result = _mm_mul_ps(_mm_set1_ps(dy * dx), LOAD_PIXEL(p11));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(dy * (1.0f - dx)),
+                                           LOAD_PIXEL(p12)));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps((1.0f - dy) * dx),
+                                           LOAD_PIXEL(p21)));
+    result = _mm_add_ps(result,
+                        _mm_mul_ps(_mm_set1_ps((1.0f - dy) * (1.0f - dx)),
+                                   LOAD_PIXEL(p22)));
+#undef LOAD_PIXEL
+    _mm_storel_pi((__m64 *) sample, result);
+    _mm_store_ss(sample + 2, _mm_movehl_ps(result, result));
+    return;
+  }
+#endif
+
+  for (int i = 0; i < image.Depth(); ++i) {
+    const float im11 = image(y1, x1, i);
+    const float im12 = image(y1, x2, i);
+    const float im21 = image(y2, x1, i);
+    const float im22 = image(y2, x2, i);
+
+    sample[i] =      dy  * (dx * im11 + (1.0f - dx) * im12) +
+                (1 - dy) * (dx * im21 + (1.0f - dx) * im22);
+  }
+}
+
 // Downsample all channels by 2. If the image has odd width or height, the last
 // row or column is ignored.
 // FIXME(MatthiasF): this implementation shouldn't be in an interface file
@@ -46,6 +46,29 @@ TEST(Image, Linear) {
   EXPECT_EQ(1.5, SampleLinear(image, 0.5, 0.5));
 }
 
+TEST(Image, LinearAllChannels) {
+  Array3Df image(3, 4, 3);
+  for (int y = 0; y < image.Height(); ++y) {
+    for (int x = 0; x < image.Width(); ++x) {
+      for (int k = 0; k < image.Depth(); ++k) {
+        image(y, x, k) = (y * 7 + x * 3 + k * 5) % 11 - 4.0f;
+      }
+    }
+  }
+  // Sample inside, on the last row and column and outside of the image; all
+  // channels at once must match sampling the channels one by one.
+  const float positions[][2] = {{0.0f, 0.0f}, {0.25f, 1.75f}, {1.5f, 2.3f},
+                                {2.0f, 3.0f}, {1.9f, 2.9f}, {-0.5f, 4.5f}};
+  for (int i = 0; i < sizeof(positions) / sizeof(*positions); ++i) {
+    float sample[3];
+    SampleLinear(image, positions[i][0], positions[i][1], sample);
+    for (int k = 0; k < image.Depth(); ++k) {
+      EXPECT_NEAR(SampleLinear(image, positions[i][0], positions[i][1], k),
+                  sample[k], 1e-5);
+    }
+  }
+}
+
 TEST(Image, DownsampleBy2) {
   Array3Df image(2, 2);
   image(0, 0) = 0;
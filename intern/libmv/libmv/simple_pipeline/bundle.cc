@@ -21,6 +21,7 @@
 #include "libmv/simple_pipeline/bundle.h"
 
 #include <map>
+#include <vector>
 
 #include "ceres/ceres.h"
 #include "ceres/rotation.h"
@@ -297,6 +298,31 @@ void CRSMatrixToEigenMatrix(const ceres::CRSMatrix &crs_matrix,
   }
 }
 
+// Configure solver options used by all the euclidean bundlers.
+//
+// num_threads of zero means the solver uses as many threads as OpenMP does
+// by default.
+void ConfigureSolverOptions(const int num_threads,
+                            ceres::Solver::Options *options) {
+  options->use_nonmonotonic_steps = true;
+  options->preconditioner_type = ceres::SCHUR_JACOBI;
+  options->linear_solver_type = ceres::ITERATIVE_SCHUR;
+  options->use_explicit_schur_complement = true;
+  options->use_inner_iterations = true;
+  options->max_num_iterations = 100;
+
+  int solver_threads = num_threads;
+#ifdef _OPENMP
+  if (solver_threads <= 0) {
+    solver_threads = omp_get_max_threads();
+  }
+#endif
+  if (solver_threads > 0) {
+    options->num_threads = solver_threads;
+    options->num_linear_solver_threads = solver_threads;
+  }
+}
+
 void EuclideanBundlerPerformEvaluation(const Tracks &tracks,
                                        EuclideanReconstruction *reconstruction,
                                        vector<Vec6> *all_cameras_R_t,
@@ -379,6 +405,7 @@ void EuclideanBundlePointsOnly(const DistortionModelType distortion_model,
                                const vector<Marker> &markers,
                                vector<Vec6> &all_cameras_R_t,
                                double ceres_intrinsics[OFFSET_MAX],
+                               const int num_threads,
                                EuclideanReconstruction *reconstruction) {
   ceres::Problem::Options problem_options;
   ceres::Problem problem(problem_options);
@@ -421,17 +448,7 @@ void EuclideanBundlePointsOnly(const DistortionModelType distortion_model,
 
   // Configure the solver.
   ceres::Solver::Options options;
-  options.use_nonmonotonic_steps = true;
-  options.preconditioner_type = ceres::SCHUR_JACOBI;
-  options.linear_solver_type = ceres::ITERATIVE_SCHUR;
-  options.use_explicit_schur_complement = true;
-  options.use_inner_iterations = true;
-  options.max_num_iterations = 100;
-
-#ifdef _OPENMP
-  options.num_threads = omp_get_max_threads();
-  options.num_linear_solver_threads = omp_get_max_threads();
-#endif
+  ConfigureSolverOptions(num_threads, &options);
 
   // Solve!
   ceres::Solver::Summary summary;
@@ -444,14 +461,131 @@ void EuclideanBundlePointsOnly(const DistortionModelType distortion_model,
 }  // namespace
 
 void EuclideanBundle(const Tracks &tracks,
-                     EuclideanReconstruction *reconstruction) {
+                     EuclideanReconstruction *reconstruction,
+                     const int num_threads) {
   PolynomialCameraIntrinsics empty_intrinsics;
   EuclideanBundleCommonIntrinsics(tracks,
                                   BUNDLE_NO_INTRINSICS,
                                   BUNDLE_NO_CONSTRAINTS,
                                   reconstruction,
                                   &empty_intrinsics,
-                                  NULL);
+                                  NULL,
+                                  num_threads);
+}
+
+void EuclideanBundleLocal(const Tracks &tracks,
+                          const vector<int> &images,
+                          EuclideanReconstruction *reconstruction,
+                          const int num_threads) {
+  const int max_image = tracks.MaxImage();
+  const int max_track = tracks.MaxTrack();
+
+  // Cameras which are refined and points seen by them.
+  std::vector<bool> variable_images(max_image + 1, false);
+  for (int i = 0; i < images.size(); ++i) {
+    if (images[i] >= 0 && images[i] <= max_image &&
+        reconstruction->CameraForImage(images[i])) {
+      variable_images[images[i]] = true;
+    }
+  }
+
+  vector<Marker> markers = tracks.AllMarkers();
+  std::vector<bool> variable_tracks(max_track + 1, false);
+  for (int i = 0; i < markers.size(); ++i) {
+    const Marker &marker = markers[i];
+    if (marker.weight != 0.0 && variable_images[marker.image] &&
+        reconstruction->PointForTrack(marker.track)) {
+      variable_tracks[marker.track] = true;
+    }
+  }
+
+  // Tracks are calibrated and intrinsics are not refined, same as for
+  // EuclideanBundle().
+  PolynomialCameraIntrinsics empty_intrinsics;
+  double ceres_intrinsics[OFFSET_MAX];
+  PackIntrinisicsIntoArray(empty_intrinsics, ceres_intrinsics);
+
+  vector<Vec6> all_cameras_R_t =
+    PackCamerasRotationAndTranslation(tracks, *reconstruction);
+
+  // Residuals of all the markers of the variable points. Cameras outside of
+  // the window which see these points are kept constant, they anchor the
+  // window to the rest of the reconstruction.
+  ceres::Problem::Options problem_options;
+  ceres::Problem problem(problem_options);
+  int num_residuals = 0;
+  int num_constant_cameras = 0;
+  std::vector<bool> constant_images(max_image + 1, false);
+  for (int i = 0; i < markers.size(); ++i) {
+    const Marker &marker = markers[i];
+    if (marker.weight == 0.0 || !variable_tracks[marker.track]) {
+      continue;
+    }
+    EuclideanCamera *camera = reconstruction->CameraForImage(marker.image);
+    EuclideanPoint *point = reconstruction->PointForTrack(marker.track);
+    if (camera == NULL || point == NULL) {
+      continue;
+    }
+
+    double *current_camera_R_t = &all_cameras_R_t[camera->image](0);
+
+    problem.AddResidualBlock(new ceres::AutoDiffCostFunction<
+        OpenCVReprojectionError, 2, OFFSET_MAX, 6, 3>(
+            new OpenCVReprojectionError(
+                empty_intrinsics.GetDistortionModelType(),
+                marker.x,
+                marker.y,
+                marker.weight)),
+        NULL,
+        ceres_intrinsics,
+        current_camera_R_t,
+        &point->X(0));
+
+    if (!variable_images[marker.image] && !constant_images[marker.image]) {
+      problem.SetParameterBlockConstant(current_camera_R_t);
+      constant_images[marker.image] = true;
+      num_constant_cameras++;
+    }
+    num_residuals++;
+  }
+  LG << "Number of residuals in local bundle: " << num_residuals;
+  LG << "Number of constant cameras in local bundle: " << num_constant_cameras;
+
+  if (!num_residuals) {
+    LG << "Skipping running minimizer with zero residuals";
+    return;
+  }
+
+  if (!num_constant_cameras) {
+    // Window covers all the cameras which see its points, fall back to the
+    // global bundle which deals with the scene orientation ambiguity.
+    EuclideanBundle(tracks, reconstruction, num_threads);
+    return;
+  }
+
+  problem.SetParameterBlockConstant(ceres_intrinsics);
+
+  // Configure the solver.
+  ceres::Solver::Options options;
+  ConfigureSolverOptions(num_threads, &options);
+
+  // Solve!
+  ceres::Solver::Summary summary;
+  ceres::Solve(options, &problem, &summary);
+
+  LG << "Final report:\n" << summary.BriefReport();
+
+  // Copy back only refined cameras, this way constant ones are not affected
+  // by the angle-axis conversion round trip.
+  for (int i = 0; i <= max_image; ++i) {
+    if (!variable_images[i]) {
+      continue;
+    }
+    EuclideanCamera *camera = reconstruction->CameraForImage(i);
+    ceres::AngleAxisToRotationMatrix(&all_cameras_R_t[i](0),
+                                     &camera->R(0, 0));
+    camera->t = all_cameras_R_t[i].tail<3>();
+  }
 }
 
 void EuclideanBundleCommonIntrinsics(
@@ -460,7 +594,8 @@ void EuclideanBundleCommonIntrinsics(
     const int bundle_constraints,
     EuclideanReconstruction *reconstruction,
     CameraIntrinsics *intrinsics,
-    BundleEvaluation *evaluation) {
+    BundleEvaluation *evaluation,
+    const int num_threads) {
   LG << "Original intrinsics: " << *intrinsics;
   vector<Marker> markers = tracks.AllMarkers();
 
@@ -591,17 +726,7 @@ void EuclideanBundleCommonIntrinsics(
 
   // Configure the solver.
   ceres::Solver::Options options;
-  options.use_nonmonotonic_steps = true;
-  options.preconditioner_type = ceres::SCHUR_JACOBI;
-  options.linear_solver_type = ceres::ITERATIVE_SCHUR;
-  options.use_explicit_schur_complement = true;
-  options.use_inner_iterations = true;
-  options.max_num_iterations = 100;
-
-#ifdef _OPENMP
-  options.num_threads = omp_get_max_threads();
-  options.num_linear_solver_threads = omp_get_max_threads();
-#endif
+  ConfigureSolverOptions(num_threads, &options);
 
   // Solve!
   ceres::Solver::Summary summary;
@@ -627,15 +752,15 @@ void EuclideanBundleCommonIntrinsics(
 
   // Separate step to adjust positions of tracks which are
   // constant zero-weighted.
+  //
+  // Markers are gathered in a single pass, querying markers of every
+  // track separately is quadratic in the number of tracks.
   vector<Marker> zero_weight_markers;
-  for (int track = 0; track < tracks.MaxTrack(); ++track) {
-    if (zero_weight_tracks_flags[track]) {
-      vector<Marker> current_markers = tracks.MarkersForTrack(track);
-      zero_weight_markers.reserve(zero_weight_markers.size() +
-                                  current_markers.size());
-      for (int i = 0; i < current_markers.size(); ++i) {
-        zero_weight_markers.push_back(current_markers[i]);
-      }
+  for (int i = 0; i < markers.size(); ++i) {
+    const Marker &marker = markers[i];
+    if (zero_weight_tracks_flags[marker.track] &&
+        reconstruction->PointForTrack(marker.track)) {
+      zero_weight_markers.push_back(marker);
     }
   }
 
@@ -645,6 +770,7 @@ void EuclideanBundleCommonIntrinsics(
                               zero_weight_markers,
                               all_cameras_R_t,
                               ceres_intrinsics,
+                              num_threads,
                               reconstruction);
   }
 }
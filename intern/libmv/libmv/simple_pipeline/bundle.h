@@ -21,6 +21,7 @@
 #ifndef LIBMV_SIMPLE_PIPELINE_BUNDLE_H
 #define LIBMV_SIMPLE_PIPELINE_BUNDLE_H
 
+#include "libmv/base/vector.h"
 #include "libmv/numeric/numeric.h"
 
 namespace libmv {
@@ -66,6 +67,9 @@ struct BundleEvaluation {
 
     The cameras and bundles (3D points) are refined in-place.
 
+    \a num_threads is the number of threads used by the solver, zero means
+    as many threads as OpenMP would use.
+
     \note This assumes an outlier-free set of markers.
     \note This assumes a calibrated reconstruction, e.g. the markers are
           already corrected for camera intrinsics and radial distortion.
@@ -73,7 +77,33 @@ struct BundleEvaluation {
     \sa EuclideanResect, EuclideanIntersect, EuclideanReconstructTwoFrames
 */
 void EuclideanBundle(const Tracks &tracks,
-                     EuclideanReconstruction *reconstruction);
+                     EuclideanReconstruction *reconstruction,
+                     const int num_threads = 0);
+
+/*!
+    Refine camera poses of the given images and 3D coordinates of the points
+    seen by them using bundle adjustment.
+
+    Only cameras of \a images and the bundles observed by these cameras are
+    adjusted. Other cameras which observe the same bundles are included in
+    the minimization but kept constant, they anchor the refined cameras to
+    the rest of the reconstruction. This makes the cost of the bundle depend
+    on the size of \a images rather than on the size of the reconstruction,
+    which is used for the incremental reconstruction of long shots.
+
+    If none of the cameras outside of \a images sees the refined bundles,
+    this falls back to EuclideanBundle().
+
+    \note This assumes an outlier-free set of markers.
+    \note This assumes a calibrated reconstruction, e.g. the markers are
+          already corrected for camera intrinsics and radial distortion.
+
+    \sa EuclideanBundle, EuclideanCompleteReconstruction
+*/
+void EuclideanBundleLocal(const Tracks &tracks,
+                          const vector<int> &images,
+                          EuclideanReconstruction *reconstruction,
+                          const int num_threads = 0);
 
 /*!
     Refine camera poses and 3D coordinates using bundle adjustment.
@@ -95,6 +125,9 @@ void EuclideanBundle(const Tracks &tracks,
     there, plus all the requested additional information (like jacobian) is
     also calculating there. Also see comments for BundleEvaluation.
 
+    \a num_threads is the number of threads used by the solver, zero means
+    as many threads as OpenMP would use.
+
     \note This assumes an outlier-free set of markers.
 
     \sa EuclideanResect, EuclideanIntersect, EuclideanReconstructTwoFrames
@@ -120,7 +153,8 @@ void EuclideanBundleCommonIntrinsics(
     const int bundle_constraints,
     EuclideanReconstruction *reconstruction,
     CameraIntrinsics *intrinsics,
-    BundleEvaluation *evaluation = NULL);
+    BundleEvaluation *evaluation = NULL,
+    const int num_threads = 0);
 
 /*!
     Refine camera poses and 3D coordinates using bundle adjustment.
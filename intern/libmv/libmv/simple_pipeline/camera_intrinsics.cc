@@ -20,6 +20,10 @@
 
 #include "libmv/simple_pipeline/camera_intrinsics.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "libmv/logging/logging.h"
 #include "libmv/simple_pipeline/distortion_models.h"
 
@@ -60,6 +64,107 @@ void LookupWarpGrid::SetThreads(int threads) {
   threads_ = threads;
 }
 
+PointWarpGrid::PointWarpGrid()
+  : nodes_(NULL),
+    width_(0),
+    height_(0),
+    nodes_x_(0),
+    nodes_y_(0),
+    threads_(1) {}
+
+PointWarpGrid::PointWarpGrid(const PointWarpGrid &from)
+    : nodes_(NULL),
+      width_(0),
+      height_(0),
+      nodes_x_(0),
+      nodes_y_(0),
+      threads_(from.threads_) {
+  *this = from;
+}
+
+PointWarpGrid::~PointWarpGrid() {
+  delete [] nodes_;
+}
+
+PointWarpGrid &PointWarpGrid::operator =(const PointWarpGrid &from) {
+  if (this == &from) {
+    return *this;
+  }
+  Reset();
+  width_ = from.width_;
+  height_ = from.height_;
+  nodes_x_ = from.nodes_x_;
+  nodes_y_ = from.nodes_y_;
+  if (from.nodes_) {
+    nodes_ = new float[nodes_x_ * nodes_y_ * 2];
+    memcpy(nodes_, from.nodes_, sizeof(float) * nodes_x_ * nodes_y_ * 2);
+  }
+  return *this;
+}
+
+bool PointWarpGrid::Apply(double x,
+                          double y,
+                          double *warp_x,
+                          double *warp_y) const {
+  if (nodes_ == NULL) {
+    return false;
+  }
+
+  const double grid_x = x / kStep + kMargin,
+               grid_y = y / kStep + kMargin;
+  // Written in a way which also rejects NaN.
+  if (!(grid_x >= 0.0 && grid_x < nodes_x_ - 1 &&
+        grid_y >= 0.0 && grid_y < nodes_y_ - 1)) {
+    return false;
+  }
+
+  const int i = (int) grid_x, j = (int) grid_y;
+  const float fx = (float) (grid_x - i), fy = (float) (grid_y - j);
+  const float *top = &nodes_[(j * nodes_x_ + i) * 2];
+  const float *bottom = top + nodes_x_ * 2;
+
+#ifdef __SSE2__
+  // Both coordinates of two neighbour nodes are loaded at once, so the
+  // whole cell is interpolated with a couple of vector operations.
+  const __m128 top_nodes = _mm_loadu_ps(top);
+  const __m128 bottom_nodes = _mm_loadu_ps(bottom);
+  const __m128 left = _mm_add_ps(top_nodes,
+                                 _mm_mul_ps(_mm_sub_ps(bottom_nodes, top_nodes),
+                                            _mm_set1_ps(fy)));
+  const __m128 right = _mm_movehl_ps(left, left);
+  const __m128 result = _mm_add_ps(left,
+                                   _mm_mul_ps(_mm_sub_ps(right, left),
+                                              _mm_set1_ps(fx)));
+  float warp[4];
+  _mm_storeu_ps(warp, result);
+  *warp_x = warp[0];
+  *warp_y = warp[1];
+#else
+  for (int k = 0; k < 2; k++) {
+    const float left = top[k] + (bottom[k] - top[k]) * fy;
+    const float right = top[k + 2] + (bottom[k + 2] - top[k + 2]) * fy;
+    const float warp = left + (right - left) * fx;
+    if (k == 0) {
+      *warp_x = warp;
+    } else {
+      *warp_y = warp;
+    }
+  }
+#endif
+
+  return true;
+}
+
+void PointWarpGrid::Reset() {
+  delete [] nodes_;
+  nodes_ = NULL;
+}
+
+// Set number of threads used for threaded grid computation.
+void PointWarpGrid::SetThreads(int threads) {
+  threads_ = threads;
+}
+
 }  // namespace internal
 
 CameraIntrinsics::CameraIntrinsics()
@@ -72,7 +177,9 @@ CameraIntrinsics::CameraIntrinsics(const CameraIntrinsics &from)
       image_height_(from.image_height_),
       K_(from.K_),
       distort_(from.distort_),
-      undistort_(from.undistort_) {}
+      undistort_(from.undistort_),
+      distort_points_(from.distort_points_),
+      undistort_points_(from.undistort_points_) {}
 
 // Set the image size in pixels.
 void CameraIntrinsics::SetImageSize(int width, int height) {
@@ -107,6 +214,35 @@ void CameraIntrinsics::SetPrincipalPoint(double cx,
 void CameraIntrinsics::SetThreads(int threads) {
   distort_.SetThreads(threads);
   undistort_.SetThreads(threads);
+  distort_points_.SetThreads(threads);
+  undistort_points_.SetThreads(threads);
+}
+
+void CameraIntrinsics::UpdatePointLookupGrids() {
+  distort_points_.Update<ApplyIntrinsicsFunction>(*this,
+                                                  image_width_,
+                                                  image_height_);
+  undistort_points_.Update<InvertIntrinsicsFunction>(*this,
+                                                     image_width_,
+                                                     image_height_);
+}
+
+void CameraIntrinsics::CopyPointLookupGrids(const CameraIntrinsics &from) {
+  if (GetDistortionModelType() != from.GetDistortionModelType() ||
+      image_width_ != from.image_width_ ||
+      image_height_ != from.image_height_ ||
+      K_ != from.K_) {
+    return;
+  }
+  const double *parameters = distortion_parameters(),
+               *from_parameters = from.distortion_parameters();
+  for (int i = 0; i < num_distortion_parameters(); i++) {
+    if (parameters[i] != from_parameters[i]) {
+      return;
+    }
+  }
+  distort_points_ = from.distort_points_;
+  undistort_points_ = from.undistort_points_;
 }
 
 void CameraIntrinsics::ImageSpaceToNormalized(double image_x,
@@ -125,10 +261,33 @@ void CameraIntrinsics::NormalizedToImageSpace(double normalized_x,
   *image_y = normalized_y * focal_length_y() + principal_point_y();
 }
 
+void CameraIntrinsics::DistortPoint(double image_x,
+                                    double image_y,
+                                    double *distorted_x,
+                                    double *distorted_y) const {
+  if (!distort_points_.Apply(image_x, image_y, distorted_x, distorted_y)) {
+    ApplyIntrinsicsFunction(*this, image_x, image_y, distorted_x, distorted_y);
+  }
+}
+
+void CameraIntrinsics::UndistortPoint(double image_x,
+                                      double image_y,
+                                      double *undistorted_x,
+                                      double *undistorted_y) const {
+  if (!undistort_points_.Apply(image_x, image_y,
+                               undistorted_x, undistorted_y)) {
+    InvertIntrinsicsFunction(*this,
+                             image_x, image_y,
+                             undistorted_x, undistorted_y);
+  }
+}
+
 // Reset lookup grids after changing the distortion model.
 void CameraIntrinsics::ResetLookupGrids() {
   distort_.Reset();
   undistort_.Reset();
+  distort_points_.Reset();
+  undistort_points_.Reset();
 }
 
 PolynomialCameraIntrinsics::PolynomialCameraIntrinsics()
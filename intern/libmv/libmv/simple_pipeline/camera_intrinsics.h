@@ -124,6 +124,66 @@ class LookupWarpGrid {
   int threads_;
 };
 
+// This class is responsible to store a coarse grid of warped point
+// positions which is sampled bilinearly. It makes warping of individual
+// points (which for undistortion means an iterative solve) as cheap as
+// few multiply-adds, which matters when every pixel of an image is warped
+// separately, as it is done by the compositor.
+class PointWarpGrid {
+ public:
+  PointWarpGrid();
+  PointWarpGrid(const PointWarpGrid &from);
+  ~PointWarpGrid();
+
+  PointWarpGrid &operator =(const PointWarpGrid &from);
+
+  // Update the grid in order to be sure it's calculated for the image
+  // of given width and height, measured in pixels.
+  template<typename WarpFunction>
+  void Update(const CameraIntrinsics &intrinsics,
+              int width,
+              int height);
+
+  // Warp a point using the grid.
+  //
+  // Returns false if the grid is not calculated or the point is outside
+  // of the area covered by the grid, caller is to warp the point using
+  // the distortion model then.
+  bool Apply(double x, double y, double *warp_x, double *warp_y) const;
+
+  // Reset the grid.
+  // This will tag the grid for update without re-computing it.
+  void Reset();
+
+  // Set number of threads used for threaded grid computation.
+  void SetThreads(int threads);
+
+ private:
+  // Compute the grid using a given warp functor.
+  template<typename WarpFunction>
+  void Compute(const CameraIntrinsics &intrinsics);
+
+  // Distance between grid nodes in pixels.
+  static const int kStep = 8;
+
+  // Number of nodes covering the area around the image, so points which
+  // are warped slightly outside of the frame are still handled by the grid.
+  static const int kMargin = 4;
+
+  // Warped position of every node of the grid, stored as interleaved
+  // x and y coordinates.
+  float *nodes_;
+
+  // Dimensions of the image this grid covers.
+  int width_, height_;
+
+  // Number of grid nodes in both directions, including margin.
+  int nodes_x_, nodes_y_;
+
+  // Number of threads which will be used for grid computation.
+  int threads_;
+};
+
 }  // namespace internal
 
 class CameraIntrinsics {
@@ -166,6 +226,19 @@ class CameraIntrinsics {
   // Set number of threads used for threaded buffer distortion/undistortion.
   void SetThreads(int threads);
 
+  // Update grids used to warp individual points by DistortPoint() and
+  // UndistortPoint() for the current image size.
+  //
+  // Grids are kept until any of intrinsics changes, until then points
+  // are warped exactly using the distortion model.
+  void UpdatePointLookupGrids();
+
+  // Copy point lookup grids from other intrinsics, so grids are computed
+  // once and shared by intrinsics used from different threads.
+  //
+  // Nothing is copied if the intrinsics differ.
+  void CopyPointLookupGrids(const CameraIntrinsics &from);
+
   // Convert image space coordinates to normalized.
   void ImageSpaceToNormalized(double image_x,
                               double image_y,
@@ -197,6 +270,20 @@ class CameraIntrinsics {
                                 double *normalized_x,
                                 double *normalized_y) const = 0;
 
+  // Distort a point given in pixel coordinates of the undistorted image
+  // to get its pixel coordinates in the distorted image.
+  void DistortPoint(double image_x,
+                    double image_y,
+                    double *distorted_x,
+                    double *distorted_y) const;
+
+  // Undistort a point given in pixel coordinates of the distorted image
+  // to get its pixel coordinates in the undistorted image.
+  void UndistortPoint(double image_x,
+                      double image_y,
+                      double *undistorted_x,
+                      double *undistorted_y) const;
+
   // Distort an image using the current camera instrinsics
   //
   // The distorted image is computed in output_buffer using samples from
@@ -268,6 +355,10 @@ class CameraIntrinsics {
   internal::LookupWarpGrid distort_;
   internal::LookupWarpGrid undistort_;
 
+  // Point lookup grids for distortion and undistortion.
+  internal::PointWarpGrid distort_points_;
+  internal::PointWarpGrid undistort_points_;
+
  protected:
   // Reset lookup grids after changing the distortion model.
   void ResetLookupGrids();
@@ -117,6 +117,46 @@ void LookupWarpGrid::Update(const CameraIntrinsics &intrinsics,
   overscan_ = overscan;
 }
 
+template<typename WarpFunction>
+void PointWarpGrid::Compute(const CameraIntrinsics &intrinsics) {
+#if defined(_OPENMP)
+#  pragma omp parallel for schedule(dynamic) num_threads(threads_) \
+  if (threads_ > 1 && nodes_y_ > 16)
+#endif
+  for (int j = 0; j < nodes_y_; j++) {
+    for (int i = 0; i < nodes_x_; i++) {
+      double warp_x, warp_y;
+      WarpFunction(intrinsics,
+                   (i - kMargin) * kStep,
+                   (j - kMargin) * kStep,
+                   &warp_x, &warp_y);
+      float *node = &nodes_[(j * nodes_x_ + i) * 2];
+      node[0] = (float) warp_x;
+      node[1] = (float) warp_y;
+    }
+  }
+}
+
+template<typename WarpFunction>
+void PointWarpGrid::Update(const CameraIntrinsics &intrinsics,
+                           int width,
+                           int height) {
+  if (width_ != width ||
+      height_ != height) {
+    Reset();
+  }
+
+  if (nodes_ == NULL && width > 0 && height > 0) {
+    nodes_x_ = (width + kStep - 1) / kStep + 2 * kMargin + 1;
+    nodes_y_ = (height + kStep - 1) / kStep + 2 * kMargin + 1;
+    nodes_ = new float[nodes_x_ * nodes_y_ * 2];
+    Compute<WarpFunction>(intrinsics);
+  }
+
+  width_ = width;
+  height_ = height;
+}
+
 // TODO(MatthiasF): cubic B-Spline image sampling, bilinear lookup
 template<typename PixelType>
 void LookupWarpGrid::Apply(const PixelType *input_buffer,
@@ -236,4 +236,57 @@ TEST(PolynomialCameraIntrinsics, IdentityUndistortBuffer) {
   }
 }
 
+TEST(PolynomialCameraIntrinsics, PointLookupGrids) {
+  const int w = 640, h = 480;
+
+  PolynomialCameraIntrinsics intrinsics;
+  intrinsics.SetImageSize(w, h);
+  intrinsics.SetFocalLength(600.0, 600.0);
+  intrinsics.SetPrincipalPoint(w / 2.0 + 5.0, h / 2.0 - 3.0);
+  intrinsics.SetRadialDistortion(-0.2, 0.05, 0.0);
+
+  // Points are warped exactly until grids are calculated.
+  PolynomialCameraIntrinsics exact(intrinsics);
+  intrinsics.UpdatePointLookupGrids();
+
+  // Bilinear interpolation of the grid keeps error well below 1/50 pixel
+  // even for such a strong distortion.
+  for (double y = -10.0; y <= h + 10.0; y += 7.3) {
+    for (double x = -10.0; x <= w + 10.0; x += 7.3) {
+      double exact_x, exact_y, grid_x, grid_y;
+
+      exact.DistortPoint(x, y, &exact_x, &exact_y);
+      intrinsics.DistortPoint(x, y, &grid_x, &grid_y);
+      EXPECT_NEAR(exact_x, grid_x, 2e-2) << "x: " << x << " y: " << y;
+      EXPECT_NEAR(exact_y, grid_y, 2e-2) << "x: " << x << " y: " << y;
+
+      exact.UndistortPoint(x, y, &exact_x, &exact_y);
+      intrinsics.UndistortPoint(x, y, &grid_x, &grid_y);
+      EXPECT_NEAR(exact_x, grid_x, 2e-2) << "x: " << x << " y: " << y;
+      EXPECT_NEAR(exact_y, grid_y, 2e-2) << "x: " << x << " y: " << y;
+    }
+  }
+
+  // Grids are only shared between identical intrinsics.
+  PolynomialCameraIntrinsics other(exact);
+  other.SetRadialDistortion(-0.1, 0.0, 0.0);
+  other.CopyPointLookupGrids(intrinsics);
+  exact.CopyPointLookupGrids(intrinsics);
+
+  double other_x, other_y, expected_x, expected_y;
+  other.UndistortPoint(100.0, 100.0, &other_x, &other_y);
+  double normalized_x, normalized_y;
+  other.InvertIntrinsics(100.0, 100.0, &normalized_x, &normalized_y);
+  other.NormalizedToImageSpace(normalized_x, normalized_y,
+                               &expected_x, &expected_y);
+  EXPECT_EQ(expected_x, other_x);
+  EXPECT_EQ(expected_y, other_y);
+
+  double shared_x, shared_y, grid_x, grid_y;
+  exact.UndistortPoint(100.5, 100.5, &shared_x, &shared_y);
+  intrinsics.UndistortPoint(100.5, 100.5, &grid_x, &grid_y);
+  EXPECT_EQ(grid_x, shared_x);
+  EXPECT_EQ(grid_y, shared_y);
+}
+
 }  // namespace libmv
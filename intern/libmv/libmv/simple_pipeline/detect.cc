@@ -24,7 +24,9 @@
 
 #include <stdlib.h>
 #include <memory.h>
-#include <queue>
+#include <algorithm>
+#include <cfloat>
+#include <vector>
 
 #include "libmv/base/scoped_ptr.h"
 #include "libmv/image/array_nd.h"
@@ -53,50 +55,139 @@ int kDefaultFastMinTrackness = 128;
 // TODO(sergey): Think of a better default value here.
 double kDefaultHarrisThreshold = 1e-5;
 
-class FeatureComparison {
+// Features with higher score go first.
+class FeatureScoreGreater {
  public:
   bool operator() (const Feature &left, const Feature &right) const {
-    return right.score > left.score;
+    return left.score > right.score;
   }
 };
 
+// Maximal number of cells of the distance filter grid along each axis, so
+// the grid stays small when the minimal distance is tiny.
+const int kMaxFeatureGridSize = 512;
+
+// Uniform grid of the accepted features. The cells are at least as large as
+// the minimal distance, so only the 3x3 cells around a candidate can hold
+// features too close to it.
+class FeatureGrid {
+ public:
+  FeatureGrid(float min_x, float min_y, float max_x, float max_y,
+              float cell_size)
+    : min_x_(min_x),
+      min_y_(min_y),
+      cell_size_(cell_size),
+      width_(static_cast<int>((max_x - min_x) / cell_size) + 1),
+      height_(static_cast<int>((max_y - min_y) / cell_size) + 1),
+      cell_first_(width_ * height_, -1) {}
+
+  // Index is the position of the feature in the features vector passed to
+  // HasFeatureCloserThan().
+  void Insert(const Feature &feature, int index) {
+    int cell = CellY(feature.y) * width_ + CellX(feature.x);
+    if (index >= next_.size()) {
+      next_.resize(index + 1, -1);
+    }
+    next_[index] = cell_first_[cell];
+    cell_first_[cell] = index;
+  }
+
+  bool HasFeatureCloserThan(const Feature &feature,
+                            const vector<Feature> &features,
+                            int min_distance_squared) const {
+    const int cell_x = CellX(feature.x), cell_y = CellY(feature.y);
+    for (int y = std::max(0, cell_y - 1);
+         y <= std::min(height_ - 1, cell_y + 1);
+         ++y) {
+      for (int x = std::max(0, cell_x - 1);
+           x <= std::min(width_ - 1, cell_x + 1);
+           ++x) {
+        for (int i = cell_first_[y * width_ + x]; i != -1; i = next_[i]) {
+          const Feature &b = features[i];
+          if (Square(feature.x - b.x) + Square(feature.y - b.y) <
+              min_distance_squared) {
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+ private:
+  int CellX(float x) const {
+    return std::min(width_ - 1,
+                    static_cast<int>((x - min_x_) / cell_size_));
+  }
+  int CellY(float y) const {
+    return std::min(height_ - 1,
+                    static_cast<int>((y - min_y_) / cell_size_));
+  }
+
+  float min_x_, min_y_;
+  float cell_size_;
+  int width_, height_;
+  // First feature of every cell and the next feature of every feature in
+  // the same cell, -1 ends the lists.
+  std::vector<int> cell_first_;
+  std::vector<int> next_;
+};
+
 // Filter the features so there are no features closer than
-// minimal distance to each other.
-// This is a naive implementation with O(n^2) asymptotic.
+// minimal distance to each other, features with higher score win.
 void FilterFeaturesByDistance(const vector<Feature> &all_features,
                               int min_distance,
                               vector<Feature> *detected_features) {
   const int min_distance_squared = min_distance * min_distance;
 
-  // Use priority queue to sort the features by their score.
+  // Sort the features by their score.
   //
   // Do this on copy of the input features to prevent possible
   // distortion in callee function behavior.
-  std::priority_queue<Feature,
-                      std::vector<Feature>,
-                      FeatureComparison> priority_features;
-
-  for (int i = 0; i < all_features.size(); i++) {
-    priority_features.push(all_features.at(i));
+  std::vector<Feature> sorted_features(all_features.begin(),
+                                       all_features.end());
+  std::stable_sort(sorted_features.begin(),
+                   sorted_features.end(),
+                   FeatureScoreGreater());
+
+  if (min_distance <= 0 || sorted_features.empty()) {
+    for (int i = 0; i < sorted_features.size(); i++) {
+      detected_features->push_back(sorted_features[i]);
+    }
+    return;
   }
 
-  while (!priority_features.empty()) {
-    bool ok = true;
-    Feature a = priority_features.top();
+  // Already detected features are taken into account as well.
+  float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX;
+  for (int i = 0; i < sorted_features.size(); i++) {
+    min_x = std::min(min_x, sorted_features[i].x);
+    min_y = std::min(min_y, sorted_features[i].y);
+    max_x = std::max(max_x, sorted_features[i].x);
+    max_y = std::max(max_y, sorted_features[i].y);
+  }
+  for (int i = 0; i < detected_features->size(); i++) {
+    min_x = std::min(min_x, (*detected_features)[i].x);
+    min_y = std::min(min_y, (*detected_features)[i].y);
+    max_x = std::max(max_x, (*detected_features)[i].x);
+    max_y = std::max(max_y, (*detected_features)[i].y);
+  }
+  const float cell_size =
+      std::max(static_cast<float>(min_distance),
+               std::max(max_x - min_x, max_y - min_y) / kMaxFeatureGridSize);
 
-    for (int i = 0; i < detected_features->size(); i++) {
-      Feature &b = detected_features->at(i);
-      if (Square(a.x - b.x) + Square(a.y - b.y) < min_distance_squared) {
-        ok = false;
-        break;
-      }
-    }
+  FeatureGrid grid(min_x, min_y, max_x, max_y, cell_size);
+  for (int i = 0; i < detected_features->size(); i++) {
+    grid.Insert((*detected_features)[i], i);
+  }
 
-    if (ok) {
+  for (int i = 0; i < sorted_features.size(); i++) {
+    const Feature &a = sorted_features[i];
+    if (!grid.HasFeatureCloserThan(a,
+                                   *detected_features,
+                                   min_distance_squared)) {
+      grid.Insert(a, detected_features->size());
       detected_features->push_back(a);
     }
-
-    priority_features.pop();
   }
 }
 
@@ -108,7 +199,7 @@ void DetectFAST(const FloatImage &grayscale_image,
   const int min_trackness = options.fast_min_trackness;
   const int margin = options.margin;
   const int width = grayscale_image.Width() - 2 * margin;
-  const int height = grayscale_image.Width() - 2 * margin;
+  const int height = grayscale_image.Height() - 2 * margin;
   const int stride = grayscale_image.Width();
 
   scoped_array<unsigned char> byte_image(FloatImageToUCharArray(grayscale_image));
@@ -183,6 +274,26 @@ static unsigned int SAD(const ubyte* imageA, const ubyte* imageB,
 }
 #endif
 
+// Moravec score of the 16x16 patch at the given pixel, zero when the patch
+// is too self-similar to be a feature.
+inline int MoravecScore(const ubyte *s,
+                        int stride,
+                        const unsigned char *pattern) {
+  const int r = 1;  // radius for self similarity comparison
+  int score =  // low self-similarity with overlapping patterns
+               // OPTI: load pattern once
+      SAD(s, s-r*stride-r, stride, stride)+SAD(s, s-r*stride, stride, stride)+SAD(s, s-r*stride+r, stride, stride)+
+      SAD(s, s         -r, stride, stride)+                                   SAD(s, s         +r, stride, stride)+
+      SAD(s, s+r*stride-r, stride, stride)+SAD(s, s+r*stride, stride, stride)+SAD(s, s+r*stride+r, stride, stride);
+  score /= 256;  // normalize
+  if (pattern)  // find only features similar to pattern
+    score -= SAD(s, pattern, stride, 16);
+  if (score <= 16) return 0;  // filter very self-similar features
+  score -= 16;  // translate to score/histogram values
+  if (score>255) score=255;  // clip
+  return score;
+}
+
 void DetectMORAVEC(const FloatImage &grayscale_image,
                    const DetectOptions &options,
                    vector<Feature> *detected_features) {
@@ -191,30 +302,33 @@ void DetectMORAVEC(const FloatImage &grayscale_image,
   const unsigned char *pattern = options.moravec_pattern;
   const int count = options.moravec_max_count;
   const int width = grayscale_image.Width() - 2 * margin;
-  const int height = grayscale_image.Width() - 2 * margin;
+  const int height = grayscale_image.Height() - 2 * margin;
   const int stride = grayscale_image.Width();
 
   scoped_array<unsigned char> byte_image(FloatImageToUCharArray(grayscale_image));
 
+  // Scores of all the pixels are independent from each other, so compute
+  // them in parallel. Non-maximum suppression below depends on the order
+  // in which pixels are visited and stays sequential.
+  scoped_array<ubyte> pixel_scores(new ubyte[width*height]);
+  memset(pixel_scores.get(), 0, width*height);
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int y = distance; y < height-distance; y++) {
+    for (int x = distance; x < width-distance; x++) {
+      pixel_scores[y*width+x] = MoravecScore(&byte_image[y*stride+x],
+                                             stride,
+                                             pattern);
+    }
+  }
+
   unsigned short histogram[256];
   memset(histogram, 0, sizeof(histogram));
   scoped_array<ubyte> scores(new ubyte[width*height]);
   memset(scores.get(), 0, width*height);
-  const int r = 1;  // radius for self similarity comparison
   for (int y = distance; y < height-distance; y++) {
     for (int x = distance; x < width-distance; x++) {
-      const ubyte* s = &byte_image[y*stride+x];
-      int score =  // low self-similarity with overlapping patterns
-                   // OPTI: load pattern once
-          SAD(s, s-r*stride-r, stride, stride)+SAD(s, s-r*stride, stride, stride)+SAD(s, s-r*stride+r, stride, stride)+
-          SAD(s, s         -r, stride, stride)+                                   SAD(s, s         +r, stride, stride)+
-          SAD(s, s+r*stride-r, stride, stride)+SAD(s, s+r*stride, stride, stride)+SAD(s, s+r*stride+r, stride, stride);
-      score /= 256;  // normalize
-      if (pattern)  // find only features similar to pattern
-        score -= SAD(s, pattern, stride, 16);
-      if (score <= 16) continue;  // filter very self-similar features
-      score -= 16;  // translate to score/histogram values
-      if (score>255) score=255;  // clip
+      int score = pixel_scores[y*width+x];
+      if (score == 0) continue;
       ubyte* c = &scores[y*width+x];
       for (int i = -distance; i < 0; i++) {
         for (int j = -distance; j < distance; j++) {
@@ -263,18 +377,64 @@ void DetectMORAVEC(const FloatImage &grayscale_image,
   }
 }
 
-void DetectHarris(const FloatImage &grayscale_image,
-                  const DetectOptions &options,
-                  vector<Feature> *detected_features) {
-  const double alpha = 0.06;
-  const double sigma = 0.9;
-
-  const int min_distance = options.min_distance;
-  const int margin = options.margin;
-  const double threshold = options.harris_threshold;
+// Number of image rows Harris response is calculated for by a single thread.
+const int kHarrisBandHeight = 64;
+
+// Evaluate Harris function
+//
+//   det(A) - alpha * trace(A)^2,  A = [ Ix^2  Ix*Iy ]
+//                                     [ Ix*Iy Iy^2  ]
+//
+// for a row of pixels. Calculation is done in double precision in the same
+// order of operations as Mat2 would do, so results are bit-exact with it.
+void HarrisResponseRow(const float *gradient_xx,
+                       const float *gradient_yy,
+                       const float *gradient_xy,
+                       int width,
+                       double alpha,
+                       double *response) {
+  int x = 0;
+#ifdef __SSE2__
+  const __m128d alpha_sse = _mm_set1_pd(alpha);
+  for (; x + 2 <= width; x += 2) {
+    const __m128d xx = _mm_cvtps_pd(_mm_castsi128_ps(
+        _mm_loadl_epi64((const __m128i *) (gradient_xx + x))));
+    const __m128d yy = _mm_cvtps_pd(_mm_castsi128_ps(
+        _mm_loadl_epi64((const __m128i *) (gradient_yy + x))));
+    const __m128d xy = _mm_cvtps_pd(_mm_castsi128_ps(
+        _mm_loadl_epi64((const __m128i *) (gradient_xy + x))));
+    const __m128d det = _mm_sub_pd(_mm_mul_pd(xx, yy), _mm_mul_pd(xy, xy));
+    const __m128d trace = _mm_add_pd(xx, yy);
+    _mm_storeu_pd(response + x,
+                  _mm_sub_pd(det,
+                             _mm_mul_pd(_mm_mul_pd(alpha_sse, trace),
+                                        trace)));
+  }
+#endif
+  for (; x < width; x++) {
+    const double xx = gradient_xx[x], yy = gradient_yy[x],
+                 xy = gradient_xy[x];
+    const double det = xx * yy - xy * xy;
+    const double trace = xx + yy;
+    response[x] = det - alpha * trace * trace;
+  }
+}
 
+// Detect Harris features in rows [begin_y, end_y) of the image. Image is
+// expected to be a band of the full frame which has enough rows around the
+// detection rows for the derivative and blur kernels, offset_y is the row
+// of the full frame the band starts at.
+void DetectHarrisInBand(const FloatImage &image,
+                        double sigma,
+                        double alpha,
+                        double threshold,
+                        int margin,
+                        int begin_y,
+                        int end_y,
+                        int offset_y,
+                        vector<Feature> *features) {
   FloatImage gradient_x, gradient_y;
-  ImageDerivatives(grayscale_image, sigma, &gradient_x, &gradient_y);
+  ImageDerivatives(image, sigma, &gradient_x, &gradient_y);
 
   FloatImage gradient_xx, gradient_yy, gradient_xy;
   MultiplyElements(gradient_x, gradient_x, &gradient_xx);
@@ -288,29 +448,86 @@ void DetectHarris(const FloatImage &grayscale_image,
   ConvolveGaussian(gradient_yy, sigma, &gradient_yy_blurred);
   ConvolveGaussian(gradient_xy, sigma, &gradient_xy_blurred);
 
-  vector<Feature> all_features;
-  for (int y = margin; y < gradient_xx_blurred.Height() - margin; ++y) {
-    for (int x = margin; x < gradient_xx_blurred.Width() - margin; ++x) {
-      // Construct matrix
-      //
-      //  A = [ Ix^2  Ix*Iy ]
-      //      [ Ix*Iy Iy^2  ]
-      Mat2 A;
-      A(0, 0) = gradient_xx_blurred(y, x);
-      A(1, 1) = gradient_yy_blurred(y, x);
-      A(0, 1) = A(1, 0) = gradient_xy_blurred(y, x);
-
-      double detA = A.determinant();
-      double traceA = A.trace();
-      double harris_function = detA - alpha * traceA * traceA;
-      if (harris_function > threshold) {
-        all_features.push_back(Feature((float) x,
-                                       (float) y,
-                                       (float) harris_function,
-                                       5.0f));
+  const int width = image.Width();
+  std::vector<double> response(width);
+  for (int y = begin_y; y < end_y; ++y) {
+    HarrisResponseRow(&gradient_xx_blurred(y, 0),
+                      &gradient_yy_blurred(y, 0),
+                      &gradient_xy_blurred(y, 0),
+                      width,
+                      alpha,
+                      &response[0]);
+    for (int x = margin; x < width - margin; ++x) {
+      if (response[x] > threshold) {
+        features->push_back(Feature((float) x,
+                                    (float) (y + offset_y),
+                                    (float) response[x],
+                                    5.0f));
       }
     }
   }
+}
+
+void DetectHarris(const FloatImage &grayscale_image,
+                  const DetectOptions &options,
+                  vector<Feature> *detected_features) {
+  const double alpha = 0.06;
+  const double sigma = 0.9;
+
+  const int min_distance = options.min_distance;
+  const int margin = options.margin;
+  const double threshold = options.harris_threshold;
+
+  const int width = grayscale_image.Width();
+  const int height = grayscale_image.Height();
+  const int begin_y = margin, end_y = height - margin;
+  if (width == 0 || end_y <= begin_y) {
+    return;
+  }
+
+  // Derivatives and blur of their products each need kernel radius rows
+  // around the band to be the same as if they were done on the whole image.
+  Vec kernel, derivative;
+  ComputeGaussianKernel(sigma, &kernel, &derivative);
+  const int band_padding = 2 * (kernel.size() / 2);
+
+  // Image is split into bands of rows which are handled independently.
+  // Features are collected per band and merged in the band order, so the
+  // result does not depend on the number of threads.
+  const int num_bands = (end_y - begin_y + kHarrisBandHeight - 1) /
+                        kHarrisBandHeight;
+  std::vector<vector<Feature> > band_features(num_bands);
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int band = 0; band < num_bands; ++band) {
+    const int band_begin_y = begin_y + band * kHarrisBandHeight;
+    const int band_end_y = std::min(band_begin_y + kHarrisBandHeight, end_y);
+    const int padded_begin_y = std::max(0, band_begin_y - band_padding);
+    const int padded_end_y = std::min(height, band_end_y + band_padding);
+
+    FloatImage band_image(padded_end_y - padded_begin_y, width);
+    memcpy(band_image.Data(),
+           &grayscale_image(padded_begin_y, 0),
+           sizeof(float) * width * (padded_end_y - padded_begin_y));
+
+    DetectHarrisInBand(band_image,
+                       sigma,
+                       alpha,
+                       threshold,
+                       margin,
+                       band_begin_y - padded_begin_y,
+                       band_end_y - padded_begin_y,
+                       padded_begin_y,
+                       &band_features[band]);
+  }
+
+  vector<Feature> all_features;
+  for (int band = 0; band < num_bands; ++band) {
+    const vector<Feature> &features = band_features[band];
+    for (int i = 0; i < features.size(); ++i) {
+      all_features.push_back(features[i]);
+    }
+  }
 
   FilterFeaturesByDistance(all_features, min_distance, detected_features);
 }
@@ -225,8 +225,56 @@ TEST(Detect, HarrisSingleTriangleTest) {
   PreformSingleTriangleTest(options);
 }
 
-// TODO(sergey): Add tests for margin option.
+TEST(Detect, HarrisBandBordersTest) {
+  DetectOptions options;
+  options.type = DetectOptions::HARRIS;
+
+  options.margin = 3;
+  options.min_distance = 3;
+
+  // Image is processed in bands of rows, put the points to the first and
+  // last rows of the bands.
+  FloatImage image(200, 30);
+  image.fill(1.0);
+  const int point_y[] = {20, 66, 67, 131, 195};
+  vector<Feature> expected_features;
+  for (int i = 0; i < 5; ++i) {
+    const int x = 4 + 5 * i;
+    image(point_y[i], x) = 0.0;
+    expected_features.push_back(Feature(x, point_y[i]));
+  }
+
+  vector<Feature> detected_features;
+  Detect(image, options, &detected_features);
+
+  CheckExpectedFeatures(detected_features, expected_features);
+}
 
-// TODO(sergey): Add tests for min_distance option.
+TEST(Detect, HarrisMinDistanceTest) {
+  DetectOptions options;
+  options.type = DetectOptions::HARRIS;
+
+  options.margin = 3;
+  options.min_distance = 8;
+
+  // Points closer than the minimal distance, the one with the lower
+  // contrast is to be filtered out.
+  FloatImage image(15, 40);
+  image.fill(1.0);
+  image(7, 10) = 0.0;
+  image(7, 16) = 0.5;
+  image(7, 30) = 0.0;
+
+  vector<Feature> detected_features;
+  Detect(image, options, &detected_features);
+
+  vector<Feature> expected_features;
+  expected_features.push_back(Feature(10, 7));
+  expected_features.push_back(Feature(30, 7));
+
+  CheckExpectedFeatures(detected_features, expected_features);
+}
+
+// TODO(sergey): Add tests for margin option.
 
 }  // namespace libmv
@@ -47,8 +47,16 @@ struct EuclideanPipelineRoutines {
   typedef EuclideanPoint Point;
 
   static void Bundle(const Tracks &tracks,
-                     EuclideanReconstruction *reconstruction) {
-    EuclideanBundle(tracks, reconstruction);
+                     EuclideanReconstruction *reconstruction,
+                     int num_threads) {
+    EuclideanBundle(tracks, reconstruction, num_threads);
+  }
+
+  static void BundleLocal(const Tracks &tracks,
+                          const vector<int> &images,
+                          EuclideanReconstruction *reconstruction,
+                          int num_threads) {
+    EuclideanBundleLocal(tracks, images, reconstruction, num_threads);
   }
 
   static bool Resect(const vector<Marker> &markers,
@@ -85,7 +93,20 @@ struct ProjectivePipelineRoutines {
   typedef ProjectivePoint Point;
 
   static void Bundle(const Tracks &tracks,
-                     ProjectiveReconstruction *reconstruction) {
+                     ProjectiveReconstruction *reconstruction,
+                     int num_threads) {
+    (void) num_threads;  // Ignored.
+
+    ProjectiveBundle(tracks, reconstruction);
+  }
+
+  static void BundleLocal(const Tracks &tracks,
+                          const vector<int> &images,
+                          ProjectiveReconstruction *reconstruction,
+                          int num_threads) {
+    (void) images;  // Ignored.
+    (void) num_threads;  // Ignored.
+
     ProjectiveBundle(tracks, reconstruction);
   }
 
@@ -121,6 +142,11 @@ struct ProjectivePipelineRoutines {
 
 }  // namespace
 
+CompleteReconstructionOptions::CompleteReconstructionOptions()
+  : local_bundle_window(10),
+    global_bundle_growth(2.0),
+    num_threads(0) {}
+
 static void CompleteReconstructionLogProgress(
     ProgressUpdateCallback *update_callback,
     double progress,
@@ -139,11 +165,57 @@ static void CompleteReconstructionLogProgress(
   }
 }
 
+// Bundle the reconstruction after num_new_images cameras were added to the
+// end of reconstructed_images (or after new points were added when it's zero).
+//
+// New cameras and the local_bundle_window cameras reconstructed before them
+// are refined by a local bundle. Once the reconstruction grew by
+// global_bundle_growth since the last global bundle, the whole reconstruction
+// is refined instead.
+template<typename PipelineRoutines>
+void InternalIncrementalBundle(
+    const Tracks &tracks,
+    const vector<int> &reconstructed_images,
+    int num_new_images,
+    const CompleteReconstructionOptions &options,
+    int *num_local_bundles,
+    int *num_globally_bundled_images,
+    typename PipelineRoutines::Reconstruction *reconstruction) {
+  const int num_images = reconstructed_images.size();
+  const int window_size = num_new_images + options.local_bundle_window;
+  if (options.local_bundle_window <= 0 ||
+      window_size >= num_images ||
+      (options.global_bundle_growth > 1.0 &&
+       num_images >=
+           options.global_bundle_growth * *num_globally_bundled_images)) {
+    PipelineRoutines::Bundle(tracks, reconstruction, options.num_threads);
+    *num_local_bundles = 0;
+    *num_globally_bundled_images = num_images;
+    LG << "Ran global Bundle().";
+    return;
+  }
+
+  vector<int> window;
+  for (int i = reconstructed_images.size() - window_size;
+       i < reconstructed_images.size();
+       ++i) {
+    window.push_back(reconstructed_images[i]);
+  }
+  PipelineRoutines::BundleLocal(tracks,
+                                window,
+                                reconstruction,
+                                options.num_threads);
+  (*num_local_bundles)++;
+  LG << "Ran local Bundle() of " << window.size() << " cameras.";
+}
+
 template<typename PipelineRoutines>
 void InternalCompleteReconstruction(
     const Tracks &tracks,
     typename PipelineRoutines::Reconstruction *reconstruction,
-    ProgressUpdateCallback *update_callback = NULL) {
+    ProgressUpdateCallback *update_callback = NULL,
+    const CompleteReconstructionOptions &options =
+        CompleteReconstructionOptions()) {
   int max_track = tracks.MaxTrack();
   int max_image = tracks.MaxImage();
   int num_resects = -1;
@@ -152,6 +224,17 @@ void InternalCompleteReconstruction(
   LG << "Max track: " << max_track;
   LG << "Max image: " << max_image;
   LG << "Number of markers: " << tracks.NumMarkers();
+
+  // Cameras in the order they were reconstructed in, local bundles refine
+  // the end of this list.
+  vector<int> reconstructed_images;
+  for (int image = 0; image <= max_image; ++image) {
+    if (reconstruction->CameraForImage(image)) {
+      reconstructed_images.push_back(image);
+    }
+  }
+  int num_local_bundles = 0;
+  int num_globally_bundled_images = reconstructed_images.size();
   while (num_resects != 0 || num_intersects != 0) {
     // Do all possible intersections.
     num_intersects = 0;
@@ -187,7 +270,13 @@ void InternalCompleteReconstruction(
       CompleteReconstructionLogProgress(update_callback,
                                         (double)tot_resects/(max_image),
                                         "Bundling...");
-      PipelineRoutines::Bundle(tracks, reconstruction);
+      InternalIncrementalBundle<PipelineRoutines>(tracks,
+                                                  reconstructed_images,
+                                                  0,
+                                                  options,
+                                                  &num_local_bundles,
+                                                  &num_globally_bundled_images,
+                                                  reconstruction);
       LG << "Ran Bundle() after intersections.";
     }
     LG << "Did " << num_intersects << " intersects.";
@@ -217,6 +306,7 @@ void InternalCompleteReconstruction(
                                      reconstruction, false)) {
           num_resects++;
           tot_resects++;
+          reconstructed_images.push_back(image);
           LG << "Ran Resect() for image " << image;
         } else {
           LG << "Failed Resect() for image " << image;
@@ -227,7 +317,13 @@ void InternalCompleteReconstruction(
       CompleteReconstructionLogProgress(update_callback,
                                         (double)tot_resects/(max_image),
                                         "Bundling...");
-      PipelineRoutines::Bundle(tracks, reconstruction);
+      InternalIncrementalBundle<PipelineRoutines>(tracks,
+                                                  reconstructed_images,
+                                                  num_resects,
+                                                  options,
+                                                  &num_local_bundles,
+                                                  &num_globally_bundled_images,
+                                                  reconstruction);
     }
     LG << "Did " << num_resects << " resects.";
   }
@@ -259,11 +355,13 @@ void InternalCompleteReconstruction(
       }
     }
   }
-  if (num_resects) {
+  // Final bundle refines the whole reconstruction, so local bundles do not
+  // leave drift behind.
+  if (num_resects || num_local_bundles) {
     CompleteReconstructionLogProgress(update_callback,
                                       (double)tot_resects/(max_image),
                                       "Bundling...");
-    PipelineRoutines::Bundle(tracks, reconstruction);
+    PipelineRoutines::Bundle(tracks, reconstruction, options.num_threads);
   }
 }
 
@@ -338,12 +436,15 @@ double ProjectiveReprojectionError(
                                                                intrinsics);
 }
 
-void EuclideanCompleteReconstruction(const Tracks &tracks,
-                                     EuclideanReconstruction *reconstruction,
-                                     ProgressUpdateCallback *update_callback) {
+void EuclideanCompleteReconstruction(
+    const Tracks &tracks,
+    EuclideanReconstruction *reconstruction,
+    ProgressUpdateCallback *update_callback,
+    const CompleteReconstructionOptions &options) {
   InternalCompleteReconstruction<EuclideanPipelineRoutines>(tracks,
                                                             reconstruction,
-                                                            update_callback);
+                                                            update_callback,
+                                                            options);
 }
 
 void ProjectiveCompleteReconstruction(const Tracks &tracks,
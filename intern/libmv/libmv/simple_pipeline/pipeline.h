@@ -27,6 +27,26 @@
 
 namespace libmv {
 
+// Bundle adjustment settings used by EuclideanCompleteReconstruction().
+struct CompleteReconstructionOptions {
+  CompleteReconstructionOptions();
+
+  // Number of previously reconstructed cameras which are refined together
+  // with newly reconstructed ones by the local bundle adjustment.
+  // Zero makes every bundle adjustment refine the whole reconstruction.
+  int local_bundle_window;
+
+  // Whole reconstruction is refined once the number of reconstructed
+  // cameras grew by this factor since it was refined last time, so the cost
+  // of global refinements grows linearly with the length of the shot.
+  // Values not greater than one mean it is only refined once at the end.
+  double global_bundle_growth;
+
+  // Number of threads used by bundle adjustment, zero means as many
+  // threads as OpenMP would use.
+  int num_threads;
+};
+
 /*!
     Estimate camera poses and scene 3D coordinates for all frames and tracks.
 
@@ -39,17 +59,24 @@ namespace libmv {
     repeated until all points and cameras are estimated. Periodically, bundle
     adjustment is run to ensure a quality reconstruction.
 
+    Bundle adjustment after adding cameras or points is local: it only
+    refines the most recently reconstructed cameras, see \a options. The
+    whole reconstruction is refined periodically and once at the end.
+
     \a tracks should contain markers used in the reconstruction.
     \a reconstruction should contain at least some 3D points or some estimated
     cameras. The minimum number of cameras is two (with no 3D points) and the
     minimum number of 3D points (with no estimated cameras) is 5.
 
-    \sa EuclideanResect, EuclideanIntersect, EuclideanBundle
+    \sa EuclideanResect, EuclideanIntersect, EuclideanBundle,
+        EuclideanBundleLocal
 */
 void EuclideanCompleteReconstruction(
         const Tracks &tracks,
         EuclideanReconstruction *reconstruction,
-        ProgressUpdateCallback *update_callback = NULL);
+        ProgressUpdateCallback *update_callback = NULL,
+        const CompleteReconstructionOptions &options =
+            CompleteReconstructionOptions());
 
 /*!
     Estimate camera matrices and homogeneous 3D coordinates for all frames and
@@ -0,0 +1,144 @@
+// Copyright (c) 2016 libmv authors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "libmv/simple_pipeline/pipeline.h"
+
+#include <cstdlib>
+
+#include "libmv/multiview/test_data_sets.h"
+#include "libmv/simple_pipeline/bundle.h"
+#include "libmv/simple_pipeline/camera_intrinsics.h"
+#include "libmv/simple_pipeline/reconstruction.h"
+#include "libmv/simple_pipeline/tracks.h"
+#include "testing/testing.h"
+
+namespace libmv {
+
+namespace {
+
+const double kFocalLength = 1000.0;
+const double kPrincipalPoint = 500.0;
+
+// Synthetic shot of a camera moving around the scene. Every point is only
+// tracked in track_length consecutive frames, as it happens in real footage.
+struct SyntheticShot {
+  NViewDataSet data;
+  Tracks tracks;
+  Tracks normalized_tracks;
+};
+
+void MakeSyntheticShot(int num_views,
+                       int num_points,
+                       int track_length,
+                       double noise,
+                       SyntheticShot *shot) {
+  srand(0);
+  shot->data = NRealisticCamerasFull(num_views, num_points);
+
+  vector<Marker> markers, normalized_markers;
+  for (int point = 0; point < num_points; ++point) {
+    const int first_view =
+        point * (num_views - track_length + 1) / num_points;
+    for (int view = first_view; view < first_view + track_length; ++view) {
+      Marker marker;
+      marker.image = view;
+      marker.track = point;
+      marker.x = shot->data.x[view](0, point) +
+                 noise * (2.0 * rand() / RAND_MAX - 1.0);
+      marker.y = shot->data.x[view](1, point) +
+                 noise * (2.0 * rand() / RAND_MAX - 1.0);
+      marker.weight = 1.0;
+      markers.push_back(marker);
+
+      marker.x = (marker.x - kPrincipalPoint) / kFocalLength;
+      marker.y = (marker.y - kPrincipalPoint) / kFocalLength;
+      normalized_markers.push_back(marker);
+    }
+  }
+  shot->tracks = Tracks(markers);
+  shot->normalized_tracks = Tracks(normalized_markers);
+}
+
+// Start the reconstruction from the two first cameras of the shot, the way
+// EuclideanReconstructTwoFrames() would do.
+void InitializeReconstruction(const SyntheticShot &shot,
+                              EuclideanReconstruction *reconstruction) {
+  reconstruction->InsertCamera(0, shot.data.R[0], shot.data.t[0]);
+  reconstruction->InsertCamera(1, shot.data.R[1], shot.data.t[1]);
+}
+
+double SolveShot(const SyntheticShot &shot,
+                 const CompleteReconstructionOptions &options,
+                 EuclideanReconstruction *reconstruction) {
+  InitializeReconstruction(shot, reconstruction);
+  EuclideanCompleteReconstruction(shot.normalized_tracks,
+                                  reconstruction,
+                                  NULL,
+                                  options);
+
+  PolynomialCameraIntrinsics intrinsics;
+  intrinsics.SetFocalLength(kFocalLength, kFocalLength);
+  intrinsics.SetPrincipalPoint(kPrincipalPoint, kPrincipalPoint);
+  return EuclideanReprojectionError(shot.tracks, *reconstruction, intrinsics);
+}
+
+}  // namespace
+
+TEST(Pipeline, IncrementalBundleSyntheticShot) {
+  SyntheticShot shot;
+  MakeSyntheticShot(40, 400, 12, 0.0, &shot);
+
+  CompleteReconstructionOptions options;
+  options.local_bundle_window = 5;
+  options.global_bundle_growth = 1.5;
+
+  EuclideanReconstruction reconstruction;
+  double error = SolveShot(shot, options, &reconstruction);
+  EXPECT_LT(error, 1e-3);
+
+  for (int view = 0; view < shot.data.n; ++view) {
+    const EuclideanCamera *camera = reconstruction.CameraForImage(view);
+    ASSERT_TRUE(camera != NULL);
+    EXPECT_LT((camera->t - shot.data.t[view]).norm(), 1e-4);
+  }
+}
+
+TEST(Pipeline, IncrementalBundleMatchesGlobalBundle) {
+  SyntheticShot shot;
+  MakeSyntheticShot(40, 400, 12, 0.5, &shot);
+
+  CompleteReconstructionOptions global_options;
+  global_options.local_bundle_window = 0;
+
+  EuclideanReconstruction global_reconstruction;
+  double global_error = SolveShot(shot,
+                                  global_options,
+                                  &global_reconstruction);
+
+  EuclideanReconstruction incremental_reconstruction;
+  double incremental_error = SolveShot(shot,
+                                       CompleteReconstructionOptions(),
+                                       &incremental_reconstruction);
+
+  // Both end with a global bundle, so they converge to the same minimum.
+  EXPECT_NEAR(global_error, incremental_error, 1e-3);
+}
+
+}  // namespace libmv
@@ -136,6 +136,7 @@ TrackRegionOptions::TrackRegionOptions()
       max_iterations(20),
       use_esm(true),
       use_brute_initialization(true),
+      use_brute_pyramid(false),
       use_normalized_intensities(false),
       sigma(0.9),
       num_extra_points(0),
@@ -1177,6 +1178,69 @@ void CreateBrutePattern(const double *x1, const double *y1,
   *origin_y = min_y;
 }
 
+// Exhaustive search of the shifts rows [r_begin, r_end) and columns [c_begin,
+// c_end) of the pattern over the search image. Returns false if no shift was
+// tried or the effective pattern area is zero.
+template<typename SearchArray>
+bool BruteSearchShifts(const FloatArray &pattern,
+                       const FloatArray &mask,
+                       const double mask_sum,
+                       const SearchArray &search,
+                       const bool use_normalized_intensities,
+                       const int r_begin, const int r_end,
+                       const int c_begin, const int c_end,
+                       int *best_r, int *best_c) {
+  double best_sad = std::numeric_limits<double>::max();
+  int w = pattern.cols();
+  int h = pattern.rows();
+
+  *best_r = -1;
+  *best_c = -1;
+  for (int r = r_begin; r < r_end; ++r) {
+    for (int c = c_begin; c < c_end; ++c) {
+      // Compute the weighted sum of absolute differences, Eigen style. Note
+      // that the block from the search image is never stored in a variable, to
+      // avoid copying overhead and permit inlining.
+      double sad;
+      if (use_normalized_intensities) {
+        // TODO(keir): It's really dumb to recompute the search mean for every
+        // shift. A smarter implementation would use summed area tables
+        // instead, reducing the mean calculation to an O(1) operation.
+        double inverse_search_mean =
+            mask_sum / ((mask * search.block(r, c, h, w)).sum());
+        sad = (mask * (pattern - (search.block(r, c, h, w) *
+                                  inverse_search_mean))).abs().sum();
+      } else {
+        sad = (mask * (pattern - search.block(r, c, h, w))).abs().sum();
+      }
+      if (sad < best_sad) {
+        *best_r = r;
+        *best_c = c;
+        best_sad = sad;
+      }
+    }
+  }
+  return *best_r != -1 && *best_c != -1;
+}
+
+// 2x2 box filter downsampling, an odd last row or column is ignored.
+template<typename ArrayType>
+void DownsampleArrayBy2(const ArrayType &in, FloatArray *out) {
+  out->resize(in.rows() / 2, in.cols() / 2);
+  for (int r = 0; r < out->rows(); ++r) {
+    for (int c = 0; c < out->cols(); ++c) {
+      (*out)(r, c) = (in(2 * r,     2 * c) +
+                      in(2 * r + 1, 2 * c) +
+                      in(2 * r,     2 * c + 1) +
+                      in(2 * r + 1, 2 * c + 1)) / 4.0f;
+    }
+  }
+}
+
+// Number of full resolution shifts around the best coarse shift which are
+// searched when use_brute_pyramid is enabled.
+const int kBrutePyramidRefineRadius = 2;
+
 // Compute a translation-only estimate of the warp, using brute force search. A
 // smarter implementation would use the FFT to compute the normalized cross
 // correlation. Instead, this is a dumb implementation. Surprisingly, it is
@@ -1200,6 +1264,7 @@ bool BruteTranslationOnlyInitialize(const FloatImage &image1,
                                     const FloatImage &image2,
                                     const int num_extra_points,
                                     const bool use_normalized_intensities,
+                                    const bool use_brute_pyramid,
                                     const double *x1, const double *y1,
                                     double *x2, double *y2) {
   // Create the pattern to match in the space of image2, assuming our inital
@@ -1236,37 +1301,56 @@ bool BruteTranslationOnlyInitialize(const FloatImage &image1,
   // change in the cost function. If the image is a blob or splotch with blurry
   // edges, then fewer samples are necessary since a few pixels offset won't
   // change the cost function much.
-  double best_sad = std::numeric_limits<double>::max();
   int best_r = -1;
   int best_c = -1;
   int w = pattern.cols();
   int h = pattern.rows();
-
-  for (int r = 0; r < (image2.Height() - h); ++r) {
-    for (int c = 0; c < (image2.Width() - w); ++c) {
-      // Compute the weighted sum of absolute differences, Eigen style. Note
-      // that the block from the search image is never stored in a variable, to
-      // avoid copying overhead and permit inlining.
-      double sad;
-      if (use_normalized_intensities) {
-        // TODO(keir): It's really dumb to recompute the search mean for every
-        // shift. A smarter implementation would use summed area tables
-        // instead, reducing the mean calculation to an O(1) operation.
-        double inverse_search_mean =
-            mask_sum / ((mask * search.block(r, c, h, w)).sum());
-        sad = (mask * (pattern - (search.block(r, c, h, w) *
-                                  inverse_search_mean))).abs().sum();
-      } else {
-        sad = (mask * (pattern - search.block(r, c, h, w))).abs().sum();
-      }
-      if (sad < best_sad) {
-        best_r = r;
-        best_c = c;
-        best_sad = sad;
-      }
+  int num_tried_shifts = 0;
+
+  // With the pyramid only the neighbourhood of the best coarse shift is
+  // searched at full resolution. Tiny patterns keep the exhaustive search,
+  // there is not enough left of them after downsampling.
+  bool found_coarse_shift = false;
+  if (use_brute_pyramid && w >= 8 && h >= 8) {
+    FloatArray coarse_pattern, coarse_mask, coarse_search;
+    DownsampleArrayBy2(pattern, &coarse_pattern);
+    DownsampleArrayBy2(mask, &coarse_mask);
+    DownsampleArrayBy2(search, &coarse_search);
+    double coarse_mask_sum =
+        use_normalized_intensities ? coarse_mask.sum() : 1.0;
+
+    int coarse_r, coarse_c;
+    const int coarse_rows = coarse_search.rows() - coarse_pattern.rows();
+    const int coarse_cols = coarse_search.cols() - coarse_pattern.cols();
+    if (BruteSearchShifts(coarse_pattern, coarse_mask, coarse_mask_sum,
+                          coarse_search, use_normalized_intensities,
+                          0, coarse_rows, 0, coarse_cols,
+                          &coarse_r, &coarse_c)) {
+      const int radius = kBrutePyramidRefineRadius;
+      const int r_begin = std::max(0, 2 * coarse_r - radius);
+      const int r_end = std::min(image2.Height() - h,
+                                 2 * coarse_r + radius + 1);
+      const int c_begin = std::max(0, 2 * coarse_c - radius);
+      const int c_end = std::min(image2.Width() - w,
+                                 2 * coarse_c + radius + 1);
+      found_coarse_shift = BruteSearchShifts(pattern, mask, mask_sum,
+                                             search,
+                                             use_normalized_intensities,
+                                             r_begin, r_end, c_begin, c_end,
+                                             &best_r, &best_c);
+      num_tried_shifts = coarse_rows * coarse_cols +
+                         (r_end - r_begin) * (c_end - c_begin);
     }
   }
 
+  if (!found_coarse_shift) {
+    BruteSearchShifts(pattern, mask, mask_sum,
+                      search, use_normalized_intensities,
+                      0, image2.Height() - h, 0, image2.Width() - w,
+                      &best_r, &best_c);
+    num_tried_shifts += (image2.Height() - h) * (image2.Width() - w);
+  }
+
   // This mean the effective pattern area is zero. This check could go earlier,
   // but this is less code.
   if (best_r == -1 || best_c == -1) {
@@ -1278,7 +1362,7 @@ bool BruteTranslationOnlyInitialize(const FloatImage &image1,
      << "origin_x: " << origin_x << ", origin_y: " << origin_y << ", "
      << "dc: " << (best_c - origin_x) << ", "
      << "dr: " << (best_r - origin_y)
-     << ", tried " << ((image2.Height() - h) * (image2.Width() - w))
+     << ", tried " << num_tried_shifts
      << " shifts.";
 
   // Apply the shift.
@@ -1302,7 +1386,9 @@ void CopyQuad(double *src_x, double *src_y,
 
 template<typename Warp>
 void TemplatedTrackRegion(const FloatImage &image1,
+                          const FloatImage &image_and_gradient1,
                           const FloatImage &image2,
+                          const FloatImage &image_and_gradient2,
                           const double *x1, const double *y1,
                           const TrackRegionOptions &options,
                           double *x2, double *y2,
@@ -1325,7 +1411,8 @@ void TemplatedTrackRegion(const FloatImage &image1,
     double y2_first_try[5];
     CopyQuad(x2, y2, x2_first_try, y2_first_try, options.num_extra_points);
 
-    TemplatedTrackRegion<Warp>(image1, image2,
+    TemplatedTrackRegion<Warp>(image1, image_and_gradient1,
+                               image2, image_and_gradient2,
                                x1, y1, modified_options,
                                x2_first_try, y2_first_try, result);
 
@@ -1368,14 +1455,6 @@ void TemplatedTrackRegion(const FloatImage &image1,
     y2_original[i] = y2[i];
   }
 
-  // Prepare the image and gradient.
-  Array3Df image_and_gradient1;
-  Array3Df image_and_gradient2;
-  BlurredImageAndDerivativesChannels(image1, options.sigma,
-                                     &image_and_gradient1);
-  BlurredImageAndDerivativesChannels(image2, options.sigma,
-                                     &image_and_gradient2);
-
   // Possibly do a brute-force translation-only initialization.
   if (SearchAreaTooBigForDescent(image2, x2, y2) &&
       options.use_brute_initialization) {
@@ -1386,6 +1465,7 @@ void TemplatedTrackRegion(const FloatImage &image1,
         image2,
         options.num_extra_points,
         options.use_normalized_intensities,
+        options.use_brute_pyramid,
         x1, y1, x2, y2);
     if (!found_any_alignment) {
       LG << "Brute failed to find an alignment; pattern too small. "
@@ -1532,10 +1612,35 @@ void TrackRegion(const FloatImage &image1,
                  const TrackRegionOptions &options,
                  double *x2, double *y2,
                  TrackRegionResult *result) {
+  // Prepare the image and gradient.
+  Array3Df image_and_gradient1;
+  Array3Df image_and_gradient2;
+  BlurredImageAndDerivativesChannels(image1, options.sigma,
+                                     &image_and_gradient1);
+  BlurredImageAndDerivativesChannels(image2, options.sigma,
+                                     &image_and_gradient2);
+
+  TrackRegion(image1, image_and_gradient1,
+              image2, image_and_gradient2,
+              x1, y1,
+              options,
+              x2, y2,
+              result);
+}
+
+void TrackRegion(const FloatImage &image1,
+                 const FloatImage &image_and_gradient1,
+                 const FloatImage &image2,
+                 const FloatImage &image_and_gradient2,
+                 const double *x1, const double *y1,
+                 const TrackRegionOptions &options,
+                 double *x2, double *y2,
+                 TrackRegionResult *result) {
   // Enum is necessary due to templated nature of autodiff.
 #define HANDLE_MODE(mode_enum, mode_type) \
   if (options.mode == TrackRegionOptions::mode_enum) { \
-    TemplatedTrackRegion<mode_type>(image1, image2, \
+    TemplatedTrackRegion<mode_type>(image1, image_and_gradient1, \
+                                    image2, image_and_gradient2, \
                                     x1, y1, \
                                     options, \
                                     x2, y2, \
@@ -68,6 +68,13 @@ struct TrackRegionOptions {
   // result is returned as is (skipping a costly brute search).
   bool attempt_refine_before_brute;
 
+  // If true, the brute-force translation search is done coarse to fine: an
+  // exhaustive search with the pattern and search area downsampled by 2,
+  // followed by a search of the few shifts around the best coarse one at full
+  // resolution. This is several times faster for large search areas, at the
+  // risk of missing patterns whose detail does not survive the downsampling.
+  bool use_brute_pyramid;
+
   // If true, normalize the image patches by their mean before doing the sum of
   // squared error calculation. This is reasonable since the effect of
   // increasing light intensity is multiplicative on the pixel intensities.
@@ -150,6 +157,18 @@ void TrackRegion(const FloatImage &image1,
                  double *x2, double *y2,
                  TrackRegionResult *result);
 
+// Same as above, but with the blurred images and their derivatives already
+// computed by BlurredImageAndDerivativesChannels() with options.sigma. This
+// avoids computing them again when a frame is shared by many tracked regions.
+void TrackRegion(const FloatImage &image1,
+                 const FloatImage &image_and_gradient1,
+                 const FloatImage &image2,
+                 const FloatImage &image_and_gradient2,
+                 const double *x1, const double *y1,
+                 const TrackRegionOptions &options,
+                 double *x2, double *y2,
+                 TrackRegionResult *result);
+
 // Sample a "canonical" version of the passed planar patch, using bilinear
 // sampling. The passed corners must be within the image, and have at least two
 // pixels of border around them. (so e.g. a corner of the patch cannot lie
@@ -315,6 +315,10 @@ class DATA_PT_modifiers(ModifierButtonsPanel, Panel):
             row.prop(md, "use_symmetry")
             row.prop(md, "symmetry_axis", text="")
 
+            row = layout.row()
+            row.active = not md.use_symmetry
+            row.prop(md, "batch_factor")
+
         elif decimate_type == 'UNSUBDIV':
             layout.prop(md, "iterations")
             layout_info = layout
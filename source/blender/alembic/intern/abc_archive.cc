@@ -28,11 +28,189 @@
 #  include "utfconv.h"
 #endif
 
+extern "C" {
+#include "BLI_task.h"
+}
+
+/* Memory budget for the vertex positions of an archive. */
+#define POSITIONS_CACHE_SIZE (512 * 1024 * 1024)
+
 using Alembic::Abc::Exception;
 using Alembic::Abc::ErrorHandler;
 using Alembic::Abc::IArchive;
 using Alembic::Abc::kWrapExisting;
 using Alembic::Abc::OArchive;
+using Alembic::Abc::index_t;
+using Alembic::AbcGeom::IP3fArrayProperty;
+using Alembic::AbcGeom::P3fArraySamplePtr;
+
+/* ************************************************************************** */
+
+struct PrefetchTask {
+	std::string path;
+	IP3fArrayProperty property;
+	index_t index;
+};
+
+static void prefetch_positions_task(TaskPool *__restrict pool, void *taskdata, int /*threadid*/)
+{
+	PositionsCache *cache = static_cast<PositionsCache *>(BLI_task_pool_userdata(pool));
+	PrefetchTask *task = static_cast<PrefetchTask *>(taskdata);
+
+	cache->read_pending(task->path, task->property, task->index);
+}
+
+static void free_prefetch_task(TaskPool *__restrict /*pool*/, void *taskdata, int /*threadid*/)
+{
+	delete static_cast<PrefetchTask *>(taskdata);
+}
+
+PositionsCache::PositionsCache(size_t max_size)
+    : m_size(0)
+    , m_max_size(max_size)
+{
+	BLI_mutex_init(&m_mutex);
+
+	/* Created on the first prefetch, most archives are never played back. */
+	m_prefetch_pool = NULL;
+	m_stopped = false;
+}
+
+PositionsCache::~PositionsCache()
+{
+	stop();
+
+	BLI_mutex_end(&m_mutex);
+}
+
+void PositionsCache::stop()
+{
+	BLI_mutex_lock(&m_mutex);
+	TaskPool *pool = m_prefetch_pool;
+	m_prefetch_pool = NULL;
+	m_stopped = true;
+	BLI_mutex_unlock(&m_mutex);
+
+	/* Without the lock, the running tasks need it to finish. */
+	if (pool) {
+		BLI_task_pool_cancel(pool);
+		BLI_task_pool_free(pool);
+	}
+
+	BLI_mutex_lock(&m_mutex);
+	m_pending.clear();
+	BLI_mutex_unlock(&m_mutex);
+}
+
+/* Must be called with the mutex locked. */
+void PositionsCache::insert(const Key &key, const P3fArraySamplePtr &positions)
+{
+	if (!positions || m_lookup.count(key) != 0) {
+		return;
+	}
+
+	m_entries.push_front(Entry(key, positions));
+	m_lookup[key] = m_entries.begin();
+	m_size += positions->size() * sizeof(Imath::V3f);
+
+	/* Always keep the newest sample, even if it exceeds the budget alone. */
+	while (m_size > m_max_size && m_entries.size() > 1) {
+		const Entry &oldest = m_entries.back();
+
+		m_size -= oldest.second->size() * sizeof(Imath::V3f);
+		m_lookup.erase(oldest.first);
+		m_entries.pop_back();
+	}
+}
+
+P3fArraySamplePtr PositionsCache::get(const std::string &path,
+                                      const IP3fArrayProperty &property,
+                                      index_t index)
+{
+	const Key key(path, index);
+
+	BLI_mutex_lock(&m_mutex);
+
+	std::map<Key, std::list<Entry>::iterator>::iterator it = m_lookup.find(key);
+
+	if (it != m_lookup.end()) {
+		/* Move to the front of the list. */
+		m_entries.splice(m_entries.begin(), m_entries, it->second);
+		P3fArraySamplePtr positions = it->second->second;
+
+		BLI_mutex_unlock(&m_mutex);
+		return positions;
+	}
+
+	BLI_mutex_unlock(&m_mutex);
+
+	/* Read without holding the lock, reading from the archive is thread safe. */
+	P3fArraySamplePtr positions;
+	property.get(positions, Alembic::Abc::ISampleSelector(index));
+
+	BLI_mutex_lock(&m_mutex);
+	insert(key, positions);
+	BLI_mutex_unlock(&m_mutex);
+
+	return positions;
+}
+
+void PositionsCache::prefetch(const std::string &path,
+                              const IP3fArrayProperty &property,
+                              index_t index)
+{
+	if (index < 0 || index >= static_cast<index_t>(property.getNumSamples())) {
+		return;
+	}
+
+	const Key key(path, index);
+
+	BLI_mutex_lock(&m_mutex);
+
+	if (m_stopped || m_lookup.count(key) != 0 || m_pending.count(key) != 0) {
+		BLI_mutex_unlock(&m_mutex);
+		return;
+	}
+
+	m_pending.insert(key);
+
+	if (m_prefetch_pool == NULL) {
+		TaskScheduler *scheduler = BLI_task_scheduler_get();
+		m_prefetch_pool = BLI_task_pool_create_background(scheduler, this);
+	}
+
+	PrefetchTask *task = new PrefetchTask;
+	task->path = path;
+	task->property = property;
+	task->index = index;
+
+	/* Pushed with the lock held, so that stop() can't free the pool meanwhile. */
+	BLI_task_pool_push_ex(m_prefetch_pool, prefetch_positions_task, task, true, free_prefetch_task, TASK_PRIORITY_LOW);
+
+	BLI_mutex_unlock(&m_mutex);
+}
+
+void PositionsCache::read_pending(const std::string &path,
+                                  const IP3fArrayProperty &property,
+                                  index_t index)
+{
+	const Key key(path, index);
+	P3fArraySamplePtr positions;
+
+	try {
+		property.get(positions, Alembic::Abc::ISampleSelector(index));
+	}
+	catch (const Alembic::Util::Exception &e) {
+		std::cerr << "Alembic prefetch error: " << e.what() << '\n';
+	}
+
+	BLI_mutex_lock(&m_mutex);
+	insert(key, positions);
+	m_pending.erase(key);
+	BLI_mutex_unlock(&m_mutex);
+}
+
+/* ************************************************************************** */
 
 static IArchive open_archive(const std::string &filename,
                              const std::vector<std::istream *> &input_streams,
@@ -70,29 +248,52 @@ static IArchive open_archive(const std::string &filename,
 	return IArchive();
 }
 
-ArchiveReader::ArchiveReader(const char *filename)
+static void open_input_stream(std::ifstream &stream, const char *filename)
 {
 #ifdef WIN32
 	UTF16_ENCODE(filename);
 	std::wstring wstr(filename_16);
-	m_infile.open(wstr.c_str(), std::ios::in | std::ios::binary);
+	stream.open(wstr.c_str(), std::ios::in | std::ios::binary);
 	UTF16_UN_ENCODE(filename);
 #else
-	m_infile.open(filename, std::ios::in | std::ios::binary);
+	stream.open(filename, std::ios::in | std::ios::binary);
 #endif
+}
 
+ArchiveReader::ArchiveReader(const char *filename)
+    : m_positions_cache(new PositionsCache(POSITIONS_CACHE_SIZE))
+{
+	open_input_stream(m_infile, filename);
 	m_streams.push_back(&m_infile);
 
+	/* Ogawa reads from the first stream that is not in use, a second one lets
+	 * the prefetch thread read without blocking the evaluation. */
+	open_input_stream(m_prefetch_infile, filename);
+	if (m_prefetch_infile.is_open()) {
+		m_streams.push_back(&m_prefetch_infile);
+	}
+
 	bool is_hdf5;
 	m_archive = open_archive(filename, m_streams, is_hdf5);
 
 	/* We can't open an HDF5 file from a stream, so close it. */
 	if (is_hdf5) {
 		m_infile.close();
+		m_prefetch_infile.close();
 		m_streams.clear();
+
+		/* The HDF5 library can't be called from another thread. */
+		m_positions_cache->stop();
 	}
 }
 
+ArchiveReader::~ArchiveReader()
+{
+	/* Mesh readers can outlive the archive, make sure no prefetch task still
+	 * reads from the streams closed after this. */
+	m_positions_cache->stop();
+}
+
 bool ArchiveReader::valid() const
 {
 	return m_archive.valid();
@@ -103,6 +304,11 @@ Alembic::Abc::IObject ArchiveReader::getTop()
 	return m_archive.getTop();
 }
 
+const PositionsCachePtr &ArchiveReader::positionsCache() const
+{
+	return m_positions_cache;
+}
+
 /* ************************************************************************** */
 
 /* This kinda duplicates CreateArchiveWithInfo, but Alembic does not seem to
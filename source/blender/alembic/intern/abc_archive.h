@@ -32,8 +32,70 @@
 #endif
 
 #include <Alembic/AbcCoreOgawa/All.h>
+#include <Alembic/AbcGeom/All.h>
 
 #include <fstream>
+#include <list>
+#include <map>
+#include <set>
+
+extern "C" {
+#include "BLI_threads.h"
+}
+
+struct TaskPool;
+
+/* Vertex positions read from an archive, shared by the mesh readers of all the
+ * objects using it. The cache is bounded in memory, the least recently used
+ * samples are dropped first. Samples can also be read ahead on a background
+ * thread, so that they are ready when playback reaches them. */
+class PositionsCache {
+	typedef std::pair<std::string, Alembic::Abc::index_t> Key;
+	typedef std::pair<Key, Alembic::AbcGeom::P3fArraySamplePtr> Entry;
+
+	std::list<Entry> m_entries;  /* Most recently used first. */
+	std::map<Key, std::list<Entry>::iterator> m_lookup;
+	std::set<Key> m_pending;
+	size_t m_size;
+	size_t m_max_size;
+
+	ThreadMutex m_mutex;
+	TaskPool *m_prefetch_pool;
+	bool m_stopped;
+
+	/* Not copyable. */
+	PositionsCache(const PositionsCache &);
+	PositionsCache &operator=(const PositionsCache &);
+
+	void insert(const Key &key, const Alembic::AbcGeom::P3fArraySamplePtr &positions);
+
+public:
+	explicit PositionsCache(size_t max_size);
+	~PositionsCache();
+
+	/* Returns the positions of the given sample, reading them if needed.
+	 * Path identifies the property, usually the full name of the object. */
+	Alembic::AbcGeom::P3fArraySamplePtr get(const std::string &path,
+	                                        const Alembic::AbcGeom::IP3fArrayProperty &property,
+	                                        Alembic::Abc::index_t index);
+
+	/* Reads the positions of the given sample in the background. */
+	void prefetch(const std::string &path,
+	              const Alembic::AbcGeom::IP3fArrayProperty &property,
+	              Alembic::Abc::index_t index);
+
+	/* Stops reading ahead and waits for the running reads, later prefetch
+	 * requests are ignored. Must be called before the streams of the archive
+	 * are closed, mesh readers may keep the cache alive longer. */
+	void stop();
+
+	/* Only for the prefetch tasks. */
+	void read_pending(const std::string &path,
+	                  const Alembic::AbcGeom::IP3fArrayProperty &property,
+	                  Alembic::Abc::index_t index);
+};
+
+typedef Alembic::Util::shared_ptr<PositionsCache> PositionsCachePtr;
 
 /* Wrappers around input and output archives. The goal is to be able to use
  * streams so that unicode paths work on Windows (T49112), and to make sure that
@@ -43,14 +105,20 @@
 class ArchiveReader {
 	Alembic::Abc::IArchive m_archive;
 	std::ifstream m_infile;
+	std::ifstream m_prefetch_infile;
 	std::vector<std::istream *> m_streams;
 
+	PositionsCachePtr m_positions_cache;
+
 public:
 	explicit ArchiveReader(const char *filename);
+	~ArchiveReader();
 
 	bool valid() const;
 
 	Alembic::Abc::IObject getTop();
+
+	const PositionsCachePtr &positionsCache() const;
 };
 
 class ArchiveWriter {
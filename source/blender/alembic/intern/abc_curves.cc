@@ -75,27 +75,24 @@ AbcCurveWriter::AbcCurveWriter(Scene *scene,
 	m_schema = curves.getSchema();
 }
 
-void AbcCurveWriter::do_write()
+void AbcCurveWriter::do_prepare()
 {
 	Curve *curve = static_cast<Curve *>(m_object->data);
 
-	std::vector<Imath::V3f> verts;
-	std::vector<int32_t> vert_counts;
-	std::vector<float> widths;
-	std::vector<float> weights;
-	std::vector<float> knots;
-	std::vector<uint8_t> orders;
 	Imath::V3f temp_vert;
 
-	Alembic::AbcGeom::BasisType curve_basis;
-	Alembic::AbcGeom::CurveType curve_type;
-	Alembic::AbcGeom::CurvePeriodicity periodicity;
+	m_verts.clear();
+	m_vert_counts.clear();
+	m_widths.clear();
+	m_weights.clear();
+	m_knots.clear();
+	m_orders.clear();
 
 	Nurb *nurbs = static_cast<Nurb *>(curve->nurb.first);
 	for (; nurbs; nurbs = nurbs->next) {
 		if (nurbs->bp) {
-			curve_basis = Alembic::AbcGeom::kNoBasis;
-			curve_type = Alembic::AbcGeom::kLinear;
+			m_curve_basis = Alembic::AbcGeom::kNoBasis;
+			m_curve_type = Alembic::AbcGeom::kLinear;
 
 			const int totpoint = nurbs->pntsu * nurbs->pntsv;
 
@@ -103,14 +100,14 @@ void AbcCurveWriter::do_write()
 
 			for (int i = 0; i < totpoint; ++i, ++point) {
 				copy_zup_yup(temp_vert.getValue(), point->vec);
-				verts.push_back(temp_vert);
-				weights.push_back(point->vec[3]);
-				widths.push_back(point->radius);
+				m_verts.push_back(temp_vert);
+				m_weights.push_back(point->vec[3]);
+				m_widths.push_back(point->radius);
 			}
 		}
 		else if (nurbs->bezt) {
-			curve_basis = Alembic::AbcGeom::kBezierBasis;
-			curve_type = Alembic::AbcGeom::kCubic;
+			m_curve_basis = Alembic::AbcGeom::kBezierBasis;
+			m_curve_type = Alembic::AbcGeom::kCubic;
 
 			const int totpoint = nurbs->pntsu;
 
@@ -119,23 +116,23 @@ void AbcCurveWriter::do_write()
 			/* TODO(kevin): store info about handles, Alembic doesn't have this. */
 			for (int i = 0; i < totpoint; ++i, ++bezier) {
 				copy_zup_yup(temp_vert.getValue(), bezier->vec[1]);
-				verts.push_back(temp_vert);
-				widths.push_back(bezier->radius);
+				m_verts.push_back(temp_vert);
+				m_widths.push_back(bezier->radius);
 			}
 		}
 
 		if ((nurbs->flagu & CU_NURB_ENDPOINT) != 0) {
-			periodicity = Alembic::AbcGeom::kNonPeriodic;
+			m_periodicity = Alembic::AbcGeom::kNonPeriodic;
 		}
 		else if ((nurbs->flagu & CU_NURB_CYCLIC) != 0) {
-			periodicity = Alembic::AbcGeom::kPeriodic;
+			m_periodicity = Alembic::AbcGeom::kPeriodic;
 
 			/* Duplicate the start points to indicate that the curve is actually
 			 * cyclic since other software need those.
 			 */
 
 			for (int i = 0; i < nurbs->orderu; ++i) {
-				verts.push_back(verts[i]);
+				m_verts.push_back(m_verts[i]);
 			}
 		}
 
@@ -144,40 +141,43 @@ void AbcCurveWriter::do_write()
 
 			/* Add an extra knot at the beggining and end of the array since most apps
 			 * require/expect them. */
-			knots.resize(num_knots + 2);
+			m_knots.resize(num_knots + 2);
 
 			for (int i = 0; i < num_knots; ++i) {
-				knots[i + 1] = nurbs->knotsu[i];
+				m_knots[i + 1] = nurbs->knotsu[i];
 			}
 
 			if ((nurbs->flagu & CU_NURB_CYCLIC) != 0) {
-				knots[0] = nurbs->knotsu[0];
-				knots[num_knots - 1] = nurbs->knotsu[num_knots - 1];
+				m_knots[0] = nurbs->knotsu[0];
+				m_knots[num_knots - 1] = nurbs->knotsu[num_knots - 1];
 			}
 			else {
-				knots[0] = (2.0f * nurbs->knotsu[0] - nurbs->knotsu[1]);
-				knots[num_knots - 1] = (2.0f * nurbs->knotsu[num_knots - 1] - nurbs->knotsu[num_knots - 2]);
+				m_knots[0] = (2.0f * nurbs->knotsu[0] - nurbs->knotsu[1]);
+				m_knots[num_knots - 1] = (2.0f * nurbs->knotsu[num_knots - 1] - nurbs->knotsu[num_knots - 2]);
 			}
 		}
 
-		orders.push_back(nurbs->orderu + 1);
-		vert_counts.push_back(verts.size());
+		m_orders.push_back(nurbs->orderu + 1);
+		m_vert_counts.push_back(m_verts.size());
 	}
+}
 
+void AbcCurveWriter::do_write()
+{
 	Alembic::AbcGeom::OFloatGeomParam::Sample width_sample;
-	width_sample.setVals(widths);
+	width_sample.setVals(m_widths);
 
-	m_sample = OCurvesSchema::Sample(verts,
-	                                 vert_counts,
-	                                 curve_type,
-	                                 periodicity,
+	m_sample = OCurvesSchema::Sample(m_verts,
+	                                 m_vert_counts,
+	                                 m_curve_type,
+	                                 m_periodicity,
 	                                 width_sample,
 	                                 OV2fGeomParam::Sample(),  /* UVs */
 	                                 ON3fGeomParam::Sample(),  /* normals */
-	                                 curve_basis,
-	                                 weights,
-	                                 orders,
-	                                 knots);
+	                                 m_curve_basis,
+	                                 m_weights,
+	                                 m_orders,
+	                                 m_knots);
 
 	m_sample.setSelfBounds(bounds());
 	m_schema.set(m_sample);
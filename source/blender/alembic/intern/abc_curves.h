@@ -35,6 +35,18 @@ class AbcCurveWriter : public AbcObjectWriter {
 	Alembic::AbcGeom::OCurvesSchema m_schema;
 	Alembic::AbcGeom::OCurvesSchema::Sample m_sample;
 
+	/* Sample buffers converted by do_prepare(). */
+	std::vector<Imath::V3f> m_verts;
+	std::vector<int32_t> m_vert_counts;
+	std::vector<float> m_widths;
+	std::vector<float> m_weights;
+	std::vector<float> m_knots;
+	std::vector<uint8_t> m_orders;
+
+	Alembic::AbcGeom::BasisType m_curve_basis;
+	Alembic::AbcGeom::CurveType m_curve_type;
+	Alembic::AbcGeom::CurvePeriodicity m_periodicity;
+
 public:
 	AbcCurveWriter(Scene *scene,
 	               Object *ob,
@@ -42,6 +54,7 @@ public:
 	               uint32_t time_sampling,
 	               ExportSettings &settings);
 
+	void do_prepare();
 	void do_write();
 };
 
@@ -22,7 +22,9 @@
 
 #include "abc_exporter.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
 
 #include "abc_archive.h"
 #include "abc_camera.h"
@@ -44,6 +46,8 @@ extern "C" {
 #include "DNA_space_types.h"  /* for FILE_MAX */
 
 #include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #ifdef WIN32
 /* needed for MSCV because of snprintf from BLI_string */
@@ -313,9 +317,7 @@ void AbcExporter::operator()(Main *bmain, float &progress, bool &was_canceled)
 		setCurrentFrame(bmain, frame - m_settings.frame_start);
 
 		if (shape_frames.count(frame) != 0) {
-			for (int i = 0, e = m_shapes.size(); i != e; ++i) {
-				m_shapes[i]->write();
-			}
+			writeShapes();
 		}
 
 		if (xform_frames.count(frame) == 0) {
@@ -337,6 +339,86 @@ void AbcExporter::operator()(Main *bmain, float &progress, bool &was_canceled)
 
 		archive_bounds_prop.set(bounds);
 	}
+
+	if (G.debug & G_DEBUG) {
+		printShapeTimings();
+	}
+}
+
+/* Writers of the same object share its modifier stack and particle systems,
+ * so they are prepared one after the other by the same task. */
+typedef std::vector< std::vector<AbcObjectWriter *> > ShapeWriterGroups;
+
+static void prepare_shape_writers(void *userdata, const int index)
+{
+	ShapeWriterGroups &groups = *static_cast<ShapeWriterGroups *>(userdata);
+	std::vector<AbcObjectWriter *> &group = groups[index];
+
+	for (int i = 0, e = group.size(); i != e; ++i) {
+		group[i]->prepare();
+	}
+}
+
+void AbcExporter::writeShapes()
+{
+	/* Shapes are converted in chunks, so only the samples of a limited number
+	 * of writers are in memory at the same time. */
+	const int chunk_size = BLI_system_thread_count() * 16;
+
+	for (int start = 0, e = m_shapes.size(); start < e; start += chunk_size) {
+		const int end = std::min(start + chunk_size, e);
+
+		ShapeWriterGroups groups;
+		std::map<Object *, int> group_index;
+
+		for (int i = start; i != end; ++i) {
+			Object *ob = m_shapes[i]->object();
+			std::map<Object *, int>::iterator it = group_index.find(ob);
+
+			if (it == group_index.end()) {
+				group_index[ob] = groups.size();
+				groups.push_back(std::vector<AbcObjectWriter *>(1, m_shapes[i]));
+			}
+			else {
+				groups[it->second].push_back(m_shapes[i]);
+			}
+		}
+
+		BLI_task_parallel_range(0, groups.size(), &groups, prepare_shape_writers, groups.size() > 1);
+
+		/* Writing to the archive is not thread safe, write in the original order. */
+		for (int i = start; i != end; ++i) {
+			m_shapes[i]->write();
+		}
+	}
+}
+
+static bool shape_writer_time_cmp(const AbcObjectWriter *a, const AbcObjectWriter *b)
+{
+	return (a->prepareTime() + a->writeTime()) > (b->prepareTime() + b->writeTime());
+}
+
+void AbcExporter::printShapeTimings() const
+{
+	std::vector<AbcObjectWriter *> shapes(m_shapes);
+	double prepare_time = 0.0, write_time = 0.0;
+
+	for (int i = 0, e = shapes.size(); i != e; ++i) {
+		prepare_time += shapes[i]->prepareTime();
+		write_time += shapes[i]->writeTime();
+	}
+
+	printf("Alembic export: %d shapes, prepare %.3fs (summed over threads), write %.3fs\n",
+	       (int)shapes.size(), prepare_time, write_time);
+
+	/* Only list the slowest writers, there can be thousands of them. */
+	const int num_print = std::min((int)shapes.size(), 10);
+	std::partial_sort(shapes.begin(), shapes.begin() + num_print, shapes.end(), shape_writer_time_cmp);
+
+	for (int i = 0; i < num_print; ++i) {
+		printf("  %s: prepare %.3fs, write %.3fs\n",
+		       shapes[i]->name().c_str(), shapes[i]->prepareTime(), shapes[i]->writeTime());
+	}
 }
 
 void AbcExporter::createTransformWritersHierarchy(EvaluationContext *eval_ctx)
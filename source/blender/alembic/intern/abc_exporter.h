@@ -112,6 +112,9 @@ private:
 
 	AbcTransformWriter *getXForm(const std::string &name);
 
+	void writeShapes();
+	void printShapeTimings() const;
+
 	void setCurrentFrame(Main *bmain, double t);
 };
 
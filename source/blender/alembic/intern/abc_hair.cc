@@ -63,8 +63,13 @@ AbcHairWriter::AbcHairWriter(Scene *scene,
 	m_schema = curves.getSchema();
 }
 
-void AbcHairWriter::do_write()
+void AbcHairWriter::do_prepare()
 {
+	m_verts.clear();
+	m_hvertices.clear();
+	m_uv_values.clear();
+	m_norm_values.clear();
+
 	if (!m_psys) {
 		return;
 	}
@@ -79,38 +84,46 @@ void AbcHairWriter::do_write()
 	DM_ensure_tessface(dm);
 	DM_update_tessface_data(dm);
 
-	std::vector<Imath::V3f> verts;
-	std::vector<int32_t> hvertices;
-	std::vector<Imath::V2f> uv_values;
-	std::vector<Imath::V3f> norm_values;
-
 	if (m_psys->pathcache) {
 		ParticleSettings *part = m_psys->part;
 
-		write_hair_sample(dm, part, verts, norm_values, uv_values, hvertices);
+		write_hair_sample(dm, part, m_verts, m_norm_values, m_uv_values, m_hvertices);
 
 		if (m_settings.export_child_hairs && m_psys->childcache) {
-			write_hair_child_sample(dm, part, verts, norm_values, uv_values, hvertices);
+			write_hair_child_sample(dm, part, m_verts, m_norm_values, m_uv_values, m_hvertices);
 		}
 	}
 
 	dm->release(dm);
+}
+
+void AbcHairWriter::do_write()
+{
+	if (!m_psys) {
+		return;
+	}
+
+	ParticleSystemModifierData *psmd = psys_get_modifier(m_object, m_psys);
+
+	if (!psmd->dm_final) {
+		return;
+	}
 
-	Alembic::Abc::P3fArraySample iPos(verts);
-	m_sample = OCurvesSchema::Sample(iPos, hvertices);
+	Alembic::Abc::P3fArraySample iPos(m_verts);
+	m_sample = OCurvesSchema::Sample(iPos, m_hvertices);
 	m_sample.setBasis(Alembic::AbcGeom::kNoBasis);
 	m_sample.setType(Alembic::AbcGeom::kLinear);
 	m_sample.setWrap(Alembic::AbcGeom::kNonPeriodic);
 
-	if (!uv_values.empty()) {
+	if (!m_uv_values.empty()) {
 		OV2fGeomParam::Sample uv_smp;
-		uv_smp.setVals(uv_values);
+		uv_smp.setVals(m_uv_values);
 		m_sample.setUVs(uv_smp);
 	}
 
-	if (!norm_values.empty()) {
+	if (!m_norm_values.empty()) {
 		ON3fGeomParam::Sample norm_smp;
-		norm_smp.setVals(norm_values);
+		norm_smp.setVals(m_norm_values);
 		m_sample.setNormals(norm_smp);
 	}
 
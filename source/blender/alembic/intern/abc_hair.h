@@ -37,6 +37,12 @@ class AbcHairWriter : public AbcObjectWriter {
 	Alembic::AbcGeom::OCurvesSchema m_schema;
 	Alembic::AbcGeom::OCurvesSchema::Sample m_sample;
 
+	/* Sample buffers converted by do_prepare(). */
+	std::vector<Imath::V3f> m_verts;
+	std::vector<int32_t> m_hvertices;
+	std::vector<Imath::V2f> m_uv_values;
+	std::vector<Imath::V3f> m_norm_values;
+
 public:
 	AbcHairWriter(Scene *scene,
 	              Object *ob,
@@ -46,6 +52,7 @@ public:
 	              ParticleSystem *psys);
 
 private:
+	virtual void do_prepare();
 	virtual void do_write();
 
 	void write_hair_sample(DerivedMesh *dm,
@@ -66,6 +66,7 @@ using Alembic::Abc::C4fArraySample;
 using Alembic::AbcGeom::IFaceSet;
 using Alembic::AbcGeom::IFaceSetSchema;
 using Alembic::AbcGeom::IObject;
+using Alembic::AbcGeom::IP3fArrayProperty;
 using Alembic::AbcGeom::IPolyMesh;
 using Alembic::AbcGeom::IPolyMeshSchema;
 using Alembic::AbcGeom::ISampleSelector;
@@ -93,6 +94,7 @@ using Alembic::AbcGeom::OV2fGeomParam;
 using Alembic::AbcGeom::OV3fGeomParam;
 
 using Alembic::AbcGeom::kFacevaryingScope;
+using Alembic::AbcGeom::kHeterogeneousTopology;
 using Alembic::AbcGeom::kVaryingScope;
 using Alembic::AbcGeom::kVertexScope;
 using Alembic::AbcGeom::kWrapExisting;
@@ -297,6 +299,9 @@ AbcMeshWriter::AbcMeshWriter(Scene *scene,
 	m_is_animated = isAnimated();
 	m_subsurf_mod = NULL;
 	m_is_subd = false;
+	m_dm = NULL;
+	m_smooth_normal = false;
+	m_uv_name = NULL;
 
 	/* If the object is static, use the default static time sampling. */
 	if (!m_is_animated) {
@@ -330,6 +335,8 @@ AbcMeshWriter::AbcMeshWriter(Scene *scene,
 
 AbcMeshWriter::~AbcMeshWriter()
 {
+	freeSample();
+
 	if (m_subsurf_mod) {
 		m_subsurf_mod->mode &= ~eModifierMode_DisableTemporary;
 	}
@@ -358,59 +365,81 @@ bool AbcMeshWriter::isAnimated() const
 	return false;
 }
 
-void AbcMeshWriter::do_write()
+void AbcMeshWriter::do_prepare()
 {
 	/* We have already stored a sample for this object. */
 	if (!m_first_frame && !m_is_animated)
 		return;
 
-	DerivedMesh *dm = getFinalMesh();
+	m_dm = getFinalMesh();
+
+	m_smooth_normal = false;
+	get_vertices(m_dm, m_points);
+	get_topology(m_dm, m_poly_verts, m_loop_counts, m_smooth_normal);
+
+	if (m_settings.use_subdiv_schema && m_subdiv_schema.valid()) {
+		get_creases(m_dm, m_crease_indices, m_crease_lengths, m_crease_sharpness);
+	}
+	else {
+		if (m_settings.export_normals) {
+			if (m_smooth_normal) {
+				get_loop_normals(m_dm, m_normals);
+			}
+			else {
+				get_vertex_normals(m_dm, m_normals);
+			}
+		}
+
+		if (m_is_liquid) {
+			getVelocities(m_dm, m_velocities);
+		}
+	}
+
+	if (m_first_frame && m_settings.export_uvs) {
+		m_uv_name = get_uv_sample(m_uv_sample, m_custom_data_config, &m_dm->loopData);
+	}
+}
+
+void AbcMeshWriter::do_write()
+{
+	/* Nothing was prepared, the sample is already stored. */
+	if (!m_dm)
+		return;
 
 	try {
 		if (m_settings.use_subdiv_schema && m_subdiv_schema.valid()) {
-			writeSubD(dm);
+			writeSubD(m_dm);
 		}
 		else {
-			writeMesh(dm);
+			writeMesh(m_dm);
 		}
 
-		freeMesh(dm);
+		freeSample();
 	}
 	catch (...) {
-		freeMesh(dm);
+		freeSample();
 		throw;
 	}
 }
 
 void AbcMeshWriter::writeMesh(DerivedMesh *dm)
 {
-	std::vector<Imath::V3f> points, normals;
-	std::vector<int32_t> poly_verts, loop_counts;
-
-	bool smooth_normal = false;
-
-	get_vertices(dm, points);
-	get_topology(dm, poly_verts, loop_counts, smooth_normal);
-
 	if (m_first_frame && m_settings.export_face_sets) {
 		writeFaceSets(dm, m_mesh_schema);
 	}
 
-	m_mesh_sample = OPolyMeshSchema::Sample(V3fArraySample(points),
-	                                        Int32ArraySample(poly_verts),
-	                                        Int32ArraySample(loop_counts));
+	m_mesh_sample = OPolyMeshSchema::Sample(V3fArraySample(m_points),
+	                                        Int32ArraySample(m_poly_verts),
+	                                        Int32ArraySample(m_loop_counts));
 
-	UVSample sample;
 	if (m_first_frame && m_settings.export_uvs) {
-		const char *name = get_uv_sample(sample, m_custom_data_config, &dm->loopData);
-
-		if (!sample.indices.empty() && !sample.uvs.empty()) {
+		if (!m_uv_sample.indices.empty() && !m_uv_sample.uvs.empty()) {
 			OV2fGeomParam::Sample uv_sample;
-			uv_sample.setVals(V2fArraySample(sample.uvs));
-			uv_sample.setIndices(UInt32ArraySample(sample.indices));
+			uv_sample.setVals(V2fArraySample(m_uv_sample.uvs));
+			uv_sample.setIndices(UInt32ArraySample(m_uv_sample.indices));
 			uv_sample.setScope(kFacevaryingScope);
 
-			m_mesh_schema.setUVSourceName(name);
+			m_mesh_schema.setUVSourceName(m_uv_name);
 			m_mesh_sample.setUVs(uv_sample);
 		}
 
@@ -418,27 +447,17 @@ void AbcMeshWriter::writeMesh(DerivedMesh *dm)
 	}
 
 	if (m_settings.export_normals) {
-		if (smooth_normal) {
-			get_loop_normals(dm, normals);
-		}
-		else {
-			get_vertex_normals(dm, normals);
-		}
-
 		ON3fGeomParam::Sample normals_sample;
-		if (!normals.empty()) {
-			normals_sample.setScope((smooth_normal) ? kFacevaryingScope : kVertexScope);
-			normals_sample.setVals(V3fArraySample(normals));
+		if (!m_normals.empty()) {
+			normals_sample.setScope((m_smooth_normal) ? kFacevaryingScope : kVertexScope);
+			normals_sample.setVals(V3fArraySample(m_normals));
 		}
 
 		m_mesh_sample.setNormals(normals_sample);
 	}
 
 	if (m_is_liquid) {
-		std::vector<Imath::V3f> velocities;
-		getVelocities(dm, velocities);
-
-		m_mesh_sample.setVelocities(V3fArraySample(velocities));
+		m_mesh_sample.setVelocities(V3fArraySample(m_velocities));
 	}
 
 	m_mesh_sample.setSelfBounds(bounds());
@@ -450,46 +469,32 @@ void AbcMeshWriter::writeMesh(DerivedMesh *dm)
 
 void AbcMeshWriter::writeSubD(DerivedMesh *dm)
 {
-	std::vector<float> crease_sharpness;
-	std::vector<Imath::V3f> points;
-	std::vector<int32_t> poly_verts, loop_counts;
-	std::vector<int32_t> crease_indices, crease_lengths;
-
-	bool smooth_normal = false;
-
-	get_vertices(dm, points);
-	get_topology(dm, poly_verts, loop_counts, smooth_normal);
-	get_creases(dm, crease_indices, crease_lengths, crease_sharpness);
-
 	if (m_first_frame && m_settings.export_face_sets) {
 		writeFaceSets(dm, m_subdiv_schema);
 	}
 
-	m_subdiv_sample = OSubDSchema::Sample(V3fArraySample(points),
-	                                      Int32ArraySample(poly_verts),
-	                                      Int32ArraySample(loop_counts));
+	m_subdiv_sample = OSubDSchema::Sample(V3fArraySample(m_points),
+	                                      Int32ArraySample(m_poly_verts),
+	                                      Int32ArraySample(m_loop_counts));
 
-	UVSample sample;
 	if (m_first_frame && m_settings.export_uvs) {
-		const char *name = get_uv_sample(sample, m_custom_data_config, &dm->loopData);
-
-		if (!sample.indices.empty() && !sample.uvs.empty()) {
+		if (!m_uv_sample.indices.empty() && !m_uv_sample.uvs.empty()) {
 			OV2fGeomParam::Sample uv_sample;
-			uv_sample.setVals(V2fArraySample(sample.uvs));
-			uv_sample.setIndices(UInt32ArraySample(sample.indices));
+			uv_sample.setVals(V2fArraySample(m_uv_sample.uvs));
+			uv_sample.setIndices(UInt32ArraySample(m_uv_sample.indices));
 			uv_sample.setScope(kFacevaryingScope);
 
-			m_subdiv_schema.setUVSourceName(name);
+			m_subdiv_schema.setUVSourceName(m_uv_name);
 			m_subdiv_sample.setUVs(uv_sample);
 		}
 
 		write_custom_data(m_subdiv_schema.getArbGeomParams(), m_custom_data_config, &dm->loopData, CD_MLOOPUV);
 	}
 
-	if (!crease_indices.empty()) {
-		m_subdiv_sample.setCreaseIndices(Int32ArraySample(crease_indices));
-		m_subdiv_sample.setCreaseLengths(Int32ArraySample(crease_lengths));
-		m_subdiv_sample.setCreaseSharpnesses(FloatArraySample(crease_sharpness));
+	if (!m_crease_indices.empty()) {
+		m_subdiv_sample.setCreaseIndices(Int32ArraySample(m_crease_indices));
+		m_subdiv_sample.setCreaseLengths(Int32ArraySample(m_crease_lengths));
+		m_subdiv_sample.setCreaseSharpnesses(FloatArraySample(m_crease_sharpness));
 	}
 
 	m_subdiv_sample.setSelfBounds(bounds());
@@ -558,6 +563,27 @@ void AbcMeshWriter::freeMesh(DerivedMesh *dm)
 	dm->release(dm);
 }
 
+/* Release the prepared mesh and the memory of the sample buffers, which can be
+ * large for dense meshes and would otherwise be kept for every writer. */
+void AbcMeshWriter::freeSample()
+{
+	if (m_dm) {
+		freeMesh(m_dm);
+		m_dm = NULL;
+	}
+
+	std::vector<Imath::V3f>().swap(m_points);
+	std::vector<Imath::V3f>().swap(m_normals);
+	std::vector<Imath::V3f>().swap(m_velocities);
+	std::vector<int32_t>().swap(m_poly_verts);
+	std::vector<int32_t>().swap(m_loop_counts);
+	std::vector<int32_t>().swap(m_crease_indices);
+	std::vector<int32_t>().swap(m_crease_lengths);
+	std::vector<float>().swap(m_crease_sharpness);
+	m_uv_sample = UVSample();
+	m_uv_name = NULL;
+}
+
 void AbcMeshWriter::writeArbGeoParams(DerivedMesh *dm)
 {
 	if (m_is_liquid) {
@@ -825,11 +851,14 @@ ABC_INLINE void read_uvs_params(CDStreamConfig &config,
 		return;
 	}
 
-	IV2fGeomParam::Sample uvsamp;
-	uv.getIndexed(uvsamp, selector);
+	/* Constant UVs may already have been read along with the topology. */
+	if (!abc_data.uvs || !abc_data.uvs_indices) {
+		IV2fGeomParam::Sample uvsamp;
+		uv.getIndexed(uvsamp, selector);
 
-	abc_data.uvs = uvsamp.getVals();
-	abc_data.uvs_indices = uvsamp.getIndices();
+		abc_data.uvs = uvsamp.getVals();
+		abc_data.uvs_indices = uvsamp.getIndices();
+	}
 
 	if (abc_data.uvs_indices->size() == config.totloop) {
 		std::string name = Alembic::Abc::GetSourceName(uv.getMetaData());
@@ -931,31 +960,19 @@ static void get_weight_and_index(CDStreamConfig &config,
 	config.ceil_index = i1;
 }
 
+/* The topology and positions of abc_mesh_data are read by the caller, as well
+ * as the index and weight of config. */
 static void read_mesh_sample(ImportSettings *settings,
                              const IPolyMeshSchema &schema,
                              const ISampleSelector &selector,
                              CDStreamConfig &config,
+                             AbcMeshData &abc_mesh_data,
                              bool &do_normals)
 {
-	const IPolyMeshSchema::Sample sample = schema.getValue(selector);
-
-	AbcMeshData abc_mesh_data;
-	abc_mesh_data.face_counts = sample.getFaceCounts();
-	abc_mesh_data.face_indices = sample.getFaceIndices();
-	abc_mesh_data.positions = sample.getPositions();
-
 	read_normals_params(abc_mesh_data, schema.getNormalsParam(), selector);
 
 	do_normals = (abc_mesh_data.face_normals != NULL);
 
-	get_weight_and_index(config, schema.getTimeSampling(), schema.getNumSamples());
-
-	if (config.weight != 0.0f) {
-		Alembic::AbcGeom::IPolyMeshSchema::Sample ceil_sample;
-		schema.get(ceil_sample, Alembic::Abc::ISampleSelector(config.ceil_index));
-		abc_mesh_data.ceil_positions = ceil_sample.getPositions();
-	}
-
 	if ((settings->read_flag & MOD_MESHSEQ_READ_UV) != 0) {
 		read_uvs_params(config, abc_mesh_data, schema.getUVsParam(), selector);
 	}
@@ -995,6 +1012,7 @@ CDStreamConfig get_config(DerivedMesh *dm)
 
 AbcMeshReader::AbcMeshReader(const IObject &object, ImportSettings &settings)
     : AbcObjectReader(object, settings)
+    , m_topology(NULL)
 {
 	m_settings->read_flag |= MOD_MESHSEQ_READ_ALL;
 
@@ -1004,6 +1022,16 @@ AbcMeshReader::AbcMeshReader(const IObject &object, ImportSettings &settings)
 	get_min_max_time(m_iobject, m_schema, m_min_time, m_max_time);
 }
 
+AbcMeshReader::~AbcMeshReader()
+{
+	delete m_topology;
+}
+
+void AbcMeshReader::positionsCache(const PositionsCachePtr &cache)
+{
+	m_positions_cache = cache;
+}
+
 bool AbcMeshReader::valid() const
 {
 	return m_schema.valid();
@@ -1041,11 +1069,20 @@ void AbcMeshReader::readObjectData(Main *bmain, float time)
 DerivedMesh *AbcMeshReader::read_derivedmesh(DerivedMesh *dm, const float time, int read_flag, const char **err_str)
 {
 	ISampleSelector sample_sel(time);
-	const IPolyMeshSchema::Sample sample = m_schema.getValue(sample_sel);
 
-	const P3fArraySamplePtr &positions = sample.getPositions();
-	const Alembic::Abc::Int32ArraySamplePtr &face_indices = sample.getFaceIndices();
-	const Alembic::Abc::Int32ArraySamplePtr &face_counts = sample.getFaceCounts();
+	Alembic::AbcGeom::index_t index, ceil_index;
+	const float weight = get_weight_and_index(time,
+	                                          m_schema.getTimeSampling(),
+	                                          m_schema.getNumSamples(),
+	                                          index,
+	                                          ceil_index);
+
+	AbcMeshData abc_mesh_data;
+	readSampleData(abc_mesh_data, sample_sel, index, ceil_index, weight);
+
+	const P3fArraySamplePtr &positions = abc_mesh_data.positions;
+	const Alembic::Abc::Int32ArraySamplePtr &face_indices = abc_mesh_data.face_indices;
+	const Alembic::Abc::Int32ArraySamplePtr &face_counts = abc_mesh_data.face_counts;
 
 	DerivedMesh *new_dm = NULL;
 
@@ -1081,9 +1118,12 @@ DerivedMesh *AbcMeshReader::read_derivedmesh(DerivedMesh *dm, const float time,
 
 	CDStreamConfig config = get_config(new_dm ? new_dm : dm);
 	config.time = time;
+	config.weight = weight;
+	config.index = index;
+	config.ceil_index = ceil_index;
 
 	bool do_normals = false;
-	read_mesh_sample(&settings, m_schema, sample_sel, config, do_normals);
+	read_mesh_sample(&settings, m_schema, sample_sel, config, abc_mesh_data, do_normals);
 
 	if (new_dm) {
 		/* Check if we had ME_SMOOTH flag set to restore it. */
@@ -1104,6 +1144,74 @@ DerivedMesh *AbcMeshReader::read_derivedmesh(DerivedMesh *dm, const float time,
 	return dm;
 }
 
+void AbcMeshReader::readSampleData(AbcMeshData &abc_mesh_data,
+                                   const ISampleSelector &sample_sel,
+                                   Alembic::AbcGeom::index_t index,
+                                   Alembic::AbcGeom::index_t ceil_index,
+                                   float weight)
+{
+	if (m_schema.getTopologyVariance() == kHeterogeneousTopology) {
+		const IPolyMeshSchema::Sample sample = m_schema.getValue(sample_sel);
+
+		abc_mesh_data.face_counts = sample.getFaceCounts();
+		abc_mesh_data.face_indices = sample.getFaceIndices();
+		abc_mesh_data.positions = sample.getPositions();
+	}
+	else {
+		/* The topology does not change, read it once and keep it around. The
+		 * samples are shared, so this does not copy anything. */
+		if (m_topology == NULL) {
+			m_topology = new AbcMeshData;
+			m_schema.getFaceCountsProperty().get(m_topology->face_counts, sample_sel);
+			m_schema.getFaceIndicesProperty().get(m_topology->face_indices, sample_sel);
+
+			const IV2fGeomParam &uv = m_schema.getUVsParam();
+
+			if (uv.valid() && uv.isConstant()) {
+				IV2fGeomParam::Sample uvsamp;
+				uv.getIndexed(uvsamp, sample_sel);
+
+				m_topology->uvs = uvsamp.getVals();
+				m_topology->uvs_indices = uvsamp.getIndices();
+			}
+		}
+
+		abc_mesh_data.face_counts = m_topology->face_counts;
+		abc_mesh_data.face_indices = m_topology->face_indices;
+		abc_mesh_data.uvs = m_topology->uvs;
+		abc_mesh_data.uvs_indices = m_topology->uvs_indices;
+		abc_mesh_data.positions = readPositions(index);
+
+		/* Read ahead the samples that playback is going to need next. */
+		if (m_positions_cache) {
+			const std::string &path = m_iobject.getFullName();
+			const IP3fArrayProperty &property = m_schema.getPositionsProperty();
+			const Alembic::AbcGeom::index_t next = std::max(index, ceil_index) + 1;
+
+			m_positions_cache->prefetch(path, property, next);
+			m_positions_cache->prefetch(path, property, next + 1);
+		}
+	}
+
+	if (weight != 0.0f) {
+		abc_mesh_data.ceil_positions = readPositions(ceil_index);
+	}
+}
+
+P3fArraySamplePtr AbcMeshReader::readPositions(Alembic::AbcGeom::index_t index)
+{
+	const IP3fArrayProperty &property = m_schema.getPositionsProperty();
+
+	if (m_positions_cache) {
+		return m_positions_cache->get(m_iobject.getFullName(), property, index);
+	}
+
+	P3fArraySamplePtr positions;
+	property.get(positions, ISampleSelector(index));
+
+	return positions;
+}
+
 void AbcMeshReader::readFaceSetsSample(Main *bmain, Mesh *mesh, size_t poly_start,
                                        const ISampleSelector &sample_sel)
 {
@@ -23,6 +23,7 @@
 #ifndef __ABC_MESH_H__
 #define __ABC_MESH_H__
 
+#include "abc_archive.h"
 #include "abc_customdata.h"
 #include "abc_object.h"
 
@@ -49,6 +50,17 @@ class AbcMeshWriter : public AbcObjectWriter {
 	bool m_is_liquid;
 	bool m_is_subd;
 
+	/* Sample buffers converted by do_prepare(), the mesh is kept until
+	 * do_write() as the custom data layers are written from it. */
+	DerivedMesh *m_dm;
+	std::vector<Imath::V3f> m_points, m_normals, m_velocities;
+	std::vector<int32_t> m_poly_verts, m_loop_counts;
+	std::vector<int32_t> m_crease_indices, m_crease_lengths;
+	std::vector<float> m_crease_sharpness;
+	bool m_smooth_normal;
+	UVSample m_uv_sample;
+	const char *m_uv_name;
+
 public:
 	AbcMeshWriter(Scene *scene,
 	              Object *ob,
@@ -59,6 +71,7 @@ public:
 	~AbcMeshWriter();
 
 private:
+	virtual void do_prepare();
 	virtual void do_write();
 
 	bool isAnimated() const;
@@ -75,6 +88,7 @@ private:
 
 	DerivedMesh *getFinalMesh();
 	void freeMesh(DerivedMesh *dm);
+	void freeSample();
 
 	void getMaterialIndices(DerivedMesh *dm, std::vector<int32_t> &indices);
 
@@ -90,13 +104,23 @@ private:
 
 /* ************************************************************************** */
 
+struct AbcMeshData;
+
 class AbcMeshReader : public AbcObjectReader {
 	Alembic::AbcGeom::IPolyMeshSchema m_schema;
 
 	CDStreamConfig m_mesh_data;
 
+	/* Topology of the first sample read, only kept if it does not change over
+	 * time, so that later samples only have to read the vertex positions. */
+	AbcMeshData *m_topology;
+
+	/* Shared with the other readers of the archive, may be NULL. */
+	PositionsCachePtr m_positions_cache;
+
 public:
 	AbcMeshReader(const Alembic::Abc::IObject &object, ImportSettings &settings);
+	~AbcMeshReader();
 
 	bool valid() const;
 
@@ -104,9 +128,19 @@ public:
 
 	DerivedMesh *read_derivedmesh(DerivedMesh *dm, const float time, int read_flag, const char **err_str);
 
+	void positionsCache(const PositionsCachePtr &cache);
+
 private:
 	void readFaceSetsSample(Main *bmain, Mesh *mesh, size_t poly_start,
 	                        const Alembic::AbcGeom::ISampleSelector &sample_sel);
+
+	void readSampleData(AbcMeshData &abc_mesh_data,
+	                    const Alembic::AbcGeom::ISampleSelector &sample_sel,
+	                    Alembic::AbcGeom::index_t index,
+	                    Alembic::AbcGeom::index_t ceil_index,
+	                    float weight);
+
+	Alembic::AbcGeom::P3fArraySamplePtr readPositions(Alembic::AbcGeom::index_t index);
 };
 
 /* ************************************************************************** */
@@ -41,6 +41,8 @@ extern "C" {
 #include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_string.h"
+
+#include "PIL_time.h"
 }
 
 using Alembic::AbcGeom::IObject;
@@ -69,6 +71,9 @@ AbcObjectWriter::AbcObjectWriter(Scene *scene,
     , m_scene(scene)
     , m_time_sampling(time_sampling)
     , m_first_frame(true)
+    , m_prepared(false)
+    , m_prepare_time(0.0)
+    , m_write_time(0.0)
 {
 	m_name = get_id_name(m_object) + "Shape";
 
@@ -109,10 +114,29 @@ Imath::Box3d AbcObjectWriter::bounds()
 	return this->m_bounds;
 }
 
+void AbcObjectWriter::prepare()
+{
+	const double start = PIL_check_seconds_timer();
+
+	do_prepare();
+	m_prepared = true;
+
+	m_prepare_time += PIL_check_seconds_timer() - start;
+}
+
 void AbcObjectWriter::write()
 {
+	if (!m_prepared) {
+		prepare();
+	}
+
+	const double start = PIL_check_seconds_timer();
+
 	do_write();
+	m_prepared = false;
 	m_first_frame = false;
+
+	m_write_time += PIL_check_seconds_timer() - start;
 }
 
 /* ************************************************************************** */
@@ -53,8 +53,13 @@ protected:
 	std::vector< std::pair<std::string, IDProperty *> > m_props;
 
 	bool m_first_frame;
+	bool m_prepared;
 	std::string m_name;
 
+	/* Time spent in prepare() and write(), in seconds. */
+	double m_prepare_time;
+	double m_write_time;
+
 public:
 	AbcObjectWriter(Scene *scene,
 	                Object *ob,
@@ -68,9 +73,21 @@ public:
 
 	virtual Imath::Box3d bounds();
 
+	/* Converts the data of the current frame into sample buffers. This may run
+	 * on a worker thread concurrently with the writers of other objects, so it
+	 * must not touch the archive. */
+	void prepare();
+
+	/* Writes the prepared sample to the archive, only from the exporting thread. */
 	void write();
 
+	Object *object() const { return m_object; }
+	const std::string &name() const { return m_name; }
+	double prepareTime() const { return m_prepare_time; }
+	double writeTime() const { return m_write_time; }
+
 private:
+	virtual void do_prepare() {}
 	virtual void do_write() = 0;
 };
 
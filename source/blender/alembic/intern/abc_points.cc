@@ -72,16 +72,16 @@ AbcPointsWriter::AbcPointsWriter(Scene *scene,
 	m_schema = points.getSchema();
 }
 
-void AbcPointsWriter::do_write()
+void AbcPointsWriter::do_prepare()
 {
 	if (!m_psys) {
 		return;
 	}
 
-	std::vector<Imath::V3f> points;
-	std::vector<Imath::V3f> velocities;
-	std::vector<float> widths;
-	std::vector<uint64_t> ids;
+	m_points.clear();
+	m_velocities.clear();
+	m_widths.clear();
+	m_ids.clear();
 
 	ParticleKey state;
 
@@ -113,21 +113,28 @@ void AbcPointsWriter::do_write()
 		sub_v3_v3v3(vel, state.co, m_psys->particles[p].prev_state.co);
 
 		/* Convert Z-up to Y-up. */
-		points.push_back(Imath::V3f(pos[0], pos[2], -pos[1]));
-		velocities.push_back(Imath::V3f(vel[0], vel[2], -vel[1]));
-		widths.push_back(m_psys->particles[p].size);
-		ids.push_back(index++);
+		m_points.push_back(Imath::V3f(pos[0], pos[2], -pos[1]));
+		m_velocities.push_back(Imath::V3f(vel[0], vel[2], -vel[1]));
+		m_widths.push_back(m_psys->particles[p].size);
+		m_ids.push_back(index++);
 	}
 
 	if (m_psys->lattice_deform_data) {
 		end_latt_deform(m_psys->lattice_deform_data);
 		m_psys->lattice_deform_data = NULL;
 	}
+}
+
+void AbcPointsWriter::do_write()
+{
+	if (!m_psys) {
+		return;
+	}
 
-	Alembic::Abc::P3fArraySample psample(points);
-	Alembic::Abc::UInt64ArraySample idsample(ids);
-	Alembic::Abc::V3fArraySample vsample(velocities);
-	Alembic::Abc::FloatArraySample wsample_array(widths);
+	Alembic::Abc::P3fArraySample psample(m_points);
+	Alembic::Abc::UInt64ArraySample idsample(m_ids);
+	Alembic::Abc::V3fArraySample vsample(m_velocities);
+	Alembic::Abc::FloatArraySample wsample_array(m_widths);
 	Alembic::AbcGeom::OFloatGeomParam::Sample wsample(wsample_array, kVertexScope);
 
 	m_sample = OPointsSchema::Sample(psample, idsample, vsample, wsample);
@@ -37,6 +37,12 @@ class AbcPointsWriter : public AbcObjectWriter {
 	Alembic::AbcGeom::OPointsSchema::Sample m_sample;
 	ParticleSystem *m_psys;
 
+	/* Sample buffers converted by do_prepare(). */
+	std::vector<Imath::V3f> m_points;
+	std::vector<Imath::V3f> m_velocities;
+	std::vector<float> m_widths;
+	std::vector<uint64_t> m_ids;
+
 public:
 	AbcPointsWriter(Scene *scene,
 	                Object *ob,
@@ -45,6 +51,7 @@ public:
 	                ExportSettings &settings,
 	                ParticleSystem *psys);
 
+	void do_prepare();
 	void do_write();
 };
 
@@ -883,5 +883,9 @@ CacheReader *CacheReader_open_alembic_object(AbcArchiveHandle *handle, CacheRead
 	abc_reader->object(object);
 	abc_reader->incref();
 
+	if (IPolyMesh::matches(iobject.getHeader())) {
+		static_cast<AbcMeshReader *>(abc_reader)->positionsCache(archive->positionsCache());
+	}
+
 	return reinterpret_cast<CacheReader *>(abc_reader);
 }
@@ -195,6 +195,8 @@ void BKE_tracking_camera_get_reconstructed_interpolate(struct MovieTracking *tra
 /* **** Distortion/Undistortion **** */
 struct MovieDistortion *BKE_tracking_distortion_new(struct MovieTracking *tracking,
                                                     int calibration_width, int calibration_height);
+struct MovieDistortion *BKE_tracking_distortion_new_cached(struct MovieTracking *tracking,
+                                                           int calibration_width, int calibration_height);
 void BKE_tracking_distortion_update(struct MovieDistortion *distortion, struct MovieTracking *tracking,
                                     int calibration_width, int calibration_height);
 void BKE_tracking_distortion_set_threads(struct MovieDistortion *distortion, int threads);
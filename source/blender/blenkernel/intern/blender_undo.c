@@ -59,6 +59,7 @@
 #include "BKE_depsgraph.h"
 #include "BKE_global.h"
 #include "BKE_image.h"
+#include "BKE_library.h"
 #include "BKE_main.h"
 #include "RE_pipeline.h"
 
@@ -119,6 +120,10 @@ static int read_undosave(bContext *C, UndoElem *uel)
 	if (success) {
 		/* important not to update time here, else non keyed tranforms are lost */
 		DAG_on_visible_update(G.main, false);
+
+		/* Restoring always reads the whole memfile, unchanged datablocks are not reused.
+		 * Datablocks were read again at new addresses, don't share their undo data. */
+		BKE_main_id_tag_all(G.main, LIB_TAG_UNDO_CHANGED, true);
 	}
 
 	return success;
@@ -197,6 +202,17 @@ void BKE_undo_write(bContext *C, const char *name)
 		memused = MEM_get_memory_in_use();
 		/* success = */ /* UNUSED */ BLO_write_file_mem(CTX_data_main(C), prevfile, &curundo->memfile, G.fileflags);
 		curundo->undosize = MEM_get_memory_in_use() - memused;
+
+		if (G.debug & G_DEBUG) {
+			size_t size_expanded, size_compacted;
+			BLO_memfile_calc_memory_usage(&size_expanded, &size_compacted);
+
+			printf("undo push '%s': %u bytes total, %u bytes written, %u bytes new, "
+			       "%u steps use %u bytes (%.2f%% of expanded size)\n",
+			       name, curundo->memfile.size, curundo->memfile.size_written, (unsigned int)curundo->undosize,
+			       BLI_listbase_count(&undobase), (unsigned int)size_compacted,
+			       size_expanded ? ((double)size_compacted / (double)size_expanded) * 100.0 : 0.0);
+		}
 	}
 
 	if (U.undomemory != 0) {
@@ -369,6 +385,8 @@ bool BKE_undo_save_file(const char *filename)
 		return false;
 	}
 
+	BLO_memfile_expand(&uel->memfile);
+
 	for (chunk = uel->memfile.chunks.first; chunk; chunk = chunk->next) {
 		if (write(file, chunk->buf, chunk->size) != chunk->size) {
 			break;
@@ -377,6 +395,8 @@ bool BKE_undo_save_file(const char *filename)
 
 	close(file);
 
+	BLO_memfile_expand_free(&uel->memfile);
+
 	if (chunk) {
 		fprintf(stderr, "Unable to save '%s': %s\n",
 		        filename, errno ? strerror(errno) : "Unknown error writing file");
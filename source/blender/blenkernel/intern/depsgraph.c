@@ -98,6 +98,25 @@
 #include "DEG_depsgraph_debug.h"
 #include "DEG_depsgraph_query.h"
 
+/* Global undo only writes datablocks again when they changed since the last step.
+ * Changes to object data are often tagged on the object, so pass them on to the data. */
+static void dag_id_tag_undo_changed(ID *id, short flag)
+{
+	id->tag |= LIB_TAG_UNDO_CHANGED;
+
+	if ((flag & OB_RECALC_DATA) && GS(id->name) == ID_OB) {
+		Object *ob = (Object *)id;
+		Key *key = BKE_key_from_object(ob);
+
+		if (ob->data) {
+			((ID *)ob->data)->tag |= LIB_TAG_UNDO_CHANGED;
+		}
+		if (key) {
+			key->id.tag |= LIB_TAG_UNDO_CHANGED;
+		}
+	}
+}
+
 #ifdef WITH_LEGACY_DEPSGRAPH
 
 static SpinLock threaded_update_lock;
@@ -1769,13 +1788,13 @@ void DAG_scene_free(Scene *sce)
 
 static void lib_id_recalc_tag(Main *bmain, ID *id)
 {
-	id->tag |= LIB_TAG_ID_RECALC;
+	id->tag |= LIB_TAG_ID_RECALC | LIB_TAG_UNDO_CHANGED;
 	DAG_id_type_tag(bmain, GS(id->name));
 }
 
 static void lib_id_recalc_data_tag(Main *bmain, ID *id)
 {
-	id->tag |= LIB_TAG_ID_RECALC_DATA;
+	id->tag |= LIB_TAG_ID_RECALC_DATA | LIB_TAG_UNDO_CHANGED;
 	DAG_id_type_tag(bmain, GS(id->name));
 }
 
@@ -2946,6 +2965,10 @@ void DAG_ids_clear_recalc(Main *bmain)
 
 void DAG_id_tag_update_ex(Main *bmain, ID *id, short flag)
 {
+	if (id) {
+		dag_id_tag_undo_changed(id, flag);
+	}
+
 	if (!DEG_depsgraph_use_legacy()) {
 		DEG_id_tag_update_ex(bmain, id, flag);
 		return;
@@ -3645,11 +3668,15 @@ void DAG_ids_check_recalc(Main *bmain, Scene *scene, bool time)
 
 void DAG_id_tag_update(ID *id, short flag)
 {
-	DEG_id_tag_update_ex(G.main, id, flag);
+	DAG_id_tag_update_ex(G.main, id, flag);
 }
 
 void DAG_id_tag_update_ex(Main *bmain, ID *id, short flag)
 {
+	if (id) {
+		dag_id_tag_undo_changed(id, flag);
+	}
+
 	DEG_id_tag_update_ex(bmain, id, flag);
 }
 
@@ -32,6 +32,8 @@
 #include "BLI_ghash.h"
 #include "BLI_task.h"
 
+#include "PIL_time.h"
+
 #include "BKE_pbvh.h"
 #include "BKE_ccg.h"
 #include "BKE_DerivedMesh.h"
@@ -237,44 +239,51 @@ void pbvh_grow_nodes(PBVH *bvh, int totnode)
 	bvh->totnode = totnode;
 }
 
-/* Add a vertex to the map, with a positive value for unique vertices and
- * a negative value for additional vertices */
-static int map_insert_vert(PBVH *bvh, GHash *map,
-                           unsigned int *face_verts,
-                           unsigned int *uniq_verts, int vertex)
+/* Flat vertex map of a leaf node, open addressing with linear probing */
+typedef struct PBVHVertMap {
+	int *keys;
+	int *values;
+	unsigned int mask;
+} PBVHVertMap;
+
+/* Add a vertex to the map, new vertices get the next index in verts */
+static int map_insert_vert(PBVHVertMap *map, int *verts, int *totvert, int vertex)
 {
-	void *key, **value_p;
+	unsigned int slot = ((unsigned int)vertex * 2654435761u) & map->mask;
 
-	key = SET_INT_IN_POINTER(vertex);
-	if (!BLI_ghash_ensure_p(map, key, &value_p)) {
-		int value_i;
-		if (BLI_BITMAP_TEST(bvh->vert_bitmap, vertex) == 0) {
-			BLI_BITMAP_ENABLE(bvh->vert_bitmap, vertex);
-			value_i = *uniq_verts;
-			(*uniq_verts)++;
-		}
-		else {
-			value_i = ~(*face_verts);
-			(*face_verts)++;
-		}
-		*value_p = SET_INT_IN_POINTER(value_i);
-		return value_i;
-	}
-	else {
-		return GET_INT_FROM_POINTER(*value_p);
+	while (map->keys[slot] != -1) {
+		if (map->keys[slot] == vertex)
+			return map->values[slot];
+		slot = (slot + 1) & map->mask;
 	}
+
+	map->keys[slot] = vertex;
+	map->values[slot] = *totvert;
+	verts[(*totvert)++] = vertex;
+	return map->values[slot];
 }
 
-/* Find vertices used by the faces in this node and update the draw buffers */
-static void build_mesh_leaf_node(PBVH *bvh, PBVHNode *node)
+/* Find vertices used by the faces in this node and update the draw buffers.
+ *
+ * vert_owner holds the lowest leaf index that uses each vertex, a vertex is
+ * unique to that leaf and an additional vertex of all other leaves */
+static void build_mesh_leaf_node(PBVH *bvh, PBVHNode *node,
+                                 const unsigned int leaf, const unsigned int *vert_owner)
 {
 	bool has_visible = false;
 
-	node->uniq_verts = node->face_verts = 0;
 	const int totface = node->totprim;
+	int totvert = 0;
+
+	/* at most half of the slots are used */
+	PBVHVertMap map;
+	const unsigned int map_size = power_of_2_max_u(3 * totface) * 2;
+	map.mask = map_size - 1;
+	map.keys = MEM_mallocN(sizeof(int) * map_size, "bvh node vert map keys");
+	map.values = MEM_mallocN(sizeof(int) * map_size, "bvh node vert map values");
+	copy_vn_i(map.keys, map_size, -1);
 
-	/* reserve size is rough guess */
-	GHash *map = BLI_ghash_int_new_ex("build_mesh_leaf_node gh", 2 * totface);
+	int *verts = MEM_mallocN(sizeof(int) * 3 * totface, "bvh node verts");
 
 	int (*face_vert_indices)[3] = MEM_mallocN(sizeof(int[3]) * totface,
 	                                          "bvh node face vert indices");
@@ -285,8 +294,7 @@ static void build_mesh_leaf_node(PBVH *bvh, PBVHNode *node)
 		const MLoopTri *lt = &bvh->looptri[node->prim_indices[i]];
 		for (int j = 0; j < 3; ++j) {
 			face_vert_indices[i][j] =
-			        map_insert_vert(bvh, map, &node->face_verts,
-			                        &node->uniq_verts, bvh->mloop[lt->tri[j]].v);
+			        map_insert_vert(&map, verts, &totvert, bvh->mloop[lt->tri[j]].v);
 		}
 
 		if (!paint_is_face_hidden(lt, bvh->verts, bvh->mloop)) {
@@ -294,31 +302,30 @@ static void build_mesh_leaf_node(PBVH *bvh, PBVHNode *node)
 		}
 	}
 
-	int *vert_indices = MEM_callocN(sizeof(int) * (node->uniq_verts + node->face_verts),
-	                                "bvh node vert indices");
-	node->vert_indices = vert_indices;
+	node->uniq_verts = 0;
+	for (int i = 0; i < totvert; ++i) {
+		if (vert_owner[verts[i]] == leaf)
+			node->uniq_verts++;
+	}
+	node->face_verts = totvert - node->uniq_verts;
 
 	/* Build the vertex list, unique verts first */
-	GHashIterator gh_iter;
-	GHASH_ITER (gh_iter, map) {
-		void *value = BLI_ghashIterator_getValue(&gh_iter);
-		int ndx = GET_INT_FROM_POINTER(value);
+	int *vert_indices = MEM_mallocN(sizeof(int) * totvert, "bvh node vert indices");
+	int uniq_index = 0, other_index = node->uniq_verts;
 
-		if (ndx < 0)
-			ndx = -ndx + node->uniq_verts - 1;
+	/* reuse the map values for the final indices */
+	int *map_indices = map.values;
 
-		vert_indices[ndx] =
-		        GET_INT_FROM_POINTER(BLI_ghashIterator_getKey(&gh_iter));
+	for (int i = 0; i < totvert; ++i) {
+		const int ndx = (vert_owner[verts[i]] == leaf) ? uniq_index++ : other_index++;
+		vert_indices[ndx] = verts[i];
+		map_indices[i] = ndx;
 	}
+	node->vert_indices = vert_indices;
 
 	for (int i = 0; i < totface; ++i) {
-		const int sides = 3;
-
-		for (int j = 0; j < sides; ++j) {
-			if (face_vert_indices[i][j] < 0)
-				face_vert_indices[i][j] =
-				        -face_vert_indices[i][j] +
-				        node->uniq_verts - 1;
+		for (int j = 0; j < 3; ++j) {
+			face_vert_indices[i][j] = map_indices[face_vert_indices[i][j]];
 		}
 	}
 
@@ -326,17 +333,9 @@ static void build_mesh_leaf_node(PBVH *bvh, PBVHNode *node)
 
 	BKE_pbvh_node_fully_hidden_set(node, !has_visible);
 
-	BLI_ghash_free(map, NULL, NULL);
-}
-
-static void update_vb(PBVH *bvh, PBVHNode *node, BBC *prim_bbc,
-                      int offset, int count)
-{
-	BB_reset(&node->vb);
-	for (int i = offset + count - 1; i >= offset; --i) {
-		BB_expand_with_bb(&node->vb, (BB *)(&prim_bbc[bvh->prim_indices[i]]));
-	}
-	node->orig_vb = node->vb;
+	MEM_freeN(map.keys);
+	MEM_freeN(map.values);
+	MEM_freeN(verts);
 }
 
 /* Returns the number of visible quads in the nodes' grids. */
@@ -378,24 +377,6 @@ static void build_grid_leaf_node(PBVH *bvh, PBVHNode *node)
 }
 
 
-static void build_leaf(PBVH *bvh, int node_index, BBC *prim_bbc,
-                       int offset, int count)
-{
-	bvh->nodes[node_index].flag |= PBVH_Leaf;
-
-	bvh->nodes[node_index].prim_indices = bvh->prim_indices + offset;
-	bvh->nodes[node_index].totprim = count;
-
-	/* Still need vb for searches */
-	update_vb(bvh, &bvh->nodes[node_index], prim_bbc, offset, count);
-		
-	if (bvh->looptri)
-		build_mesh_leaf_node(bvh, bvh->nodes + node_index);
-	else {
-		build_grid_leaf_node(bvh, bvh->nodes + node_index);
-	}
-}
-
 /* Return zero if all primitives in the node can be drawn with the
  * same material (including flat/smooth shading), non-zero otherwise */
 static bool leaf_needs_material_split(PBVH *bvh, int offset, int count)
@@ -429,20 +410,38 @@ static bool leaf_needs_material_split(PBVH *bvh, int offset, int count)
 }
 
 
+/* Node of the tree while it is being built. Subtrees are partitioned in
+ * parallel, and only flattened into the nodes array once they are all done */
+typedef struct PBVHBuildNode {
+	struct PBVHBuildNode *children[2];
+	/* Range in the array of primitive indices */
+	int offset, count;
+	/* Voxel box of leaves */
+	BB vb;
+} PBVHBuildNode;
+
+typedef struct PBVHBuildData {
+	PBVH *bvh;
+	BBC *prim_bbc;
+	TaskPool *pool;
+} PBVHBuildData;
+
+static void build_sub_task_cb(TaskPool *__restrict pool, void *taskdata, int threadid);
+
 /* Recursively build a node in the tree
- *
- * vb is the voxel box around all of the primitives contained in
- * this node.
  *
  * cb is the bounding box around all the centroids of the primitives
  * contained in this node
  *
- * offset and start indicate a range in the array of primitive indices
+ * Only the primitive indices in the range of the node are touched, so
+ * large subtrees are pushed to the task pool to be built by other threads
  */
 
-static void build_sub(PBVH *bvh, int node_index, BB *cb, BBC *prim_bbc,
-                      int offset, int count)
+static void build_sub(PBVHBuildData *data, PBVHBuildNode *bnode, BB *cb, int threadid)
 {
+	PBVH *bvh = data->bvh;
+	BBC *prim_bbc = data->prim_bbc;
+	const int offset = bnode->offset, count = bnode->count;
 	int end;
 	BB cb_backing;
 
@@ -450,18 +449,15 @@ static void build_sub(PBVH *bvh, int node_index, BB *cb, BBC *prim_bbc,
 	const bool below_leaf_limit = count <= bvh->leaf_limit;
 	if (below_leaf_limit) {
 		if (!leaf_needs_material_split(bvh, offset, count)) {
-			build_leaf(bvh, node_index, prim_bbc, offset, count);
+			/* Still need vb for searches */
+			BB_reset(&bnode->vb);
+			for (int i = offset + count - 1; i >= offset; --i) {
+				BB_expand_with_bb(&bnode->vb, (BB *)(&prim_bbc[bvh->prim_indices[i]]));
+			}
 			return;
 		}
 	}
 
-	/* Add two child nodes */
-	bvh->nodes[node_index].children_offset = bvh->totnode;
-	pbvh_grow_nodes(bvh, bvh->totnode + 2);
-
-	/* Update parent node bounding box */
-	update_vb(bvh, &bvh->nodes[node_index], prim_bbc, offset, count);
-
 	if (!below_leaf_limit) {
 		/* Find axis with widest range of primitive centroids */
 		if (!cb) {
@@ -484,15 +480,148 @@ static void build_sub(PBVH *bvh, int node_index, BB *cb, BBC *prim_bbc,
 		end = partition_indices_material(bvh, offset, offset + count - 1);
 	}
 
+	/* Add two child nodes */
+	for (int i = 0; i < 2; ++i)
+		bnode->children[i] = MEM_callocN(sizeof(PBVHBuildNode), "PBVHBuildNode");
+
+	bnode->children[0]->offset = offset;
+	bnode->children[0]->count = end - offset;
+	bnode->children[1]->offset = end;
+	bnode->children[1]->count = offset + count - end;
+
 	/* Build children */
-	build_sub(bvh, bvh->nodes[node_index].children_offset, NULL,
-	          prim_bbc, offset, end - offset);
-	build_sub(bvh, bvh->nodes[node_index].children_offset + 1, NULL,
-	          prim_bbc, end, offset + count - end);
+	if (data->pool && bnode->children[0]->count > bvh->leaf_limit * PBVH_THREADED_LIMIT) {
+		BLI_task_pool_push_from_thread(data->pool, build_sub_task_cb, bnode->children[0],
+		                               false, TASK_PRIORITY_HIGH, threadid);
+	}
+	else {
+		build_sub(data, bnode->children[0], NULL, threadid);
+	}
+	build_sub(data, bnode->children[1], NULL, threadid);
+}
+
+static void build_sub_task_cb(TaskPool *__restrict pool, void *taskdata, int threadid)
+{
+	PBVHBuildData *data = BLI_task_pool_userdata(pool);
+
+	build_sub(data, taskdata, NULL, threadid);
+}
+
+/* Copy the build tree into the nodes array, in depth first order with the
+ * children of a node next to each other, and free it */
+static void build_flatten(PBVH *bvh, PBVHBuildNode *bnode, int node_index)
+{
+	if (bnode->children[0] == NULL) {
+		PBVHNode *node = &bvh->nodes[node_index];
+
+		node->flag |= PBVH_Leaf;
+		node->prim_indices = bvh->prim_indices + bnode->offset;
+		node->totprim = bnode->count;
+		node->vb = node->orig_vb = bnode->vb;
+	}
+	else {
+		const int children_offset = bvh->totnode;
+
+		bvh->nodes[node_index].children_offset = children_offset;
+		pbvh_grow_nodes(bvh, bvh->totnode + 2);
+
+		for (int i = 0; i < 2; ++i) {
+			build_flatten(bvh, bnode->children[i], children_offset + i);
+			MEM_freeN(bnode->children[i]);
+		}
+
+		/* Nodes array may have been reallocated by the children */
+		PBVHNode *node = &bvh->nodes[node_index];
+		BB_reset(&node->vb);
+		BB_expand_with_bb(&node->vb, &bvh->nodes[children_offset].vb);
+		BB_expand_with_bb(&node->vb, &bvh->nodes[children_offset + 1].vb);
+		node->orig_vb = node->vb;
+	}
+}
+
+typedef struct PBVHBuildLeavesData {
+	PBVH *bvh;
+	const int *leaves;
+	unsigned int *vert_owner;
+} PBVHBuildLeavesData;
+
+static void build_mesh_leaves_owner_task_cb(void *userdata, const int n)
+{
+	PBVHBuildLeavesData *data = userdata;
+	PBVH *bvh = data->bvh;
+	PBVHNode *node = &bvh->nodes[data->leaves[n]];
+
+	/* Vertices belong to the first leaf that uses them, independent of the
+	 * order in which the leaves are built */
+	for (int i = 0; i < node->totprim; ++i) {
+		const MLoopTri *lt = &bvh->looptri[node->prim_indices[i]];
+		for (int j = 0; j < 3; ++j) {
+			unsigned int *owner = &data->vert_owner[bvh->mloop[lt->tri[j]].v];
+			unsigned int old = *owner;
+
+			while ((unsigned int)n < old) {
+				const unsigned int prev = atomic_cas_uint32(owner, old, (unsigned int)n);
+				if (prev == old)
+					break;
+				old = prev;
+			}
+		}
+	}
+}
+
+static void build_mesh_leaves_task_cb(void *userdata, const int n)
+{
+	PBVHBuildLeavesData *data = userdata;
+
+	build_mesh_leaf_node(data->bvh, &data->bvh->nodes[data->leaves[n]], (unsigned int)n, data->vert_owner);
+}
+
+static void build_grid_leaves_task_cb(void *userdata, const int n)
+{
+	PBVHBuildLeavesData *data = userdata;
+
+	build_grid_leaf_node(data->bvh, &data->bvh->nodes[data->leaves[n]]);
+}
+
+static void build_leaves(PBVH *bvh, const bool use_threading)
+{
+	int *leaves = MEM_mallocN(sizeof(int) * bvh->totnode, "bvh build leaves");
+	int totleaf = 0;
+
+	for (int i = 0; i < bvh->totnode; ++i) {
+		if (bvh->nodes[i].flag & PBVH_Leaf)
+			leaves[totleaf++] = i;
+	}
+
+	PBVHBuildLeavesData data = {
+	    .bvh = bvh, .leaves = leaves, .vert_owner = NULL,
+	};
+
+	if (bvh->looptri) {
+		data.vert_owner = MEM_mallocN(sizeof(unsigned int) * bvh->totvert, "bvh vert owner");
+		memset(data.vert_owner, 0xff, sizeof(unsigned int) * bvh->totvert);
+
+		BLI_task_parallel_range(0, totleaf, &data, build_mesh_leaves_owner_task_cb, use_threading);
+		BLI_task_parallel_range(0, totleaf, &data, build_mesh_leaves_task_cb, use_threading);
+
+		MEM_freeN(data.vert_owner);
+	}
+	else {
+		BLI_task_parallel_range(0, totleaf, &data, build_grid_leaves_task_cb, use_threading);
+	}
+
+	MEM_freeN(leaves);
 }
 
 static void pbvh_build(PBVH *bvh, BB *cb, BBC *prim_bbc, int totprim)
 {
+	const bool use_threading = totprim > bvh->leaf_limit * PBVH_THREADED_LIMIT;
+	double time_start = 0.0;
+
+	if (G.debug & G_DEBUG) {
+		time_start = PIL_check_seconds_timer();
+	}
+
 	if (totprim != bvh->totprim) {
 		bvh->totprim = totprim;
 		if (bvh->nodes) MEM_freeN(bvh->nodes);
@@ -510,8 +639,83 @@ static void pbvh_build(PBVH *bvh, BB *cb, BBC *prim_bbc, int totprim)
 		}
 	}
 
+	PBVHBuildNode root = {{NULL}};
+	root.offset = 0;
+	root.count = totprim;
+
+	PBVHBuildData data = {
+	    .bvh = bvh, .prim_bbc = prim_bbc, .pool = NULL,
+	};
+
+	if (use_threading) {
+		data.pool = BLI_task_pool_create(BLI_task_scheduler_get(), &data);
+	}
+
+	build_sub(&data, &root, cb, 0);
+
+	if (data.pool) {
+		BLI_task_pool_work_and_wait(data.pool);
+		BLI_task_pool_free(data.pool);
+	}
+
 	bvh->totnode = 1;
-	build_sub(bvh, 0, cb, prim_bbc, 0, totprim);
+	build_flatten(bvh, &root, 0);
+
+	build_leaves(bvh, use_threading);
+
+	if (G.debug & G_DEBUG) {
+		printf("PBVH build: %d primitives, %d nodes in %f seconds\n",
+		       totprim, bvh->totnode, PIL_check_seconds_timer() - time_start);
+	}
+}
+
+typedef struct PBVHPrimBBCData {
+	PBVH *bvh;
+	BBC *prim_bbc;
+	/* Bounding box of all centroids */
+	BB cb;
+} PBVHPrimBBCData;
+
+static void pbvh_mesh_prim_bbc_task_cb(void *userdata, void *userdata_chunk, const int i, const int UNUSED(threadid))
+{
+	PBVHPrimBBCData *data = userdata;
+	const PBVH *bvh = data->bvh;
+	const MLoopTri *lt = &bvh->looptri[i];
+	BBC *bbc = &data->prim_bbc[i];
+
+	BB_reset((BB *)bbc);
+
+	for (int j = 0; j < 3; ++j)
+		BB_expand((BB *)bbc, bvh->verts[bvh->mloop[lt->tri[j]].v].co);
+
+	BBC_update_centroid(bbc);
+
+	BB_expand(userdata_chunk, bbc->bcentroid);
+}
+
+static void pbvh_grids_prim_bbc_task_cb(void *userdata, void *userdata_chunk, const int i, const int UNUSED(threadid))
+{
+	PBVHPrimBBCData *data = userdata;
+	const PBVH *bvh = data->bvh;
+	const CCGKey *key = &bvh->gridkey;
+	CCGElem *grid = bvh->grids[i];
+	BBC *bbc = &data->prim_bbc[i];
+
+	BB_reset((BB *)bbc);
+
+	for (int j = 0; j < key->grid_size * key->grid_size; ++j)
+		BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
+
+	BBC_update_centroid(bbc);
+
+	BB_expand(userdata_chunk, bbc->bcentroid);
+}
+
+static void pbvh_prim_bbc_finalize(void *userdata, void *userdata_chunk)
+{
+	PBVHPrimBBCData *data = userdata;
+
+	BB_expand_with_bb(&data->cb, userdata_chunk);
 }
 
 /**
@@ -525,44 +729,34 @@ void BKE_pbvh_build_mesh(
         int totvert, struct CustomData *vdata,
         const MLoopTri *looptri, int looptri_num)
 {
-	BBC *prim_bbc = NULL;
-	BB cb;
-
 	bvh->type = PBVH_FACES;
 	bvh->mpoly = mpoly;
 	bvh->mloop = mloop;
 	bvh->looptri = looptri;
 	bvh->verts = verts;
-	bvh->vert_bitmap = BLI_BITMAP_NEW(totvert, "bvh->vert_bitmap");
 	bvh->totvert = totvert;
 	bvh->leaf_limit = LEAF_LIMIT;
 	bvh->vdata = vdata;
 
+	PBVHPrimBBCData data = {
+	    .bvh = bvh, .prim_bbc = NULL,
+	};
+	BB cb;
 	BB_reset(&cb);
+	BB_reset(&data.cb);
 
 	/* For each face, store the AABB and the AABB centroid */
-	prim_bbc = MEM_mallocN(sizeof(BBC) * looptri_num, "prim_bbc");
-
-	for (int i = 0; i < looptri_num; ++i) {
-		const MLoopTri *lt = &looptri[i];
-		const int sides = 3;
-		BBC *bbc = prim_bbc + i;
-
-		BB_reset((BB *)bbc);
-
-		for (int j = 0; j < sides; ++j)
-			BB_expand((BB *)bbc, verts[bvh->mloop[lt->tri[j]].v].co);
+	data.prim_bbc = MEM_mallocN(sizeof(BBC) * looptri_num, "prim_bbc");
 
-		BBC_update_centroid(bbc);
-
-		BB_expand(&cb, bbc->bcentroid);
-	}
+	BLI_task_parallel_range_finalize(
+	        0, looptri_num, &data, &cb, sizeof(cb),
+	        pbvh_mesh_prim_bbc_task_cb, pbvh_prim_bbc_finalize,
+	        looptri_num > LEAF_LIMIT, false);
 
 	if (looptri_num)
-		pbvh_build(bvh, &cb, prim_bbc, looptri_num);
+		pbvh_build(bvh, &data.cb, data.prim_bbc, looptri_num);
 
-	MEM_freeN(prim_bbc);
-	MEM_freeN(bvh->vert_bitmap);
+	MEM_freeN(data.prim_bbc);
 }
 
 /* Do a full rebuild with on Grids data structure */
@@ -580,30 +774,25 @@ void BKE_pbvh_build_grids(PBVH *bvh, CCGElem **grids,
 	bvh->grid_hidden = grid_hidden;
 	bvh->leaf_limit = max_ii(LEAF_LIMIT / ((gridsize - 1) * (gridsize - 1)), 1);
 
+	PBVHPrimBBCData data = {
+	    .bvh = bvh, .prim_bbc = NULL,
+	};
 	BB cb;
 	BB_reset(&cb);
+	BB_reset(&data.cb);
 
 	/* For each grid, store the AABB and the AABB centroid */
-	BBC *prim_bbc = MEM_mallocN(sizeof(BBC) * totgrid, "prim_bbc");
-
-	for (int i = 0; i < totgrid; ++i) {
-		CCGElem *grid = grids[i];
-		BBC *bbc = prim_bbc + i;
+	data.prim_bbc = MEM_mallocN(sizeof(BBC) * totgrid, "prim_bbc");
 
-		BB_reset((BB *)bbc);
-
-		for (int j = 0; j < gridsize * gridsize; ++j)
-			BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
-
-		BBC_update_centroid(bbc);
-
-		BB_expand(&cb, bbc->bcentroid);
-	}
+	BLI_task_parallel_range_finalize(
+	        0, totgrid, &data, &cb, sizeof(cb),
+	        pbvh_grids_prim_bbc_task_cb, pbvh_prim_bbc_finalize,
+	        totgrid > bvh->leaf_limit, false);
 
 	if (totgrid)
-		pbvh_build(bvh, &cb, prim_bbc, totgrid);
+		pbvh_build(bvh, &data.cb, data.prim_bbc, totgrid);
 
-	MEM_freeN(prim_bbc);
+	MEM_freeN(data.prim_bbc);
 }
 
 PBVH *BKE_pbvh_new(void)
@@ -150,10 +150,6 @@ struct PBVH {
 	 * in an opaque pointer per pbvh. See T47637. */
 	struct GridCommonGPUBuffer *grid_common_gpu_buffer;
 
-	/* Only used during BVH build and update,
-	 * don't need to remain valid after */
-	BLI_bitmap *vert_bitmap;
-
 #ifdef PERFCNTRS
 	int perf_modified;
 #endif
@@ -72,10 +72,6 @@
 
 typedef struct MovieDistortion {
 	struct libmv_CameraIntrinsics *intrinsics;
-	/* Parameters needed for coordinates normalization. */
-	float principal[2];
-	float pixel_aspect;
-	float focal;
 } MovieDistortion;
 
 static struct {
@@ -2028,11 +2024,6 @@ MovieDistortion *BKE_tracking_distortion_new(MovieTracking *tracking,
 	distortion = MEM_callocN(sizeof(MovieDistortion), "BKE_tracking_distortion_create");
 	distortion->intrinsics = libmv_cameraIntrinsicsNew(&camera_intrinsics_options);
 
-	const MovieTrackingCamera *camera = &tracking->camera;
-	copy_v2_v2(distortion->principal, camera->principal);
-	distortion->pixel_aspect = camera->pixel_aspect;
-	distortion->focal = camera->focal;
-
 	return distortion;
 }
 
@@ -2046,14 +2037,41 @@ void BKE_tracking_distortion_update(MovieDistortion *distortion, MovieTracking *
 	                                             calibration_height,
 	                                             &camera_intrinsics_options);
 
-	const MovieTrackingCamera *camera = &tracking->camera;
-	copy_v2_v2(distortion->principal, camera->principal);
-	distortion->pixel_aspect = camera->pixel_aspect;
-	distortion->focal = camera->focal;
-
 	libmv_cameraIntrinsicsUpdate(&camera_intrinsics_options, distortion->intrinsics);
 }
 
+/* Create distortion for per-point (un)distortion of the whole frame.
+ *
+ * Point lookup grids are calculated for the distortion cached in the tracking camera
+ * (the one used for undistorted clip display) and copied from there, so they're only
+ * recalculated when camera intrinsics or calibration size changes.
+ */
+MovieDistortion *BKE_tracking_distortion_new_cached(MovieTracking *tracking,
+                                                    int calibration_width, int calibration_height)
+{
+	MovieTrackingCamera *camera = &tracking->camera;
+	MovieDistortion *cached_distortion, *distortion;
+
+	BLI_lock_thread(LOCK_MOVIECLIP);
+
+	if (camera->intrinsics == NULL) {
+		camera->intrinsics = BKE_tracking_distortion_new(tracking, calibration_width, calibration_height);
+	}
+	else {
+		BKE_tracking_distortion_update(camera->intrinsics, tracking, calibration_width, calibration_height);
+	}
+
+	cached_distortion = camera->intrinsics;
+	libmv_cameraIntrinsicsUpdatePointGrids(cached_distortion->intrinsics);
+
+	distortion = BKE_tracking_distortion_new(tracking, calibration_width, calibration_height);
+	libmv_cameraIntrinsicsCopyPointGrids(cached_distortion->intrinsics, distortion->intrinsics);
+
+	BLI_unlock_thread(LOCK_MOVIECLIP);
+
+	return distortion;
+}
+
 void BKE_tracking_distortion_set_threads(MovieDistortion *distortion, int threads)
 {
 	libmv_cameraIntrinsicsSetThreads(distortion->intrinsics, threads);
@@ -2126,16 +2144,11 @@ void BKE_tracking_distortion_distort_v2(MovieDistortion *distortion,
                                         const float co[2],
                                         float r_co[2])
 {
-	const float aspy = 1.0f / distortion->pixel_aspect;
-
-	/* Normalize coords. */
-	float inv_focal = 1.0f / distortion->focal;
-	double x = (co[0] - distortion->principal[0]) * inv_focal,
-	       y = (co[1] - distortion->principal[1] * aspy) * inv_focal;
+	double x, y;
 
-	libmv_cameraIntrinsicsApply(distortion->intrinsics, x, y, &x, &y);
+	/* Uses point lookup grids when they're calculated. */
+	libmv_cameraIntrinsicsDistortPoint(distortion->intrinsics, co[0], co[1], &x, &y);
 
-	/* Result is in image coords already. */
 	r_co[0] = x;
 	r_co[1] = y;
 }
@@ -2144,12 +2157,12 @@ void BKE_tracking_distortion_undistort_v2(MovieDistortion *distortion,
                                           const float co[2],
                                           float r_co[2])
 {
-	double x = co[0], y = co[1];
-	libmv_cameraIntrinsicsInvert(distortion->intrinsics, x, y, &x, &y);
+	double x, y;
 
-	const float aspy = 1.0f / distortion->pixel_aspect;
-	r_co[0] = (float)x * distortion->focal + distortion->principal[0];
-	r_co[1] = (float)y * distortion->focal + distortion->principal[1] * aspy;
+	libmv_cameraIntrinsicsUndistortPoint(distortion->intrinsics, co[0], co[1], &x, &y);
+
+	r_co[0] = x;
+	r_co[1] = y;
 }
 
 void BKE_tracking_distortion_free(MovieDistortion *distortion)
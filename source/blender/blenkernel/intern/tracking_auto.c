@@ -371,18 +371,33 @@ bool BKE_autotrack_context_step(AutoTrackContext *context)
 {
 	int frame_delta = context->backwards ? -1 : 1;
 	bool ok = false;
-	int track;
-
-#pragma omp parallel for if (context->num_tracks > 1)
+	int track, i, num_markers = 0;
+	libmv_TrackRegionOptions *track_region_options;
+	libmv_Marker *tracked_markers;
+	libmv_TrackRegionResult *results;
+	int *marker_tracks, *success;
+
+	track_region_options = MEM_mallocN(sizeof(*track_region_options) * context->num_tracks,
+	                                   "autotrack region options");
+	tracked_markers = MEM_mallocN(sizeof(*tracked_markers) * context->num_tracks,
+	                              "autotrack tracked markers");
+	results = MEM_mallocN(sizeof(*results) * context->num_tracks,
+	                      "autotrack results");
+	marker_tracks = MEM_mallocN(sizeof(*marker_tracks) * context->num_tracks,
+	                            "autotrack marker tracks");
+	success = MEM_mallocN(sizeof(*success) * context->num_tracks,
+	                      "autotrack success");
+
+	/* Gather the markers of all tracks first, Libmv tracks them all at once
+	 * so the frames are only fetched and prepared once for all tracks.
+	 */
 	for (track = 0; track < context->num_tracks; ++track) {
 		AutoTrackOptions *options = &context->options[track];
 		if (options->is_failed) {
 			continue;
 		}
 		libmv_Marker libmv_current_marker,
-		             libmv_reference_marker,
 		             libmv_tracked_marker;
-		libmv_TrackRegionResult libmv_result;
 		int frame = BKE_movieclip_remap_scene_to_clip_frame(
 			context->clips[options->clip_index],
 			context->user.framenr);
@@ -411,39 +426,49 @@ bool BKE_autotrack_context_step(AutoTrackContext *context)
 			if (options->use_keyframe_match) {
 				libmv_tracked_marker.reference_frame =
 					libmv_current_marker.reference_frame;
-				libmv_autoTrackGetMarker(context->autotrack,
-			                             options->clip_index,
-			                             libmv_tracked_marker.reference_frame,
-			                             options->track_index,
-			                             &libmv_reference_marker);
 			}
 			else {
 				libmv_tracked_marker.reference_frame = frame;
-				libmv_reference_marker = libmv_current_marker;
 			}
 
-			if (libmv_autoTrackMarker(context->autotrack,
-			                          &options->track_region_options,
-			                          &libmv_tracked_marker,
-			                          &libmv_result))
-			{
-				BLI_spin_lock(&context->spin_lock);
-				libmv_autoTrackAddMarker(context->autotrack,
-				                         &libmv_tracked_marker);
-				BLI_spin_unlock(&context->spin_lock);
-			}
-			else {
-				options->is_failed = true;
-				options->failed_frame = frame + frame_delta;
-			}
+			track_region_options[num_markers] = options->track_region_options;
+			tracked_markers[num_markers] = libmv_tracked_marker;
+			marker_tracks[num_markers] = track;
+			num_markers++;
 			ok = true;
 		}
 	}
 
+	if (num_markers != 0) {
+		libmv_autoTrackMarkers(context->autotrack,
+		                       track_region_options,
+		                       tracked_markers,
+		                       results,
+		                       success,
+		                       num_markers);
+	}
+
 	BLI_spin_lock(&context->spin_lock);
+	for (i = 0; i < num_markers; ++i) {
+		AutoTrackOptions *options = &context->options[marker_tracks[i]];
+		if (success[i]) {
+			libmv_autoTrackAddMarker(context->autotrack,
+			                         &tracked_markers[i]);
+		}
+		else {
+			options->is_failed = true;
+			options->failed_frame = tracked_markers[i].frame;
+		}
+	}
 	context->user.framenr += frame_delta;
 	BLI_spin_unlock(&context->spin_lock);
 
+	MEM_freeN(track_region_options);
+	MEM_freeN(tracked_markers);
+	MEM_freeN(results);
+	MEM_freeN(marker_tracks);
+	MEM_freeN(success);
+
 	return ok;
 }
 
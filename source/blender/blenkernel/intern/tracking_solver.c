@@ -42,6 +42,7 @@
 #include "BLI_math.h"
 #include "BLI_listbase.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 
 #include "BLT_translation.h"
 
@@ -449,6 +450,8 @@ static void reconstructionOptionsFromContext(libmv_ReconstructionOptions *recons
 	reconstruction_options->keyframe2 = context->keyframe2;
 
 	reconstruction_options->refine_intrinsics = context->refine_flags;
+
+	reconstruction_options->num_threads = BLI_system_thread_count();
 }
 
 /* Solve camera/object motion and reconstruct 3D markers position
@@ -163,6 +163,11 @@ int BLI_bvhtree_ray_cast(
         BVHTree *tree, const float co[3], const float dir[3], float radius, BVHTreeRayHit *hit,
         BVHTree_RayCastCallback callback, void *userdata);
 
+int BLI_bvhtree_ray_cast_packet(
+        BVHTree *tree, const float (*co)[3], const float (*dir)[3], const int rays_num, float radius,
+        BVHTreeRayHit *hits, BVHTree_RayCastCallback callback, void *userdata,
+        int flag);
+
 void BLI_bvhtree_ray_cast_all_ex(
         BVHTree *tree, const float co[3], const float dir[3], float radius, float hit_dist,
         BVHTree_RayCastCallback callback, void *userdata,
@@ -37,7 +37,7 @@
  * implements a bvh-tree structure with support for:
  *
  * - Ray-cast:
- *   #BLI_bvhtree_ray_cast, #BVHRayCastData
+ *   #BLI_bvhtree_ray_cast, #BLI_bvhtree_ray_cast_packet, #BVHRayCastData, #BVHTreeWide
  * - Nearest point on surface:
  *   #BLI_bvhtree_find_nearest, #BVHNearestData
  * - Overlapping 2 trees:
@@ -50,6 +50,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_utildefines.h"
 #include "BLI_alloca.h"
 #include "BLI_stack.h"
@@ -58,6 +60,10 @@
 #include "BLI_strict_flags.h"
 #include "BLI_task.h"
 
+#ifdef __SSE__
+#  include <xmmintrin.h>
+#endif
+
 /* used for iterative_raycast */
 // #define USE_SKIP_LINKS
 
@@ -72,6 +78,12 @@
 #  define KDOPBVH_THREAD_LEAF_THRESHOLD 1024
 #endif
 
+/* max number of rays traversing the tree together, see: #BLI_bvhtree_ray_cast_packet */
+#define BVH_RAYCAST_PACKET_SIZE 16
+
+/* one bit per ray in the packet masks */
+BLI_STATIC_ASSERT(BVH_RAYCAST_PACKET_SIZE < 32, "packet too big")
+
 
 /* -------------------------------------------------------------------- */
 
@@ -92,6 +104,25 @@ typedef struct BVHNode {
 	char main_axis; /* Axis used to split this node */
 } BVHNode;
 
+/**
+ * Flattened copy of the tree used for ray-casting, the axis aligned bounds of 4 children
+ * are stored next to each other so they can be tested against a ray at once.
+ */
+typedef struct BVHNodeWide {
+	float bv[6][4];    /* min/max of the X, Y, Z axes (same order as #BVHNode.bv) for each child */
+	int child[4];      /* index in #BVHTreeWide.nodes, or the leaf index when its #leaf_flag bit is set */
+	char totnode;      /* used children, unused ones have empty bounds */
+	char leaf_flag;
+	char main_axis;    /* from the #BVHNode, to pick the order of traversal */
+} BVHNodeWide;
+
+typedef struct BVHTreeWide {
+	BVHNodeWide *nodes;   /* depth first order, root first */
+	BVHNode **nodes_src;  /* 4 per node, the #BVHNode each child bounds are copied from (NULL when grouped) */
+	int totnode, totnode_alloc;
+	int depth;            /* of the deepest node, to size the traversal stacks */
+} BVHTreeWide;
+
 /* keep under 26 bytes for speed purposes */
 struct BVHTree {
 	BVHNode **nodes;
@@ -104,11 +135,12 @@ struct BVHTree {
 	axis_t start_axis, stop_axis;  /* bvhtree_kdop_axes array indices according to axis */
 	axis_t axis;                   /* kdop type (6 => OBB, 7 => AABB, ...) */
 	char tree_type;                /* type of tree (4 => quadtree) */
+	BVHTreeWide *wide;             /* for ray-casts, built by the first one, NULL when the bounds don't include X, Y, Z */
 };
 
 /* optimization, ensure we stay small */
-BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 48) ||
-                  (sizeof(void *) == 4 && sizeof(BVHTree) <= 32),
+BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 56) ||
+                  (sizeof(void *) == 4 && sizeof(BVHTree) <= 36),
                   "over sized")
 
 /* avoid duplicating vars in BVHOverlapData_Thread */
@@ -934,6 +966,197 @@ static void non_recursive_bvh_div_nodes(BVHTree *tree, BVHNode *branches_array,
 /** \} */
 
 
+/* -------------------------------------------------------------------- */
+
+/** \name Wide Nodes
+ *
+ * #BVHTreeWide is built from the balanced tree by the first ray-cast,
+ * each #BVHNodeWide holds the children of one #BVHNode
+ * (the grand-children on binary trees, groups of children on trees wider than 4),
+ * so the ray-cast can test 4 bounding boxes with a single SIMD test.
+ *
+ * \{ */
+
+static int bvhtree_wide_node_add(BVHTreeWide *wide)
+{
+	if (wide->totnode == wide->totnode_alloc) {
+		wide->totnode_alloc *= 2;
+		wide->nodes = MEM_reallocN(wide->nodes, sizeof(*wide->nodes) * (size_t)wide->totnode_alloc);
+		wide->nodes_src = MEM_reallocN(wide->nodes_src, sizeof(*wide->nodes_src) * (size_t)(wide->totnode_alloc * 4));
+	}
+	return wide->totnode++;
+}
+
+/* copy the bounds of each child (from the tree node, or the union of the grouped children) */
+static void bvhtree_wide_refit_node(BVHTreeWide *wide, const int index)
+{
+	BVHNodeWide *node = &wide->nodes[index];
+	BVHNode **nodes_src = &wide->nodes_src[index * 4];
+	int c, i, j;
+
+	for (c = 0; c < node->totnode; c++) {
+		if (nodes_src[c]) {
+			for (i = 0; i < 6; i++) {
+				node->bv[i][c] = nodes_src[c]->bv[i];
+			}
+		}
+		else {
+			const BVHNodeWide *child = &wide->nodes[node->child[c]];
+			for (i = 0; i < 6; i += 2) {
+				node->bv[i][c] = child->bv[i][0];
+				node->bv[i + 1][c] = child->bv[i + 1][0];
+				for (j = 1; j < child->totnode; j++) {
+					node->bv[i][c] = min_ff(node->bv[i][c], child->bv[i][j]);
+					node->bv[i + 1][c] = max_ff(node->bv[i + 1][c], child->bv[i + 1][j]);
+				}
+			}
+		}
+	}
+}
+
+static int bvhtree_wide_build_node(
+        BVHTreeWide *wide, BVHNode **children, int children_len, const char main_axis, const int depth)
+{
+	BVHNode *children_expand[4];
+	const int index = bvhtree_wide_node_add(wide);
+	int slots_len, c, i;
+
+	wide->depth = max_ii(wide->depth, depth);
+
+	/* pull the children of branches into the unused slots (binary trees),
+	 * only from branches split on the same axis, so they're still visited in the same order */
+	if (children_len < 4) {
+		memcpy(children_expand, children, sizeof(*children) * (size_t)children_len);
+		for (i = 0; i < children_len; ) {
+			const int totnode = children_expand[i]->totnode;
+			if (totnode != 0 && (children_len - 1 + totnode) <= 4 &&
+			    children_expand[i]->main_axis == main_axis)
+			{
+				BVHNode **grandchildren = children_expand[i]->children;
+				memmove(&children_expand[i + totnode], &children_expand[i + 1],
+				        sizeof(*children_expand) * (size_t)(children_len - (i + 1)));
+				memcpy(&children_expand[i], grandchildren, sizeof(*children_expand) * (size_t)totnode);
+				children_len += totnode - 1;
+				i += totnode;
+			}
+			else {
+				i++;
+			}
+		}
+		children = children_expand;
+	}
+
+	slots_len = min_ii(children_len, 4);
+
+	{
+		BVHNodeWide *node = &wide->nodes[index];
+		for (c = 0; c < 4; c++) {
+			for (i = 0; i < 6; i += 2) {
+				node->bv[i][c] = FLT_MAX;
+				node->bv[i + 1][c] = -FLT_MAX;
+			}
+			node->child[c] = -1;
+			wide->nodes_src[index * 4 + c] = NULL;
+		}
+		node->totnode = (char)slots_len;
+		node->leaf_flag = 0;
+		node->main_axis = main_axis;
+	}
+
+	/* wider trees are split in 4 groups of (ordered) children */
+	for (c = 0; c < slots_len; c++) {
+		const int start = (children_len * c) / slots_len;
+		const int end = (children_len * (c + 1)) / slots_len;
+		int child_index;
+
+		if (end - start == 1) {
+			BVHNode *child = children[start];
+			wide->nodes_src[index * 4 + c] = child;
+			if (child->totnode == 0) {
+				wide->nodes[index].leaf_flag |= (char)(1 << c);
+				child_index = child->index;
+			}
+			else {
+				child_index = bvhtree_wide_build_node(wide, child->children, child->totnode, child->main_axis, depth + 1);
+			}
+		}
+		else {
+			child_index = bvhtree_wide_build_node(wide, &children[start], end - start, main_axis, depth + 1);
+		}
+		/* 'wide->nodes' may have been reallocated */
+		wide->nodes[index].child[c] = child_index;
+	}
+
+	bvhtree_wide_refit_node(wide, index);
+
+	return index;
+}
+
+static BVHTreeWide *bvhtree_wide_build(const BVHTree *tree)
+{
+	BVHNode *root = tree->nodes[tree->totleaf];
+	BVHTreeWide *wide;
+
+	/* the ray-cast only uses the X, Y, Z axes */
+	if (tree->start_axis != 0 || root == NULL || tree->totleaf == 0) {
+		return NULL;
+	}
+
+	wide = MEM_mallocN(sizeof(*wide), __func__);
+	wide->totnode = 0;
+	wide->totnode_alloc = max_ii(1, tree->totbranch);
+	wide->depth = 0;
+	wide->nodes = MEM_mallocN(sizeof(*wide->nodes) * (size_t)wide->totnode_alloc, __func__);
+	wide->nodes_src = MEM_mallocN(sizeof(*wide->nodes_src) * (size_t)(wide->totnode_alloc * 4), __func__);
+
+	bvhtree_wide_build_node(wide, root->children, root->totnode, root->main_axis, 1);
+
+	return wide;
+}
+
+static void bvhtree_wide_refit(BVHTreeWide *wide)
+{
+	int i;
+
+	/* grouped children always come after their parent */
+	for (i = wide->totnode - 1; i >= 0; i--) {
+		bvhtree_wide_refit_node(wide, i);
+	}
+}
+
+static void bvhtree_wide_free(BVHTreeWide *wide)
+{
+	MEM_freeN(wide->nodes);
+	MEM_freeN(wide->nodes_src);
+	MEM_freeN(wide);
+}
+
+/**
+ * Wide nodes are only built for trees that are ray-cast, so trees only used for overlap
+ * or nearest queries (collisions, refit on every step) don't build or refit them.
+ * Ray-casts may run in threads, when more than one builds them only the first is kept.
+ */
+static BVHTreeWide *bvhtree_wide_ensure(BVHTree *tree)
+{
+	BVHTreeWide *wide = tree->wide;
+
+	if (wide == NULL) {
+		wide = bvhtree_wide_build(tree);
+		if (wide) {
+			BVHTreeWide *wide_prev = (BVHTreeWide *)atomic_cas_z((size_t *)&tree->wide, 0, (size_t)wide);
+			if (wide_prev) {
+				bvhtree_wide_free(wide);
+				wide = wide_prev;
+			}
+		}
+	}
+
+	return wide;
+}
+
+/** \} */
+
+
 /* -------------------------------------------------------------------- */
 
 /** \name BLI_bvhtree API
@@ -1033,6 +1256,9 @@ void BLI_bvhtree_free(BVHTree *tree)
 		MEM_freeN(tree->nodearray);
 		MEM_freeN(tree->nodebv);
 		MEM_freeN(tree->nodechild);
+		if (tree->wide) {
+			bvhtree_wide_free(tree->wide);
+		}
 		MEM_freeN(tree);
 	}
 }
@@ -1124,6 +1350,10 @@ void BLI_bvhtree_update_tree(BVHTree *tree)
 
 	for (; index >= root; index--)
 		node_join(tree, *index);
+
+	if (tree->wide) {
+		bvhtree_wide_refit(tree->wide);
+	}
 }
 /**
  * Number of times #BLI_bvhtree_insert has been called.
@@ -1579,6 +1809,7 @@ int BLI_bvhtree_find_nearest(
 /** \name BLI_bvhtree_ray_cast
  *
  * raycast is done by performing a DFS on the BVHTree and saving the closest hit.
+ * When the tree has wide nodes (see #BVHTreeWide) they're used instead of the #BVHNode's.
  *
  * \{ */
 
@@ -1720,6 +1951,229 @@ static void dfs_raycast_all(BVHRayCastData *data, BVHNode *node)
 	}
 }
 
+/**
+ * #fast_ray_nearest_hit for the 4 children of a #BVHNodeWide.
+ *
+ * \return a bit for each child the ray hits closer than the current hit,
+ * the distances are written in \a r_dist.
+ */
+static int wide_ray_nearest_hit(const BVHRayCastData *data, const BVHNodeWide *node, float r_dist[4])
+{
+	const int used = (1 << node->totnode) - 1;
+#ifdef __SSE__
+	const __m128 ox = _mm_set1_ps(data->ray.origin[0]);
+	const __m128 oy = _mm_set1_ps(data->ray.origin[1]);
+	const __m128 oz = _mm_set1_ps(data->ray.origin[2]);
+	const __m128 idx = _mm_set1_ps(data->idot_axis[0]);
+	const __m128 idy = _mm_set1_ps(data->idot_axis[1]);
+	const __m128 idz = _mm_set1_ps(data->idot_axis[2]);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 hit_dist = _mm_set1_ps(data->hit.dist);
+
+	const __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->bv[data->index[0]]), ox), idx);
+	const __m128 t2x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->bv[data->index[1]]), ox), idx);
+	const __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->bv[data->index[2]]), oy), idy);
+	const __m128 t2y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->bv[data->index[3]]), oy), idy);
+	const __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->bv[data->index[4]]), oz), idz);
+	const __m128 t2z = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->bv[data->index[5]]), oz), idz);
+	const __m128 dist = _mm_max_ps(_mm_max_ps(t1x, t1y), t1z);
+
+	/* same tests as 'fast_ray_nearest_hit', written so NaN's don't cause a miss either */
+	__m128 miss;
+	miss = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(t1x, t2y), _mm_cmplt_ps(t2x, t1y)),
+	                 _mm_or_ps(_mm_cmpgt_ps(t1x, t2z), _mm_cmplt_ps(t2x, t1z)));
+	miss = _mm_or_ps(miss, _mm_or_ps(_mm_cmpgt_ps(t1y, t2z), _mm_cmplt_ps(t2y, t1z)));
+	miss = _mm_or_ps(miss, _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(t2x, zero), _mm_cmplt_ps(t2y, zero)),
+	                                 _mm_cmplt_ps(t2z, zero)));
+	miss = _mm_or_ps(miss, _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(t1x, hit_dist), _mm_cmpgt_ps(t1y, hit_dist)),
+	                                 _mm_cmpgt_ps(t1z, hit_dist)));
+	miss = _mm_or_ps(miss, _mm_cmpge_ps(dist, hit_dist));
+
+	_mm_storeu_ps(r_dist, dist);
+
+	return ~_mm_movemask_ps(miss) & used;
+#else
+	int mask = 0;
+	int c;
+
+	for (c = 0; c < node->totnode; c++) {
+		const float t1x = (node->bv[data->index[0]][c] - data->ray.origin[0]) * data->idot_axis[0];
+		const float t2x = (node->bv[data->index[1]][c] - data->ray.origin[0]) * data->idot_axis[0];
+		const float t1y = (node->bv[data->index[2]][c] - data->ray.origin[1]) * data->idot_axis[1];
+		const float t2y = (node->bv[data->index[3]][c] - data->ray.origin[1]) * data->idot_axis[1];
+		const float t1z = (node->bv[data->index[4]][c] - data->ray.origin[2]) * data->idot_axis[2];
+		const float t2z = (node->bv[data->index[5]][c] - data->ray.origin[2]) * data->idot_axis[2];
+
+		if ((t1x > t2y || t2x < t1y || t1x > t2z || t2x < t1z || t1y > t2z || t2y < t1z) ||
+		    (t2x < 0.0f || t2y < 0.0f || t2z < 0.0f) ||
+		    (t1x > data->hit.dist || t1y > data->hit.dist || t1z > data->hit.dist))
+		{
+			continue;
+		}
+
+		r_dist[c] = max_fff(t1x, t1y, t1z);
+		if (!(r_dist[c] >= data->hit.dist)) {
+			mask |= (1 << c);
+		}
+	}
+
+	return mask & used;
+#endif
+}
+
+BLI_INLINE void wide_raycast_leaf(BVHRayCastData *data, const int index, const float dist)
+{
+	if (data->callback) {
+		data->callback(data->userdata, index, &data->ray, &data->hit);
+	}
+	else {
+		data->hit.index = index;
+		data->hit.dist  = dist;
+		madd_v3_v3v3fl(data->hit.co, data->ray.origin, data->ray.direction, dist);
+	}
+}
+
+typedef struct BVHWideStackItem {
+	int index;   /* #BVHTreeWide.nodes index, or the leaf index */
+	float dist;  /* distance to the bounds */
+	bool is_leaf;
+} BVHWideStackItem;
+
+typedef struct BVHWidePacketStackItem {
+	int index;          /* #BVHTreeWide.nodes index, or the leaf index */
+	unsigned int mask;  /* rays which hit the bounds */
+	bool is_leaf;
+	float dist[BVH_RAYCAST_PACKET_SIZE];
+} BVHWidePacketStackItem;
+
+/**
+ * Iterative version of #dfs_raycast using #BVHTreeWide,
+ * children are visited in the same order so the result is the same.
+ */
+static void wide_raycast(const BVHTreeWide *wide, BVHRayCastData *data)
+{
+	/* each node replaces itself by up to 4 children */
+	BVHWideStackItem *stack = BLI_array_alloca(stack, (size_t)((3 * wide->depth) + 1));
+	int stack_len = 0;
+
+	stack[0].index = 0;
+	stack[0].dist = -FLT_MAX;
+	stack[0].is_leaf = false;
+	stack_len = 1;
+
+	while (stack_len) {
+		const BVHWideStackItem item = stack[--stack_len];
+		const BVHNodeWide *node;
+		float dist[4];
+		int hit, c;
+
+		/* the hit may have got closer since the bounds were tested */
+		if (item.dist >= data->hit.dist) {
+			continue;
+		}
+
+		if (item.is_leaf) {
+			wide_raycast_leaf(data, item.index, item.dist);
+			continue;
+		}
+
+		node = &wide->nodes[item.index];
+		hit = wide_ray_nearest_hit(data, node, dist);
+
+		/* push in the reverse order of the traversal (based on ray direction and split axis) */
+		for (c = 0; c < node->totnode; c++) {
+			const int c_push = (data->ray_dot_axis[(int)node->main_axis] > 0.0f) ? (node->totnode - 1 - c) : c;
+			if (hit & (1 << c_push)) {
+				BVHWideStackItem *item_push = &stack[stack_len++];
+				item_push->index = node->child[c_push];
+				item_push->dist = dist[c_push];
+				item_push->is_leaf = (node->leaf_flag & (1 << c_push)) != 0;
+			}
+		}
+	}
+}
+
+/**
+ * Traverse the tree with a packet of rays, each node is only visited once for all rays that hit its bounds.
+ *
+ * Every ray visits the children in the same order as #wide_raycast (leaves included),
+ * rays going in opposite directions along the split axis are pushed separately.
+ */
+static void wide_raycast_packet(const BVHTreeWide *wide, BVHRayCastData *rays, const int rays_num)
+{
+	/* each node replaces itself by up to 4 children, for each of the 2 directions */
+	BVHWidePacketStackItem *stack = BLI_array_alloca(stack, (size_t)((7 * wide->depth) + 1));
+	int stack_len = 0;
+	int r;
+
+	BLI_assert(rays_num <= BVH_RAYCAST_PACKET_SIZE);
+
+	stack[0].index = 0;
+	stack[0].mask = (1u << rays_num) - 1u;
+	stack[0].is_leaf = false;
+	for (r = 0; r < rays_num; r++) {
+		stack[0].dist[r] = -FLT_MAX;
+	}
+	stack_len = 1;
+
+	while (stack_len) {
+		const BVHWidePacketStackItem *item = &stack[--stack_len];
+		const BVHNodeWide *node;
+		/* rays which traverse the children forwards [0] or backwards [1], for each child */
+		unsigned int child_mask[2][4] = {{0}};
+		float child_dist[4][BVH_RAYCAST_PACKET_SIZE];
+		unsigned int mask;
+		int c, d;
+
+		if (item->is_leaf) {
+			for (r = 0, mask = item->mask; mask; r++, mask >>= 1) {
+				/* the hit may have got closer since the bounds were tested */
+				if ((mask & 1u) && (item->dist[r] < rays[r].hit.dist)) {
+					wide_raycast_leaf(&rays[r], item->index, item->dist[r]);
+				}
+			}
+			continue;
+		}
+
+		node = &wide->nodes[item->index];
+
+		for (r = 0, mask = item->mask; mask; r++, mask >>= 1) {
+			BVHRayCastData *data = &rays[r];
+			float dist[4];
+			int hit;
+
+			if (((mask & 1u) == 0) || (item->dist[r] >= data->hit.dist)) {
+				continue;
+			}
+
+			hit = wide_ray_nearest_hit(data, node, dist);
+			d = (data->ray_dot_axis[(int)node->main_axis] > 0.0f) ? 0 : 1;
+
+			for (c = 0; c < node->totnode; c++) {
+				if (hit & (1 << c)) {
+					child_mask[d][c] |= (1u << r);
+					child_dist[c][r] = dist[c];
+				}
+			}
+		}
+
+		/* 'item' is overwritten from here on,
+		 * push in the reverse order of the traversal (based on ray direction and split axis) */
+		for (d = 0; d < 2; d++) {
+			for (c = 0; c < node->totnode; c++) {
+				const int c_push = (d == 0) ? (node->totnode - 1 - c) : c;
+				if (child_mask[d][c_push]) {
+					BVHWidePacketStackItem *item_push = &stack[stack_len++];
+					item_push->index = node->child[c_push];
+					item_push->mask = child_mask[d][c_push];
+					item_push->is_leaf = (node->leaf_flag & (1 << c_push)) != 0;
+					memcpy(item_push->dist, child_dist[c_push], sizeof(float) * (size_t)rays_num);
+				}
+			}
+		}
+	}
+}
+
 #if 0
 static void iterative_raycast(BVHRayCastData *data, BVHNode *node)
 {
@@ -1786,6 +2240,7 @@ int BLI_bvhtree_ray_cast_ex(
 {
 	BVHRayCastData data;
 	BVHNode *root = tree->nodes[tree->totleaf];
+	BVHTreeWide *wide;
 
 	BLI_ASSERT_UNIT_V3(dir);
 
@@ -1808,7 +2263,10 @@ int BLI_bvhtree_ray_cast_ex(
 		data.hit.dist = BVH_RAYCAST_DIST_MAX;
 	}
 
-	if (root) {
+	if (radius == 0.0f && (wide = bvhtree_wide_ensure(tree))) {
+		wide_raycast(wide, &data);
+	}
+	else if (root) {
 		dfs_raycast(&data, root);
 //		iterative_raycast(&data, root);
 	}
@@ -1827,6 +2285,73 @@ int BLI_bvhtree_ray_cast(
 	return BLI_bvhtree_ray_cast_ex(tree, co, dir, radius, hit, callback, userdata, BVH_RAYCAST_DEFAULT);
 }
 
+/**
+ * Ray-cast many rays, coherent rays (starting close to each other, in similar directions)
+ * are traversed together, a node is only loaded once for all rays of a packet.
+ *
+ * \param hits: One hit for each ray, initialized as for #BLI_bvhtree_ray_cast
+ * (index -1 and dist #BVH_RAYCAST_DIST_MAX when there is no limit).
+ * \return the number of rays which hit.
+ *
+ * \note The callback is called for all rays of a packet, so it must not depend on the order of the rays.
+ */
+int BLI_bvhtree_ray_cast_packet(
+        BVHTree *tree, const float (*co)[3], const float (*dir)[3], const int rays_num, float radius,
+        BVHTreeRayHit *hits, BVHTree_RayCastCallback callback, void *userdata,
+        int flag)
+{
+	BVHTreeWide *wide;
+	int hit_num = 0;
+	int i;
+
+	if (radius == 0.0f && (wide = bvhtree_wide_ensure(tree))) {
+		BVHRayCastData rays[BVH_RAYCAST_PACKET_SIZE];
+		int start;
+
+		for (start = 0; start < rays_num; start += BVH_RAYCAST_PACKET_SIZE) {
+			const int packet_len = min_ii(rays_num - start, BVH_RAYCAST_PACKET_SIZE);
+
+			for (i = 0; i < packet_len; i++) {
+				BVHRayCastData *data = &rays[i];
+
+				BLI_ASSERT_UNIT_V3(dir[start + i]);
+
+				data->tree = tree;
+
+				data->callback = callback;
+				data->userdata = userdata;
+
+				copy_v3_v3(data->ray.origin,    co[start + i]);
+				copy_v3_v3(data->ray.direction, dir[start + i]);
+				data->ray.radius = radius;
+
+				bvhtree_ray_cast_data_precalc(data, flag);
+
+				memcpy(&data->hit, &hits[start + i], sizeof(data->hit));
+			}
+
+			wide_raycast_packet(wide, rays, packet_len);
+
+			for (i = 0; i < packet_len; i++) {
+				memcpy(&hits[start + i], &rays[i].hit, sizeof(rays[i].hit));
+			}
+		}
+	}
+	else {
+		for (i = 0; i < rays_num; i++) {
+			BLI_bvhtree_ray_cast_ex(tree, co[i], dir[i], radius, &hits[i], callback, userdata, flag);
+		}
+	}
+
+	for (i = 0; i < rays_num; i++) {
+		if (hits[i].index != -1) {
+			hit_num++;
+		}
+	}
+
+	return hit_num;
+}
+
 float BLI_bvhtree_bb_raycast(const float bv[6], const float light_start[3], const float light_end[3], float pos[3])
 {
 	BVHRayCastData data;
@@ -33,25 +33,42 @@
  *  \ingroup blenloader
  */
 
+struct MemFileSegment;
+struct MemFileWriteData;
+
 typedef struct {
 	void *next, *prev;
 	
+	/* only set while writing, and while the file is expanded for reading */
 	char *buf;
-	unsigned int ident, size;
+	unsigned int size;
 	
+	/* de-duplicated contents, may be shared with the chunks of other undo steps */
+	struct MemFileSegment *segment;
 } MemFileChunk;
 
 typedef struct MemFile {
 	ListBase chunks;
+	/* total size, including segments shared with the previous step */
 	unsigned int size;
+	/* size of the data written for this step, without shared segments */
+	unsigned int size_written;
 } MemFile;
 
 /* actually only used writefile.c */
-extern void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsigned int size);
+extern struct MemFileWriteData *memfile_write_begin(MemFile *current, MemFile *compare);
+extern bool memfile_write_segment(
+        struct MemFileWriteData *mwd, const void *key,
+        const void *head, unsigned int head_size, bool changed);
+extern void memfile_chunk_add(struct MemFileWriteData *mwd, const char *buf, unsigned int size);
+extern void memfile_write_end(struct MemFileWriteData *mwd);
 
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
 extern void BLO_memfile_merge(MemFile *first, MemFile *second);
+extern void BLO_memfile_expand(MemFile *memfile);
+extern void BLO_memfile_expand_free(MemFile *memfile);
+extern void BLO_memfile_calc_memory_usage(size_t *r_size_expanded, size_t *r_size_compacted);
 
 #endif
 
@@ -368,6 +368,8 @@ BlendFileData *BLO_read_from_memfile(Main *oldmain, const char *filename, MemFil
 	FileData *fd;
 	ListBase old_mainlist;
 	
+	BLO_memfile_expand(memfile);
+
 	fd = blo_openblendermemfile(memfile, reports);
 	if (fd) {
 		fd->reports = reports;
@@ -445,6 +447,8 @@ BlendFileData *BLO_read_from_memfile(Main *oldmain, const char *filename, MemFil
 		blo_freefiledata(fd);
 	}
 
+	BLO_memfile_expand_free(memfile);
+
 	return bfd;
 }
 
@@ -8102,7 +8102,9 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short
 	if (!id)
 		return blo_nextbhead(fd, bhead);
 	
-	id->tag = tag | LIB_TAG_NEED_LINK;
+	/* also when appending or linking into an existing main, so the next undo
+	 * step doesn't share data of a freed datablock at the same address */
+	id->tag = tag | LIB_TAG_NEED_LINK | LIB_TAG_UNDO_CHANGED;
 	id->lib = main->curlib;
 	id->us = ID_FAKE_USERS(id);
 	id->icon_id = 0;
@@ -9846,7 +9848,7 @@ static ID *create_placeholder(Main *mainvar, const short idcode, const char *idn
 	BLI_strncpy(ph_id->name + 2, idname, sizeof(ph_id->name) - 2);
 	BKE_libblock_init_empty(ph_id);
 	ph_id->lib = mainvar->curlib;
-	ph_id->tag = tag | LIB_TAG_MISSING;
+	ph_id->tag = tag | LIB_TAG_MISSING | LIB_TAG_UNDO_CHANGED;
 	ph_id->us = ID_FAKE_USERS(ph_id);
 	ph_id->icon_id = 0;
 
@@ -40,83 +40,304 @@
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_array_store.h"
+#include "BLI_ghash.h"
 
 #include "BLO_undofile.h"
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+/* Undo steps are written in segments, one for each datablock and one for the
+ * data before and after them. Segments are stored in an array store, using the
+ * segment of the same datablock in the previous step as reference, so only the
+ * parts that changed take up memory. Segments of datablocks that didn't change
+ * at all are shared with the previous step without writing them again. */
+
+/* bytes per chunk of the array store, check on best size later... */
+#define MEMFILE_CHUNK_SIZE 4096
+
+typedef struct MemFileSegment {
+	BArrayState *state;
+	unsigned int size;
+	int users;
+
+	/* identifies the segment in the next step, the address of the datablock */
+	const void *key;
+	/* the datablock struct itself, to check it didn't change */
+	void *head;
+	unsigned int head_size;
+} MemFileSegment;
+
+typedef struct MemFileWriteData {
+	MemFile *current;
+
+	/* segments of the previous step, by key */
+	GHash *compare_segments;
+
+	/* segment being written, its data are the chunks from 'segment_first' on */
+	bool segment_open;
+	const void *segment_key;
+	void *segment_head;
+	unsigned int segment_head_size;
+	MemFileChunk *segment_first;
+} MemFileWriteData;
+
+static struct {
+	BArrayStore *bs;
+	int users;
+} memfile_store = {NULL};
+
+static void memfile_segment_free(MemFileSegment *segment)
+{
+	BLI_array_store_state_remove(memfile_store.bs, segment->state);
+	if (segment->head) {
+		MEM_freeN(segment->head);
+	}
+	MEM_freeN(segment);
+
+	memfile_store.users -= 1;
+	BLI_assert(memfile_store.users >= 0);
+
+	if (memfile_store.users == 0) {
+		BLI_array_store_destroy(memfile_store.bs);
+		memfile_store.bs = NULL;
+	}
+}
+
 /* not memfile itself */
 void BLO_memfile_free(MemFile *memfile)
 {
 	MemFileChunk *chunk;
 	
 	while ((chunk = BLI_pophead(&memfile->chunks))) {
-		if (chunk->ident == 0)
+		if (chunk->buf) {
 			MEM_freeN(chunk->buf);
+		}
+		if (chunk->segment && --chunk->segment->users == 0) {
+			memfile_segment_free(chunk->segment);
+		}
 		MEM_freeN(chunk);
 	}
 	memfile->size = 0;
+	memfile->size_written = 0;
 }
 
 /* to keep list of memfiles consistent, 'first' is always first in list */
 /* result is that 'first' is being freed */
-void BLO_memfile_merge(MemFile *first, MemFile *second)
+void BLO_memfile_merge(MemFile *first, MemFile *UNUSED(second))
 {
-	MemFileChunk *fc, *sc;
-	
-	fc = first->chunks.first;
-	sc = second->chunks.first;
-	while (fc || sc) {
-		if (fc && sc) {
-			if (sc->ident) {
-				sc->ident = 0;
-				fc->ident = 1;
-			}
+	/* segments are reference counted, 'second' keeps what it shares with 'first' */
+	BLO_memfile_free(first);
+}
+
+/**
+ * Restore the data of all chunks, so the memfile can be read from.
+ * Free them again with #BLO_memfile_expand_free.
+ */
+void BLO_memfile_expand(MemFile *memfile)
+{
+	MemFileChunk *chunk;
+	size_t size;
+
+	for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
+		if (chunk->buf == NULL) {
+			chunk->buf = BLI_array_store_state_data_get_alloc(chunk->segment->state, &size);
+			BLI_assert(size == chunk->size);
 		}
-		if (fc) fc = fc->next;
-		if (sc) sc = sc->next;
 	}
-	
-	BLO_memfile_free(first);
 }
 
-void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsigned int size)
+void BLO_memfile_expand_free(MemFile *memfile)
 {
-	static MemFileChunk *compchunk = NULL;
-	MemFileChunk *curchunk;
-	
-	/* this function inits when compare != NULL or when current == NULL  */
+	MemFileChunk *chunk;
+
+	for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
+		if (chunk->buf) {
+			MEM_freeN(chunk->buf);
+			chunk->buf = NULL;
+		}
+	}
+}
+
+void BLO_memfile_calc_memory_usage(size_t *r_size_expanded, size_t *r_size_compacted)
+{
+	if (memfile_store.bs) {
+		*r_size_expanded = BLI_array_store_calc_size_expanded_get(memfile_store.bs);
+		*r_size_compacted = BLI_array_store_calc_size_compacted_get(memfile_store.bs);
+	}
+	else {
+		*r_size_expanded = *r_size_compacted = 0;
+	}
+}
+
+/* ********************************** writing ********************************** */
+
+/**
+ * \param compare: The previous undo step, to share unchanged data with (can be NULL).
+ */
+MemFileWriteData *memfile_write_begin(MemFile *current, MemFile *compare)
+{
+	MemFileWriteData *mwd = MEM_callocN(sizeof(MemFileWriteData), __func__);
+	MemFileChunk *chunk;
+
+	mwd->current = current;
+	mwd->compare_segments = BLI_ghash_ptr_new(__func__);
+
 	if (compare) {
-		compchunk = compare->chunks.first;
+		for (chunk = compare->chunks.first; chunk; chunk = chunk->next) {
+			if (chunk->segment) {
+				BLI_ghash_reinsert(mwd->compare_segments, (void *)chunk->segment->key, chunk->segment, NULL, NULL);
+			}
+		}
+	}
+
+	/* data written before the first datablock */
+	memfile_write_segment(mwd, NULL, NULL, 0, true);
+
+	return mwd;
+}
+
+/* move the chunks of the open segment into the array store */
+static void memfile_segment_close(MemFileWriteData *mwd)
+{
+	MemFile *current = mwd->current;
+	MemFileChunk *chunk, *chunk_next;
+	MemFileSegment *segment, *segment_reference;
+	char *data, *data_iter;
+	unsigned int size = 0;
+
+	if (!mwd->segment_open) {
 		return;
 	}
-	if (current == NULL) {
-		compchunk = NULL;
+	mwd->segment_open = false;
+
+	if (mwd->segment_first == NULL) {
+		if (mwd->segment_head) {
+			MEM_freeN(mwd->segment_head);
+		}
 		return;
 	}
-	
-	curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
-	curchunk->size = size;
-	curchunk->buf = NULL;
-	curchunk->ident = 0;
-	BLI_addtail(&current->chunks, curchunk);
-	
-	/* we compare compchunk with buf */
-	if (compchunk) {
-		if (compchunk->size == curchunk->size) {
-			if (memcmp(compchunk->buf, buf, size) == 0) {
-				curchunk->buf = compchunk->buf;
-				curchunk->ident = 1;
-			}
+
+	for (chunk = mwd->segment_first; chunk; chunk = chunk->next) {
+		size += chunk->size;
+	}
+
+	data = data_iter = MEM_mallocN(size, __func__);
+
+	for (chunk = mwd->segment_first; chunk; chunk = chunk_next) {
+		chunk_next = chunk->next;
+
+		memcpy(data_iter, chunk->buf, chunk->size);
+		data_iter += chunk->size;
+
+		if (chunk != mwd->segment_first) {
+			BLI_remlink(&current->chunks, chunk);
+			MEM_freeN(chunk->buf);
+			MEM_freeN(chunk);
 		}
-		compchunk = compchunk->next;
 	}
-	
-	/* not equal... */
-	if (curchunk->buf == NULL) {
-		curchunk->buf = MEM_mallocN(size, "Chunk buffer");
-		memcpy(curchunk->buf, buf, size);
-		current->size += size;
+
+	if (memfile_store.bs == NULL) {
+		memfile_store.bs = BLI_array_store_create(1, MEMFILE_CHUNK_SIZE);
+	}
+
+	segment_reference = BLI_ghash_lookup(mwd->compare_segments, mwd->segment_key);
+
+	segment = MEM_callocN(sizeof(MemFileSegment), "MemFileSegment");
+	segment->state = BLI_array_store_state_add(
+	        memfile_store.bs, data, size,
+	        segment_reference ? segment_reference->state : NULL);
+	segment->size = size;
+	segment->users = 1;
+	segment->key = mwd->segment_key;
+	segment->head = mwd->segment_head;
+	segment->head_size = mwd->segment_head_size;
+	memfile_store.users += 1;
+
+	MEM_freeN(data);
+
+	/* the first chunk of the segment represents all of it */
+	chunk = mwd->segment_first;
+	MEM_freeN(chunk->buf);
+	chunk->buf = NULL;
+	chunk->size = size;
+	chunk->segment = segment;
+
+	mwd->segment_first = NULL;
+	mwd->segment_head = NULL;
+}
+
+/**
+ * Ends the segment being written, and starts the next one.
+ *
+ * \param key: Identifies the segment in the next step, the address of the datablock,
+ * or any other address that stays the same for data outside of datablocks.
+ * \param head: The datablock struct, the segment is only shared when it didn't change.
+ * \param changed: Whether the datablock was tagged as changed.
+ * \return true when the segment of the previous step was shared,
+ * the data of the datablock must not be written then.
+ */
+bool memfile_write_segment(
+        MemFileWriteData *mwd, const void *key,
+        const void *head, unsigned int head_size, bool changed)
+{
+	MemFileSegment *segment_prev;
+
+	memfile_segment_close(mwd);
+
+	segment_prev = BLI_ghash_lookup(mwd->compare_segments, key);
+
+	if (!changed && segment_prev && head &&
+	    (segment_prev->head_size == head_size) &&
+	    (memcmp(segment_prev->head, head, head_size) == 0))
+	{
+		MemFileChunk *chunk = MEM_callocN(sizeof(MemFileChunk), "MemFileChunk");
+		chunk->size = segment_prev->size;
+		chunk->segment = segment_prev;
+		segment_prev->users += 1;
+
+		BLI_addtail(&mwd->current->chunks, chunk);
+		mwd->current->size += chunk->size;
+
+		return true;
+	}
+
+	mwd->segment_open = true;
+	mwd->segment_key = key;
+	mwd->segment_head = NULL;
+	mwd->segment_head_size = head_size;
+	if (head) {
+		mwd->segment_head = MEM_mallocN(head_size, "MemFileSegment head");
+		memcpy(mwd->segment_head, head, head_size);
+	}
+
+	return false;
+}
+
+void memfile_chunk_add(MemFileWriteData *mwd, const char *buf, unsigned int size)
+{
+	MemFileChunk *curchunk;
+
+	BLI_assert(mwd->segment_open);
+
+	curchunk = MEM_callocN(sizeof(MemFileChunk), "MemFileChunk");
+	curchunk->size = size;
+	curchunk->buf = MEM_mallocN(size, "Chunk buffer");
+	memcpy(curchunk->buf, buf, size);
+	BLI_addtail(&mwd->current->chunks, curchunk);
+
+	if (mwd->segment_first == NULL) {
+		mwd->segment_first = curchunk;
 	}
+
+	mwd->current->size += size;
+	mwd->current->size_written += size;
 }
 
+void memfile_write_end(MemFileWriteData *mwd)
+{
+	memfile_segment_close(mwd);
+
+	BLI_ghash_free(mwd->compare_segments, NULL, NULL);
+	MEM_freeN(mwd);
+}
@@ -307,7 +307,10 @@ typedef struct {
 	const struct SDNA *sdna;
 
 	unsigned char *buf;
-	MemFile *compare, *current;
+	MemFile *current;
+	/* only for undo, see memfile_write_segment */
+	struct MemFileWriteData *mwd;
+	bool skip_segment;
 
 	int tot, count;
 	bool error;
@@ -347,7 +350,7 @@ static void writedata_do_write(WriteData *wd, const void *mem, int memlen)
 
 	/* memory based save */
 	if (wd->current) {
-		memfile_chunk_add(NULL, wd->current, mem, memlen);
+		memfile_chunk_add(wd->mwd, mem, memlen);
 	}
 	else {
 		if (wd->ww->write(wd->ww, mem, memlen) != memlen) {
@@ -384,7 +387,7 @@ static void mywrite_flush(WriteData *wd)
  */
 static void mywrite(WriteData *wd, const void *adr, int len)
 {
-	if (UNLIKELY(wd->error)) {
+	if (UNLIKELY(wd->error || wd->skip_segment)) {
 		return;
 	}
 
@@ -424,6 +427,40 @@ static void mywrite(WriteData *wd, const void *adr, int len)
 	wd->count += len;
 }
 
+/**
+ * Start a new segment of undo data, which may be shared with the previous undo step.
+ * When it is, nothing is written until the next segment starts.
+ */
+static void mywrite_segment_begin(
+        WriteData *wd, const void *key,
+        const void *head, int head_len, bool changed)
+{
+	/* buffered data belongs to the previous segment */
+	wd->skip_segment = false;
+	mywrite_flush(wd);
+
+	wd->skip_segment = memfile_write_segment(wd->mwd, key, head, head_len, changed);
+}
+
+/**
+ * Undo writes each datablock as its own segment. The segments of types that are
+ * reliably tagged when their data changes are shared with the previous undo step
+ * when they were not tagged, these are the types which hold most of the data.
+ */
+static void mywrite_id_begin(WriteData *wd, const void *adr, const void *data, int len)
+{
+	ID *id = (ID *)adr;
+	const bool changed = ((id->tag & LIB_TAG_UNDO_CHANGED) ||
+	                      !ELEM(GS(id->name), ID_ME, ID_CU, ID_MB, ID_LT, ID_KE));
+
+	/* also clear it in the copy that is written, if any, so it doesn't make
+	 * the datablock look changed in the next step */
+	id->tag &= ~LIB_TAG_UNDO_CHANGED;
+	((ID *)data)->tag &= ~LIB_TAG_UNDO_CHANGED;
+
+	mywrite_segment_begin(wd, adr, data, len, changed);
+}
+
 /**
  * BeGiN initializer for mywrite
  * \param ww: File write wrapper.
@@ -439,10 +476,10 @@ static WriteData *bgnwrite(WriteWrap *ww, MemFile *compare, MemFile *current)
 		return NULL;
 	}
 
-	wd->compare = compare;
 	wd->current = current;
-	/* this inits comparing */
-	memfile_chunk_add(compare, NULL, NULL, 0);
+	if (current) {
+		wd->mwd = memfile_write_begin(current, compare);
+	}
 
 	return wd;
 }
@@ -460,6 +497,10 @@ static bool endwrite(WriteData *wd)
 		wd->count = 0;
 	}
 
+	if (wd->mwd) {
+		memfile_write_end(wd->mwd);
+	}
+
 	const bool err = wd->error;
 	writedata_free(wd);
 
@@ -495,6 +536,10 @@ static void writestruct_at_address_nr(
 		return;
 	}
 
+	if (wd->mwd && BKE_idcode_is_valid(filecode)) {
+		mywrite_id_begin(wd, adr, data, bh.len);
+	}
+
 	mywrite(wd, &bh, sizeof(BHead));
 	mywrite(wd, data, bh.len);
 }
@@ -4105,6 +4150,11 @@ static bool write_file_handle(
 	/* So changes above don't cause a 'DNA1' to be detected as changed on undo. */
 	mywrite_flush(wd);
 
+	if (wd->mwd) {
+		/* the DNA is borrowed, so its address is the same for every undo step */
+		mywrite_segment_begin(wd, wd->sdna->data, NULL, 0, true);
+	}
+
 	if (write_flags & G_FILE_USERPREFS) {
 		write_userdef(wd);
 	}
@@ -41,6 +41,7 @@
 #include "BLI_polyfill2d.h"
 #include "BLI_polyfill2d_beautify.h"
 #include "BLI_stackdefines.h"
+#include "BLI_task.h"
 
 
 #include "BKE_customdata.h"
@@ -73,6 +74,16 @@
 #define OPTIMIZE_EPS 1e-8
 #define COST_INVALID FLT_MAX
 
+/* below this many edges, evaluate without threads */
+#define DECIM_THREADED_LIMIT 1024
+
+// #define DEBUG_TIME
+
+#ifdef DEBUG_TIME
+#  include "PIL_time.h"
+#  include "PIL_time_utildefines.h"
+#endif
+
 typedef enum CD_UseFlag {
 	CD_DO_VERT = (1 << 0),
 	CD_DO_EDGE = (1 << 1),
@@ -248,23 +259,24 @@ static float bm_decim_build_edge_cost_single__topology(BMEdge *e)
 
 #endif  /* USE_TOPOLOGY_FALLBACK */
 
-static void bm_decim_build_edge_cost_single(
+/**
+ * Calculate the collapse cost of \a e, doesn't change the mesh or the heap.
+ *
+ * \return false when the edge can't be collapsed.
+ */
+static bool bm_decim_calc_edge_cost(
         BMEdge *e,
         const Quadric *vquadrics,
         const float *vweights, const float vweight_factor,
-        Heap *eheap, HeapNode **eheap_table)
+        float *r_cost)
 {
 	float cost;
 
-	if (eheap_table[BM_elem_index_get(e)]) {
-		BLI_heap_remove(eheap, eheap_table[BM_elem_index_get(e)]);
-	}
-
 	if (UNLIKELY(vweights &&
 	             ((vweights[BM_elem_index_get(e->v1)] == 0.0f) ||
 	              (vweights[BM_elem_index_get(e->v2)] == 0.0f))))
 	{
-		goto clear;
+		return false;
 	}
 
 	/* check we can collapse, some edges we better not touch */
@@ -274,7 +286,7 @@ static void bm_decim_build_edge_cost_single(
 		}
 		else {
 			/* only collapse tri's */
-			goto clear;
+			return false;
 		}
 	}
 	else if (BM_edge_is_manifold(e)) {
@@ -283,11 +295,11 @@ static void bm_decim_build_edge_cost_single(
 		}
 		else {
 			/* only collapse tri's */
-			goto clear;
+			return false;
 		}
 	}
 	else {
-		goto clear;
+		return false;
 	}
 	/* end sanity check */
 
@@ -341,11 +353,28 @@ static void bm_decim_build_edge_cost_single(
 		}
 	}
 
-	eheap_table[BM_elem_index_get(e)] = BLI_heap_insert(eheap, cost, e);
-	return;
+	*r_cost = cost;
+	return true;
+}
+
+static void bm_decim_build_edge_cost_single(
+        BMEdge *e,
+        const Quadric *vquadrics,
+        const float *vweights, const float vweight_factor,
+        Heap *eheap, HeapNode **eheap_table)
+{
+	float cost;
+
+	if (eheap_table[BM_elem_index_get(e)]) {
+		BLI_heap_remove(eheap, eheap_table[BM_elem_index_get(e)]);
+	}
 
-clear:
-	eheap_table[BM_elem_index_get(e)] = NULL;
+	if (bm_decim_calc_edge_cost(e, vquadrics, vweights, vweight_factor, &cost)) {
+		eheap_table[BM_elem_index_get(e)] = BLI_heap_insert(eheap, cost, e);
+	}
+	else {
+		eheap_table[BM_elem_index_get(e)] = NULL;
+	}
 }
 
 
@@ -359,20 +388,82 @@ static void bm_decim_invalid_edge_cost_single(
 	eheap_table[BM_elem_index_get(e)] = BLI_heap_insert(eheap, COST_INVALID, e);
 }
 
+/* Edge costs are calculated in threads, then added to the heap in order */
+typedef struct DecimEdgeCost {
+	BMEdge *e;
+	float cost;
+	bool is_valid;
+} DecimEdgeCost;
+
+typedef struct DecimEdgeCostData {
+	DecimEdgeCost *ecosts;
+	const Quadric *vquadrics;
+	const float *vweights;
+	float vweight_factor;
+} DecimEdgeCostData;
+
+static void bm_decim_calc_edge_cost_cb(void *userdata, const int index)
+{
+	DecimEdgeCostData *data = userdata;
+	DecimEdgeCost *ecost = &data->ecosts[index];
+
+	ecost->is_valid = bm_decim_calc_edge_cost(
+	        ecost->e, data->vquadrics, data->vweights, data->vweight_factor, &ecost->cost);
+}
+
+/**
+ * Update the heap with the costs of \a ecosts,
+ * the same edge may be included more than once.
+ */
+static void bm_decim_build_edge_cost_array(
+        DecimEdgeCost *ecosts, const int ecosts_len,
+        const Quadric *vquadrics,
+        const float *vweights, const float vweight_factor,
+        Heap *eheap, HeapNode **eheap_table)
+{
+	DecimEdgeCostData data = {
+		.ecosts = ecosts,
+		.vquadrics = vquadrics,
+		.vweights = vweights,
+		.vweight_factor = vweight_factor,
+	};
+	int i;
+
+	BLI_task_parallel_range(
+	        0, ecosts_len, &data, bm_decim_calc_edge_cost_cb,
+	        ecosts_len > DECIM_THREADED_LIMIT);
+
+	for (i = 0; i < ecosts_len; i++) {
+		DecimEdgeCost *ecost = &ecosts[i];
+		const int e_index = BM_elem_index_get(ecost->e);
+
+		if (eheap_table[e_index]) {
+			BLI_heap_remove(eheap, eheap_table[e_index]);
+		}
+
+		eheap_table[e_index] = ecost->is_valid ? BLI_heap_insert(eheap, ecost->cost, ecost->e) : NULL;
+	}
+}
+
 static void bm_decim_build_edge_cost(
         BMesh *bm,
         const Quadric *vquadrics,
         const float *vweights, const float vweight_factor,
         Heap *eheap, HeapNode **eheap_table)
 {
+	DecimEdgeCost *ecosts = MEM_mallocN(sizeof(*ecosts) * bm->totedge, __func__);
 	BMIter iter;
 	BMEdge *e;
 	unsigned int i;
 
 	BM_ITER_MESH_INDEX (e, &iter, bm, BM_EDGES_OF_MESH, i) {
 		eheap_table[i] = NULL;  /* keep sanity check happy */
-		bm_decim_build_edge_cost_single(e, vquadrics, vweights, vweight_factor, eheap, eheap_table);
+		ecosts[i].e = e;
 	}
+
+	bm_decim_build_edge_cost_array(ecosts, bm->totedge, vquadrics, vweights, vweight_factor, eheap, eheap_table);
+
+	MEM_freeN(ecosts);
 }
 
 #ifdef USE_SYMMETRY
@@ -1148,7 +1239,8 @@ static bool bm_decim_edge_collapse(
         int *edge_symmetry_map,
 #endif
         const CD_UseFlag customdata_flag,
-        float optimize_co[3], bool optimize_co_calc
+        float optimize_co[3], bool optimize_co_calc,
+        const bool update_cost
         )
 {
 	int e_clear_other[2];
@@ -1237,6 +1329,10 @@ static bool bm_decim_edge_collapse(
 		BM_vert_normal_update(v_other);
 #endif
 
+		if (update_cost == false) {
+			/* the caller updates the costs of the surrounding edges, see #bm_decim_vert_cost_edges */
+			return true;
+		}
 
 		/* update error costs and the eheap */
 		if (LIKELY(v_other->e)) {
@@ -1283,6 +1379,277 @@ static bool bm_decim_edge_collapse(
 }
 
 
+/* Batched Edge Collapse
+ * ********************* */
+
+/**
+ * Collapsing an edge only changes the geometry around its two vertices,
+ * so edges which one-rings don't share any vertex can't influence each other.
+ *
+ * Each round takes the cheapest edges from the heap, keeps the ones that are independent,
+ * checks them for degenerate results in threads, then collapses them in order of their cost.
+ * The costs of the edges around the collapsed edges are calculated in threads afterwards.
+ *
+ * The larger a round, the further the collapse order is from the one edge at a time method.
+ */
+
+typedef struct DecimBatchEdge {
+	BMEdge *e;
+	BMVert *v_other;  /* the vertex kept by the collapse */
+	float cost;
+	float optimize_co[3];
+	bool is_valid;
+} DecimBatchEdge;
+
+typedef struct DecimBatchData {
+	DecimBatchEdge *batch;
+	const Quadric *vquadrics;
+} DecimBatchData;
+
+/**
+ * Lock the vertices of the one-rings of \a e's vertices,
+ * unless one of them has already been locked by another edge of this round.
+ */
+static bool bm_decim_edge_ring_lock(BMEdge *e, int *vert_lock, const int lock_id)
+{
+	int pass, i;
+
+	for (pass = 0; pass < 2; pass++) {
+		for (i = 0; i < 2; i++) {
+			BMVert *v = *((&e->v1) + i);
+			BMEdge *e_iter, *e_first;
+
+			e_iter = e_first = v->e;
+			do {
+				BMVert *v_iter = BM_edge_other_vert(e_iter, v);
+				if (pass == 0) {
+					if (vert_lock[BM_elem_index_get(v_iter)] == lock_id) {
+						return false;
+					}
+				}
+				else {
+					vert_lock[BM_elem_index_get(v_iter)] = lock_id;
+				}
+			} while ((e_iter = bmesh_disk_edge_next(e_iter, v)) != e_first);
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Edges which costs depend on the position of \a v, the same edges
+ * #bm_decim_edge_collapse updates (pass NULL \a ecosts to count them).
+ */
+static int bm_decim_vert_cost_edges(BMVert *v, DecimEdgeCost *ecosts)
+{
+	int ecosts_len = 0;
+
+	if (LIKELY(v->e)) {
+		BMEdge *e_iter;
+		BMEdge *e_first;
+		e_iter = e_first = v->e;
+		do {
+			if (ecosts) {
+				ecosts[ecosts_len].e = e_iter;
+			}
+			ecosts_len++;
+		} while ((e_iter = bmesh_disk_edge_next(e_iter, v)) != e_first);
+	}
+
+	{
+		BMIter liter;
+		BMLoop *l;
+		BM_ITER_ELEM (l, &liter, v, BM_LOOPS_OF_VERT) {
+			if (l->f->len == 3) {
+				if (ecosts) {
+					ecosts[ecosts_len].e = BM_vert_in_edge(l->prev->e, l->v) ? l->next->e : l->prev->e;
+				}
+				ecosts_len++;
+			}
+		}
+	}
+
+	return ecosts_len;
+}
+
+static void bm_decim_batch_edge_check_cb(void *userdata, const int index)
+{
+	DecimBatchData *data = userdata;
+	DecimBatchEdge *be = &data->batch[index];
+
+	/* same checks as #bm_decim_edge_collapse,
+	 * the tags these use are only set on the locked one-ring */
+	be->is_valid = false;
+
+	if (UNLIKELY(bm_edge_collapse_is_degenerate_topology(be->e))) {
+		return;
+	}
+
+	bm_decim_calc_target_co_fl(be->e, be->optimize_co, data->vquadrics);
+
+	if (UNLIKELY(bm_edge_collapse_is_degenerate_flip(be->e, be->optimize_co))) {
+		return;
+	}
+
+	be->is_valid = true;
+}
+
+/**
+ * \param batch_factor: Share of the remaining collapses to attempt in each round.
+ */
+static void bm_decim_collapse_batched(
+        BMesh *bm, const int face_tot_target, const float batch_factor,
+        Quadric *vquadrics,
+        float *vweights, const float vweight_factor,
+        Heap *eheap, HeapNode **eheap_table,
+        const CD_UseFlag customdata_flag)
+{
+	const int batch_len_max = max_ii((int)((float)((bm->totface - face_tot_target + 1) / 2) * batch_factor), 1);
+	DecimBatchEdge *batch = MEM_mallocN(sizeof(*batch) * (size_t)batch_len_max, __func__);
+	/* vertices are locked for the round matching their value */
+	int *vert_lock = MEM_callocN(sizeof(*vert_lock) * (size_t)bm->totvert, __func__);
+	DecimEdgeCost *ecosts = NULL;
+	int ecosts_len_alloc = 0;
+	int round = 0;
+
+	DecimBatchData data = {
+		.batch = batch,
+		.vquadrics = vquadrics,
+	};
+
+#ifdef DEBUG_TIME
+	int collapse_tot = 0;
+	TIMEIT_BLOCK_INIT(select);
+	TIMEIT_BLOCK_INIT(check);
+	TIMEIT_BLOCK_INIT(collapse);
+	TIMEIT_BLOCK_INIT(cost);
+#endif
+
+	while ((bm->totface > face_tot_target) &&
+	       (BLI_heap_is_empty(eheap) == false) &&
+	       (BLI_heap_node_value(BLI_heap_top(eheap)) != COST_INVALID))
+	{
+		/* each collapse removes up to 2 faces, never overshoot by more than the one edge at a time method */
+		const int batch_len_round = max_ii(
+		        min_ii((int)((float)((bm->totface - face_tot_target + 1) / 2) * batch_factor), batch_len_max), 1);
+		int batch_len = 0, candidate_len = 0;
+		int ecosts_len = 0;
+		int i;
+
+		round++;
+
+#ifdef DEBUG_TIME
+		TIMEIT_BLOCK_START(select);
+#endif
+		/* take the cheapest edges, the ones overlapping an edge taken before are put back after */
+		while ((candidate_len < batch_len_round) &&
+		       (BLI_heap_is_empty(eheap) == false) &&
+		       (BLI_heap_node_value(BLI_heap_top(eheap)) != COST_INVALID))
+		{
+			DecimBatchEdge *be = &batch[candidate_len++];
+			be->cost = BLI_heap_node_value(BLI_heap_top(eheap));
+			be->e = BLI_heap_popmin(eheap);
+			eheap_table[BM_elem_index_get(be->e)] = NULL;
+		}
+
+		for (i = 0; i < candidate_len; i++) {
+			DecimBatchEdge *be = &batch[i];
+			if (bm_decim_edge_ring_lock(be->e, vert_lock, round)) {
+				if (i != batch_len) {
+					SWAP(DecimBatchEdge, batch[batch_len], *be);
+				}
+				batch_len++;
+			}
+		}
+
+		for (i = batch_len; i < candidate_len; i++) {
+			DecimBatchEdge *be = &batch[i];
+			eheap_table[BM_elem_index_get(be->e)] = BLI_heap_insert(eheap, be->cost, be->e);
+		}
+#ifdef DEBUG_TIME
+		TIMEIT_BLOCK_END(select);
+		TIMEIT_BLOCK_START(check);
+#endif
+
+		BLI_task_parallel_range(
+		        0, batch_len, &data, bm_decim_batch_edge_check_cb,
+		        batch_len > DECIM_THREADED_LIMIT);
+
+#ifdef DEBUG_TIME
+		TIMEIT_BLOCK_END(check);
+		TIMEIT_BLOCK_START(collapse);
+#endif
+		/* topology changes can't run in threads, the cheapest edges are still collapsed first */
+		for (i = 0; i < batch_len; i++) {
+			DecimBatchEdge *be = &batch[i];
+			BMVert *v_other = be->e->v1;
+
+			be->v_other = NULL;
+
+			if (be->is_valid == false) {
+				bm_decim_invalid_edge_cost_single(be->e, eheap, eheap_table);  /* add back with a high cost */
+				continue;
+			}
+
+			if (bm_decim_edge_collapse(
+			        bm, be->e, vquadrics, vweights, vweight_factor, eheap, eheap_table,
+#ifdef USE_SYMMETRY
+			        NULL,
+#endif
+			        customdata_flag,
+			        be->optimize_co, false, false))
+			{
+				be->v_other = v_other;
+				ecosts_len += bm_decim_vert_cost_edges(v_other, NULL);
+#ifdef DEBUG_TIME
+				collapse_tot++;
+#endif
+			}
+		}
+#ifdef DEBUG_TIME
+		TIMEIT_BLOCK_END(collapse);
+		TIMEIT_BLOCK_START(cost);
+#endif
+
+		/* update error costs and the eheap */
+		if (ecosts_len > ecosts_len_alloc) {
+			ecosts_len_alloc = ecosts_len * 2;
+			if (ecosts) {
+				MEM_freeN(ecosts);
+			}
+			ecosts = MEM_mallocN(sizeof(*ecosts) * (size_t)ecosts_len_alloc, __func__);
+		}
+
+		ecosts_len = 0;
+		for (i = 0; i < batch_len; i++) {
+			if (batch[i].v_other) {
+				ecosts_len += bm_decim_vert_cost_edges(batch[i].v_other, &ecosts[ecosts_len]);
+			}
+		}
+
+		bm_decim_build_edge_cost_array(ecosts, ecosts_len, vquadrics, vweights, vweight_factor, eheap, eheap_table);
+#ifdef DEBUG_TIME
+		TIMEIT_BLOCK_END(cost);
+#endif
+	}
+
+#ifdef DEBUG_TIME
+	printf("%s: %d collapses in %d rounds\n", __func__, collapse_tot, round);
+	TIMEIT_BLOCK_STATS(select);
+	TIMEIT_BLOCK_STATS(check);
+	TIMEIT_BLOCK_STATS(collapse);
+	TIMEIT_BLOCK_STATS(cost);
+#endif
+
+	if (ecosts) {
+		MEM_freeN(ecosts);
+	}
+	MEM_freeN(vert_lock);
+	MEM_freeN(batch);
+}
+
+
 /* Main Decimate Function
  * ********************** */
 
@@ -1294,13 +1661,16 @@ static bool bm_decim_edge_collapse(
  *        a vertex group is the usual source for this.
  * \param symmetry_axis: Axis of symmetry, -1 to disable mirror decimate.
  * \param symmetry_eps: Threshold when matching mirror verts.
+ * \param batch_factor: Share of the remaining edges to collapse together in each multi-threaded round [0 - 1],
+ *        zero collapses one edge at a time (best quality), ignored with symmetry.
  */
 void BM_mesh_decimate_collapse(
         BMesh *bm,
         const float factor,
         float *vweights, float vweight_factor,
         const bool do_triangulate,
-        const int symmetry_axis, const float symmetry_eps)
+        const int symmetry_axis, const float symmetry_eps,
+        const float batch_factor)
 {
 	Heap *eheap;             /* edge heap */
 	HeapNode **eheap_table;  /* edge index aligned table pointing to the eheap */
@@ -1354,8 +1724,22 @@ void BM_mesh_decimate_collapse(
 #endif
 
 	/* iterative edge collapse and maintain the eheap */
+	if ((batch_factor > 0.0f)
+#ifdef USE_SYMMETRY
+	    && (use_symmetry == false)
+#endif
+	    )
+	{
+		bm_decim_collapse_batched(
+		        bm, face_tot_target, min_ff(batch_factor, 1.0f),
+		        vquadrics, vweights, vweight_factor,
+		        eheap, eheap_table,
+		        customdata_flag);
+	}
 #ifdef USE_SYMMETRY
-	if (use_symmetry == false)
+	else if (use_symmetry == false)
+#else
+	else
 #endif
 	{
 		/* simple non-mirror case */
@@ -1378,7 +1762,7 @@ void BM_mesh_decimate_collapse(
 			        edge_symmetry_map,
 #endif
 			        customdata_flag,
-			        optimize_co, true
+			        optimize_co, true, true
 			        );
 		}
 	}
@@ -1459,7 +1843,7 @@ void BM_mesh_decimate_collapse(
 			        bm, e, vquadrics, vweights, vweight_factor, eheap, eheap_table,
 			        edge_symmetry_map,
 			        customdata_flag,
-			        optimize_co, false))
+			        optimize_co, false, true))
 			{
 				if (e_mirr && (eheap_table[e_index_mirr])) {
 					BLI_assert(e_index_mirr != e_index);
@@ -1470,7 +1854,7 @@ void BM_mesh_decimate_collapse(
 					        bm, e_mirr, vquadrics, vweights, vweight_factor, eheap, eheap_table,
 					        edge_symmetry_map,
 					        customdata_flag,
-					        optimize_co, false);
+					        optimize_co, false, true);
 				}
 			}
 			else {
@@ -51,6 +51,7 @@
 
 #include "BLI_kdopbvh.h"
 #include "BLI_buffer.h"
+#include "BLI_task.h"
 
 #include "bmesh.h"
 #include "intern/bmesh_private.h"
@@ -971,6 +972,110 @@ static int isect_bvhtree_point_v3(
 	return num_isect;
 }
 
+/**
+ * Relative tolerance (of the triangle size) used when culling overlapping pairs,
+ * it only needs to be large enough to account for float precision,
+ * culling too few pairs only costs some time.
+ */
+#define ISECT_CULL_REL_EPS 1e-3f
+
+struct OverlapCullData {
+	BMLoop *(*looptris)[3];
+	float margin;
+};
+
+/**
+ * Check if all vertices of \a t_a are on the same side of the plane of \a t_b,
+ * further away than \a margin.
+ *
+ * Any vertex, edge or face touching found by #bm_isect_tri_tri (within it's epsilon)
+ * needs a point of \a t_a within that epsilon of the plane of \a t_b,
+ * so triangles separated this way can be skipped entirely.
+ */
+static bool bm_isect_tri_plane_separated(
+        const BMLoop *t_a[3], const BMLoop *t_b[3], const float margin)
+{
+	const float *b_cos[3] = {UNPACK3_EX(, t_b, ->v->co)};
+	float no[3], dist[3], size_sq = 0.0f, m;
+	float area;
+	unsigned int i;
+
+	area = normal_tri_v3(no, UNPACK3(b_cos));
+
+	/* don't trust the normal of degenerate and sliver triangles */
+	for (i = 0; i < 3; i++) {
+		size_sq = max_ff(size_sq, len_squared_v3v3(b_cos[i], b_cos[(i + 1) % 3]));
+	}
+	if (!(area > size_sq * ISECT_CULL_REL_EPS)) {
+		return false;
+	}
+
+	for (i = 0; i < 3; i++) {
+		float dir[3];
+		sub_v3_v3v3(dir, t_a[i]->v->co, b_cos[0]);
+		dist[i] = dot_v3v3(no, dir);
+		size_sq = max_ff(size_sq, len_squared_v3(dir));
+	}
+
+	m = margin + sqrtf(size_sq) * ISECT_CULL_REL_EPS;
+
+	return ((min_fff(UNPACK3(dist)) > m) ||
+	        (max_fff(UNPACK3(dist)) < -m));
+}
+
+/**
+ * Overlap callback, runs threaded from #BLI_bvhtree_overlap
+ * which keeps the order of pairs deterministic.
+ */
+static bool bm_isect_overlap_cull_cb(void *userdata, int index_a, int index_b, int UNUSED(thread))
+{
+	const struct OverlapCullData *data = userdata;
+	const BMLoop **t_a = (const BMLoop **)data->looptris[index_a];
+	const BMLoop **t_b = (const BMLoop **)data->looptris[index_b];
+
+	return !(bm_isect_tri_plane_separated(t_a, t_b, data->margin) ||
+	         bm_isect_tri_plane_separated(t_b, t_a, data->margin));
+}
+
+struct RaycastGroupData {
+	BMFace **ftable;
+	const int *groups_array;
+	const int (*group_index)[2];
+	BVHTree **tree_pair;
+	const float **looptri_coords;
+	int (*test_fn)(BMFace *f, void *user_data);
+	void *user_data;
+
+	/* output: -1 when skipped, otherwise the side (lowest bit) & number of hits */
+	int *group_side;
+	int *group_hits;
+};
+
+/**
+ * Ray-cast from each face-group, this only reads from the mesh and trees,
+ * so groups are calculated in parallel and applied afterwards.
+ */
+static void bm_isect_group_raycast_cb(void *userdata, const int i)
+{
+	const struct RaycastGroupData *data = userdata;
+	/* for now assyme this is an OK face to test with (not degenerate!) */
+	BMFace *f = data->ftable[data->groups_array[data->group_index[i][0]]];
+	float co[3];
+	int side = data->test_fn(f, data->user_data);
+
+	data->group_side[i] = side;
+	if (side == -1) {
+		return;
+	}
+	BLI_assert(ELEM(side, 0, 1));
+	side = !side;
+
+	// BM_face_calc_center_mean(f, co);
+	BM_face_calc_point_in_face(f, co);
+
+	data->group_hits[i] = isect_bvhtree_point_v3(data->tree_pair[side], data->looptri_coords, co);
+}
+
 #endif  /* USE_BVH */
 
 /**
@@ -1114,7 +1219,15 @@ bool BM_mesh_intersect(
 		tree_b = tree_a;
 	}
 
-	overlap = BLI_bvhtree_overlap(tree_b, tree_a, &tree_overlap_tot, NULL, NULL);
+	{
+		/* pairs which can't touch (most of them for dense meshes) are removed in parallel,
+		 * only the remaining ones are intersected (modifying the mesh) below. */
+		struct OverlapCullData cull_data = {
+			.looptris = looptris,
+			.margin = s.epsilon.eps_margin * 2.0f,
+		};
+		overlap = BLI_bvhtree_overlap(tree_b, tree_a, &tree_overlap_tot, bm_isect_overlap_cull_cb, &cull_data);
+	}
 
 	if (overlap) {
 		unsigned int i;
@@ -1569,29 +1682,41 @@ bool BM_mesh_intersect(
 		printf("%s: Total face-groups: %d\n", __func__, group_tot);
 #endif
 
-		/* Check if island is inside/outside */
+		/* Check if island is inside/outside,
+		 * the ray-casts are done in parallel, the results are applied in order. */
+		int *group_side = MEM_mallocN(sizeof(*group_side) * (size_t)group_tot * 2, __func__);
+		int *group_hits = &group_side[group_tot];
+
+		{
+			struct RaycastGroupData data = {
+				.ftable = ftable,
+				.groups_array = groups_array,
+				.group_index = (const int (*)[2])group_index,
+				.tree_pair = tree_pair,
+				.looptri_coords = looptri_coords,
+				.test_fn = test_fn,
+				.user_data = user_data,
+				.group_side = group_side,
+				.group_hits = group_hits,
+			};
+			BLI_task_parallel_range(0, group_tot, &data, bm_isect_group_raycast_cb, group_tot > 1);
+		}
+
 		for (i = 0; i < group_tot; i++) {
 			int fg     = group_index[i][0];
 			int fg_end = group_index[i][1] + fg;
 			bool do_remove, do_flip;
 
 			{
-				/* for now assyme this is an OK face to test with (not degenerate!) */
-				BMFace *f = ftable[groups_array[fg]];
-				float co[3];
 				int hits;
-				int side = test_fn(f, user_data);
+				int side = group_side[i];
 
 				if (side == -1) {
 					continue;
 				}
-				BLI_assert(ELEM(side, 0, 1));
 				side = !side;
 
-				// BM_face_calc_center_mean(f, co);
-				BM_face_calc_point_in_face(f, co);
-
-				hits = isect_bvhtree_point_v3(tree_pair[side], looptri_coords, co);
+				hits = group_hits[i];
 
 				switch (boolean_mode) {
 					case BMESH_ISECT_BOOLEAN_ISECT:
@@ -1611,7 +1736,9 @@ bool BM_mesh_intersect(
 #ifdef USE_BOOLEAN_RAYCAST_DRAW
 				{
 					unsigned int colors[4] = {0x00000000, 0xffffffff, 0xff000000, 0x0000ff};
-					float co_other[3] = {UNPACK3(co)};
+					float co[3], co_other[3];
+					BM_face_calc_point_in_face(ftable[groups_array[fg]], co);
+					copy_v3_v3(co_other, co);
 					co_other[0] += 1000.0f;
 					bl_debug_color_set(colors[(hits & 1) == 1]);
 					bl_debug_draw_edge_add(co, co_other);
@@ -1636,6 +1763,7 @@ bool BM_mesh_intersect(
 			has_edit_boolean |= (do_flip || do_remove);
 		}
 
+		MEM_freeN(group_side);
 		MEM_freeN(groups_array);
 		MEM_freeN(group_index);
 
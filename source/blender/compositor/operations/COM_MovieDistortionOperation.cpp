@@ -70,9 +70,9 @@ void MovieDistortionOperation::initExecution()
 		m_margin[0] = delta[0] + 5;
 		m_margin[1] = delta[1] + 5;
 
-		this->m_distortion = BKE_tracking_distortion_new(tracking,
-		                                                 calibration_width,
-		                                                 calibration_height);
+		this->m_distortion = BKE_tracking_distortion_new_cached(tracking,
+		                                                        calibration_width,
+		                                                        calibration_height);
 		this->m_calibration_width = calibration_width;
 		this->m_calibration_height = calibration_height;
 		this->m_pixel_aspect = tracking->camera.pixel_aspect;
@@ -59,13 +59,13 @@ namespace {
 // TODO(sergey): De-duplicate with depsgraph_tag,cc
 void lib_id_recalc_tag(Main *bmain, ID *id)
 {
-	id->tag |= LIB_TAG_ID_RECALC;
+	id->tag |= LIB_TAG_ID_RECALC | LIB_TAG_UNDO_CHANGED;
 	DEG_id_type_tag(bmain, GS(id->name));
 }
 
 void lib_id_recalc_data_tag(Main *bmain, ID *id)
 {
-	id->tag |= LIB_TAG_ID_RECALC_DATA;
+	id->tag |= LIB_TAG_ID_RECALC_DATA | LIB_TAG_UNDO_CHANGED;
 	DEG_id_type_tag(bmain, GS(id->name));
 }
 
@@ -4020,6 +4020,7 @@ static int edbm_decimate_exec(bContext *C, wmOperator *op)
 	const bool use_symmetry = RNA_boolean_get(op->ptr, "use_symmetry");
 	const float symmetry_eps = 0.00002f;
 	const int symmetry_axis = use_symmetry ? RNA_enum_get(op->ptr, "symmetry_axis") : -1;
+	const float batch_factor = RNA_float_get(op->ptr, "batch_factor");
 
 	/* nop */
 	if (ratio == 1.0f) {
@@ -4101,7 +4102,7 @@ static int edbm_decimate_exec(bContext *C, wmOperator *op)
 
 	BM_mesh_decimate_collapse(
 	        em->bm, ratio_adjust, vweights, vertex_group_factor, false,
-	        symmetry_axis, symmetry_eps);
+	        symmetry_axis, symmetry_eps, batch_factor);
 
 	MEM_freeN(vweights);
 
@@ -4147,6 +4148,10 @@ static void edbm_decimate_ui(bContext *UNUSED(C), wmOperator *op)
 	row = uiLayoutRow(box, true);
 	uiLayoutSetActive(row, RNA_boolean_get(&ptr, "use_symmetry"));
 	uiItemR(row, &ptr, "symmetry_axis", UI_ITEM_R_EXPAND, NULL, ICON_NONE);
+
+	row = uiLayoutRow(layout, false);
+	uiLayoutSetActive(row, !RNA_boolean_get(&ptr, "use_symmetry"));
+	uiItemR(row, &ptr, "batch_factor", 0, NULL, ICON_NONE);
 }
 
 
@@ -4181,6 +4186,10 @@ void MESH_OT_decimate(wmOperatorType *ot)
 	                "Maintain symmetry on an axis");
 
 	RNA_def_enum(ot->srna, "symmetry_axis", rna_enum_axis_xyz_items, 1, "Axis", "Axis of symmetry");
+
+	RNA_def_float(ot->srna, "batch_factor", 0.0f, 0.0f, 1.0f, "Batch",
+	              "Share of the remaining edges collapsed together in each multi-threaded step, "
+	              "faster but less accurate, zero collapses one edge at a time (not used with symmetry)", 0.0f, 1.0f);
 }
 
 /** \} */
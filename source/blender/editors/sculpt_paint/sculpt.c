@@ -99,6 +99,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 /** \name Tool Capabilities
  *
  * Avoid duplicate checks, internal logic only,
@@ -1316,6 +1320,216 @@ static float tex_strength(SculptSession *ss, Brush *br,
 	return avg;
 }
 
+/************************ Batched Brush Falloff *******************/
+
+/* Brushes without a texture can evaluate their falloff for batches of vertices: the
+ * coordinates, normals and masks of a node are gathered into flat arrays, the distance
+ * test, front face and mask factors are computed four vertices at a time and only the
+ * falloff curve lookup stays scalar. Results are the same as with tex_strength(). */
+
+#define SCULPT_BATCH_SIZE 256
+
+typedef struct SculptVertBatch {
+	int totvert;
+
+	/* Index of the vertex in the node, and its mesh vertex if any */
+	int index[SCULPT_BATCH_SIZE];
+	MVert *mvert[SCULPT_BATCH_SIZE];
+
+	float co[3][SCULPT_BATCH_SIZE];
+	float no[3][SCULPT_BATCH_SIZE];
+	float mask[SCULPT_BATCH_SIZE];
+
+	float dist[SCULPT_BATCH_SIZE];
+	/* Only valid for vertices inside the brush */
+	float fade[SCULPT_BATCH_SIZE];
+	bool inside[SCULPT_BATCH_SIZE];
+} SculptVertBatch;
+
+static bool sculpt_brush_use_batch(const Brush *brush)
+{
+	return (brush->mtex.tex == NULL);
+}
+
+/* Same as sculpt_brush_test() followed by bstrength * tex_strength() for all vertices of the batch */
+static void sculpt_vert_batch_falloff(
+        SculptSession *ss, Brush *brush, const SculptBrushTest *test,
+        SculptVertBatch *batch, const float bstrength)
+{
+	const StrokeCache *cache = ss->cache;
+	const float *view_normal = cache->view_normal;
+	const bool use_frontface = (brush->flag & BRUSH_FRONTFACE) != 0;
+	const int totvert = batch->totvert;
+	int i = 0;
+
+	/* Distance to the brush center */
+#ifdef __SSE2__
+	{
+		const __m128 loc_x = _mm_set1_ps(test->location[0]);
+		const __m128 loc_y = _mm_set1_ps(test->location[1]);
+		const __m128 loc_z = _mm_set1_ps(test->location[2]);
+		const __m128 radius_squared = _mm_set1_ps(test->radius_squared);
+
+		for (; i + 4 <= totvert; i += 4) {
+			const __m128 dx = _mm_sub_ps(loc_x, _mm_loadu_ps(&batch->co[0][i]));
+			const __m128 dy = _mm_sub_ps(loc_y, _mm_loadu_ps(&batch->co[1][i]));
+			const __m128 dz = _mm_sub_ps(loc_z, _mm_loadu_ps(&batch->co[2][i]));
+			const __m128 distsq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+			                                 _mm_mul_ps(dz, dz));
+			const int inside = _mm_movemask_ps(_mm_cmple_ps(distsq, radius_squared));
+
+			_mm_storeu_ps(&batch->dist[i], _mm_sqrt_ps(distsq));
+			for (int j = 0; j < 4; j++)
+				batch->inside[i + j] = (inside & (1 << j)) != 0;
+		}
+	}
+#endif
+	for (; i < totvert; i++) {
+		const float co[3] = {batch->co[0][i], batch->co[1][i], batch->co[2][i]};
+		const float distsq = len_squared_v3v3(co, test->location);
+
+		batch->dist[i] = sqrtf(distsq);
+		batch->inside[i] = (distsq <= test->radius_squared);
+	}
+
+	/* Clipping and falloff curve */
+	for (i = 0; i < totvert; i++) {
+		if (batch->inside[i] && test->clip_rv3d) {
+			const float co[3] = {batch->co[0][i], batch->co[1][i], batch->co[2][i]};
+			batch->inside[i] = !sculpt_brush_test_clipping(test, co);
+		}
+		batch->fade[i] = batch->inside[i] ? BKE_brush_curve_strength(brush, batch->dist[i], cache->radius) : 0.0f;
+	}
+
+	/* Front face, paint mask and strength */
+	i = 0;
+#ifdef __SSE2__
+	{
+		const __m128 view_x = _mm_set1_ps(view_normal[0]);
+		const __m128 view_y = _mm_set1_ps(view_normal[1]);
+		const __m128 view_z = _mm_set1_ps(view_normal[2]);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 strength = _mm_set1_ps(bstrength);
+
+		for (; i + 4 <= totvert; i += 4) {
+			__m128 fade = _mm_loadu_ps(&batch->fade[i]);
+
+			if (use_frontface) {
+				const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&batch->no[0][i]), view_x),
+				                                         _mm_mul_ps(_mm_loadu_ps(&batch->no[1][i]), view_y)),
+				                              _mm_mul_ps(_mm_loadu_ps(&batch->no[2][i]), view_z));
+				fade = _mm_mul_ps(fade, _mm_max_ps(dot, _mm_setzero_ps()));
+			}
+
+			fade = _mm_mul_ps(fade, _mm_sub_ps(one, _mm_loadu_ps(&batch->mask[i])));
+			_mm_storeu_ps(&batch->fade[i], _mm_mul_ps(strength, fade));
+		}
+	}
+#endif
+	for (; i < totvert; i++) {
+		float fade = batch->fade[i];
+
+		if (use_frontface) {
+			const float no[3] = {batch->no[0][i], batch->no[1][i], batch->no[2][i]};
+			const float dot = dot_v3v3(no, view_normal);
+			fade *= dot > 0 ? dot : 0;
+		}
+
+		fade *= 1.0f - batch->mask[i];
+		batch->fade[i] = bstrength * fade;
+	}
+}
+
+/* Offset the vertices of the batch inside the brush along dir, or along their normal when
+ * dir is NULL, and clear the batch */
+static void sculpt_vert_batch_flush(
+        SculptSession *ss, Brush *brush, const SculptBrushTest *test, SculptVertBatch *batch,
+        float (*proxy)[3], const float dir[3], const float bstrength)
+{
+	sculpt_vert_batch_falloff(ss, brush, test, batch, bstrength);
+
+	for (int i = 0; i < batch->totvert; i++) {
+		if (!batch->inside[i])
+			continue;
+
+		if (dir) {
+			mul_v3_v3fl(proxy[batch->index[i]], dir, batch->fade[i]);
+		}
+		else {
+			float val[3] = {batch->no[0][i], batch->no[1][i], batch->no[2][i]};
+
+			mul_v3_fl(val, batch->fade[i] * ss->cache->radius);
+			mul_v3_v3v3(proxy[batch->index[i]], val, ss->cache->scale);
+		}
+
+		if (batch->mvert[i])
+			batch->mvert[i]->flag |= ME_VERT_PBVH_UPDATE;
+	}
+
+	batch->totvert = 0;
+}
+
+/* Batched vertex loop of the brushes that offset vertices along a fixed direction or along
+ * their normal, uses the original coordinates and normals when orig_data is given */
+static void sculpt_brush_offset_batched(
+        SculptSession *ss, Brush *brush, PBVHNode *node, SculptOrigVertData *orig_data,
+        const float dir[3], const float bstrength)
+{
+	SculptVertBatch batch;
+	SculptBrushTest test;
+	PBVHVertexIter vd;
+	const bool use_normals = (brush->flag & BRUSH_FRONTFACE) || (dir == NULL);
+	float (*proxy)[3];
+
+	proxy = BKE_pbvh_node_add_proxy(ss->pbvh, node)->co;
+
+	sculpt_brush_test_init(ss, &test);
+
+	batch.totvert = 0;
+
+	BKE_pbvh_vertex_iter_begin(ss->pbvh, node, vd, PBVH_ITER_UNIQUE)
+	{
+		const float *co = vd.co;
+		const short *no = vd.no;
+		const float *fno = vd.fno;
+		const int i = batch.totvert++;
+
+		if (orig_data) {
+			sculpt_orig_vert_data_update(orig_data, &vd);
+			co = orig_data->co;
+			no = orig_data->no;
+			fno = NULL;
+		}
+
+		batch.index[i] = vd.i;
+		batch.mvert[i] = vd.mvert;
+
+		for (int j = 0; j < 3; j++)
+			batch.co[j][i] = co[j];
+
+		if (use_normals) {
+			float normal[3];
+
+			if (no)
+				normal_short_to_float_v3(normal, no);
+			else
+				copy_v3_v3(normal, fno);
+
+			for (int j = 0; j < 3; j++)
+				batch.no[j][i] = normal[j];
+		}
+
+		batch.mask[i] = vd.mask ? *vd.mask : 0.0f;
+
+		if (batch.totvert == SCULPT_BATCH_SIZE)
+			sculpt_vert_batch_flush(ss, brush, &test, &batch, proxy, dir, bstrength);
+	}
+	BKE_pbvh_vertex_iter_end;
+
+	if (batch.totvert)
+		sculpt_vert_batch_flush(ss, brush, &test, &batch, proxy, dir, bstrength);
+}
+
 typedef struct {
 	Sculpt *sd;
 	SculptSession *ss;
@@ -2012,6 +2226,12 @@ static void do_draw_brush_task_cb_ex(
 	SculptBrushTest test;
 	float (*proxy)[3];
 
+	if (sculpt_brush_use_batch(brush)) {
+		/* bstrength is already part of the offset */
+		sculpt_brush_offset_batched(ss, brush, data->nodes[n], NULL, offset, 1.0f);
+		return;
+	}
+
 	proxy = BKE_pbvh_node_add_proxy(ss->pbvh, data->nodes[n])->co;
 
 	sculpt_brush_test_init(ss, &test);
@@ -2205,6 +2425,11 @@ static void do_grab_brush_task_cb_ex(
 
 	sculpt_orig_vert_data_init(&orig_data, data->ob, data->nodes[n]);
 
+	if (sculpt_brush_use_batch(brush)) {
+		sculpt_brush_offset_batched(ss, brush, data->nodes[n], &orig_data, grab_delta, bstrength);
+		return;
+	}
+
 	proxy = BKE_pbvh_node_add_proxy(ss->pbvh, data->nodes[n])->co;
 
 	sculpt_brush_test_init(ss, &test);
@@ -2262,6 +2487,11 @@ static void do_nudge_brush_task_cb_ex(
 	float (*proxy)[3];
 	const float bstrength = ss->cache->bstrength;
 
+	if (sculpt_brush_use_batch(brush)) {
+		sculpt_brush_offset_batched(ss, brush, data->nodes[n], NULL, cono, bstrength);
+		return;
+	}
+
 	proxy = BKE_pbvh_node_add_proxy(ss->pbvh, data->nodes[n])->co;
 
 	sculpt_brush_test_init(ss, &test);
@@ -2622,6 +2852,12 @@ static void do_inflate_brush_task_cb_ex(
 	float (*proxy)[3];
 	const float bstrength = ss->cache->bstrength;
 
+	if (sculpt_brush_use_batch(brush)) {
+		/* offset along the vertex normals */
+		sculpt_brush_offset_batched(ss, brush, data->nodes[n], NULL, NULL, bstrength);
+		return;
+	}
+
 	proxy = BKE_pbvh_node_add_proxy(ss->pbvh, data->nodes[n])->co;
 
 	sculpt_brush_test_init(ss, &test);
@@ -4790,6 +5026,13 @@ static void sculpt_stroke_done(const bContext *C, struct PaintStroke *UNUSED(str
 
 		ss->partial_redraw = 0;
 
+		/* strokes modify the mesh in place without tagging it, make sure
+		 * the next global undo step writes it again */
+		((ID *)ob->data)->tag |= LIB_TAG_UNDO_CHANGED;
+		if (ss->kb) {
+			((ID *)BKE_key_from_object(ob))->tag |= LIB_TAG_UNDO_CHANGED;
+		}
+
 		/* try to avoid calling this, only for e.g. linked duplicates now */
 		if (((Mesh *)ob->data)->id.us > 1)
 			DAG_id_tag_update(&ob->id, OB_RECALC_DATA);
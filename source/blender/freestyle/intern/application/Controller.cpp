@@ -63,6 +63,7 @@ extern "C" {
 #include "../winged_edge/WXEdgeBuilder.h"
 
 #include "../blender_interface/BlenderFileLoader.h"
+#include "../blender_interface/BlenderStrokeRasterizer.h"
 #include "../blender_interface/BlenderStrokeRenderer.h"
 #include "../blender_interface/BlenderStyleModule.h"
 
@@ -926,6 +927,29 @@ Render *Controller::RenderStrokes(Render *re, bool render)
 	return freestyle_render;
 }
 
+// Composite the strokes straight into dest without building a temporary scene.
+// Returns false if some strokes need the render engine for their textures or shaders.
+bool Controller::RasterizeStrokes(Render *re, float *dest)
+{
+	if (!BlenderStrokeRasterizer::IsSupported(re, _Canvas))
+		return false;
+
+	_Chrono.start();
+	BlenderStrokeRasterizer *rasterizer = new BlenderStrokeRasterizer(re, dest);
+	_Canvas->Render(rasterizer);
+	rasterizer->Flush();
+	real d = _Chrono.stop();
+	if (G.debug & G_DEBUG_FREESTYLE) {
+		cout << "Stroke rasterization  : " << d << endl;
+		printf("%u strokes, %u triangles, %u batches, mem peak %.2fM\n",
+		       rasterizer->totstroke, rasterizer->tottri, rasterizer->totbatch,
+		       MEM_get_peak_memory() / (1024.0 * 1024.0));
+	}
+	delete rasterizer;
+
+	return true;
+}
+
 void Controller::InsertStyleModule(unsigned index, const char *iFileName)
 {
 	if (!BLI_testextensie(iFileName, ".py")) {
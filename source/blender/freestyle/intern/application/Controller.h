@@ -78,6 +78,7 @@ public:
 	int DrawStrokes();
 	void ResetRenderCount();
 	Render *RenderStrokes(Render *re, bool render);
+	bool RasterizeStrokes(Render *re, float *dest);
 	void SwapStyleModules(unsigned i1, unsigned i2);
 	void InsertStyleModule(unsigned index, const char *iFileName);
 	void InsertStyleModule(unsigned index, const char *iName, const char *iBuffer);
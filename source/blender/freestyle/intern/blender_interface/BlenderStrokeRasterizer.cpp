@@ -0,0 +1,289 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/freestyle/intern/blender_interface/BlenderStrokeRasterizer.cpp
+ *  \ingroup freestyle
+ */
+
+#include "BlenderStrokeRasterizer.h"
+
+#include "../stroke/Canvas.h"
+#include "../stroke/Stroke.h"
+#include "../stroke/StrokeLayer.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+
+#include "DNA_scene_types.h"
+
+#include "BKE_scene.h"
+
+#include "BLI_math_base.h"
+#include "BLI_math_vector.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "render_types.h"
+#include "pixelblending.h"
+}
+
+#include <float.h>
+#include <math.h>
+
+namespace Freestyle {
+
+// Number of triangles tessellated before they are composited
+#define BATCH_TRIANGLES (1 << 16)
+
+BlenderStrokeRasterizer::BlenderStrokeRasterizer(Render *re, float *dest) : StrokeRenderer()
+{
+	totstroke = tottri = totbatch = 0;
+
+	_re = re;
+	_dest = dest;
+	_rectx = re->rectx;
+	_recty = re->recty;
+
+	// stroke coordinates are relative to the whole image, the result only covers disprect
+	_xofs = re->disprect.xmin;
+	_yofs = re->disprect.ymin;
+
+	// sample at the pixel centers, or at the jittered positions of the internal renderer
+	_osa = (re->osa > 0) ? min((int)re->osa, 32) : 1;
+	if (re->osa > 0) {
+		memcpy(_jit, re->jit, sizeof(_jit));
+	}
+	else {
+		_jit[0][0] = _jit[0][1] = 0.5f;
+	}
+
+	_tilex = max(re->partx, 16);
+	_tiley = max(re->party, 16);
+	_numxtiles = (_rectx + _tilex - 1) / _tilex;
+	_numytiles = (_recty + _tiley - 1) / _tiley;
+	_tiles.resize(_numxtiles * _numytiles);
+	for (int ty = 0; ty < _numytiles; ty++) {
+		for (int tx = 0; tx < _numxtiles; tx++) {
+			Tile& tile = _tiles[ty * _numxtiles + tx];
+			tile.xmin = tx * _tilex;
+			tile.ymin = ty * _tiley;
+			tile.xmax = min(tile.xmin + _tilex, _rectx);
+			tile.ymax = min(tile.ymin + _tiley, _recty);
+		}
+	}
+
+	_triangles.reserve(BATCH_TRIANGLES);
+}
+
+BlenderStrokeRasterizer::~BlenderStrokeRasterizer()
+{
+}
+
+bool BlenderStrokeRasterizer::IsSupported(Render *re, Canvas *iCanvas)
+{
+	// node shaders are evaluated by the render engine
+	if (BKE_scene_use_new_shading_nodes(re->scene))
+		return false;
+	// full sample compositing reads back the samples of a separate render result
+	if (re->r.scemode & R_FULL_SAMPLE)
+		return false;
+	return !iCanvas->hasTexturedStrokes();
+}
+
+void BlenderStrokeRasterizer::RenderStrokeRep(StrokeRep *iStrokeRep) const
+{
+	RenderStrokeRepBasic(iStrokeRep);
+}
+
+void BlenderStrokeRasterizer::RenderStrokeRepBasic(StrokeRep *iStrokeRep) const
+{
+	BlenderStrokeRasterizer *self = const_cast<BlenderStrokeRasterizer *>(this);
+	const vector<Strip*>& strips = iStrokeRep->getStrips();
+	StrokeVertexRep *svRep[3];
+
+	for (vector<Strip*>::const_iterator s = strips.begin(), send = strips.end(); s != send; ++s) {
+		Strip::vertex_container& strip_vertices = (*s)->vertices();
+		const int strip_vertex_count = strip_vertices.size();
+
+		for (int n = 2; n < strip_vertex_count; n++) {
+			svRep[0] = strip_vertices[n - 2];
+			svRep[1] = strip_vertices[n - 1];
+			svRep[2] = strip_vertices[n];
+			self->AddTriangle(svRep);
+		}
+	}
+	self->totstroke++;
+
+	// only flush between strokes, so that a stroke is never split over two batches
+	if (_triangles.size() >= BATCH_TRIANGLES)
+		self->Flush();
+}
+
+void BlenderStrokeRasterizer::AddTriangle(StrokeVertexRep *svRep[3])
+{
+	Triangle tri;
+	float xmin = FLT_MAX, xmax = -FLT_MAX, ymin = FLT_MAX, ymax = -FLT_MAX;
+
+	for (int i = 0; i < 3; i++) {
+		const Vec2r& p = svRep[i]->point2d();
+		tri.co[i][0] = p[0] - _xofs;
+		tri.co[i][1] = p[1] - _yofs;
+		xmin = min(xmin, tri.co[i][0]);
+		xmax = max(xmax, tri.co[i][0]);
+		ymin = min(ymin, tri.co[i][1]);
+		ymax = max(ymax, tri.co[i][1]);
+	}
+
+	// cull triangles outside of the render result, and skip degenerate ones
+	if (xmax < 0.0f || ymax < 0.0f || xmin > _rectx || ymin > _recty)
+		return;
+	if (((tri.co[1][0] - tri.co[0][0]) * (tri.co[2][1] - tri.co[0][1]) -
+	     (tri.co[2][0] - tri.co[0][0]) * (tri.co[1][1] - tri.co[0][1])) == 0.0f)
+	{
+		return;
+	}
+
+	tri.xmin = max((int)floorf(xmin), 0);
+	tri.ymin = max((int)floorf(ymin), 0);
+	tri.xmax = min((int)floorf(xmax), _rectx - 1);
+	tri.ymax = min((int)floorf(ymax), _recty - 1);
+	if (tri.xmin > tri.xmax || tri.ymin > tri.ymax)
+		return;
+
+	// colors are clamped like the byte vertex colors of the stroke meshes
+	for (int i = 0; i < 3; i++) {
+		const Vec3r& color = svRep[i]->color();
+		const float alpha = CLAMPIS(svRep[i]->alpha(), 0.0f, 1.0f);
+		tri.col[i][0] = CLAMPIS((float)color[0], 0.0f, 1.0f) * alpha;
+		tri.col[i][1] = CLAMPIS((float)color[1], 0.0f, 1.0f) * alpha;
+		tri.col[i][2] = CLAMPIS((float)color[2], 0.0f, 1.0f) * alpha;
+		tri.col[i][3] = alpha;
+	}
+
+	_triangles.push_back(tri);
+	tottri++;
+}
+
+typedef struct RasterizeTileData {
+	const BlenderStrokeRasterizer::Triangle *triangles;
+	BlenderStrokeRasterizer::Tile *tiles;
+	float *dest;
+	int rectx;
+	int osa;
+	const float (*jit)[2];
+} RasterizeTileData;
+
+static void rasterize_tile(void *userdata, const int index)
+{
+	RasterizeTileData *data = (RasterizeTileData *)userdata;
+	BlenderStrokeRasterizer::Tile& tile = data->tiles[index];
+	const int osa = data->osa;
+	const float (*jit)[2] = data->jit;
+
+	if (tile.triangles.empty())
+		return;
+
+	const int width = tile.xmax - tile.xmin;
+	const int height = tile.ymax - tile.ymin;
+	// strokes are composited over each other per sample, and the samples are only
+	// averaged at the end, so that adjacent triangles of a strip don't leave seams
+	float *layer = (float *)MEM_callocN(sizeof(float) * 4 * osa * width * height, "Freestyle stroke tile");
+
+	for (vector<unsigned int>::const_iterator it = tile.triangles.begin(), itend = tile.triangles.end();
+	     it != itend; ++it)
+	{
+		const BlenderStrokeRasterizer::Triangle& tri = data->triangles[*it];
+		const float *v0 = tri.co[0], *v1 = tri.co[1], *v2 = tri.co[2];
+		const float inv_area = 1.0f / ((v1[0] - v0[0]) * (v2[1] - v0[1]) - (v2[0] - v0[0]) * (v1[1] - v0[1]));
+		const int xmin = max(tri.xmin, tile.xmin), xmax = min(tri.xmax, tile.xmax - 1);
+		const int ymin = max(tri.ymin, tile.ymin), ymax = min(tri.ymax, tile.ymax - 1);
+
+		for (int y = ymin; y <= ymax; y++) {
+			float *pixel = layer + 4 * osa * ((y - tile.ymin) * width + (xmin - tile.xmin));
+			for (int x = xmin; x <= xmax; x++, pixel += 4 * osa) {
+				for (int s = 0; s < osa; s++) {
+					const float px = x + jit[s][0], py = y + jit[s][1];
+					// barycentric coordinates, the sign of the area takes care of the winding
+					const float w0 = ((v1[0] - px) * (v2[1] - py) - (v2[0] - px) * (v1[1] - py)) * inv_area;
+					const float w1 = ((v2[0] - px) * (v0[1] - py) - (v0[0] - px) * (v2[1] - py)) * inv_area;
+					const float w2 = 1.0f - w0 - w1;
+					if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+						continue;
+
+					const float w[3] = {w0, w1, w2};
+					float src[4];
+					interp_v4_v4v4v4(src, tri.col[0], tri.col[1], tri.col[2], w);
+					addAlphaOverFloat(pixel + 4 * s, src);
+				}
+			}
+		}
+	}
+
+	const float osa_inv = 1.0f / osa;
+	for (int y = tile.ymin; y < tile.ymax; y++) {
+		const float *pixel = layer + 4 * osa * (y - tile.ymin) * width;
+		float *dest = data->dest + 4 * (data->rectx * y + tile.xmin);
+		for (int x = tile.xmin; x < tile.xmax; x++, pixel += 4 * osa, dest += 4) {
+			float src[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			for (int s = 0; s < osa; s++) {
+				add_v4_v4(src, pixel + 4 * s);
+			}
+			mul_v4_fl(src, osa_inv);
+			if (src[3] > 0.0f)
+				addAlphaOverFloat(dest, src);
+		}
+	}
+
+	MEM_freeN(layer);
+	tile.triangles.clear();
+}
+
+void BlenderStrokeRasterizer::Flush()
+{
+	if (_triangles.empty())
+		return;
+
+	if (!_re->test_break(_re->tbh)) {
+		// bin the triangles into the tiles they overlap, in stroke order
+		for (unsigned int i = 0; i < _triangles.size(); i++) {
+			const Triangle& tri = _triangles[i];
+			for (int ty = tri.ymin / _tiley; ty <= tri.ymax / _tiley; ty++) {
+				for (int tx = tri.xmin / _tilex; tx <= tri.xmax / _tilex; tx++) {
+					_tiles[ty * _numxtiles + tx].triangles.push_back(i);
+				}
+			}
+		}
+
+		RasterizeTileData data;
+		data.triangles = &_triangles[0];
+		data.tiles = &_tiles[0];
+		data.dest = _dest;
+		data.rectx = _rectx;
+		data.osa = _osa;
+		data.jit = _jit;
+
+		BLI_task_parallel_range(0, _tiles.size(), &data, rasterize_tile, _tiles.size() > 1);
+		totbatch++;
+	}
+
+	_triangles.clear();
+}
+
+} /* namespace Freestyle */
@@ -0,0 +1,97 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BLENDER_STROKE_RASTERIZER_H__
+#define __BLENDER_STROKE_RASTERIZER_H__
+
+/** \file blender/freestyle/intern/blender_interface/BlenderStrokeRasterizer.h
+ *  \ingroup freestyle
+ */
+
+#include "../stroke/StrokeRenderer.h"
+#include "../system/FreestyleConfig.h"
+
+extern "C" {
+struct Render;
+}
+
+namespace Freestyle {
+
+class Canvas;
+
+/*! Renders strokes without going through a temporary scene.
+ *  Stroke strips are tessellated into a bounded batch of triangles, and each full batch is
+ *  rasterized tile by tile and composited over the given combined pass.  Only flat vertex
+ *  colored strokes are supported, textured or node shaded strokes need BlenderStrokeRenderer.
+ */
+class BlenderStrokeRasterizer : public StrokeRenderer
+{
+public:
+	/*! dest is the RGBA combined pass of the render result, re->rectx by re->recty pixels */
+	BlenderStrokeRasterizer(Render *re, float *dest);
+	virtual ~BlenderStrokeRasterizer();
+
+	/*! Renders a stroke rep */
+	virtual void RenderStrokeRep(StrokeRep *iStrokeRep) const;
+	virtual void RenderStrokeRepBasic(StrokeRep *iStrokeRep) const;
+
+	/*! Composites the strokes that are still in the batch */
+	void Flush();
+
+	/*! Whether all strokes on the canvas can be rendered by this class */
+	static bool IsSupported(Render *re, Canvas *iCanvas);
+
+	struct Triangle {
+		float co[3][2];
+		float col[3][4]; /* premultiplied */
+		int xmin, xmax, ymin, ymax; /* pixel bounds, inclusive */
+	};
+
+	struct Tile {
+		int xmin, xmax, ymin, ymax; /* pixel bounds, exclusive maximum */
+		vector<unsigned int> triangles;
+	};
+
+	/*! Statistics for debug output */
+	unsigned int totstroke, tottri, totbatch;
+
+protected:
+	Render *_re;
+	float *_dest;
+	int _rectx, _recty;
+	float _xofs, _yofs;
+	int _tilex, _tiley;
+	int _numxtiles, _numytiles;
+	int _osa;
+	float _jit[32][2];
+
+	vector<Triangle> _triangles;
+	vector<Tile> _tiles;
+
+	void AddTriangle(StrokeVertexRep *svRep[3]);
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("Freestyle:BlenderStrokeRasterizer")
+#endif
+};
+
+} /* namespace Freestyle */
+
+#endif // __BLENDER_STROKE_RASTERIZER_H__
@@ -475,6 +475,28 @@ static void prepare(Render *re, SceneRenderLayer *srl)
 	controller->ComputeViewMap();
 }
 
+static float *composite_destination(Render *re, SceneRenderLayer *srl)
+{
+	RenderLayer *rl;
+	float *dest;
+
+	rl = RE_GetRenderLayer(re->result, srl->name);
+	if (!rl) {
+		if (G.debug & G_DEBUG_FREESTYLE) {
+			cout << "No destination render layer to composite to" << endl;
+		}
+		return NULL;
+	}
+	dest = RE_RenderLayerGetPass(rl, SCE_PASS_COMBINED, re->viewname);
+	if (!dest) {
+		if (G.debug & G_DEBUG_FREESTYLE) {
+			cout << "No destination result image to composite to" << endl;
+		}
+		return NULL;
+	}
+	return dest;
+}
+
 void FRS_composite_result(Render *re, SceneRenderLayer *srl, Render *freestyle_render)
 {
 	RenderLayer *rl;
@@ -505,20 +527,9 @@ void FRS_composite_result(Render *re, SceneRenderLayer *srl, Render *freestyle_r
 	}
 #endif
 
-	rl = RE_GetRenderLayer(re->result, srl->name);
-	if (!rl) {
-		if (G.debug & G_DEBUG_FREESTYLE) {
-			cout << "No destination render layer to composite to" << endl;
-		}
+	dest = composite_destination(re, srl);
+	if (!dest)
 		return;
-	}
-	dest = RE_RenderLayerGetPass(rl, SCE_PASS_COMBINED, re->viewname);
-	if (!dest) {
-		if (G.debug & G_DEBUG_FREESTYLE) {
-			cout << "No destination result image to composite to" << endl;
-		}
-		return;
-	}
 #if 0
 	if (G.debug & G_DEBUG_FREESTYLE) {
 		cout << "dest: " << rl->rectx << " x " << rl->recty << endl;
@@ -630,7 +641,11 @@ Render *FRS_do_stroke_rendering(Render *re, SceneRenderLayer *srl, int render)
 			g_freestyle.scene = re->scene;
 			int strokeCount = controller->DrawStrokes();
 			if (strokeCount > 0) {
-				freestyle_render = controller->RenderStrokes(re, true);
+				// plain strokes are rasterized into the render result directly, others
+				// are rendered as a temporary scene and composited below
+				float *dest = composite_destination(re, srl);
+				if (!(dest && controller->RasterizeStrokes(re, dest)))
+					freestyle_render = controller->RenderStrokes(re, true);
 			}
 			controller->CloseFile();
 			g_freestyle.scene = NULL;
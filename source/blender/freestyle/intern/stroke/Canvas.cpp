@@ -29,6 +29,7 @@
 #include <vector>
 
 #include "Canvas.h"
+#include "Stroke.h"
 #include "StrokeRenderer.h"
 #include "StyleModule.h"
 
@@ -297,6 +298,22 @@ void Canvas::RenderBasic(const StrokeRenderer *iRenderer)
 	}
 }
 
+bool Canvas::hasTexturedStrokes()
+{
+	for (unsigned int i = 0; i < _StyleModules.size(); ++i) {
+		if (!_StyleModules[i]->getDisplayed() || !_Layers[i])
+			continue;
+		for (StrokeLayer::stroke_container::iterator s = _Layers[i]->strokes_begin(), send = _Layers[i]->strokes_end();
+		     s != send;
+		     ++s)
+		{
+			if ((*s)->hasTex())
+				return true;
+		}
+	}
+	return false;
+}
+
 void Canvas::loadMap(const char *iFileName, const char *iMapName, unsigned int iNbLevels, float iSigma)
 {
 	// check whether this map was already loaded:
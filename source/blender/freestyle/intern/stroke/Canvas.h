@@ -118,6 +118,8 @@ public:
 	virtual void Render(const StrokeRenderer *iRenderer);
 	/* Basic Renders the created strokes */
 	virtual void RenderBasic(const StrokeRenderer *iRenderer);
+	/* Checks whether any of the strokes to be rendered has textures or a shader node tree */
+	bool hasTexturedStrokes();
 	/* Renders a stroke */
 	virtual void RenderStroke(Stroke *iStroke) = 0;
 
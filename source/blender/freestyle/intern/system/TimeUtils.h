@@ -28,7 +28,7 @@
  *  \date 10/04/2002
  */
 
-#include <time.h>
+#include "PIL_time.h"
 
 #ifdef WITH_CXX_GUARDEDALLOC
 #include "MEM_guardedalloc.h"
@@ -42,20 +42,20 @@ public:
 	inline Chronometer() {}
 	inline ~Chronometer() {}
 
-	inline clock_t start()
+	// Wall clock time, CPU time of parallel stages would add up over all threads.
+	inline double start()
 	{
-		_start = clock();
+		_start = PIL_check_seconds_timer();
 		return _start;
 	}
 
 	inline double stop()
 	{
-		clock_t stop = clock();
-		return (double)(stop - _start) / CLOCKS_PER_SEC;
+		return PIL_check_seconds_timer() - _start;
 	}
 
 private:
-	clock_t _start;
+	double _start;
 
 #ifdef WITH_CXX_GUARDEDALLOC
 	MEM_CXX_CLASS_ALLOC_FUNCS("Freestyle:Chronometer")
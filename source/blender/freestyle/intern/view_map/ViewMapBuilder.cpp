@@ -46,6 +46,9 @@
 
 #include "BKE_global.h"
 
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
 namespace Freestyle {
 
 // XXX Grmll... G is used as template's typename parameter :/
@@ -405,209 +408,182 @@ static int computeVisibility(ViewMap *viewMap, FEdge *fe, G& grid, real epsilon,
 // 6 occluders have QI <= 22.
 
 template <typename G, typename I>
-static void computeCumulativeVisibility(ViewMap *ioViewMap, G& grid, real epsilon, RenderMonitor *iRenderMonitor)
+static void computeCumulativeVisibility(ViewMap *ioViewMap, ViewEdge *ve, G& grid, real epsilon)
 {
-	vector<ViewEdge*>& vedges = ioViewMap->ViewEdges();
-
 	FEdge *fe, *festart;
 	int nSamples = 0;
 	vector<WFace*> wFaces;
 	WFace *wFace = NULL;
-	unsigned cnt = 0;
-	unsigned cntStep = (unsigned)ceil(0.01f * vedges.size());
 	unsigned tmpQI = 0;
 	unsigned qiClasses[256];
 	unsigned maxIndex, maxCard;
 	unsigned qiMajority;
-	for (vector<ViewEdge*>::iterator ve = vedges.begin(), veend = vedges.end(); ve != veend; ve++) {
-		if (iRenderMonitor) {
-			if (iRenderMonitor->testBreak())
-				break;
-			if (cnt % cntStep == 0) {
-				stringstream ss;
-				ss << "Freestyle: Visibility computations " << (100 * cnt / vedges.size()) << "%";
-				iRenderMonitor->setInfo(ss.str());
-				iRenderMonitor->progress((float)cnt / vedges.size());
-			}
-			cnt++;
-		}
+#if LOGGING
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		cout << "Processing ViewEdge " << ve->getId() << endl;
+	}
+#endif
+	// Find an edge to test
+	if (!ve->isInImage()) {
+		// This view edge has been proscenium culled
+		ve->setQI(255);
+		ve->setaShape(0);
 #if LOGGING
 		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "Processing ViewEdge " << (*ve)->getId() << endl;
+			cout << "\tCulled." << endl;
 		}
 #endif
-		// Find an edge to test
-		if (!(*ve)->isInImage()) {
-			// This view edge has been proscenium culled
-			(*ve)->setQI(255);
-			(*ve)->setaShape(0);
+		return;
+	}
+
+	// Test edge
+	festart = ve->fedgeA();
+	fe = ve->fedgeA();
+	qiMajority = 0;
+	do {
+		if (fe != NULL && fe->isInImage()) {
+			qiMajority++;
+		}
+		fe = fe->nextEdge();
+	} while (fe && fe != festart);
+
+	if (qiMajority == 0) {
+		// There are no occludable FEdges on this ViewEdge
+		// This should be impossible.
+		if (_global.debug & G_DEBUG_FREESTYLE) {
+			cout << "View Edge in viewport without occludable FEdges: " << ve->getId() << endl;
+		}
+		// We can recover from this error:
+		// Treat this edge as fully visible with no occludee
+		ve->setQI(0);
+		ve->setaShape(0);
+		return;
+	}
+	else {
+		++qiMajority;
+		qiMajority >>= 1;
+	}
 #if LOGGING
-			if (_global.debug & G_DEBUG_FREESTYLE) {
-				cout << "\tCulled." << endl;
-			}
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		cout << "\tqiMajority: " << qiMajority << endl;
+	}
 #endif
-			continue;
-		}
 
-		// Test edge
-		festart = (*ve)->fedgeA();
-		fe = (*ve)->fedgeA();
-		qiMajority = 0;
-		do {
-			if (fe != NULL && fe->isInImage()) {
-				qiMajority++;
-			}
-			fe = fe->nextEdge();
-		} while (fe && fe != festart);
+	tmpQI = 0;
+	maxIndex = 0;
+	maxCard = 0;
+	nSamples = 0;
+	memset(qiClasses, 0, 256 * sizeof(*qiClasses));
+	set<ViewShape*> foundOccluders;
 
-		if (qiMajority == 0) {
-			// There are no occludable FEdges on this ViewEdge
-			// This should be impossible.
-			if (_global.debug & G_DEBUG_FREESTYLE) {
-				cout << "View Edge in viewport without occludable FEdges: " << (*ve)->getId() << endl;
-			}
-			// We can recover from this error:
-			// Treat this edge as fully visible with no occludee
-			(*ve)->setQI(0);
-			(*ve)->setaShape(0);
+	fe = ve->fedgeA();
+	do {
+		if (!fe || !fe->isInImage()) {
+			fe = fe->nextEdge();
 			continue;
 		}
-		else {
-			++qiMajority;
-			qiMajority >>= 1;
-		}
+		if ((maxCard < qiMajority)) {
+			//ARB: change &wFace to wFace and use reference in called function
+			tmpQI = computeVisibility<G, I>(ioViewMap, fe, grid, epsilon, ve, &wFace, &foundOccluders);
 #if LOGGING
-		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "\tqiMajority: " << qiMajority << endl;
-		}
+			if (_global.debug & G_DEBUG_FREESTYLE) {
+				cout << "\tFEdge: visibility " << tmpQI << endl;
+			}
 #endif
 
-		tmpQI = 0;
-		maxIndex = 0;
-		maxCard = 0;
-		nSamples = 0;
-		memset(qiClasses, 0, 256 * sizeof(*qiClasses));
-		set<ViewShape*> foundOccluders;
+			//ARB: This is an error condition, not an alert condition.
+			// Some sort of recovery or abort is necessary.
+			if (tmpQI >= 256) {
+				cerr << "Warning: too many occluding levels" << endl;
+				//ARB: Wild guess: instead of aborting or corrupting memory, treat as tmpQI == 255
+				tmpQI = 255;
+			}
 
-		fe = (*ve)->fedgeA();
-		do {
-			if (!fe || !fe->isInImage()) {
-				fe = fe->nextEdge();
-				continue;
+			if (++qiClasses[tmpQI] > maxCard) {
+				maxCard = qiClasses[tmpQI];
+				maxIndex = tmpQI;
 			}
-			if ((maxCard < qiMajority)) {
-				//ARB: change &wFace to wFace and use reference in called function
-				tmpQI = computeVisibility<G, I>(ioViewMap, fe, grid, epsilon, *ve, &wFace, &foundOccluders);
+		}
+		else {
+			//ARB: FindOccludee is redundant if ComputeRayCastingVisibility has been called
+			//ARB: change &wFace to wFace and use reference in called function
+			findOccludee<G, I>(fe, grid, epsilon, ve, &wFace);
 #if LOGGING
-				if (_global.debug & G_DEBUG_FREESTYLE) {
-					cout << "\tFEdge: visibility " << tmpQI << endl;
-				}
+			if (_global.debug & G_DEBUG_FREESTYLE) {
+				cout << "\tFEdge: occludee only (" << (wFace != NULL ? "found" : "not found") << ")" << endl;
+			}
 #endif
+		}
 
-				//ARB: This is an error condition, not an alert condition.
-				// Some sort of recovery or abort is necessary.
-				if (tmpQI >= 256) {
-					cerr << "Warning: too many occluding levels" << endl;
-					//ARB: Wild guess: instead of aborting or corrupting memory, treat as tmpQI == 255
-					tmpQI = 255;
-				}
-
-				if (++qiClasses[tmpQI] > maxCard) {
-					maxCard = qiClasses[tmpQI];
-					maxIndex = tmpQI;
-				}
+		// Store test results
+		if (wFace) {
+			vector<Vec3r> vertices;
+			for (int i = 0, numEdges = wFace->numberOfEdges(); i < numEdges; ++i) {
+				vertices.push_back(Vec3r(wFace->GetVertex(i)->GetVertex()));
 			}
-			else {
-				//ARB: FindOccludee is redundant if ComputeRayCastingVisibility has been called
-				//ARB: change &wFace to wFace and use reference in called function
-				findOccludee<G, I>(fe, grid, epsilon, *ve, &wFace);
+			Polygon3r poly(vertices, wFace->GetNormal());
+			poly.userdata = (void *)wFace;
+			fe->setaFace(poly);
+			wFaces.push_back(wFace);
+			fe->setOccludeeEmpty(false);
 #if LOGGING
-				if (_global.debug & G_DEBUG_FREESTYLE) {
-					cout << "\tFEdge: occludee only (" << (wFace != NULL ? "found" : "not found") << ")" << endl;
-				}
-#endif
+			if (_global.debug & G_DEBUG_FREESTYLE) {
+				cout << "\tFound occludee" << endl;
 			}
-
-			// Store test results
-			if (wFace) {
-				vector<Vec3r> vertices;
-				for (int i = 0, numEdges = wFace->numberOfEdges(); i < numEdges; ++i) {
-					vertices.push_back(Vec3r(wFace->GetVertex(i)->GetVertex()));
-				}
-				Polygon3r poly(vertices, wFace->GetNormal());
-				poly.userdata = (void *)wFace;
-				fe->setaFace(poly);
-				wFaces.push_back(wFace);
-				fe->setOccludeeEmpty(false);
-#if LOGGING
-				if (_global.debug & G_DEBUG_FREESTYLE) {
-					cout << "\tFound occludee" << endl;
-				}
 #endif
-			}
-			else {
-				fe->setOccludeeEmpty(true);
-			}
+		}
+		else {
+			fe->setOccludeeEmpty(true);
+		}
 
-			++nSamples;
-			fe = fe->nextEdge();
-		} while ((maxCard < qiMajority) && (fe) && (fe != festart));
+		++nSamples;
+		fe = fe->nextEdge();
+	} while ((maxCard < qiMajority) && (fe) && (fe != festart));
 
 #if LOGGING
-		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "\tFinished with " << nSamples << " samples, maxCard = " << maxCard << endl;
-		}
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		cout << "\tFinished with " << nSamples << " samples, maxCard = " << maxCard << endl;
+	}
 #endif
 
-		// ViewEdge
-		// qi --
-		// Find the minimum value that is >= the majority of the QI
-		for (unsigned count = 0, i = 0; i < 256; ++i) {
-			count += qiClasses[i];
-			if (count >= qiMajority) {
-				(*ve)->setQI(i);
-				break;
-			}
-		}
-		// occluders --
-		// I would rather not have to go through the effort of creating this set and then copying out its contents.
-		// Is there a reason why ViewEdge::_Occluders cannot be converted to a set<>?
-		for (set<ViewShape*>::iterator o = foundOccluders.begin(), oend = foundOccluders.end(); o != oend; ++o) {
-			(*ve)->AddOccluder((*o));
+	// ViewEdge
+	// qi --
+	// Find the minimum value that is >= the majority of the QI
+	for (unsigned count = 0, i = 0; i < 256; ++i) {
+		count += qiClasses[i];
+		if (count >= qiMajority) {
+			ve->setQI(i);
+			break;
 		}
+	}
+	// occluders --
+	// I would rather not have to go through the effort of creating this set and then copying out its contents.
+	// Is there a reason why ViewEdge::_Occluders cannot be converted to a set<>?
+	for (set<ViewShape*>::iterator o = foundOccluders.begin(), oend = foundOccluders.end(); o != oend; ++o) {
+		ve->AddOccluder((*o));
+	}
 #if LOGGING
-		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "\tConclusion: QI = " << maxIndex << ", " << (*ve)->occluders_size() << " occluders." << endl;
-		}
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		cout << "\tConclusion: QI = " << maxIndex << ", " << ve->occluders_size() << " occluders." << endl;
+	}
 #else
-		(void)maxIndex;
+	(void)maxIndex;
 #endif
-		// occludee --
-		if (!wFaces.empty()) {
-			if (wFaces.size() <= (float)nSamples / 2.0f) {
-				(*ve)->setaShape(0);
-			}
-			else {
-				ViewShape *vshape = ioViewMap->viewShape((*wFaces.begin())->GetVertex(0)->shape()->GetId());
-				(*ve)->setaShape(vshape);
-			}
+	// occludee --
+	if (!wFaces.empty()) {
+		if (wFaces.size() <= (float)nSamples / 2.0f) {
+			ve->setaShape(0);
+		}
+		else {
+			ViewShape *vshape = ioViewMap->viewShape((*wFaces.begin())->GetVertex(0)->shape()->GetId());
+			ve->setaShape(vshape);
 		}
-
-		wFaces.clear();
-	}
-	if (iRenderMonitor && vedges.size()) {
-		stringstream ss;
-		ss << "Freestyle: Visibility computations " << (100 * cnt / vedges.size()) << "%";
-		iRenderMonitor->setInfo(ss.str());
-		iRenderMonitor->progress((float)cnt / vedges.size());
 	}
 }
 
 template <typename G, typename I>
-static void computeDetailedVisibility(ViewMap *ioViewMap, G& grid, real epsilon, RenderMonitor *iRenderMonitor)
+static void computeDetailedVisibility(ViewMap *ioViewMap, ViewEdge *ve, G& grid, real epsilon)
 {
-	vector<ViewEdge*>& vedges = ioViewMap->ViewEdges();
-
 	FEdge *fe, *festart;
 	int nSamples = 0;
 	vector<WFace*> wFaces;
@@ -616,163 +592,222 @@ static void computeDetailedVisibility(ViewMap *ioViewMap, G& grid, real epsilon,
 	unsigned qiClasses[256];
 	unsigned maxIndex, maxCard;
 	unsigned qiMajority;
-	for (vector<ViewEdge*>::iterator ve = vedges.begin(), veend = vedges.end(); ve != veend; ve++) {
-		if (iRenderMonitor && iRenderMonitor->testBreak())
-			break;
+#if LOGGING
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		cout << "Processing ViewEdge " << ve->getId() << endl;
+	}
+#endif
+	// Find an edge to test
+	if (!ve->isInImage()) {
+		// This view edge has been proscenium culled
+		ve->setQI(255);
+		ve->setaShape(0);
 #if LOGGING
 		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "Processing ViewEdge " << (*ve)->getId() << endl;
+			cout << "\tCulled." << endl;
 		}
 #endif
-		// Find an edge to test
-		if (!(*ve)->isInImage()) {
-			// This view edge has been proscenium culled
-			(*ve)->setQI(255);
-			(*ve)->setaShape(0);
+		return;
+	}
+
+	// Test edge
+	festart = ve->fedgeA();
+	fe = ve->fedgeA();
+	qiMajority = 0;
+	do {
+		if (fe != NULL && fe->isInImage()) {
+			qiMajority++;
+		}
+		fe = fe->nextEdge();
+	} while (fe && fe != festart);
+
+	if (qiMajority == 0) {
+		// There are no occludable FEdges on this ViewEdge
+		// This should be impossible.
+		if (_global.debug & G_DEBUG_FREESTYLE) {
+			cout << "View Edge in viewport without occludable FEdges: " << ve->getId() << endl;
+		}
+		// We can recover from this error:
+		// Treat this edge as fully visible with no occludee
+		ve->setQI(0);
+		ve->setaShape(0);
+		return;
+	}
+	else {
+		++qiMajority;
+		qiMajority >>= 1;
+	}
 #if LOGGING
-			if (_global.debug & G_DEBUG_FREESTYLE) {
-				cout << "\tCulled." << endl;
-			}
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		cout << "\tqiMajority: " << qiMajority << endl;
+	}
 #endif
-			continue;
-		}
 
-		// Test edge
-		festart = (*ve)->fedgeA();
-		fe = (*ve)->fedgeA();
-		qiMajority = 0;
-		do {
-			if (fe != NULL && fe->isInImage()) {
-				qiMajority++;
-			}
-			fe = fe->nextEdge();
-		} while (fe && fe != festart);
+	tmpQI = 0;
+	maxIndex = 0;
+	maxCard = 0;
+	nSamples = 0;
+	memset(qiClasses, 0, 256 * sizeof(*qiClasses));
+	set<ViewShape*> foundOccluders;
 
-		if (qiMajority == 0) {
-			// There are no occludable FEdges on this ViewEdge
-			// This should be impossible.
-			if (_global.debug & G_DEBUG_FREESTYLE) {
-				cout << "View Edge in viewport without occludable FEdges: " << (*ve)->getId() << endl;
-			}
-			// We can recover from this error:
-			// Treat this edge as fully visible with no occludee
-			(*ve)->setQI(0);
-			(*ve)->setaShape(0);
+	fe = ve->fedgeA();
+	do {
+		if (fe == NULL || ! fe->isInImage()) {
+			fe = fe->nextEdge();
 			continue;
 		}
-		else {
-			++qiMajority;
-			qiMajority >>= 1;
-		}
+		if ((maxCard < qiMajority)) {
+			//ARB: change &wFace to wFace and use reference in called function
+			tmpQI = computeVisibility<G, I>(ioViewMap, fe, grid, epsilon, ve, &wFace, &foundOccluders);
 #if LOGGING
-		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "\tqiMajority: " << qiMajority << endl;
-		}
+			if (_global.debug & G_DEBUG_FREESTYLE) {
+				cout << "\tFEdge: visibility " << tmpQI << endl;
+			}
 #endif
 
-		tmpQI = 0;
-		maxIndex = 0;
-		maxCard = 0;
-		nSamples = 0;
-		memset(qiClasses, 0, 256 * sizeof(*qiClasses));
-		set<ViewShape*> foundOccluders;
+			//ARB: This is an error condition, not an alert condition.
+			// Some sort of recovery or abort is necessary.
+			if (tmpQI >= 256) {
+				cerr << "Warning: too many occluding levels" << endl;
+				//ARB: Wild guess: instead of aborting or corrupting memory, treat as tmpQI == 255
+				tmpQI = 255;
+			}
 
-		fe = (*ve)->fedgeA();
-		do {
-			if (fe == NULL || ! fe->isInImage()) {
-				fe = fe->nextEdge();
-				continue;
+			if (++qiClasses[tmpQI] > maxCard) {
+				maxCard = qiClasses[tmpQI];
+				maxIndex = tmpQI;
 			}
-			if ((maxCard < qiMajority)) {
-				//ARB: change &wFace to wFace and use reference in called function
-				tmpQI = computeVisibility<G, I>(ioViewMap, fe, grid, epsilon, *ve, &wFace, &foundOccluders);
+		}
+		else {
+			//ARB: FindOccludee is redundant if ComputeRayCastingVisibility has been called
+			//ARB: change &wFace to wFace and use reference in called function
+			findOccludee<G, I>(fe, grid, epsilon, ve, &wFace);
 #if LOGGING
-				if (_global.debug & G_DEBUG_FREESTYLE) {
-					cout << "\tFEdge: visibility " << tmpQI << endl;
-				}
+			if (_global.debug & G_DEBUG_FREESTYLE) {
+				cout << "\tFEdge: occludee only (" << (wFace != NULL ? "found" : "not found") << ")" << endl;
+			}
 #endif
+		}
 
-				//ARB: This is an error condition, not an alert condition.
-				// Some sort of recovery or abort is necessary.
-				if (tmpQI >= 256) {
-					cerr << "Warning: too many occluding levels" << endl;
-					//ARB: Wild guess: instead of aborting or corrupting memory, treat as tmpQI == 255
-					tmpQI = 255;
-				}
-
-				if (++qiClasses[tmpQI] > maxCard) {
-					maxCard = qiClasses[tmpQI];
-					maxIndex = tmpQI;
-				}
+		// Store test results
+		if (wFace) {
+			vector<Vec3r> vertices;
+			for (int i = 0, numEdges = wFace->numberOfEdges(); i < numEdges; ++i) {
+				vertices.push_back(Vec3r(wFace->GetVertex(i)->GetVertex()));
 			}
-			else {
-				//ARB: FindOccludee is redundant if ComputeRayCastingVisibility has been called
-				//ARB: change &wFace to wFace and use reference in called function
-				findOccludee<G, I>(fe, grid, epsilon, *ve, &wFace);
+			Polygon3r poly(vertices, wFace->GetNormal());
+			poly.userdata = (void *)wFace;
+			fe->setaFace(poly);
+			wFaces.push_back(wFace);
+			fe->setOccludeeEmpty(false);
 #if LOGGING
-				if (_global.debug & G_DEBUG_FREESTYLE) {
-					cout << "\tFEdge: occludee only (" << (wFace != NULL ? "found" : "not found") << ")" << endl;
-				}
-#endif
+			if (_global.debug & G_DEBUG_FREESTYLE) {
+				cout << "\tFound occludee" << endl;
 			}
-
-			// Store test results
-			if (wFace) {
-				vector<Vec3r> vertices;
-				for (int i = 0, numEdges = wFace->numberOfEdges(); i < numEdges; ++i) {
-					vertices.push_back(Vec3r(wFace->GetVertex(i)->GetVertex()));
-				}
-				Polygon3r poly(vertices, wFace->GetNormal());
-				poly.userdata = (void *)wFace;
-				fe->setaFace(poly);
-				wFaces.push_back(wFace);
-				fe->setOccludeeEmpty(false);
-#if LOGGING
-				if (_global.debug & G_DEBUG_FREESTYLE) {
-					cout << "\tFound occludee" << endl;
-				}
 #endif
-			}
-			else {
-				fe->setOccludeeEmpty(true);
-			}
+		}
+		else {
+			fe->setOccludeeEmpty(true);
+		}
 
-			++nSamples;
-			fe = fe->nextEdge();
-		} while ((maxCard < qiMajority) && (fe) && (fe != festart));
+		++nSamples;
+		fe = fe->nextEdge();
+	} while ((maxCard < qiMajority) && (fe) && (fe != festart));
 
 #if LOGGING
-		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "\tFinished with " << nSamples << " samples, maxCard = " << maxCard << endl;
-		}
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		cout << "\tFinished with " << nSamples << " samples, maxCard = " << maxCard << endl;
+	}
 #endif
 
-		// ViewEdge
-		// qi --
-		(*ve)->setQI(maxIndex);
-		// occluders --
-		// I would rather not have to go through the effort of creating this this set and then copying out its contents.
-		// Is there a reason why ViewEdge::_Occluders cannot be converted to a set<>?
-		for (set<ViewShape*>::iterator o = foundOccluders.begin(), oend = foundOccluders.end(); o != oend; ++o) {
-			(*ve)->AddOccluder((*o));
-		}
+	// ViewEdge
+	// qi --
+	ve->setQI(maxIndex);
+	// occluders --
+	// I would rather not have to go through the effort of creating this this set and then copying out its contents.
+	// Is there a reason why ViewEdge::_Occluders cannot be converted to a set<>?
+	for (set<ViewShape*>::iterator o = foundOccluders.begin(), oend = foundOccluders.end(); o != oend; ++o) {
+		ve->AddOccluder((*o));
+	}
 #if LOGGING
-		if (_global.debug & G_DEBUG_FREESTYLE) {
-			cout << "\tConclusion: QI = " << maxIndex << ", " << (*ve)->occluders_size() << " occluders." << endl;
-		}
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		cout << "\tConclusion: QI = " << maxIndex << ", " << ve->occluders_size() << " occluders." << endl;
+	}
 #endif
-		// occludee --
-		if (!wFaces.empty()) {
-			if (wFaces.size() <= (float)nSamples / 2.0f) {
-				(*ve)->setaShape(0);
-			}
-			else {
-				ViewShape *vshape = ioViewMap->viewShape((*wFaces.begin())->GetVertex(0)->shape()->GetId());
-				(*ve)->setaShape(vshape);
-			}
+	// occludee --
+	if (!wFaces.empty()) {
+		if (wFaces.size() <= (float)nSamples / 2.0f) {
+			ve->setaShape(0);
+		}
+		else {
+			ViewShape *vshape = ioViewMap->viewShape((*wFaces.begin())->GetVertex(0)->shape()->GetId());
+			ve->setaShape(vshape);
 		}
+	}
+}
 
-		wFaces.clear();
+template <typename G>
+struct VisibilityTaskData
+{
+	ViewMap *viewMap;
+	ViewEdge **viewEdges;
+	G *grid;
+	real epsilon;
+};
+
+template <typename G, typename I>
+static void computeCumulativeVisibilityTask(void *userdata, const int index)
+{
+	VisibilityTaskData<G> *data = (VisibilityTaskData<G> *)userdata;
+	computeCumulativeVisibility<G, I>(data->viewMap, data->viewEdges[index], *data->grid, data->epsilon);
+}
+
+template <typename G, typename I>
+static void computeDetailedVisibilityTask(void *userdata, const int index)
+{
+	VisibilityTaskData<G> *data = (VisibilityTaskData<G> *)userdata;
+	computeDetailedVisibility<G, I>(data->viewMap, data->viewEdges[index], *data->grid, data->epsilon);
+}
+
+// Minimal number of view edges processed by one parallel range.
+static const unsigned gVisibilityMinBlockSize = 256;
+
+// Visibility of a view edge only depends on the grid, which is read-only once it is built, and each iterator keeps
+// its own state, so view edges are processed in parallel. This is done in blocks, to test for cancellation and
+// report progress from the calling thread in between.
+template <typename G>
+static void computeVisibilityParallel(ViewMap *ioViewMap, G& grid, real epsilon, RenderMonitor *iRenderMonitor,
+                                      TaskParallelRangeFunc func)
+{
+	vector<ViewEdge*>& vedges = ioViewMap->ViewEdges();
+	const unsigned numEdges = vedges.size();
+	const unsigned blockSize = max(gVisibilityMinBlockSize, (unsigned)ceil(0.01f * numEdges));
+
+	VisibilityTaskData<G> data;
+	data.viewMap = ioViewMap;
+	data.viewEdges = (numEdges != 0) ? &vedges[0] : NULL;
+	data.grid = &grid;
+	data.epsilon = epsilon;
+
+	unsigned cnt = 0;
+	while (cnt < numEdges) {
+		if (iRenderMonitor) {
+			if (iRenderMonitor->testBreak())
+				break;
+			stringstream ss;
+			ss << "Freestyle: Visibility computations " << (100 * cnt / numEdges) << "%";
+			iRenderMonitor->setInfo(ss.str());
+			iRenderMonitor->progress((float)cnt / numEdges);
+		}
+		const unsigned end = min(cnt + blockSize, numEdges);
+		BLI_task_parallel_range(cnt, end, &data, func, true);
+		cnt = end;
+	}
+	if (iRenderMonitor && numEdges) {
+		stringstream ss;
+		ss << "Freestyle: Visibility computations " << (100 * cnt / numEdges) << "%";
+		iRenderMonitor->setInfo(ss.str());
+		iRenderMonitor->progress((float)cnt / numEdges);
 	}
 }
 
@@ -998,17 +1033,40 @@ ViewMap *ViewMapBuilder::BuildViewMap(WingedEdge& we, visibility_algo iAlgo, rea
 	_currentFId = 0;
 	_currentSVertexId = 0;
 
+	Chronometer chrono;
+	real duration;
+
 	// Builds initial view edges
+	chrono.start();
 	computeInitialViewEdges(we);
+	duration = chrono.stop();
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		printf("  Initial view edges : %lf\n", duration);
+	}
 
 	// Detects cusps
-	computeCusps(_ViewMap); 
+	chrono.start();
+	computeCusps(_ViewMap);
+	duration = chrono.stop();
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		printf("  Cusps              : %lf\n", duration);
+	}
 
 	// Compute intersections
+	chrono.start();
 	ComputeIntersections(_ViewMap, sweep_line, epsilon);
+	duration = chrono.stop();
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		printf("  Intersections      : %lf\n", duration);
+	}
 
 	// Compute visibility
+	chrono.start();
 	ComputeEdgesVisibility(_ViewMap, we, bbox, sceneNumFaces, iAlgo, epsilon);
+	duration = chrono.stop();
+	if (_global.debug & G_DEBUG_FREESTYLE) {
+		printf("  Visibility         : %lf\n", duration);
+	}
 
 	return _ViewMap;
 }
@@ -1191,9 +1249,49 @@ void ViewMapBuilder::CullViewEdges(ViewMap *ioViewMap, real viewProscenium[4], r
 	}
 }
 
+struct ShapeViewEdgesData
+{
+	WXShape *wshape;
+	ViewShape *vshape;
+	RenderMonitor *renderMonitor;
+	// Number of view edge and feature edge ids used by the shape, counting from zero.
+	int numViewIds;
+	int numFIds;
+};
+
+static void computeShapeViewEdges(void *userdata, const int index)
+{
+	ShapeViewEdgesData *data = &((ShapeViewEdgesData *)userdata)[index];
+
+	// A skipped shape keeps an empty view shape, which the numbering below handles as any other shape.
+	if (data->renderMonitor && data->renderMonitor->testBreak())
+		return;
+
+	ViewEdgeXBuilder builder;
+
+	// The builder numbers view edges from one by default, the ids are offset per shape afterwards.
+	builder.setCurrentViewId(0);
+	builder.setCurrentFId(0);
+	builder.setCurrentSVertexId(0);
+
+	// Elements are stored in the view shape as well, the view map is filled in from there
+	vector<ViewEdge*> vedges;
+	vector<ViewVertex*> vvertices;
+	vector<FEdge*> fedges;
+	vector<SVertex*> svertices;
+
+	builder.BuildViewEdges(data->wshape, data->vshape, vedges, vvertices, fedges, svertices);
+
+	data->numViewIds = builder.currentViewId();
+	data->numFIds = builder.currentFId();
+
+	data->vshape->sshape()->ComputeBBox();
+}
+
 void ViewMapBuilder::computeInitialViewEdges(WingedEdge& we)
 {
 	vector<WShape*> wshapes = we.getWShapes();
+	vector<ShapeViewEdgesData> shapes;
 	SShape *psShape;
 
 	for (vector<WShape*>::const_iterator it = wshapes.begin(); it != wshapes.end(); it++) {
@@ -1212,20 +1310,51 @@ void ViewMapBuilder::computeInitialViewEdges(WingedEdge& we)
 		// add this view shape to the view map:
 		_ViewMap->AddViewShape(vshape);
 
-		// we want to number the view edges in a unique way for the while scene.
-		_pViewEdgeBuilder->setCurrentViewId(_currentId);
-		// we want to number the feature edges in a unique way for the while scene.
-		_pViewEdgeBuilder->setCurrentFId(_currentFId);
-		// we want to number the SVertex in a unique way for the while scene.
-		_pViewEdgeBuilder->setCurrentSVertexId(_currentFId);
-		_pViewEdgeBuilder->BuildViewEdges(dynamic_cast<WXShape*>(*it), vshape, _ViewMap->ViewEdges(),
-		                                  _ViewMap->ViewVertices(), _ViewMap->FEdges(), _ViewMap->SVertices());
+		ShapeViewEdgesData data = {dynamic_cast<WXShape*>(*it), vshape, _pRenderMonitor, 0, 0};
+		shapes.push_back(data);
+	}
 
-		_currentId = _pViewEdgeBuilder->currentViewId() + 1;
-		_currentFId = _pViewEdgeBuilder->currentFId() + 1;
-		_currentSVertexId = _pViewEdgeBuilder->currentSVertexId() + 1;
+	if (shapes.empty())
+		return;
 
-		psShape->ComputeBBox();
+	// Shapes share no topology, so their view edges are built in parallel, with ids counting from zero.
+	BLI_task_parallel_range(0, shapes.size(), &shapes[0], computeShapeViewEdges, shapes.size() > 1);
+
+	// Number the view edges, feature edges and SVertex in a unique way for the whole scene, in the same
+	// order as if shapes were built one after another.
+	for (vector<ShapeViewEdgesData>::iterator data = shapes.begin(); data != shapes.end(); ++data) {
+		ViewShape *vshape = data->vshape;
+		vector<ViewEdge*>& vedges = vshape->edges();
+		vector<ViewVertex*>& vvertices = vshape->vertices();
+		vector<FEdge*>& fedges = vshape->sshape()->getEdgeList();
+		vector<SVertex*>& svertices = vshape->sshape()->getVertexList();
+
+		// Elements are stored in creation order, sequential building numbered them consecutively from the
+		// current ids, which the asserts check.
+		BLI_assert(data->numViewIds == (int)vedges.size());
+		BLI_assert(data->numFIds == (int)fedges.size());
+		for (unsigned int i = 0; i < vedges.size(); i++) {
+			vedges[i]->setId(Id(vedges[i]->getId().getFirst() + _currentId));
+			BLI_assert(vedges[i]->getId().getFirst() == _currentId + i);
+		}
+		for (unsigned int i = 0; i < fedges.size(); i++) {
+			fedges[i]->setId(Id(fedges[i]->getId().getFirst() + _currentFId));
+			BLI_assert(fedges[i]->getId().getFirst() == _currentFId + i);
+		}
+		// SVertex ids start from the current FEdge id, as they always did.
+		for (unsigned int i = 0; i < svertices.size(); i++) {
+			svertices[i]->setId(Id(svertices[i]->getId().getFirst() + _currentFId));
+			BLI_assert(svertices[i]->getId().getFirst() == _currentFId + i);
+		}
+
+		_ViewMap->FEdges().insert(_ViewMap->FEdges().end(), fedges.begin(), fedges.end());
+		_ViewMap->SVertices().insert(_ViewMap->SVertices().end(), svertices.begin(), svertices.end());
+		_ViewMap->ViewVertices().insert(_ViewMap->ViewVertices().end(), vvertices.begin(), vvertices.end());
+		_ViewMap->ViewEdges().insert(_ViewMap->ViewEdges().end(), vedges.begin(), vedges.end());
+
+		_currentSVertexId = _currentFId + svertices.size() + 1;
+		_currentId += data->numViewIds + 1;
+		_currentFId += data->numFIds + 1;
 	}
 }
 
@@ -1322,11 +1451,13 @@ void ViewMapBuilder::ComputeCumulativeVisibility(ViewMap *ioViewMap, WingedEdge&
 
 	if (_orthographicProjection) {
 		BoxGrid grid(*source, *density, ioViewMap, _viewpoint, _EnableQI);
-		computeCumulativeVisibility<BoxGrid, BoxGrid::Iterator>(ioViewMap, grid, epsilon, _pRenderMonitor);
+		computeVisibilityParallel(ioViewMap, grid, epsilon, _pRenderMonitor,
+		                          computeCumulativeVisibilityTask<BoxGrid, BoxGrid::Iterator>);
 	}
 	else {
 		SphericalGrid grid(*source, *density, ioViewMap, _viewpoint, _EnableQI);
-		computeCumulativeVisibility<SphericalGrid, SphericalGrid::Iterator>(ioViewMap, grid, epsilon, _pRenderMonitor);
+		computeVisibilityParallel(ioViewMap, grid, epsilon, _pRenderMonitor,
+		                          computeCumulativeVisibilityTask<SphericalGrid, SphericalGrid::Iterator>);
 	}
 }
 
@@ -1354,11 +1485,13 @@ void ViewMapBuilder::ComputeDetailedVisibility(ViewMap *ioViewMap, WingedEdge& w
 
 	if (_orthographicProjection) {
 		BoxGrid grid(*source, *density, ioViewMap, _viewpoint, _EnableQI);
-		computeDetailedVisibility<BoxGrid, BoxGrid::Iterator>(ioViewMap, grid, epsilon, _pRenderMonitor);
+		computeVisibilityParallel(ioViewMap, grid, epsilon, _pRenderMonitor,
+		                          computeDetailedVisibilityTask<BoxGrid, BoxGrid::Iterator>);
 	}
 	else {
 		SphericalGrid grid(*source, *density, ioViewMap, _viewpoint, _EnableQI);
-		computeDetailedVisibility<SphericalGrid, SphericalGrid::Iterator>(ioViewMap, grid, epsilon, _pRenderMonitor);
+		computeVisibilityParallel(ioViewMap, grid, epsilon, _pRenderMonitor,
+		                          computeDetailedVisibilityTask<SphericalGrid, SphericalGrid::Iterator>);
 	}
 }
 
@@ -70,7 +70,6 @@ private:
 	Vec3r _viewpoint;
 	bool _orthographicProjection;
 	Grid *_Grid;
-	ViewEdgeXBuilder *_pViewEdgeBuilder;
 	bool _EnableQI;
 	double _epsilon;
 
@@ -102,17 +101,10 @@ public:
 		_currentId = 1;
 		_currentFId = 0;
 		_currentSVertexId = 0;
-		_pViewEdgeBuilder = new ViewEdgeXBuilder;
 		_EnableQI = true;
 	}
 
-	inline ~ViewMapBuilder()
-	{
-		if (_pViewEdgeBuilder) {
-			delete _pViewEdgeBuilder;
-			_pViewEdgeBuilder = NULL;
-		}
-	}
+	inline ~ViewMapBuilder() {}
 
 	/* Build Grid for ray casting */
 	/*! Build non-culled Grid in camera space for ray casting */
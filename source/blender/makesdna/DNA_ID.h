@@ -349,6 +349,9 @@ enum {
 	LIB_TAG_ID_RECALC_DATA  = 1 << 13,
 	LIB_TAG_ANIM_NO_RECALC  = 1 << 14,
 	LIB_TAG_ID_RECALC_ALL   = (LIB_TAG_ID_RECALC | LIB_TAG_ID_RECALC_DATA),
+
+	/* RESET_AFTER_USE, datablock changed since the last global undo step was written. */
+	LIB_TAG_UNDO_CHANGED    = 1 << 15,
 };
 
 /* To filter ID types (filter_id) */
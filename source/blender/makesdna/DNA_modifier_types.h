@@ -443,6 +443,8 @@ typedef struct DecimateModifierData {
 	char defgrp_name[64];  /* MAX_VGROUP_NAME */
 	float defgrp_factor;
 	short flag, mode;
+	float batch_factor;  /* (mode == MOD_DECIM_MODE_COLLAPSE) */
+	char pad[4];
 
 	/* runtime only */
 	int face_count;
@@ -1752,6 +1752,14 @@ bool RNA_property_path_from_ID_check(PointerRNA *ptr, PropertyRNA *prop)
 	return ret;
 }
 
+/* The next global undo step has to write the datablock again, tagged on every set
+ * since not all of them are followed by an update (raw access, no update check). */
+static void rna_property_tag_undo_changed(PointerRNA *ptr)
+{
+	if (ptr->id.data) {
+		((ID *)ptr->id.data)->tag |= LIB_TAG_UNDO_CHANGED;
+	}
+}
 
 static void rna_property_update(bContext *C, Main *bmain, Scene *scene, PointerRNA *ptr, PropertyRNA *prop)
 {
@@ -1778,6 +1786,8 @@ static void rna_property_update(bContext *C, Main *bmain, Scene *scene, PointerR
 		if (prop->noteflag)
 			WM_main_add_notifier(prop->noteflag, ptr->id.data);
 	}
+
+	rna_property_tag_undo_changed(ptr);
 	
 	if (!is_rna || (prop->flag & PROP_IDPROPERTY)) {
 		/* WARNING! This is so property drivers update the display!
@@ -1951,6 +1961,8 @@ void RNA_property_boolean_set(PointerRNA *ptr, PropertyRNA *prop, int value)
 	BoolPropertyRNA *bprop = (BoolPropertyRNA *)prop;
 	IDProperty *idprop;
 
+	rna_property_tag_undo_changed(ptr);
+
 	BLI_assert(RNA_property_type(prop) == PROP_BOOLEAN);
 	BLI_assert(RNA_property_array_check(prop) == false);
 	BLI_assert(ELEM(value, false, true));
@@ -2040,6 +2052,8 @@ void RNA_property_boolean_set_array(PointerRNA *ptr, PropertyRNA *prop, const in
 	BoolPropertyRNA *bprop = (BoolPropertyRNA *)prop;
 	IDProperty *idprop;
 
+	rna_property_tag_undo_changed(ptr);
+
 	BLI_assert(RNA_property_type(prop) == PROP_BOOLEAN);
 	BLI_assert(RNA_property_array_check(prop) != false);
 
@@ -2175,6 +2189,8 @@ void RNA_property_int_set(PointerRNA *ptr, PropertyRNA *prop, int value)
 	IntPropertyRNA *iprop = (IntPropertyRNA *)prop;
 	IDProperty *idprop;
 
+	rna_property_tag_undo_changed(ptr);
+
 	BLI_assert(RNA_property_type(prop) == PROP_INT);
 	BLI_assert(RNA_property_array_check(prop) == false);
 	/* useful to check on bad values but set function should clamp */
@@ -2298,6 +2314,8 @@ void RNA_property_int_set_array(PointerRNA *ptr, PropertyRNA *prop, const int *v
 	IntPropertyRNA *iprop = (IntPropertyRNA *)prop;
 	IDProperty *idprop;
 
+	rna_property_tag_undo_changed(ptr);
+
 	BLI_assert(RNA_property_type(prop) == PROP_INT);
 	BLI_assert(RNA_property_array_check(prop) != false);
 
@@ -2434,6 +2452,8 @@ void RNA_property_float_set(PointerRNA *ptr, PropertyRNA *prop, float value)
 	FloatPropertyRNA *fprop = (FloatPropertyRNA *)prop;
 	IDProperty *idprop;
 
+	rna_property_tag_undo_changed(ptr);
+
 	BLI_assert(RNA_property_type(prop) == PROP_FLOAT);
 	BLI_assert(RNA_property_array_check(prop) == false);
 	/* useful to check on bad values but set function should clamp */
@@ -2570,6 +2590,8 @@ void RNA_property_float_set_array(PointerRNA *ptr, PropertyRNA *prop, const floa
 	IDProperty *idprop;
 	int i;
 
+	rna_property_tag_undo_changed(ptr);
+
 	BLI_assert(RNA_property_type(prop) == PROP_FLOAT);
 	BLI_assert(RNA_property_array_check(prop) != false);
 
@@ -2789,6 +2811,8 @@ void RNA_property_string_set(PointerRNA *ptr, PropertyRNA *prop, const char *val
 	StringPropertyRNA *sprop = (StringPropertyRNA *)prop;
 	IDProperty *idprop;
 
+	rna_property_tag_undo_changed(ptr);
+
 	BLI_assert(RNA_property_type(prop) == PROP_STRING);
 
 	if ((idprop = rna_idproperty_check(&prop, ptr))) {
@@ -2869,6 +2893,8 @@ void RNA_property_enum_set(PointerRNA *ptr, PropertyRNA *prop, int value)
 	EnumPropertyRNA *eprop = (EnumPropertyRNA *)prop;
 	IDProperty *idprop;
 
+	rna_property_tag_undo_changed(ptr);
+
 	BLI_assert(RNA_property_type(prop) == PROP_ENUM);
 
 	if ((idprop = rna_idproperty_check(&prop, ptr))) {
@@ -2984,6 +3010,8 @@ void RNA_property_pointer_set(PointerRNA *ptr, PropertyRNA *prop, PointerRNA ptr
 {
 	/*IDProperty *idprop;*/
 
+	rna_property_tag_undo_changed(ptr);
+
 	BLI_assert(RNA_property_type(prop) == PROP_POINTER);
 
 	if ((/*idprop = */ rna_idproperty_check(&prop, ptr))) {
@@ -3166,6 +3194,8 @@ void RNA_property_collection_add(PointerRNA *ptr, PropertyRNA *prop, PointerRNA
 	IDProperty *idprop;
 /*	CollectionPropertyRNA *cprop = (CollectionPropertyRNA *)prop; */
 
+	rna_property_tag_undo_changed(ptr);
+
 	BLI_assert(RNA_property_type(prop) == PROP_COLLECTION);
 
 	if ((idprop = rna_idproperty_check(&prop, ptr))) {
@@ -3229,6 +3259,8 @@ bool RNA_property_collection_remove(PointerRNA *ptr, PropertyRNA *prop, int key)
 	IDProperty *idprop;
 /*	CollectionPropertyRNA *cprop = (CollectionPropertyRNA *)prop; */
 
+	rna_property_tag_undo_changed(ptr);
+
 	BLI_assert(RNA_property_type(prop) == PROP_COLLECTION);
 
 	if ((idprop = rna_idproperty_check(&prop, ptr))) {
@@ -3280,6 +3312,8 @@ bool RNA_property_collection_move(PointerRNA *ptr, PropertyRNA *prop, int key, i
 {
 	IDProperty *idprop;
 
+	rna_property_tag_undo_changed(ptr);
+
 	BLI_assert(RNA_property_type(prop) == PROP_COLLECTION);
 
 	if ((idprop = rna_idproperty_check(&prop, ptr))) {
@@ -3311,6 +3345,8 @@ void RNA_property_collection_clear(PointerRNA *ptr, PropertyRNA *prop)
 {
 	IDProperty *idprop;
 
+	rna_property_tag_undo_changed(ptr);
+
 	BLI_assert(RNA_property_type(prop) == PROP_COLLECTION);
 
 	if ((idprop = rna_idproperty_check(&prop, ptr))) {
@@ -3866,6 +3902,7 @@ int RNA_property_collection_raw_get(ReportList *reports, PointerRNA *ptr, Proper
 int RNA_property_collection_raw_set(ReportList *reports, PointerRNA *ptr, PropertyRNA *prop, const char *propname,
                                     void *array, RawPropertyType type, int len)
 {
+	rna_property_tag_undo_changed(ptr);
 	return rna_raw_access(reports, ptr, prop, propname, array, type, len, 1);
 }
 
@@ -1614,6 +1614,15 @@ static void rna_def_modifier_decimate(BlenderRNA *brna)
 	RNA_def_property_ui_range(prop, 0, 10, 1, 4);
 	RNA_def_property_ui_text(prop, "Factor", "Vertex group strength");
 	RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
+	prop = RNA_def_property(srna, "batch_factor", PROP_FLOAT, PROP_FACTOR);
+	RNA_def_property_float_sdna(prop, NULL, "batch_factor");
+	RNA_def_property_range(prop, 0, 1);
+	RNA_def_property_ui_range(prop, 0, 1, 1, 3);
+	RNA_def_property_ui_text(prop, "Batch",
+	                         "Share of the remaining edges collapsed together in each multi-threaded step, "
+	                         "faster but less accurate, zero collapses one edge at a time (not used with symmetry)");
+	RNA_def_property_update(prop, 0, "rna_Modifier_update");
 	/* end collapse-only option */
 
 	/* (mode == MOD_DECIM_MODE_DISSOLVE) */
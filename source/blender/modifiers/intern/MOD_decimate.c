@@ -168,7 +168,7 @@ static DerivedMesh *applyModifier(ModifierData *md, Object *ob,
 			const float symmetry_eps = 0.00002f;
 			BM_mesh_decimate_collapse(
 			        bm, dmd->percent, vweights, dmd->defgrp_factor, do_triangulate,
-			        symmetry_axis, symmetry_eps);
+			        symmetry_axis, symmetry_eps, dmd->batch_factor);
 			break;
 		}
 		case MOD_DECIM_MODE_UNSUBDIV:
@@ -35,6 +35,8 @@
 
 #include "BKE_idprop.h"
 
+#include "DNA_ID.h"
+
 #define USE_STRING_COERCE
 
 #ifdef USE_STRING_COERCE
@@ -588,6 +590,11 @@ int BPy_Wrap_SetMapItem(IDProperty *prop, PyObject *key, PyObject *val)
 
 static int BPy_IDGroup_Map_SetItem(BPy_IDProperty *self, PyObject *key, PyObject *val)
 {
+	/* the next global undo step has to write the datablock again */
+	if (self->id) {
+		self->id->tag |= LIB_TAG_UNDO_CHANGED;
+	}
+
 	return BPy_Wrap_SetMapItem(self->prop, key, val);
 }
 
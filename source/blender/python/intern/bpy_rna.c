@@ -3276,6 +3276,11 @@ static int pyrna_struct_ass_subscript(BPy_StructRNA *self, PyObject *key, PyObje
 		return -1;
 	}
 
+	/* the next global undo step has to write the datablock again */
+	if (self->ptr.id.data) {
+		((ID *)self->ptr.id.data)->tag |= LIB_TAG_UNDO_CHANGED;
+	}
+
 	return BPy_Wrap_SetMapItem(group, key, value);
 }
 
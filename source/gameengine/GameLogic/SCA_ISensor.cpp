@@ -38,6 +38,7 @@
 #include "SCA_ISensor.h"
 #include "SCA_EventManager.h"
 #include "SCA_LogicManager.h"
+#include "SCA_Profiler.h"
 // needed for IsTriggered()
 #include "SCA_PythonController.h"
 
@@ -241,7 +242,15 @@ void SCA_ISensor::Activate(class SCA_LogicManager* logicmgr)
 	// calculate if a __triggering__ is wanted
 	// don't evaluate a sensor that is not connected to any controller
 	if (m_links && !m_suspended) {
+		SCA_Profiler *profiler = SCA_Profiler::GetActive();
+		if (profiler && profiler->IsCapturing())
+			profiler->BeginScope(GetParent()->GetName().ReadPtr(), GetName().ReadPtr());
+		else
+			profiler = NULL;
+
 		bool result = this->Evaluate();
+		if (profiler)
+			profiler->EndScope();
 		// store the state for the rest of the logic system
 		m_prev_state = m_state;
 		m_state = this->IsPositiveTrigger();
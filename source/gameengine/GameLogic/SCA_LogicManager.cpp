@@ -37,6 +37,7 @@
 #include "SCA_IActuator.h"
 #include "SCA_EventManager.h"
 #include "SCA_PythonController.h"
+#include "SCA_Profiler.h"
 #include <set>
 
 
@@ -186,8 +187,18 @@ void SCA_LogicManager::RegisterToActuator(SCA_IController* controller,SCA_IActua
 
 void SCA_LogicManager::BeginFrame(double curtime, double fixedtime)
 {
+	SCA_Profiler *profiler = SCA_Profiler::GetActive();
+	if (!(profiler && profiler->IsCapturing()))
+		profiler = NULL;
+
+	if (profiler)
+		profiler->BeginScope("Sensors");
 	for (vector<SCA_EventManager*>::const_iterator ie=m_eventmanagers.begin(); !(ie==m_eventmanagers.end()); ie++)
 		(*ie)->NextFrame(curtime, fixedtime);
+	if (profiler) {
+		profiler->EndScope();
+		profiler->BeginScope("Controllers");
+	}
 
 	for (SG_QList* obj = (SG_QList*)m_triggeredControllerSet.Remove();
 		obj != NULL;
@@ -197,16 +208,28 @@ void SCA_LogicManager::BeginFrame(double curtime, double fixedtime)
 			contr != NULL;
 			contr = (SCA_IController*)obj->QRemove())
 		{
+			if (profiler)
+				profiler->BeginScope(contr->GetParent()->GetName().ReadPtr(), contr->GetName().ReadPtr());
 			contr->Trigger(this);
+			if (profiler)
+				profiler->EndScope();
 			contr->ClrJustActivated();
 		}
 	}
+	if (profiler)
+		profiler->EndScope();
 }
 
 
 
 void SCA_LogicManager::UpdateFrame(double curtime, bool frame)
 {
+	SCA_Profiler *profiler = SCA_Profiler::GetActive();
+	if (!(profiler && profiler->IsCapturing()))
+		profiler = NULL;
+
+	if (profiler)
+		profiler->BeginScope("Actuators");
 	for (vector<SCA_EventManager*>::const_iterator ie=m_eventmanagers.begin(); !(ie==m_eventmanagers.end()); ie++)
 		(*ie)->UpdateFrame();
 
@@ -222,7 +245,12 @@ void SCA_LogicManager::UpdateFrame(double curtime, bool frame)
 			SCA_IActuator* actua = *ia;
 			// increment first to allow removal of inactive actuators.
 			++ia;
-			if (!actua->Update(curtime, frame))
+			if (profiler)
+				profiler->BeginScope(actua->GetParent()->GetName().ReadPtr(), actua->GetName().ReadPtr());
+			bool active = actua->Update(curtime, frame);
+			if (profiler)
+				profiler->EndScope();
+			if (!active)
 			{
 				// this actuator is not active anymore, remove
 				actua->QDelink(); 
@@ -245,6 +273,8 @@ void SCA_LogicManager::UpdateFrame(double curtime, bool frame)
 			ahead->Delink();
 		}
 	}
+	if (profiler)
+		profiler->EndScope();
 }
 
 
@@ -0,0 +1,216 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file gameengine/GameLogic/SCA_Profiler.cpp
+ *  \ingroup gamelogic
+ */
+
+#include <stdio.h>
+
+#include "SCA_Profiler.h"
+
+#include "PIL_time.h"
+
+SCA_Profiler *SCA_Profiler::m_active = NULL;
+
+SCA_Profiler::SCA_Profiler(unsigned int maxNumScopes)
+	:m_maxNumScopes(maxNumScopes),
+	m_frame(0),
+	m_startTime(0.0),
+	m_capturing(false)
+{
+}
+
+SCA_Profiler::~SCA_Profiler()
+{
+	if (m_active == this)
+		m_active = NULL;
+}
+
+SCA_Profiler *SCA_Profiler::GetActive()
+{
+	return m_active;
+}
+
+void SCA_Profiler::SetActive(SCA_Profiler *profiler)
+{
+	m_active = profiler;
+}
+
+void SCA_Profiler::StartCapture()
+{
+	m_scopes.clear();
+	m_stack.clear();
+	m_frame = 0;
+	m_startTime = PIL_check_seconds_timer();
+	m_capturing = true;
+	// the frame in progress is partial but still worth having
+	BeginScopeIntern("Frame", m_startTime, false);
+}
+
+void SCA_Profiler::StopCapture()
+{
+	if (!m_capturing)
+		return;
+
+	double now = PIL_check_seconds_timer();
+	while (!m_stack.empty())
+		EndScopeIntern(now);
+	m_capturing = false;
+}
+
+void SCA_Profiler::BeginScopeIntern(const char *name, double now, bool script)
+{
+	if (m_scopes.size() >= m_maxNumScopes) {
+		printf("Warning: profile capture stopped after %u scopes\n", m_maxNumScopes);
+		StopCapture();
+		return;
+	}
+
+	Scope scope;
+	scope.m_name = name;
+	scope.m_begin = now;
+	scope.m_end = now;
+	scope.m_depth = m_stack.size();
+	scope.m_frame = m_frame;
+	scope.m_script = script;
+
+	m_stack.push_back(m_scopes.size());
+	m_scopes.push_back(scope);
+}
+
+void SCA_Profiler::EndScopeIntern(double now)
+{
+	m_scopes[m_stack.back()].m_end = now;
+	m_stack.pop_back();
+}
+
+void SCA_Profiler::BeginScope(const char *name)
+{
+	// scopes only exist inside a frame
+	if (!m_capturing || m_stack.empty())
+		return;
+
+	BeginScopeIntern(name, PIL_check_seconds_timer(), false);
+}
+
+void SCA_Profiler::BeginScope(const std::string& name)
+{
+	BeginScope(name.c_str());
+}
+
+void SCA_Profiler::BeginScope(const char *owner, const char *name)
+{
+	if (!m_capturing || m_stack.empty())
+		return;
+
+	BeginScope(std::string(owner) + "." + name);
+}
+
+void SCA_Profiler::EndScope()
+{
+	// never close the frame scope, only NextFrame does
+	if (!m_capturing || m_stack.size() < 2)
+		return;
+
+	double now = PIL_check_seconds_timer();
+	// scripts may leave their scopes open, they end with the engine scope around them
+	while (m_stack.size() > 2 && m_scopes[m_stack.back()].m_script)
+		EndScopeIntern(now);
+	EndScopeIntern(now);
+}
+
+void SCA_Profiler::BeginScriptScope(const char *name)
+{
+	if (!m_capturing || m_stack.empty())
+		return;
+
+	BeginScopeIntern(name, PIL_check_seconds_timer(), true);
+}
+
+bool SCA_Profiler::EndScriptScope()
+{
+	// without a capture the matching BeginScriptScope did nothing either
+	if (!m_capturing)
+		return true;
+
+	if (m_stack.size() < 2 || !m_scopes[m_stack.back()].m_script)
+		return false;
+
+	EndScopeIntern(PIL_check_seconds_timer());
+	return true;
+}
+
+void SCA_Profiler::NextFrame()
+{
+	if (!m_capturing)
+		return;
+
+	double now = PIL_check_seconds_timer();
+	while (!m_stack.empty())
+		EndScopeIntern(now);
+
+	m_frame++;
+	BeginScopeIntern("Frame", now, false);
+}
+
+static void write_json_string(FILE *fp, const std::string& str)
+{
+	fputc('"', fp);
+	for (std::string::const_iterator it = str.begin(); it != str.end(); ++it) {
+		const unsigned char c = *it;
+		if (c == '"' || c == '\\')
+			fprintf(fp, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(fp, "\\u%04x", c);
+		else
+			fputc(c, fp);
+	}
+	fputc('"', fp);
+}
+
+bool SCA_Profiler::WriteChromeTrace(const char *filepath) const
+{
+	FILE *fp = fopen(filepath, "w");
+	if (!fp)
+		return false;
+
+	// complete events ("ph": "X") in microseconds, nesting is deduced from the times
+	fprintf(fp, "{\"traceEvents\":[\n");
+	for (std::vector<Scope>::const_iterator it = m_scopes.begin(); it != m_scopes.end(); ++it) {
+		const Scope& scope = *it;
+		if (it != m_scopes.begin())
+			fprintf(fp, ",\n");
+		fprintf(fp, "{\"name\":");
+		write_json_string(fp, scope.m_name);
+		fprintf(fp, ",\"cat\":\"bge\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,"
+		        "\"args\":{\"frame\":%u,\"depth\":%u}}",
+		        (scope.m_begin - m_startTime) * 1e6, (scope.m_end - scope.m_begin) * 1e6,
+		        scope.m_frame, scope.m_depth);
+	}
+	fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+	bool ok = (ferror(fp) == 0);
+	if (fclose(fp) != 0)
+		ok = false;
+	return ok;
+}
@@ -0,0 +1,165 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file SCA_Profiler.h
+ *  \ingroup gamelogic
+ *  \brief Hierarchical per-frame timing of the game loop. Nested scopes are
+ * only recorded while a capture is running, they can then be exported to a
+ * Chrome trace file (chrome://tracing) to look for frame spikes.
+ */
+
+#ifndef __SCA_PROFILER_H__
+#define __SCA_PROFILER_H__
+
+#include <string>
+#include <vector>
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#include "MEM_guardedalloc.h"
+#endif
+
+class SCA_Profiler
+{
+public:
+	/** A closed (or still open) timed scope. */
+	struct Scope {
+		std::string m_name;
+		/** Start and end time in seconds. */
+		double m_begin;
+		double m_end;
+		/** Nesting level, 0 is the frame itself. */
+		unsigned int m_depth;
+		/** Frame number since the capture was started. */
+		unsigned int m_frame;
+		/** Opened by a script, see BeginScriptScope(). */
+		bool m_script;
+	};
+
+	/**
+	 * Constructor.
+	 * \param maxNumScopes Maximum number of scopes recorded in a capture,
+	 *        the capture stops by itself when it is reached.
+	 */
+	SCA_Profiler(unsigned int maxNumScopes = 1000000);
+	~SCA_Profiler();
+
+	/** Profiler receiving the scopes of the running game, may be NULL. */
+	static SCA_Profiler *GetActive();
+	static void SetActive(SCA_Profiler *profiler);
+
+	/** Discards the previous capture and starts recording scopes. */
+	void StartCapture();
+	/** Stops recording, the captured scopes are kept until the next capture. */
+	void StopCapture();
+	bool IsCapturing() const
+	{
+		return m_capturing;
+	}
+
+	/** Opens a scope nested in the currently open one. */
+	void BeginScope(const char *name);
+	void BeginScope(const std::string& name);
+	/** Opens a scope named "owner.name", e.g. for the logic bricks of an object. */
+	void BeginScope(const char *owner, const char *name);
+	/**
+	 * Closes the innermost open scope, does nothing if only the frame is open.
+	 * Script scopes left open inside the scope are closed with it.
+	 */
+	void EndScope();
+
+	/** Opens a scope on behalf of a script, it can only be closed by EndScriptScope(). */
+	void BeginScriptScope(const char *name);
+	/**
+	 * Closes the innermost open scope if it was opened by BeginScriptScope().
+	 * \return false if no script scope is open or another scope is open on top of
+	 *         it, nothing is closed then. Always true when not capturing.
+	 */
+	bool EndScriptScope();
+
+	/**
+	 * Closes every open scope and opens the scope of the next frame.
+	 * Must be called once at the start of each frame of the game loop.
+	 */
+	void NextFrame();
+
+	/** Number of frames in the current or last capture. */
+	unsigned int GetNumFrames() const
+	{
+		return m_frame;
+	}
+	const std::vector<Scope>& GetScopes() const
+	{
+		return m_scopes;
+	}
+
+	/**
+	 * Writes the captured scopes as a Chrome trace event JSON file.
+	 * \return false if the file cannot be written.
+	 */
+	bool WriteChromeTrace(const char *filepath) const;
+
+private:
+	void BeginScopeIntern(const char *name, double now, bool script);
+	void EndScopeIntern(double now);
+
+	std::vector<Scope> m_scopes;
+	/** Indices in m_scopes of the open scopes, the first one is the frame. */
+	std::vector<unsigned int> m_stack;
+	unsigned int m_maxNumScopes;
+	unsigned int m_frame;
+	/** Time at which the capture started, trace times are relative to it. */
+	double m_startTime;
+	bool m_capturing;
+
+	static SCA_Profiler *m_active;
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("GE:SCA_Profiler")
+#endif
+};
+
+/**
+ * Scope timer for C++ code, times the enclosing block when a capture is
+ * running and costs a single test otherwise.
+ */
+class SCA_ProfileScope
+{
+public:
+	SCA_ProfileScope(const char *name)
+		:m_profiler(SCA_Profiler::GetActive())
+	{
+		if (m_profiler && m_profiler->IsCapturing())
+			m_profiler->BeginScope(name);
+		else
+			m_profiler = NULL;
+	}
+	~SCA_ProfileScope()
+	{
+		if (m_profiler)
+			m_profiler->EndScope();
+	}
+
+private:
+	SCA_Profiler *m_profiler;
+};
+
+#endif  /* __SCA_PROFILER_H__ */
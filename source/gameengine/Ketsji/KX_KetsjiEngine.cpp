@@ -68,6 +68,7 @@
 #include "KX_WorldInfo.h"
 #include "KX_ISceneConverter.h"
 #include "KX_TimeCategoryLogger.h"
+#include "SCA_Profiler.h"
 
 #include "RAS_FramingManager.h"
 #include "DNA_world_types.h"
@@ -155,6 +156,7 @@ KX_KetsjiEngine::KX_KetsjiEngine(KX_ISystem* system)
 	m_curreye(0),
 
 	m_logger(NULL),
+	m_profiler(NULL),
 	
 	// Set up timing info display variables
 	m_show_framerate(false),
@@ -183,6 +185,10 @@ KX_KetsjiEngine::KX_KetsjiEngine(KX_ISystem* system)
 	for (int i = tc_first; i < tc_numCategories; i++)
 		m_logger->AddCategory((KX_TimeCategory)i);
 
+	// Frame profiler, idle until a capture is started
+	m_profiler = new SCA_Profiler();
+	SCA_Profiler::SetActive(m_profiler);
+
 #ifdef WITH_PYTHON
 	m_pyprofiledict = PyDict_New();
 #endif
@@ -200,6 +206,7 @@ KX_KetsjiEngine::KX_KetsjiEngine(KX_ISystem* system)
 KX_KetsjiEngine::~KX_KetsjiEngine()
 {
 	delete m_logger;
+	delete m_profiler;
 	if (m_usedome)
 		delete m_dome;
 
@@ -546,7 +553,9 @@ void KX_KetsjiEngine::EndFrame()
 	m_rasterizer->EndFrame();
 	// swap backbuffer (drawing into this buffer) <-> front/visible buffer
 	m_logger->StartLog(tc_latency, m_kxsystem->GetTimeInSeconds(), true);
+	m_profiler->BeginScope("SwapBuffers");
 	m_rasterizer->SwapBuffers();
+	m_profiler->EndScope();
 	m_logger->StartLog(tc_rasterizer, m_kxsystem->GetTimeInSeconds(), true);
 	
 	m_canvas->EndDraw();
@@ -564,6 +573,9 @@ bool KX_KetsjiEngine::NextFrame()
 
 	m_logger->StartLog(tc_services, m_kxsystem->GetTimeInSeconds(),true);
 
+	// everything up to the next call belongs to this frame, including the render
+	m_profiler->NextFrame();
+
 	//float dt = sClock.getTimeMicroseconds() * 0.000001f;
 	//sClock.reset();
 
@@ -647,12 +659,14 @@ bool KX_KetsjiEngine::NextFrame()
 
 		m_frameTime += framestep;
 		
+		m_profiler->BeginScope("LogicFrame");
 		m_sceneconverter->MergeAsyncLoads();
 
 		for (sceneit = m_scenes.begin();sceneit != m_scenes.end(); ++sceneit)
 		// for each scene, call the proceed functions
 		{
 			KX_Scene* scene = *sceneit;
+			m_profiler->BeginScope(scene->GetName().ReadPtr());
 	
 			/* Suspension holds the physics and logic processing for an
 			 * entire scene. Objects can be suspended individually, and
@@ -675,7 +689,9 @@ bool KX_KetsjiEngine::NextFrame()
 				
 				m_logger->StartLog(tc_network, m_kxsystem->GetTimeInSeconds(), true);
 				SG_SetActiveStage(SG_STAGE_NETWORK);
+				m_profiler->BeginScope("Network");
 				scene->GetNetworkScene()->proceed(m_frameTime);
+				m_profiler->EndScope();
 	
 				//m_logger->StartLog(tc_scenegraph, m_kxsystem->GetTimeInSeconds(), true);
 				//SG_SetActiveStage(SG_STAGE_NETWORK_UPDATE);
@@ -689,7 +705,9 @@ bool KX_KetsjiEngine::NextFrame()
 #endif
 				KX_SetActiveScene(scene);
 	
+				m_profiler->BeginScope("PhysicsEndFrame");
 				scene->GetPhysicsEnvironment()->EndFrame();
+				m_profiler->EndScope();
 				
 				// Update scenegraph after physics step. This maps physics calculations
 				// into node positions.
@@ -700,42 +718,54 @@ bool KX_KetsjiEngine::NextFrame()
 				// Process sensors, and controllers
 				m_logger->StartLog(tc_logic, m_kxsystem->GetTimeInSeconds(), true);
 				SG_SetActiveStage(SG_STAGE_CONTROLLER);
+				m_profiler->BeginScope("LogicBeginFrame");
 				scene->LogicBeginFrame(m_frameTime);
+				m_profiler->EndScope();
 	
 				// Scenegraph needs to be updated again, because Logic Controllers 
 				// can affect the local matrices.
 				m_logger->StartLog(tc_scenegraph, m_kxsystem->GetTimeInSeconds(), true);
 				SG_SetActiveStage(SG_STAGE_CONTROLLER_UPDATE);
+				m_profiler->BeginScope("UpdateParents");
 				scene->UpdateParents(m_frameTime);
+				m_profiler->EndScope();
 	
 				// Process actuators
 	
 				// Do some cleanup work for this logic frame
 				m_logger->StartLog(tc_logic, m_kxsystem->GetTimeInSeconds(), true);
 				SG_SetActiveStage(SG_STAGE_ACTUATOR);
+				m_profiler->BeginScope("LogicUpdateFrame");
 				scene->LogicUpdateFrame(m_frameTime, true);
 				
 				scene->LogicEndFrame();
+				m_profiler->EndScope();
 	
 				// Actuators can affect the scenegraph
 				m_logger->StartLog(tc_scenegraph, m_kxsystem->GetTimeInSeconds(), true);
 				SG_SetActiveStage(SG_STAGE_ACTUATOR_UPDATE);
+				m_profiler->BeginScope("UpdateParents");
 				scene->UpdateParents(m_frameTime);
 
 				// update levels of detail
 				scene->UpdateObjectLods();
+				m_profiler->EndScope();
 
 				m_logger->StartLog(tc_physics, m_kxsystem->GetTimeInSeconds(), true);
 				SG_SetActiveStage(SG_STAGE_PHYSICS2);
+				m_profiler->BeginScope("Physics");
 				scene->GetPhysicsEnvironment()->BeginFrame();
 		
 				// Perform physics calculations on the scene. This can involve 
 				// many iterations of the physics solver.
 				scene->GetPhysicsEnvironment()->ProceedDeltaTime(m_frameTime,timestep,framestep);//m_deltatimerealDeltaTime);
+				m_profiler->EndScope();
 
 				m_logger->StartLog(tc_scenegraph, m_kxsystem->GetTimeInSeconds(), true);
 				SG_SetActiveStage(SG_STAGE_PHYSICS2_UPDATE);
+				m_profiler->BeginScope("UpdateParents");
 				scene->UpdateParents(m_frameTime);
+				m_profiler->EndScope();
 			
 			
 				if (m_animation_record)
@@ -753,6 +783,7 @@ bool KX_KetsjiEngine::NextFrame()
 
 			// invalidates the shadow buffer from previous render/ImageRender because the scene has changed
 			scene->SetShadowDone(false);
+			m_profiler->EndScope();
 		}
 
 		// update system devices
@@ -768,6 +799,7 @@ bool KX_KetsjiEngine::NextFrame()
 
 		// scene management
 		ProcessScheduledScenes();
+		m_profiler->EndScope();
 		
 		frames--;
 	}
@@ -838,6 +870,7 @@ void KX_KetsjiEngine::Render()
 	{
 		KX_Scene* scene = *sceneit;
 		KX_Camera* cam = scene->GetActiveCamera();
+		m_profiler->BeginScope("Render", scene->GetName().ReadPtr());
 		// pass the scene's worldsettings to the rasterizer
 		scene->GetWorldInfo()->UpdateWorldSettings();
 
@@ -878,6 +911,7 @@ void KX_KetsjiEngine::Render()
 			it++;
 		}
 		PostRenderScene(scene);
+		m_profiler->EndScope();
 	}
 
 	// only one place that checks for stereo
@@ -894,6 +928,7 @@ void KX_KetsjiEngine::Render()
 		{
 			KX_Scene* scene = *sceneit;
 			KX_Camera* cam = scene->GetActiveCamera();
+			m_profiler->BeginScope("Render", scene->GetName().ReadPtr());
 
 			// pass the scene's worldsettings to the rasterizer
 			scene->GetWorldInfo()->UpdateWorldSettings();
@@ -927,6 +962,7 @@ void KX_KetsjiEngine::Render()
 				it++;
 			}
 			PostRenderScene(scene);
+			m_profiler->EndScope();
 		}
 	} // if (m_rasterizer->Stereo())
 
@@ -1269,11 +1305,15 @@ void KX_KetsjiEngine::RenderFrame(KX_Scene* scene, KX_Camera* cam)
 	m_logger->StartLog(tc_scenegraph, m_kxsystem->GetTimeInSeconds(), true);
 	SG_SetActiveStage(SG_STAGE_CULLING);
 
+	m_profiler->BeginScope("Culling");
 	scene->CalculateVisibleMeshes(m_rasterizer,cam);
+	m_profiler->EndScope();
 
 	m_logger->StartLog(tc_animations, m_kxsystem->GetTimeInSeconds(), true);
 	SG_SetActiveStage(SG_STAGE_ANIMATION_UPDATE);
+	m_profiler->BeginScope("Animations");
 	UpdateAnimations(scene);
+	m_profiler->EndScope();
 
 	m_logger->StartLog(tc_rasterizer, m_kxsystem->GetTimeInSeconds(), true);
 	SG_SetActiveStage(SG_STAGE_RENDER);
@@ -1284,10 +1324,12 @@ void KX_KetsjiEngine::RenderFrame(KX_Scene* scene, KX_Camera* cam)
 	scene->RunDrawingCallbacks(scene->GetPreDrawCB());
 #endif
 
+	m_profiler->BeginScope("RenderBuckets");
 	scene->RenderBuckets(camtrans, m_rasterizer);
 
 	// render all the font objects for this scene
 	scene->RenderFonts();
+	m_profiler->EndScope();
 
 	if (scene->GetPhysicsEnvironment())
 		scene->GetPhysicsEnvironment()->DebugDrawWorld();
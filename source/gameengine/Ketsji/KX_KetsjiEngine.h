@@ -169,6 +169,8 @@ private:
 
 	/** Time logger. */
 	KX_TimeCategoryLogger*	m_logger;
+	/** Hierarchical frame profiler, records only while a capture is running */
+	class SCA_Profiler*		m_profiler;
 	
 	/** Labels for profiling display. */
 	static const char		m_profileLabels[tc_numCategories][15];
@@ -237,6 +239,7 @@ public:
 	void setAnimRecordFrame(int framenr);
 
 	RAS_IRasterizer*		GetRasterizer() { return m_rasterizer; }
+	class SCA_Profiler*		GetProfiler() { return m_profiler; }
 	RAS_ICanvas*		    GetCanvas() { return m_canvas; }
 	SCA_IInputDevice*		GetKeyboardDevice() { return m_keyboarddevice; }
 	SCA_IInputDevice*		GetMouseDevice() { return m_mousedevice; }
@@ -28,6 +28,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_math_vector.h"
+#include "BLI_task.h"
 #include "KX_NavMeshObject.h"
 #include "RAS_MeshObject.h"
 #include "RAS_Polygon.h"
@@ -49,8 +50,11 @@ extern "C" {
 #include "Recast.h"
 #include "DetourStatNavMeshBuilder.h"
 #include "KX_ObstacleSimulation.h"
+#include "KX_KetsjiEngine.h"
 
 #define MAX_PATH_LEN 256
+/* number of polygon corridors kept for asynchronous path requests */
+#define PATH_CACHE_SIZE 256
 static const float polyPickExt[3] = {2, 4, 2};
 
 static void calcMeshBounds(const float* vert, int nverts, float* bmin, float* bmax)
@@ -74,15 +78,28 @@ inline void flipAxes(float* vec)
 {
 	std::swap(vec[1],vec[2]);
 }
+KX_NavMeshPathRequest::KX_NavMeshPathRequest(int maxPathLen)
+:	m_state(REQUEST_IDLE)
+,	m_startRef(0)
+,	m_endRef(0)
+,	m_path(maxPathLen * 3)
+,	m_pathLen(0)
+{
+}
+
 KX_NavMeshObject::KX_NavMeshObject(void* sgReplicationInfo, SG_Callbacks callbacks)
 :	KX_GameObject(sgReplicationInfo, callbacks)
 ,	m_navMesh(NULL)
+,	m_pathPool(NULL)
+,	m_pathPoolTime(0.0)
+,	m_pathCacheClock(0)
 {
 	
 }
 
 KX_NavMeshObject::~KX_NavMeshObject()
 {
+	FreePathRequests();
 	if (m_navMesh)
 		delete m_navMesh;
 }
@@ -98,6 +115,11 @@ void KX_NavMeshObject::ProcessReplica()
 {
 	KX_GameObject::ProcessReplica();
 	m_navMesh = NULL;  /* without this, building frees the navmesh we copied from */
+	/* same for the asynchronous path requests of the original */
+	m_threadNavMeshes.clear();
+	m_pathPool = NULL;
+	m_pendingRequests.clear();
+	m_pathCache.clear();
 	if (!BuildNavMesh()) {
 		std::cout << "Error in " << __func__ << ": unable to build navigation mesh" << std::endl;
 		return;
@@ -285,6 +307,9 @@ bool KX_NavMeshObject::BuildVertIndArrays(float *&vertices, int& nverts,
 
 bool KX_NavMeshObject::BuildNavMesh()
 {
+	/* requests and cached paths refer to the previous polygons */
+	FreePathRequests();
+
 	if (m_navMesh)
 	{
 		delete m_navMesh;
@@ -614,6 +639,156 @@ int KX_NavMeshObject::FindPath(const MT_Point3& from, const MT_Point3& to, float
 	return pathLen;
 }
 
+void KX_NavMeshObject::StraightenPath(dtStatNavMesh *navmesh, KX_NavMeshPathRequest *request,
+                                      const dtStatPolyRef *polys, int npolys)
+{
+	request->m_pathLen = navmesh->findStraightPath(request->m_from, request->m_to, polys, npolys,
+	                                               &request->m_path[0], request->m_path.size() / 3);
+}
+
+void KX_NavMeshObject::TransformPathToWorld(KX_NavMeshPathRequest *request)
+{
+	for (int i = 0; i < request->m_pathLen; i++) {
+		float *point = &request->m_path[i * 3];
+		flipAxes(point);
+		MT_Point3 waypoint(point);
+		waypoint = TransformToWorldCoords(waypoint);
+		waypoint.getValue(point);
+	}
+}
+
+void KX_NavMeshObject::PathRequestTask(TaskPool *__restrict pool, void *taskdata, int threadid)
+{
+	KX_NavMeshObject *self = (KX_NavMeshObject *)BLI_task_pool_userdata(pool);
+	KX_NavMeshPathRequest *request = (KX_NavMeshPathRequest *)taskdata;
+	/* the node pool and open list of a navmesh can only be used by one thread at a time */
+	dtStatNavMesh *navmesh = self->m_threadNavMeshes[threadid];
+
+	request->m_polys.resize(request->m_path.size() / 3);
+	int npolys = navmesh->findPath(request->m_startRef, request->m_endRef, request->m_from, request->m_to,
+	                               &request->m_polys[0], request->m_polys.size());
+	request->m_polys.resize(npolys);
+
+	request->m_pathLen = 0;
+	if (npolys)
+		self->StraightenPath(navmesh, request, &request->m_polys[0], npolys);
+}
+
+bool KX_NavMeshObject::QueuePathRequest(KX_NavMeshPathRequest *request, const MT_Point3& from, const MT_Point3& to,
+                                        double curtime)
+{
+	UpdatePathRequests(curtime);
+
+	if (!m_navMesh || request->m_state == KX_NavMeshPathRequest::REQUEST_PENDING)
+		return false;
+
+	MT_Point3 localfrom = TransformToLocalCoords(from);
+	MT_Point3 localto = TransformToLocalCoords(to);
+	localfrom.getValue(request->m_from); flipAxes(request->m_from);
+	localto.getValue(request->m_to); flipAxes(request->m_to);
+	/* nearest polygon queries only read the navmesh, they are cheap enough to run here */
+	request->m_startRef = m_navMesh->findNearestPoly(request->m_from, polyPickExt);
+	request->m_endRef = m_navMesh->findNearestPoly(request->m_to, polyPickExt);
+	request->m_pathLen = 0;
+
+	if (!request->m_startRef || !request->m_endRef) {
+		request->m_state = KX_NavMeshPathRequest::REQUEST_DONE;
+		return true;
+	}
+
+	/* a corridor between the same polygons can be reused, only the end points move */
+	unsigned int key = ((unsigned int)request->m_startRef << 16) | request->m_endRef;
+	PathCache::iterator it = m_pathCache.find(key);
+	if (it != m_pathCache.end()) {
+		PathCacheEntry& entry = it->second;
+		entry.m_lastUse = ++m_pathCacheClock;
+		StraightenPath(m_navMesh, request, &entry.m_polys[0], entry.m_polys.size());
+		TransformPathToWorld(request);
+		request->m_state = KX_NavMeshPathRequest::REQUEST_DONE;
+		return true;
+	}
+
+	if (!m_pathPool) {
+		TaskScheduler *scheduler = KX_GetActiveEngine()->GetTaskScheduler();
+		/* one navmesh per thread id: 0 is the thread waiting for the pool, the
+		 * others are the workers, the scheduler count includes both */
+		unsigned int numthreads = BLI_task_scheduler_num_threads(scheduler);
+		while (m_threadNavMeshes.size() < numthreads) {
+			dtStatNavMesh *navmesh = new dtStatNavMesh;
+			navmesh->init(m_navMesh->getData(), m_navMesh->getDataSize(), false);
+			m_threadNavMeshes.push_back(navmesh);
+		}
+		m_pathPool = BLI_task_pool_create_background(scheduler, this);
+		m_pathPoolTime = curtime;
+	}
+
+	request->m_state = KX_NavMeshPathRequest::REQUEST_PENDING;
+	m_pendingRequests.push_back(request);
+	BLI_task_pool_push(m_pathPool, PathRequestTask, request, false, TASK_PRIORITY_LOW);
+	return true;
+}
+
+void KX_NavMeshObject::FinishPathRequests()
+{
+	if (!m_pathPool)
+		return;
+
+	BLI_task_pool_work_and_wait(m_pathPool);
+	BLI_task_pool_free(m_pathPool);
+	m_pathPool = NULL;
+
+	for (std::vector<KX_NavMeshPathRequest*>::iterator it = m_pendingRequests.begin();
+	     it != m_pendingRequests.end(); ++it)
+	{
+		KX_NavMeshPathRequest *request = *it;
+
+		if (!request->m_polys.empty()) {
+			if (m_pathCache.size() >= PATH_CACHE_SIZE) {
+				/* evict the least recently used corridor */
+				PathCache::iterator oldest = m_pathCache.begin();
+				for (PathCache::iterator jt = m_pathCache.begin(); jt != m_pathCache.end(); ++jt) {
+					if (jt->second.m_lastUse < oldest->second.m_lastUse)
+						oldest = jt;
+				}
+				m_pathCache.erase(oldest);
+			}
+			unsigned int key = ((unsigned int)request->m_startRef << 16) | request->m_endRef;
+			PathCacheEntry& entry = m_pathCache[key];
+			entry.m_polys.swap(request->m_polys);
+			entry.m_lastUse = ++m_pathCacheClock;
+			request->m_polys.clear();
+		}
+
+		TransformPathToWorld(request);
+		request->m_state = KX_NavMeshPathRequest::REQUEST_DONE;
+	}
+	m_pendingRequests.clear();
+}
+
+void KX_NavMeshObject::UpdatePathRequests(double curtime)
+{
+	/* requests of the current frame are still being worked on */
+	if (m_pathPool && curtime != m_pathPoolTime)
+		FinishPathRequests();
+}
+
+void KX_NavMeshObject::CancelPathRequest(KX_NavMeshPathRequest *request)
+{
+	if (request->m_state == KX_NavMeshPathRequest::REQUEST_PENDING) {
+		FinishPathRequests();
+	}
+	request->m_state = KX_NavMeshPathRequest::REQUEST_IDLE;
+}
+
+void KX_NavMeshObject::FreePathRequests()
+{
+	FinishPathRequests();
+	for (std::vector<dtStatNavMesh*>::iterator it = m_threadNavMeshes.begin(); it != m_threadNavMeshes.end(); ++it)
+		delete *it;
+	m_threadNavMeshes.clear();
+	m_pathCache.clear();
+}
+
 float KX_NavMeshObject::Raycast(const MT_Point3& from, const MT_Point3& to)
 {
 	if (!m_navMesh)
@@ -30,9 +30,39 @@
 #include "KX_GameObject.h"
 #include "EXP_PyObjectPlus.h"
 #include <vector>
+#include <map>
 
 class RAS_MeshObject;
 class MT_Transform;
+struct TaskPool;
+
+/**
+ * Path query resolved by KX_NavMeshObject on worker threads.
+ * The owner keeps the request alive until it is done or canceled
+ * and reads the path once the state is REQUEST_DONE.
+ */
+struct KX_NavMeshPathRequest
+{
+	enum State {
+		REQUEST_IDLE = 0,
+		REQUEST_PENDING,
+		REQUEST_DONE
+	};
+
+	KX_NavMeshPathRequest(int maxPathLen);
+
+	State m_state;
+	/** Query points in navmesh space */
+	float m_from[3];
+	float m_to[3];
+	dtStatPolyRef m_startRef;
+	dtStatPolyRef m_endRef;
+	/** Polygon corridor found by the worker, added to the cache when the request completes */
+	std::vector<dtStatPolyRef> m_polys;
+	/** Result points in world space, valid when done */
+	std::vector<float> m_path;
+	int m_pathLen;
+};
 
 class KX_NavMeshObject: public KX_GameObject
 {
@@ -40,6 +70,33 @@ class KX_NavMeshObject: public KX_GameObject
 
 protected:
 	dtStatNavMesh* m_navMesh;
+
+	/** Navmeshes sharing the data of m_navMesh, one per thread of the pool since queries aren't reentrant */
+	std::vector<dtStatNavMesh*> m_threadNavMeshes;
+	/** Pool resolving the requests queued during one frame */
+	TaskPool* m_pathPool;
+	/** Time of the frame the requests of m_pathPool were queued */
+	double m_pathPoolTime;
+	std::vector<KX_NavMeshPathRequest*> m_pendingRequests;
+
+	/** Recently found polygon corridors by start and end polygon */
+	struct PathCacheEntry {
+		std::vector<dtStatPolyRef> m_polys;
+		unsigned int m_lastUse;
+	};
+	typedef std::map<unsigned int, PathCacheEntry> PathCache;
+	PathCache m_pathCache;
+	unsigned int m_pathCacheClock;
+
+	static void PathRequestTask(TaskPool *__restrict pool, void *taskdata, int threadid);
+	/** Wait for the queued requests and deliver their results */
+	void FinishPathRequests();
+	/** Free everything depending on the current navmesh data */
+	void FreePathRequests();
+	/** Fills the result of a request from the polygon corridor, in navmesh space */
+	void StraightenPath(dtStatNavMesh *navmesh, KX_NavMeshPathRequest *request,
+	                    const dtStatPolyRef *polys, int npolys);
+	void TransformPathToWorld(KX_NavMeshPathRequest *request);
 	
 	bool BuildVertIndArrays(float *&vertices, int& nverts,
 							unsigned short* &polys, int& npolys, unsigned short *&dmeshes, 
@@ -57,6 +114,19 @@ public:
 	bool BuildNavMesh();
 	dtStatNavMesh* GetNavMesh();
 	int FindPath(const MT_Point3& from, const MT_Point3& to, float* path, int maxPathLen);
+
+	/**
+	 * Queues an asynchronous path query. Paths between recently queried
+	 * polygons are answered immediately from the cache, the others are
+	 * resolved on worker threads and delivered on the next frame.
+	 * \return false if the request can't be resolved, i.e. the navmesh isn't built.
+	 */
+	bool QueuePathRequest(KX_NavMeshPathRequest *request, const MT_Point3& from, const MT_Point3& to,
+	                      double curtime);
+	/** Delivers the results of requests queued on previous frames, call before reading a request */
+	void UpdatePathRequests(double curtime);
+	/** Removes a request from the queue, waits if it's being resolved */
+	void CancelPathRequest(KX_NavMeshPathRequest *request);
 	float Raycast(const MT_Point3& from, const MT_Point3& to);
 
 	enum NavMeshRenderMode {RM_WALLS, RM_POLYS, RM_TRIS, RM_MAX};
@@ -97,6 +97,7 @@ extern "C" {
 #include "SCA_PythonJoystick.h"
 #include "SCA_PythonKeyboard.h"
 #include "SCA_PythonMouse.h"
+#include "SCA_Profiler.h"
 #include "KX_ConstraintActuator.h"
 #include "KX_SoundActuator.h"
 #include "KX_StateActuator.h"
@@ -405,6 +406,78 @@ static PyObject *gPyGetProfileInfo(PyObject *)
 	return gp_KetsjiEngine->GetPyProfileDict();
 }
 
+PyDoc_STRVAR(gPyStartProfileCapture_doc,
+"startProfileCapture()\n"
+"starts recording the nested timing scopes of every frame"
+);
+static PyObject *gPyStartProfileCapture(PyObject *)
+{
+	gp_KetsjiEngine->GetProfiler()->StartCapture();
+	Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(gPyStopProfileCapture_doc,
+"stopProfileCapture()\n"
+"stops recording timing scopes, returns the number of frames captured"
+);
+static PyObject *gPyStopProfileCapture(PyObject *)
+{
+	SCA_Profiler *profiler = gp_KetsjiEngine->GetProfiler();
+	profiler->StopCapture();
+	return PyLong_FromLong(profiler->GetNumFrames());
+}
+
+PyDoc_STRVAR(gPyWriteProfileTrace_doc,
+"writeProfileTrace(filepath)\n"
+"writes the captured timing scopes to a Chrome trace JSON file"
+);
+static PyObject *gPyWriteProfileTrace(PyObject *, PyObject *args)
+{
+	char *filepath;
+	char expanded[FILE_MAX];
+
+	if (!PyArg_ParseTuple(args, "s:writeProfileTrace", &filepath))
+		return NULL;
+
+	BLI_strncpy(expanded, filepath, FILE_MAX);
+	BLI_path_abs(expanded, gp_GamePythonPath);
+
+	if (!gp_KetsjiEngine->GetProfiler()->WriteChromeTrace(expanded)) {
+		PyErr_Format(PyExc_IOError, "writeProfileTrace(filepath): could not write \"%s\"", expanded);
+		return NULL;
+	}
+	Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(gPyBeginProfileScope_doc,
+"beginProfileScope(name)\n"
+"opens a named timing scope, must be closed with endProfileScope()"
+);
+static PyObject *gPyBeginProfileScope(PyObject *, PyObject *args)
+{
+	char *name;
+
+	if (!PyArg_ParseTuple(args, "s:beginProfileScope", &name))
+		return NULL;
+
+	gp_KetsjiEngine->GetProfiler()->BeginScriptScope(name);
+	Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(gPyEndProfileScope_doc,
+"endProfileScope()\n"
+"closes the scope opened by the last beginProfileScope(),\n"
+"does nothing if that scope is not the innermost open one"
+);
+static PyObject *gPyEndProfileScope(PyObject *)
+{
+	/* never close the scopes of the engine, a capture starting or a new frame
+	 * between the begin and end calls leaves no script scope to close */
+	if (!gp_KetsjiEngine->GetProfiler()->EndScriptScope())
+		printf("Warning: endProfileScope() without a matching beginProfileScope()\n");
+	Py_RETURN_NONE;
+}
+
 PyDoc_STRVAR(gPySendMessage_doc,
 "sendMessage(subject, [body, to, from])\n"
 "sends a message in same manner as a message actuator"
@@ -945,6 +1018,11 @@ static struct PyMethodDef game_methods[] = {
 	{"PrintMemInfo", (PyCFunction)pyPrintStats, METH_NOARGS, (const char *)"Print engine statistics"},
 	{"NextFrame", (PyCFunction)gPyNextFrame, METH_NOARGS, (const char *)"Render next frame (if Python has control)"},
 	{"getProfileInfo", (PyCFunction)gPyGetProfileInfo, METH_NOARGS, gPyGetProfileInfo_doc},
+	{"startProfileCapture", (PyCFunction)gPyStartProfileCapture, METH_NOARGS, gPyStartProfileCapture_doc},
+	{"stopProfileCapture", (PyCFunction)gPyStopProfileCapture, METH_NOARGS, gPyStopProfileCapture_doc},
+	{"writeProfileTrace", (PyCFunction)gPyWriteProfileTrace, METH_VARARGS, gPyWriteProfileTrace_doc},
+	{"beginProfileScope", (PyCFunction)gPyBeginProfileScope, METH_VARARGS, gPyBeginProfileScope_doc},
+	{"endProfileScope", (PyCFunction)gPyEndProfileScope, METH_NOARGS, gPyEndProfileScope_doc},
 	/* library functions */
 	{"LibLoad", (PyCFunction)gLibLoad, METH_VARARGS|METH_KEYWORDS, (const char *)""},
 	{"LibNew", (PyCFunction)gLibNew, METH_VARARGS, (const char *)""},
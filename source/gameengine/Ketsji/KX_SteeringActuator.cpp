@@ -73,6 +73,7 @@ KX_SteeringActuator::KX_SteeringActuator(SCA_IObject *gameobj,
       m_normalUp(normalup),
       m_pathLen(0),
       m_pathUpdatePeriod(pathUpdatePeriod),
+      m_pathRequest(MAX_PATH_LENGTH),
       m_lockzvel(lockzvel),
       m_wayPointIdx(-1),
       m_steerVec(MT_Vector3(0, 0, 0))
@@ -96,8 +97,10 @@ KX_SteeringActuator::KX_SteeringActuator(SCA_IObject *gameobj,
 
 KX_SteeringActuator::~KX_SteeringActuator()
 {
-	if (m_navmesh)
+	if (m_navmesh) {
+		m_navmesh->CancelPathRequest(&m_pathRequest);
 		m_navmesh->UnregisterActuator(this);
+	}
 	if (m_target)
 		m_target->UnregisterActuator(this);
 } 
@@ -112,6 +115,8 @@ CValue* KX_SteeringActuator::GetReplica()
 
 void KX_SteeringActuator::ProcessReplica()
 {
+	// the request of the original is not ours
+	m_pathRequest.m_state = KX_NavMeshPathRequest::REQUEST_IDLE;
 	if (m_target)
 		m_target->RegisterActuator(this);
 	if (m_navmesh)
@@ -135,6 +140,7 @@ bool KX_SteeringActuator::UnlinkObject(SCA_IObject* clientobj)
 	}
 	else if (clientobj == m_navmesh)
 	{
+		m_navmesh->CancelPathRequest(&m_pathRequest);
 		m_navmesh = NULL;
 		return true;
 	}
@@ -153,8 +159,10 @@ void KX_SteeringActuator::Relink(CTR_Map<CTR_HashedPtr, void*> *obj_map)
 
 	h_obj = (*obj_map)[m_navmesh];
 	if (h_obj) {
-		if (m_navmesh)
+		if (m_navmesh) {
+			m_navmesh->CancelPathRequest(&m_pathRequest);
 			m_navmesh->UnregisterActuator(this);
+		}
 		m_navmesh = (KX_NavMeshObject*)(*h_obj);
 		m_navmesh->RegisterActuator(this);
 	}
@@ -222,12 +230,21 @@ bool KX_SteeringActuator::Update(double curtime, bool frame)
 
 					static const MT_Scalar WAYPOINT_RADIUS(0.25f);
 
-					if (m_pathUpdateTime<0 || (m_pathUpdatePeriod>=0 && 
-												curtime - m_pathUpdateTime>((double)m_pathUpdatePeriod/1000.0)))
+					// the path is computed asynchronously, keep following
+					// the previous one until the new one is delivered
+					m_navmesh->UpdatePathRequests(curtime);
+					if (m_pathRequest.m_state == KX_NavMeshPathRequest::REQUEST_DONE)
+						TakePathRequest();
+
+					if ((m_pathUpdateTime<0 || (m_pathUpdatePeriod>=0 && 
+												curtime - m_pathUpdateTime>((double)m_pathUpdatePeriod/1000.0))) &&
+					    m_pathRequest.m_state != KX_NavMeshPathRequest::REQUEST_PENDING)
 					{
 						m_pathUpdateTime = curtime;
-						m_pathLen = m_navmesh->FindPath(mypos, targpos, m_path, MAX_PATH_LENGTH);
-						m_wayPointIdx = m_pathLen > 1 ? 1 : -1;
+						m_navmesh->QueuePathRequest(&m_pathRequest, mypos, targpos, curtime);
+						// cached paths are available immediately
+						if (m_pathRequest.m_state == KX_NavMeshPathRequest::REQUEST_DONE)
+							TakePathRequest();
 					}
 
 					if (m_wayPointIdx>0)
@@ -416,6 +433,14 @@ static bool getNavmeshNormal(dtStatNavMesh* navmesh, const MT_Vector3& pos, MT_V
 	return false;
 }
 
+void KX_SteeringActuator::TakePathRequest()
+{
+	m_pathLen = m_pathRequest.m_pathLen;
+	memcpy(m_path, &m_pathRequest.m_path[0], sizeof(float) * 3 * m_pathLen);
+	m_wayPointIdx = m_pathLen > 1 ? 1 : -1;
+	m_pathRequest.m_state = KX_NavMeshPathRequest::REQUEST_IDLE;
+}
+
 void KX_SteeringActuator::HandleActorFace(MT_Vector3& velocity)
 {
 	if (m_facingMode==0 && (!m_navmesh || !m_normalUp))
@@ -615,8 +640,10 @@ int KX_SteeringActuator::pyattr_set_navmesh(void *self, const struct KX_PYATTRIB
 		return PY_SET_ATTR_FAIL;
 	}
 
-	if (actuator->m_navmesh != NULL)
+	if (actuator->m_navmesh != NULL) {
+		actuator->m_navmesh->CancelPathRequest(&actuator->m_pathRequest);
 		actuator->m_navmesh->UnregisterActuator(actuator);
+	}
 
 	actuator->m_navmesh = static_cast<KX_NavMeshObject*>(gameobj);
 
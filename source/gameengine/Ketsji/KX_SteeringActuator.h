@@ -30,9 +30,9 @@
 #include "SCA_IActuator.h"
 #include "SCA_LogicManager.h"
 #include "MT_Matrix3x3.h"
+#include "KX_NavMeshObject.h"
 
 class KX_GameObject;
-class KX_NavMeshObject;
 struct KX_Obstacle;
 class KX_ObstacleSimulation;
 const int MAX_PATH_LENGTH  = 128;
@@ -62,11 +62,15 @@ class KX_SteeringActuator : public SCA_IActuator
 	int m_pathLen;
 	int m_pathUpdatePeriod;
 	double m_pathUpdateTime;
+	/** Path being computed by the navmesh, replaces m_path when done */
+	KX_NavMeshPathRequest m_pathRequest;
 	bool m_lockzvel;
 	int m_wayPointIdx;
 	MT_Matrix3x3 m_parentlocalmat;
 	MT_Vector3 m_steerVec;
 	void HandleActorFace(MT_Vector3& velocity);
+	/** Use the path of a completed request */
+	void TakePathRequest();
 public:
 	enum KX_STEERINGACT_MODE
 	{
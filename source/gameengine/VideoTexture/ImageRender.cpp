@@ -550,6 +550,7 @@ static PyGetSetDef imageRenderGetSets[] =
 	// attribute from ImageViewport
 	{(char*)"capsize", (getter)ImageViewport_getCaptureSize, (setter)ImageViewport_setCaptureSize, (char*)"size of render area", NULL},
 	{(char*)"alpha", (getter)ImageViewport_getAlpha, (setter)ImageViewport_setAlpha, (char*)"use alpha in texture", NULL},
+	{(char*)"asyncRead", (getter)ImageViewport_getAsync, (setter)ImageViewport_setAsync, (char*)"read pixels asynchronously, with one frame latency", NULL},
 	{(char*)"whole", (getter)ImageViewport_getWhole, (setter)ImageViewport_setWhole, (char*)"use whole viewport to render", NULL},
 	// attributes from ImageBase class
 	{(char*)"valid", (getter)Image_valid, NULL, (char*)"bool to tell if an image is available", NULL},
@@ -713,6 +714,7 @@ static PyGetSetDef imageMirrorGetSets[] =
 	// attribute from ImageViewport
 	{(char*)"capsize", (getter)ImageViewport_getCaptureSize, (setter)ImageViewport_setCaptureSize, (char*)"size of render area", NULL},
 	{(char*)"alpha", (getter)ImageViewport_getAlpha, (setter)ImageViewport_setAlpha, (char*)"use alpha in texture", NULL},
+	{(char*)"asyncRead", (getter)ImageViewport_getAsync, (setter)ImageViewport_setAsync, (char*)"read pixels asynchronously, with one frame latency", NULL},
 	{(char*)"whole", (getter)ImageViewport_getWhole, (setter)ImageViewport_setWhole, (char*)"use whole viewport to render", NULL},
 	// attributes from ImageBase class
 	{(char*)"valid", (getter)Image_valid, NULL, (char*)"bool to tell if an image is available", NULL},
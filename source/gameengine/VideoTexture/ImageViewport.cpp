@@ -45,8 +45,10 @@
 
 
 // constructor
-ImageViewport::ImageViewport (PyRASOffScreen *offscreen) : m_alpha(false), m_texInit(false)
+ImageViewport::ImageViewport (PyRASOffScreen *offscreen) : m_alpha(false), m_texInit(false),
+	m_async(false), m_pboIndex(0), m_pboSize(0), m_pboFormat(0), m_pboType(0), m_pboPending(false)
 {
+	m_pbo[0] = m_pbo[1] = 0;
 	// get viewport rectangle
 	if (offscreen) {
 		m_viewport[0] = 0;
@@ -74,6 +76,7 @@ ImageViewport::ImageViewport (PyRASOffScreen *offscreen) : m_alpha(false), m_tex
 // destructor
 ImageViewport::~ImageViewport (void)
 {
+	freePBO();
 	delete [] m_viewportImage;
 }
 
@@ -133,6 +136,87 @@ void ImageViewport::setPosition (GLint pos[2])
 }
 
 
+// use asynchronous readback
+void ImageViewport::setAsync (bool async)
+{
+	// pixel buffer objects are core since OpenGL 2.1
+	if (async && !(GLEW_VERSION_2_1 || GLEW_ARB_pixel_buffer_object))
+		async = false;
+	if (!async)
+		freePBO();
+	m_async = async;
+}
+
+// delete pixel buffer objects
+void ImageViewport::freePBO (void)
+{
+	if (m_pbo[0]) {
+		glDeleteBuffers(2, m_pbo);
+		m_pbo[0] = m_pbo[1] = 0;
+	}
+	m_pboSize = 0;
+	m_pboPending = false;
+}
+
+// read frame buffer
+BYTE * ImageViewport::mapPixels (GLenum format, GLenum type, unsigned int pixSize)
+{
+	if (!m_async) {
+		glReadPixels(m_upLeft[0], m_upLeft[1], (GLsizei)m_capSize[0], (GLsizei)m_capSize[1],
+		             format, type, m_viewportImage);
+		return m_viewportImage;
+	}
+
+	unsigned int size = m_capSize[0] * m_capSize[1] * pixSize;
+	// a pending frame of another layout is useless, restart the ring
+	if (size != m_pboSize || format != m_pboFormat || type != m_pboType) {
+		if (!m_pbo[0])
+			glGenBuffers(2, m_pbo);
+		for (int idx = 0; idx < 2; ++idx) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[idx]);
+			glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+		}
+		m_pboSize = size;
+		m_pboFormat = format;
+		m_pboType = type;
+		m_pboPending = false;
+	}
+	// start the transfer of the current frame, this returns immediately
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[m_pboIndex]);
+	glReadPixels(m_upLeft[0], m_upLeft[1], (GLsizei)m_capSize[0], (GLsizei)m_capSize[1],
+	             format, type, 0);
+	// read the frame started on the previous call, it's normally completed by now
+	// on the first call there is no such frame and we wait for the current one
+	if (m_pboPending)
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[m_pboIndex ^ 1]);
+	m_pboPending = true;
+	m_pboIndex ^= 1;
+
+	BYTE *pixels = (BYTE *)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+	if (pixels == NULL) {
+		// mapping failed, fall back to a synchronous read for this frame
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glReadPixels(m_upLeft[0], m_upLeft[1], (GLsizei)m_capSize[0], (GLsizei)m_capSize[1],
+		             format, type, m_viewportImage);
+		return m_viewportImage;
+	}
+	return pixels;
+}
+
+// release pixels returned by mapPixels
+void ImageViewport::unmapPixels (void)
+{
+	if (m_async) {
+		GLint pbo = 0;
+		glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &pbo);
+		if (pbo != 0) {
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+	}
+}
+
+
 // capture image from viewport
 void ImageViewport::calcViewport (unsigned int texId, double ts, unsigned int format)
 {
@@ -164,22 +248,22 @@ void ImageViewport::calcViewport (unsigned int texId, double ts, unsigned int fo
 			// *** misusing m_viewportImage here, but since it has the correct size
 			//     (4 bytes per pixel = size of float) and we just need it to apply
 			//     the filter, it's ok
-			glReadPixels(m_upLeft[0], m_upLeft[1], (GLsizei)m_capSize[0], (GLsizei)m_capSize[1],
-			        GL_DEPTH_COMPONENT, GL_FLOAT, m_viewportImage);
+			BYTE *pixels = mapPixels(GL_DEPTH_COMPONENT, GL_FLOAT, 4);
 			// filter loaded data
 			FilterZZZA filt;
-			filterImage(filt, (float *)m_viewportImage, m_capSize);
+			filterImage(filt, (float *)pixels, m_capSize);
+			unmapPixels();
 		}
 		else {
 
 			if (m_depth) {
 				// Use read pixels with the depth buffer
 				// See warning above about m_viewportImage.
-				glReadPixels(m_upLeft[0], m_upLeft[1], (GLsizei)m_capSize[0], (GLsizei)m_capSize[1],
-				        GL_DEPTH_COMPONENT, GL_FLOAT, m_viewportImage);
+				BYTE *pixels = mapPixels(GL_DEPTH_COMPONENT, GL_FLOAT, 4);
 				// filter loaded data
 				FilterDEPTH filt;
-				filterImage(filt, (float *)m_viewportImage, m_capSize);
+				filterImage(filt, (float *)pixels, m_capSize);
+				unmapPixels();
 			}
 			else {
 
@@ -192,21 +276,29 @@ void ImageViewport::calcViewport (unsigned int texId, double ts, unsigned int fo
 					    !m_flip &&
 					    !m_pyfilter)
 					{
-						glReadPixels(m_upLeft[0], m_upLeft[1], (GLsizei)m_capSize[0], (GLsizei)m_capSize[1], format,
-						             GL_UNSIGNED_BYTE, m_image);
+						if (m_async) {
+							// the pixel buffer holds the previous frame in the native format, just copy it
+							BYTE *pixels = mapPixels(format, GL_UNSIGNED_BYTE, 4);
+							memcpy(m_image, pixels, getBuffSize());
+							unmapPixels();
+						}
+						else {
+							glReadPixels(m_upLeft[0], m_upLeft[1], (GLsizei)m_capSize[0], (GLsizei)m_capSize[1], format,
+							             GL_UNSIGNED_BYTE, m_image);
+						}
 						m_avail = true;
 					}
 					else if (!m_pyfilter) {
-						glReadPixels(m_upLeft[0], m_upLeft[1], (GLsizei)m_capSize[0], (GLsizei)m_capSize[1], format,
-						             GL_UNSIGNED_BYTE, m_viewportImage);
+						BYTE *pixels = mapPixels(format, GL_UNSIGNED_BYTE, 4);
 						FilterRGBA32 filt;
-						filterImage(filt, m_viewportImage, m_capSize);
+						filterImage(filt, pixels, m_capSize);
+						unmapPixels();
 					}
 					else {
-						glReadPixels(m_upLeft[0], m_upLeft[1], (GLsizei)m_capSize[0], (GLsizei)m_capSize[1], GL_RGBA,
-						             GL_UNSIGNED_BYTE, m_viewportImage);
+						BYTE *pixels = mapPixels(GL_RGBA, GL_UNSIGNED_BYTE, 4);
 						FilterRGBA32 filt;
-						filterImage(filt, m_viewportImage, m_capSize);
+						filterImage(filt, pixels, m_capSize);
+						unmapPixels();
 						if (format == GL_BGRA) {
 							// in place byte swapping
 							swapImageBR();
@@ -214,11 +306,15 @@ void ImageViewport::calcViewport (unsigned int texId, double ts, unsigned int fo
 					}
 				}
 				else {
-					glReadPixels(m_upLeft[0], m_upLeft[1], (GLsizei)m_capSize[0], (GLsizei)m_capSize[1], GL_RGB,
-					        GL_UNSIGNED_BYTE, m_viewportImage);
+					// rows of 3 bytes pixels are not necessarily aligned on 4 bytes,
+					// use a packed layout so that the size of the pixel buffer is exact
+					glPixelStorei(GL_PACK_ALIGNMENT, 1);
+					BYTE *pixels = mapPixels(GL_RGB, GL_UNSIGNED_BYTE, 3);
+					glPixelStorei(GL_PACK_ALIGNMENT, 4);
 					// filter loaded data
 					FilterRGB24 filt;
-					filterImage(filt, m_viewportImage, m_capSize);
+					filterImage(filt, pixels, m_capSize);
+					unmapPixels();
 					if (format == GL_BGRA) {
 						// in place byte swapping
 						swapImageBR();
@@ -321,6 +417,28 @@ int ImageViewport_setAlpha(PyImage *self, PyObject *value, void *closure)
 	return 0;
 }
 
+// get async
+PyObject *ImageViewport_getAsync (PyImage *self, void *closure)
+{
+	if (self->m_image != NULL && getImageViewport(self)->getAsync()) Py_RETURN_TRUE;
+	else Py_RETURN_FALSE;
+}
+
+// set async
+int ImageViewport_setAsync(PyImage *self, PyObject *value, void *closure)
+{
+	// check parameter, report failure
+	if (value == NULL || !PyBool_Check(value))
+	{
+		PyErr_SetString(PyExc_TypeError, "The value must be a bool");
+		return -1;
+	}
+	// set async, silently stays synchronous if pixel buffer objects are not supported
+	if (self->m_image != NULL) getImageViewport(self)->setAsync(value == Py_True);
+	// success
+	return 0;
+}
+
 
 // get position
 static PyObject *ImageViewport_getPosition (PyImage *self, void *closure)
@@ -411,6 +529,7 @@ static PyGetSetDef imageViewportGetSets[] =
 	{(char*)"position", (getter)ImageViewport_getPosition, (setter)ImageViewport_setPosition, (char*)"upper left corner of captured area", NULL},
 	{(char*)"capsize", (getter)ImageViewport_getCaptureSize, (setter)ImageViewport_setCaptureSize, (char*)"size of viewport area being captured", NULL},
 	{(char*)"alpha", (getter)ImageViewport_getAlpha, (setter)ImageViewport_setAlpha, (char*)"use alpha in texture", NULL},
+	{(char*)"asyncRead", (getter)ImageViewport_getAsync, (setter)ImageViewport_setAsync, (char*)"read pixels asynchronously, with one frame latency", NULL},
 	// attributes from ImageBase class
 	{(char*)"valid", (getter)Image_valid, NULL, (char*)"bool to tell if an image is available", NULL},
 	{(char*)"image", (getter)Image_getImage, NULL, (char*)"image data", NULL},
@@ -68,6 +68,11 @@ public:
 	/// set position in viewport
 	void setPosition (GLint pos[2] = NULL);
 
+	/// is asynchronous readback used
+	bool getAsync (void) { return m_async; }
+	/// set asynchronous readback, pixels are then delivered one frame late
+	void setAsync (bool async);
+
 	/// capture image from viewport to user buffer
 	virtual bool loadImage(unsigned int *buffer, unsigned int size, unsigned int format, double ts);
 
@@ -92,6 +97,26 @@ protected:
 	/// texture is initialized
 	bool m_texInit;
 
+	/// use pixel buffer objects to read the frame buffer asynchronously
+	bool m_async;
+	/// ring of pixel buffer objects, one is filled while the other is read
+	GLuint m_pbo[2];
+	/// index of the pixel buffer object receiving the current frame
+	unsigned int m_pboIndex;
+	/// size in bytes of the pixel buffer objects
+	unsigned int m_pboSize;
+	/// pixel format and type of the pending read
+	GLenum m_pboFormat, m_pboType;
+	/// previous pixel buffer object contains a frame
+	bool m_pboPending;
+
+	/// read frame buffer, returns pixels that must be released with unmapPixels
+	BYTE * mapPixels (GLenum format, GLenum type, unsigned int pixSize);
+	/// release pixels returned by mapPixels
+	void unmapPixels (void);
+	/// delete pixel buffer objects
+	void freePBO (void);
+
 	/// capture image from viewport
 	virtual void calcImage (unsigned int texId, double ts) { calcViewport(texId, ts, GL_RGBA); }
 
@@ -108,6 +133,8 @@ PyObject *ImageViewport_getWhole(PyImage *self, void *closure);
 int ImageViewport_setWhole(PyImage *self, PyObject *value, void *closure);
 PyObject *ImageViewport_getAlpha(PyImage *self, void *closure);
 int ImageViewport_setAlpha(PyImage *self, PyObject *value, void *closure);
+PyObject *ImageViewport_getAsync(PyImage *self, void *closure);
+int ImageViewport_setAsync(PyImage *self, PyObject *value, void *closure);
 
 #endif
 
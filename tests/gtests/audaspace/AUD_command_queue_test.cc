@@ -0,0 +1,163 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "AUD_CommandQueue.h"
+#include "AUD_ReadDevice.h"
+#include "AUD_IHandle.h"
+#include "AUD_SinusFactory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+
+#define NUM_COMMANDS 100000
+
+TEST(command_queue, FullAndEmpty)
+{
+	AUD_CommandQueue<int, 4> queue;
+	int value;
+
+	EXPECT_FALSE(queue.pop(value));
+
+	/* more rounds than slots so the counters wrap in the ring */
+	for (int round = 0; round < 3; round++) {
+		for (int i = 0; i < 4; i++) {
+			EXPECT_TRUE(queue.push(round * 4 + i));
+		}
+		EXPECT_FALSE(queue.push(-1));
+
+		for (int i = 0; i < 4; i++) {
+			EXPECT_TRUE(queue.pop(value));
+			EXPECT_EQ(round * 4 + i, value);
+		}
+		EXPECT_FALSE(queue.pop(value));
+	}
+}
+
+static void *produce_commands(void *data)
+{
+	AUD_CommandQueue<int, 256> *queue = (AUD_CommandQueue<int, 256> *)data;
+
+	for (int i = 0; i < NUM_COMMANDS; i++) {
+		while (!queue->push(i)) {
+			sched_yield();
+		}
+	}
+
+	return NULL;
+}
+
+TEST(command_queue, ProducerConsumer)
+{
+	AUD_CommandQueue<int, 256> queue;
+	pthread_t thread;
+
+	pthread_create(&thread, NULL, produce_commands, &queue);
+
+	int expected = 0, value;
+	while (expected < NUM_COMMANDS) {
+		if (queue.pop(value)) {
+			ASSERT_EQ(expected, value);
+			expected++;
+		}
+		else {
+			sched_yield();
+		}
+	}
+
+	pthread_join(thread, NULL);
+
+	EXPECT_FALSE(queue.pop(value));
+}
+
+static AUD_DeviceSpecs test_specs()
+{
+	AUD_DeviceSpecs specs;
+	specs.format = AUD_FORMAT_FLOAT32;
+	specs.rate = AUD_RATE_48000;
+	specs.channels = AUD_CHANNELS_STEREO;
+	return specs;
+}
+
+static float peak(const std::vector<data_t> &buffer)
+{
+	const float *samples = (const float *)&buffer[0];
+	float result = 0.0f;
+	for (size_t i = 0; i < buffer.size() / sizeof(float); i++) {
+		result = std::max(result, std::abs(samples[i]));
+	}
+	return result;
+}
+
+TEST(command_queue, ParametersAtBufferBoundary)
+{
+	AUD_DeviceSpecs specs = test_specs();
+	AUD_ReadDevice device(specs);
+	std::vector<data_t> buffer(512 * AUD_DEVICE_SAMPLE_SIZE(specs));
+
+	boost::shared_ptr<AUD_IFactory> sine(new AUD_SinusFactory(441.0f, specs.rate));
+	boost::shared_ptr<AUD_IHandle> handle = device.play(sine);
+
+	device.read(&buffer[0], 512);
+	const float full = peak(buffer);
+	EXPECT_GT(full, 0.5f);
+
+	/* the user sees the new value at once, the mixer with the next buffer */
+	handle->setVolume(0.0f);
+	EXPECT_EQ(0.0f, handle->getVolume());
+	device.read(&buffer[0], 512);
+	EXPECT_EQ(0.0f, peak(buffer));
+
+	/* more changes than the queue holds fall back to the device lock */
+	for (int i = 0; i < 10000; i++) {
+		handle->setVolume((i & 1) ? 0.25f : 0.0f);
+	}
+	device.setVolume(2.0f);
+	EXPECT_EQ(2.0f, device.getVolume());
+
+	device.read(&buffer[0], 512);
+	device.read(&buffer[0], 512);
+	EXPECT_NEAR(full * 0.25f * 2.0f, peak(buffer), 0.01f);
+
+	EXPECT_EQ(0u, device.getLockWaits());
+}
+
+static void *read_buffer(void *data)
+{
+	AUD_ReadDevice *device = (AUD_ReadDevice *)data;
+	std::vector<data_t> buffer(512 * AUD_DEVICE_SAMPLE_SIZE(device->getSpecs()));
+
+	device->read(&buffer[0], 512);
+
+	return NULL;
+}
+
+TEST(command_queue, LockWaitCounter)
+{
+	AUD_DeviceSpecs specs = test_specs();
+	AUD_ReadDevice device(specs);
+	std::vector<data_t> buffer(512 * AUD_DEVICE_SAMPLE_SIZE(specs));
+
+	boost::shared_ptr<AUD_IFactory> sine(new AUD_SinusFactory(441.0f, specs.rate));
+	device.play(sine);
+
+	device.read(&buffer[0], 512);
+	EXPECT_EQ(0u, device.getLockWaits());
+
+	/* the mixing thread counts the wait before it blocks on the lock we hold */
+	pthread_t reader;
+
+	device.lock();
+	pthread_create(&reader, NULL, read_buffer, &device);
+	while (device.getLockWaits() == 0) {
+		sched_yield();
+	}
+	device.unlock();
+
+	pthread_join(reader, NULL);
+
+	EXPECT_EQ(1u, device.getLockWaits());
+}
@@ -0,0 +1,122 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "AUD_FileWriter.h"
+#include "AUD_SequencerEntry.h"
+#include "AUD_SequencerFactory.h"
+#include "AUD_SinusFactory.h"
+
+#include <vector>
+
+/* The parallel mixdown has to write exactly the samples of the serial one. */
+
+class MemoryWriter : public AUD_IWriter
+{
+public:
+	AUD_DeviceSpecs m_specs;
+	std::vector<float> m_samples;
+	std::vector<unsigned int> m_writes;
+
+	MemoryWriter(AUD_DeviceSpecs specs) : m_specs(specs) {}
+
+	virtual int getPosition() const
+	{
+		return m_samples.size() / m_specs.channels;
+	}
+
+	virtual AUD_DeviceSpecs getSpecs() const
+	{
+		return m_specs;
+	}
+
+	virtual void write(unsigned int length, sample_t *buffer)
+	{
+		m_samples.insert(m_samples.end(), buffer, buffer + length * m_specs.channels);
+		m_writes.push_back(length);
+	}
+};
+
+static boost::shared_ptr<AUD_SequencerFactory> test_sequence(AUD_Specs specs, AUD_SampleRate strip_rate)
+{
+	boost::shared_ptr<AUD_SequencerFactory> sequence(new AUD_SequencerFactory(specs, 25.0f, false));
+
+	/* strips crossing the chunk borders, loud enough to clip when overlapping */
+	for (int i = 0; i < 6; i++) {
+		boost::shared_ptr<AUD_IFactory> sine(new AUD_SinusFactory(220.0f * (i + 1), strip_rate));
+		sequence->add(sine, 0.3f * i, 0.3f * i + 1.1f, 0.0f);
+	}
+
+	return sequence;
+}
+
+static void mixdown_test(unsigned int start, unsigned int length, unsigned int buffersize,
+                         unsigned int chunksize, unsigned int preroll, int threads)
+{
+	AUD_DeviceSpecs specs;
+	specs.format = AUD_FORMAT_FLOAT32;
+	specs.rate = AUD_RATE_48000;
+	specs.channels = AUD_CHANNELS_STEREO;
+
+	boost::shared_ptr<AUD_SequencerFactory> sequence = test_sequence(specs.specs, specs.rate);
+
+	MemoryWriter *serial = new MemoryWriter(specs);
+	boost::shared_ptr<AUD_IWriter> serial_writer(serial);
+	boost::shared_ptr<AUD_IReader> reader = sequence->createReader();
+	reader->seek(start);
+	AUD_FileWriter::writeReader(reader, serial_writer, length, buffersize);
+
+	MemoryWriter *parallel = new MemoryWriter(specs);
+	boost::shared_ptr<AUD_IWriter> parallel_writer(parallel);
+	AUD_FileWriter::writeFactoryParallel(sequence, parallel_writer, start, length, buffersize, chunksize, preroll, threads);
+
+	ASSERT_EQ(length * specs.channels, serial->m_samples.size());
+	ASSERT_EQ(serial->m_samples.size(), parallel->m_samples.size());
+	EXPECT_TRUE(serial->m_writes == parallel->m_writes);
+
+	int mismatches = 0;
+	for (size_t i = 0; i < serial->m_samples.size(); i++) {
+		if (serial->m_samples[i] != parallel->m_samples[i]) {
+			if (mismatches++ == 0) {
+				ADD_FAILURE() << "first mismatch at sample " << i / specs.channels;
+			}
+		}
+	}
+	EXPECT_EQ(0, mismatches);
+}
+
+TEST(audaspace, MixdownParallel)
+{
+	mixdown_test(0, 48000 * 3, 1024, 48000 / 2, 48000 / 4, 4);
+}
+
+TEST(audaspace, MixdownParallelOffset)
+{
+	/* start inside a strip, odd buffer and chunk sizes and a partial last chunk */
+	mixdown_test(12345, 100000, 1000, 17000, 9000, 3);
+}
+
+TEST(audaspace, MixdownParallelSingleThread)
+{
+	mixdown_test(0, 48000 * 2, 512, 10000, 4096, 1);
+}
+
+TEST(audaspace, MixdownResampled)
+{
+	AUD_Specs specs;
+	specs.rate = AUD_RATE_48000;
+	specs.channels = AUD_CHANNELS_STEREO;
+
+	/* seeked resamplers start over, so AUD_mixdown can't render these in chunks */
+	EXPECT_FALSE(test_sequence(specs, AUD_RATE_48000)->isResampled());
+	EXPECT_TRUE(test_sequence(specs, AUD_RATE_44100)->isResampled());
+
+	boost::shared_ptr<AUD_SequencerFactory> sequence = test_sequence(specs, AUD_RATE_48000);
+	boost::shared_ptr<AUD_SequencerEntry> entry = sequence->add(
+	        boost::shared_ptr<AUD_IFactory>(new AUD_SinusFactory(440.0f, AUD_RATE_48000)), 0.0f, 1.0f, 0.0f);
+	EXPECT_FALSE(sequence->isResampled());
+
+	float pitch = 1.5f;
+	entry->getAnimProperty(AUD_AP_PITCH)->write(&pitch);
+	EXPECT_TRUE(sequence->isResampled());
+}
@@ -0,0 +1,91 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "AUD_ReadDevice.h"
+#include "AUD_IHandle.h"
+#include "AUD_SinusFactory.h"
+
+#include <vector>
+
+extern "C" {
+#include "PIL_time.h"
+}
+
+/* Renders one second of audio with a growing number of voices on a
+ * headless device, like the software device does in the audio callback,
+ * and reports how many voices still fit in real-time. The volume of every
+ * voice changes each buffer so the mixer goes through the volume ramps. */
+
+#define BUFFER_FRAMES 1024
+#define MAX_VOICES 4096
+
+static double mixdown_time(AUD_SampleFormat format, int num_voices, bool quality)
+{
+	AUD_DeviceSpecs specs;
+	specs.format = format;
+	specs.rate = AUD_RATE_48000;
+	specs.channels = AUD_CHANNELS_STEREO;
+
+	AUD_ReadDevice device(specs);
+	device.setQuality(quality);
+
+	std::vector<boost::shared_ptr<AUD_IHandle> > handles;
+	for (int i = 0; i < num_voices; i++) {
+		/* different rates so the resampler has work to do */
+		boost::shared_ptr<AUD_IFactory> sine(new AUD_SinusFactory(110.0f + i, (i & 1) ? AUD_RATE_44100 : AUD_RATE_48000));
+		handles.push_back(device.play(sine));
+	}
+
+	std::vector<data_t> buffer(BUFFER_FRAMES * AUD_DEVICE_SAMPLE_SIZE(specs));
+	const int num_buffers = (int)specs.rate / BUFFER_FRAMES;
+
+	double time = PIL_check_seconds_timer();
+	for (int b = 0; b < num_buffers; b++) {
+		for (int i = 0; i < num_voices; i++) {
+			handles[i]->setVolume(((b + i) & 1) ? 0.5f : 1.0f);
+		}
+		device.read(&buffer[0], BUFFER_FRAMES);
+	}
+	time = PIL_check_seconds_timer() - time;
+
+	/* normalized to one second of audio */
+	return time * specs.rate / (num_buffers * BUFFER_FRAMES);
+}
+
+static void realtime_voices_test(AUD_SampleFormat format, bool quality, const char *id)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	int num_voices = 1, fitting = 0;
+
+	while (num_voices <= MAX_VOICES) {
+		double time = mixdown_time(format, num_voices, quality);
+		printf("%5d voices: %8.3f ms per second of audio\n", num_voices, time * 1000.0);
+
+		if (time >= 1.0) {
+			break;
+		}
+
+		fitting = num_voices;
+		num_voices *= 2;
+	}
+
+	printf("Real-time voices: at least %d\n", fitting);
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(audaspace, RealtimeVoicesFloat)
+{
+	realtime_voices_test(AUD_FORMAT_FLOAT32, false, "audaspace - Real-time voices, float32, linear resampling");
+}
+
+TEST(audaspace, RealtimeVoicesS16)
+{
+	realtime_voices_test(AUD_FORMAT_S16, false, "audaspace - Real-time voices, int16, linear resampling");
+}
+
+TEST(audaspace, RealtimeVoicesS16Quality)
+{
+	realtime_voices_test(AUD_FORMAT_S16, true, "audaspace - Real-time voices, int16, high quality resampling");
+}
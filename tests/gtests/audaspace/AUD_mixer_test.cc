@@ -0,0 +1,163 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "AUD_ConverterFunctions.h"
+#include "AUD_Mixer.h"
+
+#include <vector>
+
+/* The SIMD code paths have to match the scalar conversions exactly, test
+ * lengths that are not a multiple of the vector width and values around
+ * and beyond the clipping limits. */
+
+static const float test_values[] = {
+	-2.0f, -1.0f, -0.99999994f, -0.5f, -1e-6f, 0.0f, 1e-6f, 0.25f,
+	0.5f, 0.7071f, 0.99999994f, 1.0f, 1.5f, -0.3f, 0.1f, 0.9f, -0.9f
+};
+
+#define NUM_TEST_VALUES ((int)(sizeof(test_values) / sizeof(*test_values)))
+
+static int32_t ref_float_s32(float s)
+{
+	if(s <= -1.0f)
+		return (int32_t)0x80000000;
+	else if(s >= 1.0f)
+		return (int32_t)0x7FFFFFFF;
+	return (int32_t)(s * (int32_t)0x7FFFFFFF);
+}
+
+static int16_t ref_float_s16(float s)
+{
+	if(s <= -1.0f)
+		return (int16_t)0x8000;
+	else if(s >= 1.0f)
+		return (int16_t)0x7FFF;
+	return (int16_t)(s * (int16_t)0x7FFF);
+}
+
+TEST(audaspace, ConvertFloatS16)
+{
+	std::vector<float> source(test_values, test_values + NUM_TEST_VALUES);
+	std::vector<int16_t> target(NUM_TEST_VALUES);
+
+	AUD_convert_float_s16((data_t *)&target[0], (data_t *)&source[0], NUM_TEST_VALUES);
+
+	for (int i = 0; i < NUM_TEST_VALUES; i++) {
+		EXPECT_EQ(ref_float_s16(test_values[i]), target[i]) << "value " << test_values[i];
+	}
+}
+
+TEST(audaspace, ConvertFloatS16InPlace)
+{
+	std::vector<float> buffer(test_values, test_values + NUM_TEST_VALUES);
+	int16_t *target = (int16_t *)&buffer[0];
+
+	AUD_convert_float_s16((data_t *)target, (data_t *)&buffer[0], NUM_TEST_VALUES);
+
+	for (int i = 0; i < NUM_TEST_VALUES; i++) {
+		EXPECT_EQ(ref_float_s16(test_values[i]), target[i]) << "value " << test_values[i];
+	}
+}
+
+TEST(audaspace, ConvertFloatS32)
+{
+	std::vector<float> source(test_values, test_values + NUM_TEST_VALUES);
+	std::vector<int32_t> target(NUM_TEST_VALUES);
+
+	AUD_convert_float_s32((data_t *)&target[0], (data_t *)&source[0], NUM_TEST_VALUES);
+
+	for (int i = 0; i < NUM_TEST_VALUES; i++) {
+		EXPECT_EQ(ref_float_s32(test_values[i]), target[i]) << "value " << test_values[i];
+	}
+}
+
+TEST(audaspace, ConvertFloatS24)
+{
+	std::vector<float> source(test_values, test_values + NUM_TEST_VALUES);
+	std::vector<data_t> be(NUM_TEST_VALUES * 3), le(NUM_TEST_VALUES * 3);
+
+	AUD_convert_float_s24_be(&be[0], (data_t *)&source[0], NUM_TEST_VALUES);
+	AUD_convert_float_s24_le(&le[0], (data_t *)&source[0], NUM_TEST_VALUES);
+
+	for (int i = 0; i < NUM_TEST_VALUES; i++) {
+		int32_t t = ref_float_s32(test_values[i]);
+		EXPECT_EQ(t >> 24 & 0xFF, be[i * 3]);
+		EXPECT_EQ(t >> 16 & 0xFF, be[i * 3 + 1]);
+		EXPECT_EQ(t >> 8 & 0xFF, be[i * 3 + 2]);
+		EXPECT_EQ(t >> 24 & 0xFF, le[i * 3 + 2]);
+		EXPECT_EQ(t >> 16 & 0xFF, le[i * 3 + 1]);
+		EXPECT_EQ(t >> 8 & 0xFF, le[i * 3]);
+	}
+}
+
+TEST(audaspace, ConvertS16FloatInPlace)
+{
+	const int16_t values[] = {-32768, -32767, -16384, -1, 0, 1, 255, 16384, 32767, 1000, -1000};
+	const int num = sizeof(values) / sizeof(*values);
+	std::vector<float> buffer(num);
+	int16_t *source = (int16_t *)&buffer[0];
+
+	for (int i = 0; i < num; i++) {
+		source[i] = values[i];
+	}
+
+	AUD_convert_s16_float((data_t *)&buffer[0], (data_t *)source, num);
+
+	for (int i = 0; i < num; i++) {
+		EXPECT_EQ(values[i] / 32767.0f, buffer[i]);
+	}
+}
+
+TEST(audaspace, ConvertS32Float)
+{
+	const int32_t values[] = {(int32_t)0x80000000, -65536, -1, 0, 1, 123456789, 0x7FFFFFFF};
+	const int num = sizeof(values) / sizeof(*values);
+	std::vector<float> target(num);
+
+	AUD_convert_s32_float((data_t *)&target[0], (data_t *)values, num);
+
+	for (int i = 0; i < num; i++) {
+		EXPECT_EQ(values[i] / 2147483647.0f, target[i]);
+	}
+}
+
+static void mixer_ramp_test(AUD_Channels channels, int length, int start)
+{
+	AUD_DeviceSpecs specs;
+	specs.format = AUD_FORMAT_FLOAT32;
+	specs.rate = AUD_RATE_48000;
+	specs.channels = channels;
+
+	const int total = start + length;
+	const float volume_from = 0.25f, volume_to = 1.0f;
+	std::vector<float> source(length * channels), result(total * channels);
+
+	for (int i = 0; i < length * channels; i++) {
+		source[i] = (i % 7) * 0.1f - 0.3f;
+	}
+
+	AUD_Mixer mixer(specs);
+	mixer.clear(total);
+	mixer.mix(&source[0], start, length, volume_to, volume_from);
+	mixer.read((data_t *)&result[0], 1.0f);
+
+	for (int i = 0; i < start * channels; i++) {
+		EXPECT_EQ(0.0f, result[i]);
+	}
+
+	for (int i = 0; i < length; i++) {
+		float volume = volume_from + (volume_to - volume_from) * i / float(length);
+		for (int c = 0; c < channels; c++) {
+			EXPECT_NEAR(source[i * channels + c] * volume, result[(start + i) * channels + c], 1e-6f);
+		}
+	}
+}
+
+TEST(audaspace, MixerRamp)
+{
+	mixer_ramp_test(AUD_CHANNELS_MONO, 37, 3);
+	mixer_ramp_test(AUD_CHANNELS_STEREO, 37, 1);
+	mixer_ramp_test(AUD_CHANNELS_SURROUND4, 19, 2);
+	mixer_ramp_test(AUD_CHANNELS_SURROUND51, 23, 0);
+}
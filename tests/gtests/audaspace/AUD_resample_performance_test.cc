@@ -0,0 +1,71 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "AUD_ChannelMapperReader.h"
+#include "AUD_JOSResampleReader.h"
+#include "AUD_SinusFactory.h"
+
+#include <vector>
+
+extern "C" {
+#include "PIL_time.h"
+}
+
+/* Throughput of the high quality resampler with the per sample interpolated
+ * filter and with the polyphase filter bank, in seconds of audio resampled
+ * per second. */
+
+#define SECONDS 20
+#define BUFFER_FRAMES 1024
+
+static double resample_speed(AUD_SampleRate source, AUD_SampleRate target, AUD_Channels channels, bool polyphase)
+{
+	AUD_SinusFactory sine(440.0f, source);
+	boost::shared_ptr<AUD_IReader> reader = sine.createReader();
+
+	if (channels != AUD_CHANNELS_MONO) {
+		reader = boost::shared_ptr<AUD_IReader>(new AUD_ChannelMapperReader(reader, channels));
+	}
+
+	AUD_Specs specs;
+	specs.rate = target;
+	specs.channels = channels;
+
+	AUD_JOSResampleReader *resampler = new AUD_JOSResampleReader(reader, specs);
+	boost::shared_ptr<AUD_IReader> resampled(resampler);
+	resampler->setPolyphase(polyphase);
+
+	std::vector<float> buffer(BUFFER_FRAMES * channels);
+	const int length = SECONDS * (int)target;
+	bool eos;
+
+	double time = PIL_check_seconds_timer();
+	for (int pos = 0; pos < length; pos += BUFFER_FRAMES) {
+		int len = BUFFER_FRAMES;
+		resampled->read(len, eos, &buffer[0]);
+	}
+	time = PIL_check_seconds_timer() - time;
+
+	return SECONDS / time;
+}
+
+static void resample_speed_test(AUD_SampleRate source, AUD_SampleRate target, AUD_Channels channels)
+{
+	double jos = resample_speed(source, target, channels, false);
+	double polyphase = resample_speed(source, target, channels, true);
+
+	printf("%6d Hz -> %6d Hz, %d channel(s): interpolated %8.1fx, polyphase %8.1fx real-time (%.1fx faster)\n",
+	       (int)source, (int)target, (int)channels, jos, polyphase, polyphase / jos);
+}
+
+TEST(audaspace, ResampleSpeed)
+{
+	printf("\n========== STARTING audaspace - Resampling speed ==========\n");
+	resample_speed_test(AUD_RATE_44100, AUD_RATE_48000, AUD_CHANNELS_MONO);
+	resample_speed_test(AUD_RATE_44100, AUD_RATE_48000, AUD_CHANNELS_STEREO);
+	resample_speed_test(AUD_RATE_22050, AUD_RATE_48000, AUD_CHANNELS_STEREO);
+	resample_speed_test(AUD_RATE_48000, AUD_RATE_44100, AUD_CHANNELS_STEREO);
+	resample_speed_test(AUD_RATE_44100, AUD_RATE_48000, AUD_CHANNELS_SURROUND51);
+	printf("========== ENDED audaspace - Resampling speed ==========\n\n");
+}
@@ -0,0 +1,90 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "AUD_ChannelMapperReader.h"
+#include "AUD_JOSResampleReader.h"
+#include "AUD_SinusFactory.h"
+
+#include <cmath>
+#include <vector>
+
+/* The polyphase filter bank has to give the result of the per sample
+ * interpolated filter, and both have to resample a sine cleanly. */
+
+#define SINE_FREQUENCY 1000.0f
+
+static std::vector<float> resample(AUD_SampleRate source, AUD_SampleRate target, AUD_Channels channels,
+                                   bool polyphase, int length, int buffersize)
+{
+	AUD_SinusFactory sine(SINE_FREQUENCY, source);
+	boost::shared_ptr<AUD_IReader> reader = sine.createReader();
+
+	if (channels != AUD_CHANNELS_MONO) {
+		reader = boost::shared_ptr<AUD_IReader>(new AUD_ChannelMapperReader(reader, channels));
+	}
+
+	AUD_Specs specs;
+	specs.rate = target;
+	specs.channels = channels;
+
+	AUD_JOSResampleReader *resampler = new AUD_JOSResampleReader(reader, specs);
+	boost::shared_ptr<AUD_IReader> resampled(resampler);
+	resampler->setPolyphase(polyphase);
+
+	std::vector<float> result(length * channels);
+	bool eos = false;
+
+	for (int pos = 0; pos < length;) {
+		int len = std::min(buffersize, length - pos);
+		resampled->read(len, eos, &result[pos * channels]);
+		EXPECT_GT(len, 0);
+		if (len <= 0) {
+			break;
+		}
+		pos += len;
+	}
+
+	return result;
+}
+
+static void resample_test(AUD_SampleRate source, AUD_SampleRate target, AUD_Channels channels)
+{
+	const int length = 20000;
+	std::vector<float> jos = resample(source, target, channels, false, length, 1000);
+	std::vector<float> poly = resample(source, target, channels, true, length, 1000);
+	std::vector<float> poly_small = resample(source, target, channels, true, length, 37);
+
+	float diff = 0.0f, diff_small = 0.0f, error = 0.0f;
+
+	/* skip the start where the filter is still filling */
+	for (int i = 1000; i < length; i++) {
+		for (int c = 0; c < channels; c++) {
+			diff = std::max(diff, std::fabs(jos[i * channels + c] - poly[i * channels + c]));
+			diff_small = std::max(diff_small, std::fabs(poly_small[i * channels + c] - poly[i * channels + c]));
+		}
+
+		if (channels == AUD_CHANNELS_MONO) {
+			float expected = sin(i * 2.0 * M_PI * SINE_FREQUENCY / target);
+			error = std::max(error, std::fabs(poly[i] - expected));
+		}
+	}
+
+	EXPECT_LT(diff, 1e-5f);
+	EXPECT_LT(diff_small, 1e-6f);
+	EXPECT_LT(error, 1e-5f);
+}
+
+TEST(audaspace, ResamplePolyphaseUp)
+{
+	resample_test(AUD_RATE_44100, AUD_RATE_48000, AUD_CHANNELS_MONO);
+	resample_test(AUD_RATE_44100, AUD_RATE_48000, AUD_CHANNELS_STEREO);
+	resample_test(AUD_RATE_22050, AUD_RATE_48000, AUD_CHANNELS_SURROUND51);
+}
+
+TEST(audaspace, ResamplePolyphaseDown)
+{
+	resample_test(AUD_RATE_48000, AUD_RATE_44100, AUD_CHANNELS_MONO);
+	resample_test(AUD_RATE_48000, AUD_RATE_44100, AUD_CHANNELS_STEREO);
+	resample_test(AUD_RATE_96000, AUD_RATE_44100, AUD_CHANNELS_MONO);
+}
@@ -0,0 +1,117 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "DNA_meshdata_types.h"
+#include "BLI_utildefines.h"
+#include "BLI_rand.h"
+#include "BKE_mesh.h"
+#include "BKE_pbvh.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Run the longest tests! */
+//#define PBVH_RUN_BIG
+
+/* Grid of quads with some noise in the heights, triangulated in looptris. */
+static void pbvh_build_mesh_tests(const int size, const char *id)
+{
+	const int totvert = (size + 1) * (size + 1);
+	const int totpoly = size * size;
+	const int totloop = totpoly * 4;
+	const int looptri_num = totpoly * 2;
+
+	printf("\n========== STARTING %s ==========\n", id);
+
+	MVert *mvert = (MVert *)MEM_callocN(sizeof(*mvert) * totvert, __func__);
+	MPoly *mpoly = (MPoly *)MEM_callocN(sizeof(*mpoly) * totpoly, __func__);
+	MLoop *mloop = (MLoop *)MEM_callocN(sizeof(*mloop) * totloop, __func__);
+	/* Owned by the PBVH. */
+	MLoopTri *looptri = (MLoopTri *)MEM_mallocN(sizeof(*looptri) * looptri_num, __func__);
+
+	RNG *rng = BLI_rng_new(0);
+
+	for (int y = 0; y <= size; y++) {
+		for (int x = 0; x <= size; x++) {
+			MVert *mv = &mvert[y * (size + 1) + x];
+			mv->co[0] = (float)x;
+			mv->co[1] = (float)y;
+			mv->co[2] = BLI_rng_get_float(rng);
+		}
+	}
+
+	for (int y = 0, p = 0; y < size; y++) {
+		for (int x = 0; x < size; x++, p++) {
+			MPoly *mp = &mpoly[p];
+			MLoop *ml = &mloop[p * 4];
+
+			mp->loopstart = p * 4;
+			mp->totloop = 4;
+			mp->flag = ME_SMOOTH;
+
+			ml[0].v = y * (size + 1) + x;
+			ml[1].v = y * (size + 1) + x + 1;
+			ml[2].v = (y + 1) * (size + 1) + x + 1;
+			ml[3].v = (y + 1) * (size + 1) + x;
+		}
+	}
+
+	BLI_rng_free(rng);
+
+	BKE_mesh_recalc_looptri(mloop, mpoly, mvert, totloop, totpoly, looptri);
+
+	PBVH *bvh = BKE_pbvh_new();
+
+	TIMEIT_START(pbvh_build_mesh);
+
+	BKE_pbvh_build_mesh(bvh, mpoly, mloop, mvert, totvert, NULL, looptri, looptri_num);
+
+	TIMEIT_END(pbvh_build_mesh);
+
+	PBVHNode **nodes;
+	int totnode, totuniq = 0;
+
+	BKE_pbvh_search_gather(bvh, NULL, NULL, &nodes, &totnode);
+
+	for (int i = 0; i < totnode; i++) {
+		int uniq_verts, node_verts;
+		BKE_pbvh_node_num_verts(bvh, nodes[i], &uniq_verts, &node_verts);
+		totuniq += uniq_verts;
+	}
+
+	printf("%d leaves\n", totnode);
+
+	/* Every vertex is unique to exactly one leaf. */
+	EXPECT_EQ(totvert, totuniq);
+
+	if (nodes) {
+		MEM_freeN(nodes);
+	}
+
+	BKE_pbvh_free(bvh);
+
+	MEM_freeN(mvert);
+	MEM_freeN(mpoly);
+	MEM_freeN(mloop);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(pbvh, BuildMesh100k)
+{
+	pbvh_build_mesh_tests(224, "PBVH build mesh - 100k triangles");
+}
+
+TEST(pbvh, BuildMesh2M)
+{
+	pbvh_build_mesh_tests(1000, "PBVH build mesh - 2M triangles");
+}
+
+#ifdef PBVH_RUN_BIG
+TEST(pbvh, BuildMesh20M)
+{
+	pbvh_build_mesh_tests(3163, "PBVH build mesh - 20M triangles");
+}
+#endif
@@ -0,0 +1,195 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_kdopbvh.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Run the longest tests! */
+//#define KDOPBVH_RUN_BIG
+
+/* Size of the tiles the rays are ordered in (coherent rays, as for rendering an image). */
+#define RAY_TILE_SIZE 4
+
+typedef struct RayCastTestData {
+	const float (*tris)[3][3];
+} RayCastTestData;
+
+static void raycast_tri_cb(void *userdata, int index, const BVHTreeRay *ray, BVHTreeRayHit *hit)
+{
+	const RayCastTestData *data = (const RayCastTestData *)userdata;
+	const float (*tri)[3] = data->tris[index];
+	float dist;
+
+	if (isect_ray_tri_watertight_v3(ray->origin, ray->isect_precalc, tri[0], tri[1], tri[2], &dist, NULL) &&
+	    (dist < hit->dist))
+	{
+		hit->index = index;
+		hit->dist = dist;
+		madd_v3_v3v3fl(hit->co, ray->origin, ray->direction, dist);
+	}
+}
+
+static void raycast_hits_init(BVHTreeRayHit *hits, const int rays_num)
+{
+	for (int i = 0; i < rays_num; i++) {
+		hits[i].index = -1;
+		hits[i].dist = BVH_RAYCAST_DIST_MAX;
+	}
+}
+
+/* Grid of triangles with some noise in the heights, seen by a perspective camera of res * res pixels. */
+static void kdopbvh_raycast_tests(const int size, const int res, const int tree_type, const char *id)
+{
+	const int tris_num = size * size * 2;
+	const int rays_num = res * res;
+
+	printf("\n========== STARTING %s ==========\n", id);
+
+	float (*verts)[3] = (float (*)[3])MEM_mallocN(sizeof(*verts) * (size + 1) * (size + 1), __func__);
+	float (*tris)[3][3] = (float (*)[3][3])MEM_mallocN(sizeof(*tris) * tris_num, __func__);
+
+	RNG *rng = BLI_rng_new(0);
+
+	for (int y = 0; y <= size; y++) {
+		for (int x = 0; x <= size; x++) {
+			float *co = verts[y * (size + 1) + x];
+			co[0] = (float)x;
+			co[1] = (float)y;
+			co[2] = BLI_rng_get_float(rng);
+		}
+	}
+
+	BLI_rng_free(rng);
+
+	for (int y = 0, t = 0; y < size; y++) {
+		for (int x = 0; x < size; x++, t += 2) {
+			const int v = y * (size + 1) + x;
+			copy_v3_v3(tris[t][0], verts[v]);
+			copy_v3_v3(tris[t][1], verts[v + 1]);
+			copy_v3_v3(tris[t][2], verts[v + size + 2]);
+			copy_v3_v3(tris[t + 1][0], verts[v]);
+			copy_v3_v3(tris[t + 1][1], verts[v + size + 2]);
+			copy_v3_v3(tris[t + 1][2], verts[v + size + 1]);
+		}
+	}
+
+	MEM_freeN(verts);
+
+	BVHTree *tree = BLI_bvhtree_new(tris_num, 0.0f, tree_type, 6);
+
+	TIMEIT_START(bvhtree_build);
+
+	for (int i = 0; i < tris_num; i++) {
+		BLI_bvhtree_insert(tree, i, tris[i][0], 3);
+	}
+	BLI_bvhtree_balance(tree);
+
+	TIMEIT_END(bvhtree_build);
+
+	float (*ray_co)[3] = (float (*)[3])MEM_mallocN(sizeof(*ray_co) * rays_num, __func__);
+	float (*ray_dir)[3] = (float (*)[3])MEM_mallocN(sizeof(*ray_dir) * rays_num, __func__);
+
+	for (int ty = 0, r = 0; ty < res; ty += RAY_TILE_SIZE) {
+		for (int tx = 0; tx < res; tx += RAY_TILE_SIZE) {
+			for (int y = ty; y < ty + RAY_TILE_SIZE; y++) {
+				for (int x = tx; x < tx + RAY_TILE_SIZE; x++, r++) {
+					const float target[3] = {size * (x + 0.5f) / res, size * (y + 0.5f) / res, 0.0f};
+					ray_co[r][0] = size * 0.5f;
+					ray_co[r][1] = size * -0.2f;
+					ray_co[r][2] = size * 0.6f;
+					sub_v3_v3v3(ray_dir[r], target, ray_co[r]);
+					normalize_v3(ray_dir[r]);
+				}
+			}
+		}
+	}
+
+	BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hits) * rays_num, __func__);
+	BVHTreeRayHit *hits_packet = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hits_packet) * rays_num, __func__);
+	RayCastTestData data = {tris};
+	int hits_num = 0, hits_packet_num;
+
+	raycast_hits_init(hits, rays_num);
+	raycast_hits_init(hits_packet, rays_num);
+
+	TIMEIT_START(bvhtree_ray_cast);
+
+	for (int i = 0; i < rays_num; i++) {
+		if (BLI_bvhtree_ray_cast(tree, ray_co[i], ray_dir[i], 0.0f, &hits[i], raycast_tri_cb, &data) != -1) {
+			hits_num++;
+		}
+	}
+
+	TIMEIT_END(bvhtree_ray_cast);
+
+	TIMEIT_START(bvhtree_ray_cast_packet);
+
+	hits_packet_num = BLI_bvhtree_ray_cast_packet(
+	        tree, ray_co, ray_dir, rays_num, 0.0f, hits_packet, raycast_tri_cb, &data, BVH_RAYCAST_DEFAULT);
+
+	TIMEIT_END(bvhtree_ray_cast_packet);
+
+	/* The camera sees the whole grid. */
+	EXPECT_EQ(rays_num, hits_num);
+	EXPECT_EQ(hits_num, hits_packet_num);
+
+	for (int i = 0; i < rays_num; i++) {
+		EXPECT_EQ(hits[i].index, hits_packet[i].index);
+		EXPECT_EQ(hits[i].dist, hits_packet[i].dist);
+	}
+
+	/* Traversal of the k-DOP nodes (used for rays with a radius), the hits don't depend on the radius. */
+	raycast_hits_init(hits_packet, rays_num);
+
+	TIMEIT_START(bvhtree_ray_cast_kdop);
+
+	for (int i = 0; i < rays_num; i++) {
+		BLI_bvhtree_ray_cast(tree, ray_co[i], ray_dir[i], FLT_EPSILON, &hits_packet[i], raycast_tri_cb, &data);
+	}
+
+	TIMEIT_END(bvhtree_ray_cast_kdop);
+
+	for (int i = 0; i < rays_num; i++) {
+		EXPECT_EQ(hits[i].index, hits_packet[i].index);
+		EXPECT_EQ(hits[i].dist, hits_packet[i].dist);
+	}
+
+	BLI_bvhtree_free(tree);
+
+	MEM_freeN(tris);
+	MEM_freeN(ray_co);
+	MEM_freeN(ray_dir);
+	MEM_freeN(hits);
+	MEM_freeN(hits_packet);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdopbvh, RayCast2M)
+{
+	kdopbvh_raycast_tests(1000, 512, 4, "BVH-tree ray-cast - 2M triangles, 260k rays");
+}
+
+TEST(kdopbvh, RayCastBinary2M)
+{
+	kdopbvh_raycast_tests(1000, 512, 2, "BVH-tree ray-cast (binary tree) - 2M triangles, 260k rays");
+}
+
+TEST(kdopbvh, RayCastOctree2M)
+{
+	kdopbvh_raycast_tests(1000, 512, 8, "BVH-tree ray-cast (octree) - 2M triangles, 260k rays");
+}
+
+#ifdef KDOPBVH_RUN_BIG
+TEST(kdopbvh, RayCast20M)
+{
+	kdopbvh_raycast_tests(3163, 2048, 4, "BVH-tree ray-cast - 20M triangles, 4M rays");
+}
+#endif
@@ -0,0 +1,108 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "bmesh.h"
+#include "tools/bmesh_intersect.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Run the longest tests! */
+//#define BOOLEAN_RUN_BIG
+
+static int bm_face_isect_tag(BMFace *f, void *UNUSED(user_data))
+{
+	return BM_elem_flag_test(f, BM_ELEM_TAG) ? 1 : 0;
+}
+
+static void bm_add_uvsphere(BMesh *bm, const int segments, const float offset[3])
+{
+	float mat[4][4];
+
+	unit_m4(mat);
+	copy_v3_v3(mat[3], offset);
+
+	BMO_op_callf(
+	        bm, BMO_FLAG_DEFAULTS,
+	        "create_uvsphere u_segments=%i v_segments=%i diameter=%f matrix=%m4 calc_uvs=%b",
+	        segments, segments / 2, 1.0f, mat, false);
+}
+
+/* Two dense, overlapping spheres, cut with the BMesh boolean (same as the modifier). */
+static void bm_boolean_tests(const int segments, const int boolean_mode, const char *id)
+{
+	const float offset_a[3] = {0.0f, 0.0f, 0.0f};
+	const float offset_b[3] = {0.5f, 0.25f, 0.125f};
+
+	printf("\n========== STARTING %s ==========\n", id);
+
+	BMeshCreateParams bm_params;
+	bm_params.use_toolflags = true;
+	BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default, &bm_params);
+
+	/* the first sphere is tagged as the other side */
+	bm_add_uvsphere(bm, segments, offset_a);
+	BM_mesh_elem_hflag_enable_all(bm, BM_FACE, BM_ELEM_TAG, false);
+	bm_add_uvsphere(bm, segments, offset_b);
+	BM_mesh_normals_update(bm);
+
+	const int totface_orig = bm->totface;
+	const int looptris_tot_max = poly_to_tri_count(bm->totface, bm->totloop);
+	BMLoop *(*looptris)[3] = (BMLoop *(*)[3])MEM_mallocN(sizeof(*looptris) * looptris_tot_max, __func__);
+	int looptris_tot;
+
+	BM_mesh_calc_tessellation(bm, looptris, &looptris_tot);
+
+	printf("%d triangles\n", looptris_tot);
+
+	bool changed;
+
+	TIMEIT_START(bm_mesh_intersect);
+
+	changed = BM_mesh_intersect(
+	        bm,
+	        looptris, looptris_tot,
+	        bm_face_isect_tag, NULL,
+	        false, false, true, true,
+	        boolean_mode,
+	        1e-6f);
+
+	TIMEIT_END(bm_mesh_intersect);
+
+	printf("%d faces\n", bm->totface);
+
+	EXPECT_TRUE(changed);
+	EXPECT_GT(bm->totface, 0);
+	EXPECT_NE(totface_orig, bm->totface);
+
+	MEM_freeN(looptris);
+	BM_mesh_free(bm);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(bmesh_boolean, Union100k)
+{
+	bm_boolean_tests(224, BMESH_ISECT_BOOLEAN_UNION, "BMesh boolean union - 100k triangles");
+}
+
+TEST(bmesh_boolean, Difference100k)
+{
+	bm_boolean_tests(224, BMESH_ISECT_BOOLEAN_DIFFERENCE, "BMesh boolean difference - 100k triangles");
+}
+
+TEST(bmesh_boolean, Difference1M)
+{
+	bm_boolean_tests(708, BMESH_ISECT_BOOLEAN_DIFFERENCE, "BMesh boolean difference - 1M triangles");
+}
+
+#ifdef BOOLEAN_RUN_BIG
+TEST(bmesh_boolean, Difference10M)
+{
+	bm_boolean_tests(2236, BMESH_ISECT_BOOLEAN_DIFFERENCE, "BMesh boolean difference - 10M triangles");
+}
+#endif
@@ -0,0 +1,97 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "bmesh.h"
+#include "bmesh_tools.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Run the longest tests! */
+//#define DECIMATE_RUN_BIG
+
+/* Noisy sphere (so the quadric costs differ), decimated to a tenth of its triangles. */
+static void bm_decimate_tests(const int subdivisions, const float batch_factor, const char *id)
+{
+	const float ratio = 0.1f;
+	float mat[4][4];
+
+	printf("\n========== STARTING %s ==========\n", id);
+
+	BMeshCreateParams bm_params;
+	bm_params.use_toolflags = true;
+	BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default, &bm_params);
+
+	unit_m4(mat);
+	BMO_op_callf(
+	        bm, BMO_FLAG_DEFAULTS,
+	        "create_icosphere subdivisions=%i diameter=%f matrix=%m4 calc_uvs=%b",
+	        subdivisions, 1.0f, mat, false);
+
+	{
+		RNG *rng = BLI_rng_new(0);
+		BMIter iter;
+		BMVert *v;
+
+		BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
+			mul_v3_fl(v->co, 1.0f + (BLI_rng_get_float(rng) * 0.01f));
+		}
+		BLI_rng_free(rng);
+	}
+
+	BM_mesh_normals_update(bm);
+	BM_mesh_elem_index_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
+
+	const int totface_orig = bm->totface;
+	const int totface_target = (int)(totface_orig * ratio);
+
+	printf("%d triangles\n", totface_orig);
+
+	TIMEIT_START(bm_mesh_decimate_collapse);
+
+	BM_mesh_decimate_collapse(bm, ratio, NULL, 0.0f, true, -1, 0.0f, batch_factor);
+
+	TIMEIT_END(bm_mesh_decimate_collapse);
+
+	printf("%d faces\n", bm->totface);
+
+	/* may overshoot by one collapse */
+	EXPECT_GE(bm->totface, totface_target - 2);
+	EXPECT_LE(bm->totface, totface_target);
+
+	BM_mesh_free(bm);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(bmesh_decimate, Collapse300k)
+{
+	bm_decimate_tests(8, 0.0f, "BMesh decimate collapse - 300k triangles");
+}
+
+TEST(bmesh_decimate, CollapseBatched300k)
+{
+	bm_decimate_tests(8, 0.1f, "BMesh decimate collapse batched - 300k triangles");
+}
+
+TEST(bmesh_decimate, Collapse1M)
+{
+	bm_decimate_tests(9, 0.0f, "BMesh decimate collapse - 1.3M triangles");
+}
+
+TEST(bmesh_decimate, CollapseBatched1M)
+{
+	bm_decimate_tests(9, 0.1f, "BMesh decimate collapse batched - 1.3M triangles");
+}
+
+#ifdef DECIMATE_RUN_BIG
+TEST(bmesh_decimate, CollapseBatched20M)
+{
+	bm_decimate_tests(11, 0.1f, "BMesh decimate collapse batched - 20M triangles");
+}
+#endif